@@ -0,0 +1,214 @@
+#include "AllocationTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#if ALLOCATION_TRACKING
+#include <malloc.h>
+#endif
+
+namespace
+{
+	/**
+	* These are plain globals & thread_locals of trivial types, so they're ready before the first static constructor
+	* calls operator new & never need to be destroyed
+	*/
+	std::atomic<unsigned long long> gAllocations(0);
+	std::atomic<unsigned long long> gFrees(0);
+	std::atomic<unsigned long long> gBytesAllocated(0);
+	std::atomic<unsigned long long> gBytesFreed(0);
+	thread_local unsigned long long tAllocations = 0;
+	thread_local unsigned long long tFrees = 0;
+	thread_local unsigned long long tBytesAllocated = 0;
+	thread_local unsigned long long tBytesFreed = 0;
+}
+
+bool IsAllocationTrackingEnabled()
+{
+	return ALLOCATION_TRACKING != 0;
+}
+
+AllocationCounts GetThreadAllocationCounts()
+{
+	AllocationCounts result;
+	result.allocations = tAllocations;
+	result.frees = tFrees;
+	result.bytesAllocated = tBytesAllocated;
+	result.bytesFreed = tBytesFreed;
+	return result;
+}
+
+AllocationCounts GetGlobalAllocationCounts()
+{
+	AllocationCounts result;
+	result.allocations = gAllocations.load();
+	result.frees = gFrees.load();
+	result.bytesAllocated = gBytesAllocated.load();
+	result.bytesFreed = gBytesFreed.load();
+	return result;
+}
+
+#if ALLOCATION_TRACKING
+static void* TrackedAllocate(size_t inSize)
+{
+	if (inSize == 0) { inSize = 1; }
+	void* memory = malloc(inSize);
+	if (memory == 0) { return 0; }
+
+	// _msize is used on free, so the size reported here has to match it
+	size_t size = _msize(memory);
+	++gAllocations;
+	gBytesAllocated += size;
+	++tAllocations;
+	tBytesAllocated += size;
+	return memory;
+}
+
+static void TrackedFree(void* inMemory)
+{
+	if (inMemory == 0) { return; }
+	size_t size = _msize(inMemory);
+	++gFrees;
+	gBytesFreed += size;
+	++tFrees;
+	tBytesFreed += size;
+	free(inMemory);
+}
+
+#if __cpp_aligned_new
+// Over aligned types (alignas above 16, Job for example) go through these, _aligned_msize needs the same alignment as the allocation
+static void* TrackedAlignedAllocate(size_t inSize, std::align_val_t inAlignment)
+{
+	if (inSize == 0) { inSize = 1; }
+	void* memory = _aligned_malloc(inSize, (size_t)inAlignment);
+	if (memory == 0) { return 0; }
+
+	size_t size = _aligned_msize(memory, (size_t)inAlignment, 0);
+	++gAllocations;
+	gBytesAllocated += size;
+	++tAllocations;
+	tBytesAllocated += size;
+	return memory;
+}
+
+static void TrackedAlignedFree(void* inMemory, std::align_val_t inAlignment)
+{
+	if (inMemory == 0) { return; }
+	size_t size = _aligned_msize(inMemory, (size_t)inAlignment, 0);
+	++gFrees;
+	gBytesFreed += size;
+	++tFrees;
+	tBytesFreed += size;
+	_aligned_free(inMemory);
+}
+#endif
+
+void* operator new(size_t inSize)
+{
+	void* memory = TrackedAllocate(inSize);
+	if (memory == 0) { throw std::bad_alloc(); }
+	return memory;
+}
+
+void* operator new[](size_t inSize)
+{
+	void* memory = TrackedAllocate(inSize);
+	if (memory == 0) { throw std::bad_alloc(); }
+	return memory;
+}
+
+void* operator new(size_t inSize, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(inSize);
+}
+
+void* operator new[](size_t inSize, const std::nothrow_t&) noexcept
+{
+	return TrackedAllocate(inSize);
+}
+
+void operator delete(void* inMemory) noexcept
+{
+	TrackedFree(inMemory);
+}
+
+void operator delete[](void* inMemory) noexcept
+{
+	TrackedFree(inMemory);
+}
+
+void operator delete(void* inMemory, const std::nothrow_t&) noexcept
+{
+	TrackedFree(inMemory);
+}
+
+void operator delete[](void* inMemory, const std::nothrow_t&) noexcept
+{
+	TrackedFree(inMemory);
+}
+
+void operator delete(void* inMemory, size_t) noexcept
+{
+	TrackedFree(inMemory);
+}
+
+void operator delete[](void* inMemory, size_t) noexcept
+{
+	TrackedFree(inMemory);
+}
+
+#if __cpp_aligned_new
+void* operator new(size_t inSize, std::align_val_t inAlignment)
+{
+	void* memory = TrackedAlignedAllocate(inSize, inAlignment);
+	if (memory == 0) { throw std::bad_alloc(); }
+	return memory;
+}
+
+void* operator new[](size_t inSize, std::align_val_t inAlignment)
+{
+	void* memory = TrackedAlignedAllocate(inSize, inAlignment);
+	if (memory == 0) { throw std::bad_alloc(); }
+	return memory;
+}
+
+void* operator new(size_t inSize, std::align_val_t inAlignment, const std::nothrow_t&) noexcept
+{
+	return TrackedAlignedAllocate(inSize, inAlignment);
+}
+
+void* operator new[](size_t inSize, std::align_val_t inAlignment, const std::nothrow_t&) noexcept
+{
+	return TrackedAlignedAllocate(inSize, inAlignment);
+}
+
+void operator delete(void* inMemory, std::align_val_t inAlignment) noexcept
+{
+	TrackedAlignedFree(inMemory, inAlignment);
+}
+
+void operator delete[](void* inMemory, std::align_val_t inAlignment) noexcept
+{
+	TrackedAlignedFree(inMemory, inAlignment);
+}
+
+void operator delete(void* inMemory, std::align_val_t inAlignment, const std::nothrow_t&) noexcept
+{
+	TrackedAlignedFree(inMemory, inAlignment);
+}
+
+void operator delete[](void* inMemory, std::align_val_t inAlignment, const std::nothrow_t&) noexcept
+{
+	TrackedAlignedFree(inMemory, inAlignment);
+}
+
+void operator delete(void* inMemory, size_t, std::align_val_t inAlignment) noexcept
+{
+	TrackedAlignedFree(inMemory, inAlignment);
+}
+
+void operator delete[](void* inMemory, size_t, std::align_val_t inAlignment) noexcept
+{
+	TrackedAlignedFree(inMemory, inAlignment);
+}
+#endif
+#endif
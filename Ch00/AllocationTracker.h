@@ -0,0 +1,33 @@
+#pragma once
+#ifndef _H_ALLOCATIONTRACKER_
+#define _H_ALLOCATIONTRACKER_
+
+/**
+* In debug builds the global operator new & delete are replaced (see AllocationTracker.cpp) so every heap allocation made
+* through them is counted, per thread & for the whole process
+* The frame profiler uses the per thread counts to attribute allocations to its markers, which makes it easy to spot
+* per frame heap churn in Update() or Render(). Release builds don't replace anything & all counts stay 0
+* The aligned overloads (std::align_val_t, used for types with alignas above the default) are replaced as well
+* Allocations made with malloc directly (glad, the C runtime) aren't counted
+*/
+#if _DEBUG
+	#define ALLOCATION_TRACKING 1
+#else
+	#define ALLOCATION_TRACKING 0
+#endif
+
+struct AllocationCounts
+{
+	unsigned long long allocations;
+	unsigned long long frees;
+	unsigned long long bytesAllocated;
+	unsigned long long bytesFreed;
+};
+
+bool IsAllocationTrackingEnabled();
+// Counts of the calling thread since it started
+AllocationCounts GetThreadAllocationCounts();
+// Counts of every thread since the process started
+AllocationCounts GetGlobalAllocationCounts();
+
+#endif
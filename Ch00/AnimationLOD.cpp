@@ -0,0 +1,143 @@
+#include "AnimationLOD.h"
+#include "FrameProfiler.h"
+#include <cmath>
+#include <iostream>
+
+AnimationLOD::AnimationLOD()
+{
+	mLevelCount = 0;
+	mFrame = 0;
+	SetFieldOfView(60.0f);
+}
+
+void AnimationLOD::Initialize(unsigned int inInstanceCount, unsigned int inJointCount)
+{
+	AnimationLODLevel levels[3];
+	levels[0].minScreenSize = 0.25f;
+	levels[0].updateInterval = 1;
+	levels[0].jointCount = inJointCount;
+	levels[1].minScreenSize = 0.1f;
+	levels[1].updateInterval = 2;
+	levels[1].jointCount = (inJointCount * 3 + 3) / 4;
+	levels[2].minScreenSize = 0.0f;
+	levels[2].updateInterval = 4;
+	levels[2].jointCount = (inJointCount + 1) / 2;
+	SetLevels(levels, 3);
+
+	AnimationLODInstance instance;
+	instance.level = 0;
+	instance.period = 0; // Evaluates on the first Schedule()
+	instance.elapsed = 0;
+	instance.screenSize = 0.0f;
+	instance.alpha = 1.0f;
+	instance.visible = true;
+	instance.update = false;
+	mInstances.assign(inInstanceCount, instance);
+	mFrame = 0;
+}
+
+bool AnimationLOD::SetLevels(const AnimationLODLevel* inLevels, unsigned int inCount)
+{
+	if (inCount == 0 || inCount > kMaxLevels)
+	{
+		std::cout << "AnimationLOD needs 1 to " << kMaxLevels << " levels, got " << inCount << "\n";
+		return false;
+	}
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		mLevels[i] = inLevels[i];
+		if (mLevels[i].updateInterval == 0) { mLevels[i].updateInterval = 1; }
+	}
+	mLevelCount = inCount;
+	return true;
+}
+
+void AnimationLOD::SetFieldOfView(float inFieldOfView)
+{
+	mTanHalfFov = tanf(inFieldOfView * 0.5f * 0.0174532925f);
+}
+
+unsigned int AnimationLOD::GetLevelCount() const
+{
+	return mLevelCount;
+}
+
+const AnimationLODLevel& AnimationLOD::GetLevel(unsigned int inLevel) const
+{
+	return mLevels[inLevel];
+}
+
+unsigned int AnimationLOD::GetInterval(unsigned int inLevel) const
+{
+	return (inLevel < mLevelCount) ? mLevels[inLevel].updateInterval : kCulledInterval;
+}
+
+void AnimationLOD::Schedule(const Frustum& inFrustum, const vec3& inEye, const vec3* inCenters, float inRadius)
+{
+	if (mLevelCount == 0) { return; }
+	unsigned int updates = 0;
+	unsigned int interpolated = 0;
+	unsigned int culled = 0;
+	unsigned int count = (unsigned int)mInstances.size();
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		AnimationLODInstance& instance = mInstances[i];
+		instance.visible = inFrustum.ContainsSphere(inCenters[i], inRadius);
+		float distance = len(inCenters[i] - inEye);
+		if (distance < inRadius) { distance = inRadius; }
+		instance.screenSize = inRadius / (distance * mTanHalfFov);
+
+		instance.update = instance.period == 0 || instance.elapsed >= instance.period;
+		if (instance.update)
+		{
+			unsigned int level = mLevelCount;
+			if (instance.visible)
+			{
+				level = mLevelCount - 1;
+				for (unsigned int l = 0; l + 1 < mLevelCount; ++l)
+				{
+					if (instance.screenSize >= mLevels[l].minScreenSize)
+					{
+						level = l;
+						break;
+					}
+				}
+			}
+			instance.level = level;
+			// Shorten the first period after a level change so the instance lands on its own slot again
+			unsigned int interval = GetInterval(level);
+			instance.period = interval - (mFrame + i) % interval;
+			instance.elapsed = 0;
+			++updates;
+		}
+		instance.elapsed += 1;
+		instance.alpha = (float)instance.elapsed / (float)instance.period;
+
+		if (!instance.visible) { ++culled; }
+		else if (!instance.update) { ++interpolated; }
+	}
+	++mFrame;
+
+	if (gProfiler != 0)
+	{
+		gProfiler->AddCounter("Anim updates", (float)updates);
+		gProfiler->AddCounter("Anim interpolated", (float)interpolated);
+		gProfiler->AddCounter("Anim culled", (float)culled);
+	}
+}
+
+unsigned int AnimationLOD::Size() const
+{
+	return (unsigned int)mInstances.size();
+}
+
+const AnimationLODInstance& AnimationLOD::GetInstance(unsigned int inIndex) const
+{
+	return mInstances[inIndex];
+}
+
+unsigned int AnimationLOD::GetJointCount(unsigned int inIndex) const
+{
+	unsigned int level = mInstances[inIndex].level;
+	return mLevels[(level < mLevelCount) ? level : mLevelCount - 1].jointCount;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef _H_ANIMATIONLOD_
+#define _H_ANIMATIONLOD_
+
+#include "vec3.h"
+#include "Frustum.h"
+#include <vector>
+
+// One detail level, the levels are sorted from the most to the least detailed
+struct AnimationLODLevel
+{
+	float minScreenSize; // Bounding radius over half the screen height an instance needs for this level
+	unsigned int updateInterval; // Frames between two evaluations, the frames in between interpolate
+	unsigned int jointCount; // Joints that get evaluated, parents come first in a Pose so this is always a complete skeleton
+};
+
+// What the scheduler decided for one instance this frame
+struct AnimationLODInstance
+{
+	unsigned int level; // Index into the levels, the level count when the instance is culled
+	unsigned int period; // Frames between the last evaluation & the next one
+	unsigned int elapsed; // Frames since the last evaluation, including this one
+	float screenSize;
+	float alpha; // elapsed / period, blend weight from the previous evaluated pose to the latest one
+	bool visible;
+	bool update; // Evaluate this frame, period frames ahead
+};
+
+/**
+* Animation LOD & update rate throttling
+* Every frame Schedule() picks a level per instance from its projected size & frustum visibility. Instances are evaluated
+* every updateInterval frames, period frames ahead of time (advance the animation by period * dt), & the frames in between
+* blend from the previous evaluation to that one with alpha, so the displayed animation doesn't lag behind
+* Updates are staggered by instance index: instance i only evaluates on frames where (frame + i) % interval == 0,
+* so each level spreads its work evenly over its interval & the schedule is the same on every run
+* Levels only change when an instance evaluates, culled instances use kCulledInterval & the least detailed level's joints
+* & shouldn't be blended or skinned at all
+*/
+class AnimationLOD
+{
+public:
+	static const unsigned int kMaxLevels = 4;
+	static const unsigned int kCulledInterval = 8;
+private:
+	AnimationLODLevel mLevels[kMaxLevels];
+	unsigned int mLevelCount;
+	std::vector<AnimationLODInstance> mInstances;
+	unsigned int mFrame;
+	float mTanHalfFov;
+private:
+	unsigned int GetInterval(unsigned int inLevel) const;
+public:
+	AnimationLOD();
+	// Resets every instance, the default levels evaluate all, 3/4 & 1/2 of inJointCount every 1st, 2nd & 4th frame
+	void Initialize(unsigned int inInstanceCount, unsigned int inJointCount);
+	bool SetLevels(const AnimationLODLevel* inLevels, unsigned int inCount);
+	// Vertical field of view in degrees, the same one the projection uses
+	void SetFieldOfView(float inFieldOfView);
+	unsigned int GetLevelCount() const;
+	const AnimationLODLevel& GetLevel(unsigned int inLevel) const;
+
+	// inCenters has an entry per instance, adds the "Anim updates", "Anim interpolated" & "Anim culled" counters
+	void Schedule(const Frustum& inFrustum, const vec3& inEye, const vec3* inCenters, float inRadius);
+	unsigned int Size() const;
+	const AnimationLODInstance& GetInstance(unsigned int inIndex) const;
+	// Joints to evaluate for the instance's current level
+	unsigned int GetJointCount(unsigned int inIndex) const;
+};
+
+#endif
@@ -19,9 +19,55 @@ private:
 public:
 	inline Application() {}
 	inline virtual ~Application() {}
+	/**
+	* Memory: Initialize() should take long lived buffers from gPersistentArena & Update() / Render() transient ones from gFrameArena,
+	* which is reset at the start of every frame (see Arena.h). That keeps the per frame path free of heap allocations
+	*/
 	inline virtual void Initialize() {}
+	/**
+	* Loads queued on gAssetLoader (see AssetLoader.h) run on a loading thread while the loop keeps updating & presenting,
+	* OnAssetsReady() is called on the Update thread, before Update(), once every queued load has finished on the GPU
+	*/
+	inline virtual void OnAssetsReady() {}
 	inline virtual void Update(float inDeltaTime) {}
+	/**
+	* Called once per frame right before Render()
+	* When the game loop runs with a fixed time step, inAlpha (0 to 1) is how far the current frame is between
+	* the last Update() & the next one, so poses can be interpolated for smooth playback
+	* With a variable time step Update() always lands on the current frame & inAlpha is 1
+	*/
+	inline virtual void Interpolate(float inAlpha) {}
 	inline virtual void Render(float inAspectRation) {}
+	/**
+	* Render data handoff
+	* ExtractRenderData() is called after Update() & Interpolate(), it should copy everything a frame needs for rendering
+	* (matrix palettes, draw lists, camera) into packet inPacket
+	* RenderPacket() then renders one of those packets, by default it just calls Render()
+	* With -renderthread RenderPacket() runs on a separate render thread while the next frame is being updated,
+	* so it must only read from its own packet. Without it there's a single packet (0) & both run back to back
+	* SetRenderPacketCount() is called before Initialize() so packets can be allocated up front
+	*/
+	inline virtual void SetRenderPacketCount(unsigned int inCount) {}
+	inline virtual void ExtractRenderData(unsigned int inPacket) {}
+	inline virtual void RenderPacket(unsigned int inPacket, float inAspectRation) { Render(inAspectRation); }
+	/**
+	* Tool viewports (-viewports=N, see WindowManager.h) render the same packet right after RenderPacket(), each into a window
+	* & context of its own. Buffers, textures & programs are shared with the main context but VAOs, framebuffers & queries aren't,
+	* so anything created for the main window's framebuffers can't be used here. By default every viewport shows the main view
+	* Per frame data (palettes, instances, debug geometry) should be uploaded once in RenderPacket(), RenderView() only draws it
+	* again & EndRenderPacket() fences the StreamBuffers after the last viewport. Applications that do that return true from
+	* HasDrawOnlyViews(), the default RenderView() runs all of RenderPacket() again, so only StreamBuffer::kRegionCount - 1
+	* viewports are drawn for them, any more would wrap the ring within a single frame
+	*/
+	inline virtual void RenderView(unsigned int inView, unsigned int inPacket, float inAspectRation) { RenderPacket(inPacket, inAspectRation); }
+	inline virtual void EndRenderPacket(unsigned int inPacket) {}
+	inline virtual bool HasDrawOnlyViews() const { return false; }
+	/**
+	* Called after Initialize() with the starting client size & again whenever the window's client area changes size
+	* Size dependent resources (framebuffers, projection matrices) should be rebuilt here instead of being checked every frame
+	* Resize() is always called on the thread that renders
+	*/
+	inline virtual void Resize(int inWidth, int inHeight) {}
 	inline virtual void Shutdown() {}
 };
 
@@ -0,0 +1,95 @@
+#include "Arena.h"
+#include <iostream>
+
+thread_local LinearArena* gFrameArena = 0;
+LinearArena* gPersistentArena = 0;
+
+LinearArena::LinearArena(const char* inName, size_t inCapacity)
+{
+	mName = inName;
+	mCapacity = inCapacity;
+	mMemory = new unsigned char[inCapacity + kBaseAlignment];
+	size_t misalignment = (size_t)mMemory % kBaseAlignment;
+	mBase = mMemory + (misalignment == 0 ? 0 : kBaseAlignment - misalignment);
+	mOffset = 0;
+	mHighWater = 0;
+	mFailedAllocations = 0;
+}
+
+LinearArena::~LinearArena()
+{
+	delete[] mMemory;
+}
+
+void* LinearArena::Allocate(size_t inSize, size_t inAlignment)
+{
+	size_t offset = mOffset.load();
+	size_t aligned = 0;
+	size_t end = 0;
+	do
+	{
+		aligned = (offset + inAlignment - 1) & ~(inAlignment - 1);
+		end = aligned + inSize;
+		if (end > mCapacity)
+		{
+			// Keep track of what would have been needed, the memory itself is left alone
+			size_t highWater = mHighWater.load();
+			while (end > highWater && !mHighWater.compare_exchange_weak(highWater, end)) {}
+			if (mFailedAllocations++ == 0)
+			{
+				std::cout << "Arena " << mName << " is out of memory (" << mCapacity << " bytes), needed " << end << "\n";
+			}
+			return 0;
+		}
+	} while (!mOffset.compare_exchange_weak(offset, end));
+
+	size_t highWater = mHighWater.load();
+	while (end > highWater && !mHighWater.compare_exchange_weak(highWater, end)) {}
+	return mBase + aligned;
+}
+
+size_t LinearArena::GetMarker() const
+{
+	return mOffset.load();
+}
+
+void LinearArena::Rewind(size_t inMarker)
+{
+	if (inMarker <= mOffset.load()) { mOffset = inMarker; }
+}
+
+void LinearArena::Reset()
+{
+	mOffset = 0;
+}
+
+const char* LinearArena::GetName() const
+{
+	return mName;
+}
+
+size_t LinearArena::GetCapacity() const
+{
+	return mCapacity;
+}
+
+size_t LinearArena::GetUsed() const
+{
+	return mOffset.load();
+}
+
+size_t LinearArena::GetHighWaterMark() const
+{
+	return mHighWater.load();
+}
+
+unsigned int LinearArena::GetFailedAllocations() const
+{
+	return mFailedAllocations.load();
+}
+
+void LinearArena::ResetHighWaterMark()
+{
+	mHighWater = mOffset.load();
+	mFailedAllocations = 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef _H_ARENA_
+#define _H_ARENA_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+/**
+* LinearArena is a bump allocator over one block of memory that's reserved up front
+* Allocating is just moving an offset forward, nothing is ever freed individually, the whole arena is reset at once
+* This makes it a good fit for memory that only lives for one frame (transient poses, sort keys, draw lists)
+* Allocate() is safe to call from several threads (job system workers for example), Reset() & Rewind() are not
+* When the arena runs out Allocate() returns 0 & the size it would have needed is still recorded in the high water mark,
+* so the report tells how big the arena should be
+*/
+class LinearArena
+{
+private:
+	unsigned char* mMemory; // Raw block, mBase is mMemory aligned to kBaseAlignment
+	unsigned char* mBase;
+	size_t mCapacity;
+	std::atomic<size_t> mOffset;
+	std::atomic<size_t> mHighWater;
+	std::atomic<unsigned int> mFailedAllocations;
+	const char* mName;
+private:
+	LinearArena(const LinearArena&);
+	LinearArena& operator=(const LinearArena&);
+public:
+	static const size_t kBaseAlignment = 64;
+
+	LinearArena(const char* inName, size_t inCapacity);
+	~LinearArena();
+
+	// inAlignment has to be a power of two
+	void* Allocate(size_t inSize, size_t inAlignment = 16);
+	// Uninitialized storage for inCount objects of type T, only meant for types that don't need a destructor
+	template<typename T>
+	T* AllocateArray(size_t inCount);
+	// Constructs a T in the arena, its destructor is never called
+	template<typename T>
+	T* New();
+
+	// Everything allocated after GetMarker() can be released with Rewind(), useful for scratch memory inside a frame
+	size_t GetMarker() const;
+	void Rewind(size_t inMarker);
+	void Reset();
+
+	const char* GetName() const;
+	size_t GetCapacity() const;
+	size_t GetUsed() const;
+	size_t GetHighWaterMark() const;
+	unsigned int GetFailedAllocations() const;
+	void ResetHighWaterMark();
+};
+
+// Rewinds the arena to where it was when the scope was entered
+class ArenaScope
+{
+private:
+	LinearArena& mArena;
+	size_t mMarker;
+	ArenaScope(const ArenaScope&);
+	ArenaScope& operator=(const ArenaScope&);
+public:
+	inline ArenaScope(LinearArena& inArena) : mArena(inArena), mMarker(inArena.GetMarker()) {}
+	inline ~ArenaScope() { mArena.Rewind(mMarker); }
+};
+
+template<typename T>
+T* LinearArena::AllocateArray(size_t inCount)
+{
+	return (T*)Allocate(sizeof(T) * inCount, alignof(T) > 16 ? alignof(T) : 16);
+}
+
+template<typename T>
+T* LinearArena::New()
+{
+	void* memory = Allocate(sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+	return memory != 0 ? new (memory) T() : 0;
+}
+
+/**
+* gFrameArena is reset at the top of every frame, anything allocated from it is valid until the next frame starts
+* It's per thread: the WinMain thread's arena holds what Update() & ExtractRenderData() allocate, with -renderthread the
+* render thread has its own that's reset before each RenderPacket(). Frame packets may point into the update thread's arena,
+* the game loop keeps enough arenas in rotation that a packet's memory stays untouched until the packet was rendered
+* gPersistentArena is for Initialize() & lives until the application shuts down
+*/
+extern thread_local LinearArena* gFrameArena;
+extern LinearArena* gPersistentArena;
+
+#endif
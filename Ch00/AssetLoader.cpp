@@ -0,0 +1,230 @@
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#include "include/glad/glad.h"
+#include <Windows.h>
+#include <iostream>
+#include "AssetLoader.h"
+#include "Arena.h"
+#include "FrameClock.h"
+#include "RenderState.h"
+
+AssetLoader* gAssetLoader = 0;
+
+AssetLoader::AssetLoader()
+{
+	mOutstanding = 0;
+	mStopping = false;
+	mRunning = false;
+	mDeviceContext = 0;
+	mLoaderContext = 0;
+	mStartDone = false;
+	mContextCurrent = false;
+	mBusyTime = 0.0;
+}
+
+AssetLoader::~AssetLoader()
+{
+	Stop();
+}
+
+void AssetLoader::Start(void* inHDC, void* inLoaderContext)
+{
+	if (mRunning) { return; }
+	mDeviceContext = inHDC;
+	mLoaderContext = inLoaderContext;
+	mStopping = false;
+	if (mLoaderContext == 0) { return; }
+
+	// Submit() decides between the thread & the synchronous path, so it has to be known whether the context works before returning
+	mStartDone = false;
+	mContextCurrent = false;
+	mThread = std::thread(&AssetLoader::Run, this);
+	bool current = false;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		while (!mStartDone) { mStarted.wait(lock); }
+		current = mContextCurrent;
+	}
+	if (!current)
+	{
+		mThread.join();
+		std::cout << "The asset loader couldn't make its OpenGL context current, loading synchronously\n";
+		return;
+	}
+	mRunning = true;
+}
+
+void AssetLoader::Stop()
+{
+	if (mRunning)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mWake.notify_all();
+		mThread.join();
+		mRunning = false;
+	}
+
+	// Whatever is left never ran or finished after the last Update(), either way the owners get told
+	std::deque<Request> pending;
+	std::vector<Request> completed;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		pending.swap(mPending);
+		completed.swap(mCompleted);
+	}
+	for (unsigned int i = 0; i < completed.size(); ++i)
+	{
+		if (completed[i].complete != 0) { completed[i].complete(completed[i].userData, completed[i].success); }
+	}
+	for (unsigned int i = 0; i < pending.size(); ++i)
+	{
+		if (pending[i].complete != 0) { pending[i].complete(pending[i].userData, false); }
+	}
+	mOutstanding = 0;
+}
+
+bool AssetLoader::IsAsync() const
+{
+	return mRunning;
+}
+
+double AssetLoader::Execute(Request& inRequest)
+{
+	long long start = FrameClock::Now();
+	inRequest.success = inRequest.load(inRequest.userData);
+
+	// The upload isn't visible to other contexts in a reliable way until the GPU actually executed it
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (fence != 0)
+	{
+		GLenum result = GL_TIMEOUT_EXPIRED;
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100ms, checked in a loop
+		}
+		if (result == GL_WAIT_FAILED) { glFinish(); }
+		glDeleteSync(fence);
+	}
+
+	return FrameClock::ToSeconds(FrameClock::Now() - start);
+}
+
+void AssetLoader::Submit(LoadFn inLoad, CompleteFn inComplete, void* inUserData)
+{
+	Request request;
+	request.load = inLoad;
+	request.complete = inComplete;
+	request.userData = inUserData;
+	request.success = false;
+	++mOutstanding;
+
+	if (!mRunning)
+	{
+		// Synchronous fallback, the result is still delivered from Update() like an async load
+		double seconds = 0.0;
+		{
+			ArenaScope scope(*gFrameArena);
+			seconds = Execute(request);
+		}
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCompleted.push_back(request);
+		mBusyTime += seconds;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPending.push_back(request);
+	}
+	mWake.notify_one();
+}
+
+bool AssetLoader::Update()
+{
+	if (mOutstanding == 0) { return false; }
+
+	// Swapped out under the lock, the complete functions run without it so they can Submit() more loads
+	std::vector<Request> completed;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mCompleted.empty()) { return false; }
+		completed.swap(mCompleted);
+	}
+	for (unsigned int i = 0; i < completed.size(); ++i)
+	{
+		if (completed[i].complete != 0) { completed[i].complete(completed[i].userData, completed[i].success); }
+		--mOutstanding;
+	}
+	return mOutstanding == 0;
+}
+
+bool AssetLoader::IsLoading() const
+{
+	return mOutstanding > 0;
+}
+
+unsigned int AssetLoader::GetOutstandingCount() const
+{
+	return mOutstanding;
+}
+
+double AssetLoader::GetBusyTime()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mBusyTime;
+}
+
+void AssetLoader::Run()
+{
+	bool current = wglMakeCurrent((HDC)mDeviceContext, (HGLRC)mLoaderContext) != FALSE;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mContextCurrent = current;
+		mStartDone = true;
+	}
+	mStarted.notify_all();
+	if (!current)
+	{
+		wglDeleteContext((HGLRC)mLoaderContext);
+		mLoaderContext = 0;
+		return;
+	}
+
+	// Element array bindings need a VAO in a core context, loads go through a state cache of this context just like the main one
+	GLuint vertexArray = 0;
+	glGenVertexArrays(1, &vertexArray);
+	gRenderState = new RenderState();
+	gRenderState->BindVertexArray(vertexArray);
+	gFrameArena = new LinearArena("Loader", kScratchArenaSize);
+
+	while (true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			while (!mStopping && mPending.empty()) { mWake.wait(lock); }
+			if (mStopping) { break; }
+			request = mPending.front();
+			mPending.pop_front();
+		}
+
+		double seconds = Execute(request);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCompleted.push_back(request);
+		mBusyTime += seconds;
+	}
+
+	glBindVertexArray(0);
+	glDeleteVertexArrays(1, &vertexArray);
+	delete gRenderState;
+	gRenderState = 0;
+	delete gFrameArena;
+	gFrameArena = 0;
+	wglMakeCurrent(NULL, NULL);
+	wglDeleteContext((HGLRC)mLoaderContext);
+	mLoaderContext = 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#ifndef _H_ASSETLOADER_
+#define _H_ASSETLOADER_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+* AssetLoader runs asset loads on a thread of its own, so Initialize() can return right away & the window keeps presenting
+* The loading thread has a second OpenGL context that shares objects with the main one (created by WinMain with
+* wglCreateContextAttribsARB's share argument), so load functions can decode files & create buffers, textures & programs
+* After a load function returns the loader puts a fence in its context & waits for it on the loading thread, a load only
+* counts as complete once the GPU finished the upload, so the objects are safe to draw from any context
+*
+* Load functions run on the loading thread: they can't touch any state the Update thread owns
+* The loading thread binds a VAO & has a gRenderState of its own, so Mesh & texture uploads work there like anywhere else.
+* Its gFrameArena is a scratch arena that's rewound after every load (it's also what jobs the thread runs while it waits allocate from)
+* If the loader context can't be made current Start() falls back to loading synchronously
+* Complete functions, Application::OnAssetsReady() & everything else below run on the thread that called Start()
+*/
+class AssetLoader
+{
+public:
+	static const size_t kScratchArenaSize = 4 * 1024 * 1024;
+	// Returns false if the asset couldn't be loaded, inUserData is whatever was passed to Submit()
+	typedef bool (*LoadFn)(void* inUserData);
+	typedef void (*CompleteFn)(void* inUserData, bool inSuccess);
+private:
+	struct Request
+	{
+		LoadFn load;
+		CompleteFn complete;
+		void* userData;
+		bool success;
+	};
+	std::thread mThread;
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::deque<Request> mPending;
+	std::vector<Request> mCompleted; // Filled by the loading thread, drained by Update()
+	unsigned int mOutstanding; // Submitted but not yet handed to a complete function, main thread only
+	bool mStopping;
+	bool mRunning;
+	void* mDeviceContext;
+	void* mLoaderContext;
+	std::condition_variable mStarted;
+	bool mStartDone; // Set by the loading thread once it knows whether its context could be made current
+	bool mContextCurrent;
+	double mBusyTime; // Seconds the loading thread spent in load functions & waiting for fences
+private:
+	AssetLoader(const AssetLoader&);
+	AssetLoader& operator=(const AssetLoader&);
+	void Run();
+	// Returns the seconds spent, the caller adds them to mBusyTime under the lock
+	double Execute(Request& inRequest);
+public:
+	AssetLoader();
+	~AssetLoader();
+
+	/**
+	* inLoaderContext has to share objects with the main context & must not be current anywhere, the loading thread takes it over
+	* & deletes it when it stops. Without a context (0) the loader runs every load right inside Submit() on the calling thread,
+	* which needs the main context to be current there
+	*/
+	void Start(void* inHDC, void* inLoaderContext);
+	// Loads that haven't started are dropped (their complete function gets false), the one in progress is finished first
+	void Stop();
+	bool IsAsync() const;
+
+	// inComplete may be 0
+	void Submit(LoadFn inLoad, CompleteFn inComplete, void* inUserData);
+	/**
+	* Call once per frame, runs the complete functions of the loads that finished since the last call
+	* Returns true on the frame the last outstanding load was completed
+	*/
+	bool Update();
+	bool IsLoading() const;
+	unsigned int GetOutstandingCount() const;
+	double GetBusyTime();
+};
+
+// Created by WinMain before Application::Initialize(), Initialize() can queue its loads here
+extern AssetLoader* gAssetLoader;
+
+#endif
@@ -0,0 +1,305 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "Benchmark.h"
+#include "AllocationTracker.h"
+#include "CommandLine.h"
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+BenchmarkOptions ParseBenchmarkOptions(const char* inCmdLine)
+{
+	BenchmarkOptions result;
+	result.enabled = HasSwitch(inCmdLine, "benchmark");
+
+	int frames = GetSwitchInt(inCmdLine, "frames", 1000);
+	result.frames = frames > 0 ? (unsigned int)frames : 1000;
+	int warmup = GetSwitchInt(inCmdLine, "warmup", 60);
+	result.warmupFrames = warmup >= 0 ? (unsigned int)warmup : 0;
+	result.deltaTime = GetSwitchFloat(inCmdLine, "dt", 1.0f / 60.0f);
+	if (result.deltaTime <= 0.0f) { result.deltaTime = 1.0f / 60.0f; }
+	result.assertNoAllocations = HasSwitch(inCmdLine, "assertnoalloc");
+	if (!GetSwitchString(inCmdLine, "report", result.reportPath, sizeof(result.reportPath)))
+	{
+		strcpy(result.reportPath, "benchmark.csv");
+	}
+	return result;
+}
+
+// Summary over every measured frame, the profiler only keeps a rolling window. inRows skips the rows that are 0 in it
+static ProfileStats Summarize(const std::vector<float>& inSamples, unsigned int inColumn, unsigned int inStride, unsigned int inCount, const unsigned char* inRows = 0)
+{
+	ProfileStats result;
+	result.min = result.avg = result.p99 = result.max = 0.0f;
+	result.count = 0;
+
+	std::vector<float> sorted;
+	sorted.reserve(inCount);
+	double sum = 0.0;
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		if (inRows != 0 && inRows[i] == 0) { continue; }
+		sorted.push_back(inSamples[i * inStride + inColumn]);
+		sum += sorted.back();
+	}
+	inCount = (unsigned int)sorted.size();
+	result.count = inCount;
+	if (inCount == 0) { return result; }
+	std::sort(sorted.begin(), sorted.end());
+
+	unsigned int p99Index = (inCount * 99) / 100;
+	if (p99Index >= inCount) { p99Index = inCount - 1; }
+	result.min = sorted[0];
+	result.avg = (float)(sum / (double)inCount);
+	result.p99 = sorted[p99Index];
+	result.max = sorted[inCount - 1];
+	return result;
+}
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkOptions& inOptions)
+{
+	mOptions = inOptions;
+	mFrame = 0;
+	mMeasured = 0;
+	mFrameTimes.resize(mOptions.frames, 0.0f);
+	mCpuSamples.resize(mOptions.frames * kMaxColumns, 0.0f);
+	mGpuSamples.resize(mOptions.frames * kMaxColumns, 0.0f);
+	mGpuRecorded.resize(mOptions.frames, 0);
+	mFirstFrameIndex = 0;
+	mLastGpuFrame = -1;
+	mCounterSamples.resize(mOptions.frames * kMaxColumns, 0.0f);
+	mAllocationSamples.resize(mOptions.frames * kMaxColumns, 0.0f);
+	mFrameAllocations.resize(mOptions.frames, 0.0f);
+	mLastGlobalAllocations = 0;
+	mAllocatingFrames = 0;
+	mFirstAllocatingFrame = 0;
+	mFirstFrameAllocations = 0;
+	if (mOptions.assertNoAllocations && !IsAllocationTrackingEnabled())
+	{
+		std::cout << "-assertnoalloc needs allocation tracking, which is only compiled into debug builds\n";
+	}
+}
+
+float BenchmarkRunner::GetDeltaTime() const
+{
+	return mOptions.deltaTime;
+}
+
+bool BenchmarkRunner::IsWarmingUp() const
+{
+	return mFrame < mOptions.warmupFrames;
+}
+
+bool BenchmarkRunner::IsFinished() const
+{
+	return mMeasured >= mOptions.frames;
+}
+
+void BenchmarkRunner::RecordFrame(FrameProfiler& inProfiler)
+{
+	if (IsFinished()) { return; }
+	++mFrame;
+	// Everything between 2 calls is one frame of the whole process
+	unsigned long long globalAllocations = GetGlobalAllocationCounts().allocations;
+	unsigned long long frameAllocations = globalAllocations - mLastGlobalAllocations;
+	mLastGlobalAllocations = globalAllocations;
+	if (mFrame <= mOptions.warmupFrames)
+	{
+		// Warm up frames fill caches & compile shaders, don't let them pollute the rolling stats either
+		if (mFrame == mOptions.warmupFrames) { inProfiler.Reset(); }
+		return;
+	}
+
+	// RecordFrame() runs after EndFrame(), so the frame that was just measured is one before the profiler's current index
+	unsigned long long frameIndex = inProfiler.GetFrameIndex() - 1;
+	if (mMeasured == 0) { mFirstFrameIndex = frameIndex; }
+	unsigned int row = mMeasured * kMaxColumns;
+	mFrameTimes[mMeasured] = inProfiler.GetLastFrameTime();
+	mFrameAllocations[mMeasured] = (float)inProfiler.GetLastFrameAllocations();
+
+	unsigned int markers = std::min(inProfiler.GetMarkerCount(), kMaxColumns);
+	for (unsigned int i = 0; i < markers; ++i)
+	{
+		mCpuSamples[row + i] = inProfiler.GetMarkerLastCpu(i);
+		mAllocationSamples[row + i] = (float)inProfiler.GetMarkerLastAllocations(i);
+	}
+	// The first measured frame has no previous call to count from when there's no warm up
+	if (frameAllocations > 0 && mFrame > 1)
+	{
+		if (mAllocatingFrames == 0)
+		{
+			mFirstAllocatingFrame = mMeasured;
+			mFirstFrameAllocations = frameAllocations;
+		}
+		++mAllocatingFrames;
+	}
+	unsigned int counters = std::min(inProfiler.GetCounterCount(), kMaxColumns);
+	for (unsigned int i = 0; i < counters; ++i)
+	{
+		mCounterSamples[row + i] = inProfiler.GetCounterLast(i);
+	}
+	++mMeasured;
+
+	// The GPU results that came in this frame belong to an earlier row, results from before the first row are warm up frames
+	long long gpuFrame = inProfiler.GetLastGpuFrameIndex();
+	if (gpuFrame == mLastGpuFrame || gpuFrame < (long long)mFirstFrameIndex) { return; }
+	mLastGpuFrame = gpuFrame;
+	unsigned long long gpuRow = (unsigned long long)gpuFrame - mFirstFrameIndex;
+	if (gpuRow >= mMeasured) { return; }
+	for (unsigned int i = 0; i < markers; ++i) { mGpuSamples[gpuRow * kMaxColumns + i] = inProfiler.GetMarkerLastGpu(i); }
+	mGpuRecorded[gpuRow] = 1;
+}
+
+std::string BenchmarkRunner::GetMarkerPath(const FrameProfiler& inProfiler, unsigned int inMarker) const
+{
+	std::string result = inProfiler.GetMarkerName(inMarker);
+	for (int parent = inProfiler.GetMarkerParent(inMarker); parent >= 0; parent = inProfiler.GetMarkerParent(parent))
+	{
+		result = std::string(inProfiler.GetMarkerName(parent)) + "/" + result;
+	}
+	return result;
+}
+
+bool BenchmarkRunner::WriteReport(const FrameProfiler& inProfiler) const
+{
+	size_t length = strlen(mOptions.reportPath);
+	bool json = length > 5 && strcmp(mOptions.reportPath + length - 5, ".json") == 0;
+	bool result = json ? WriteJson(inProfiler) : WriteCsv(inProfiler);
+	if (result) { std::cout << "Benchmark report written to " << mOptions.reportPath << "\n"; }
+	else { std::cout << "Couldn't write benchmark report " << mOptions.reportPath << "\n"; }
+	return result;
+}
+
+bool BenchmarkRunner::CheckAssertions() const
+{
+	bool failed = false;
+	if (mOptions.assertNoAllocations && mAllocatingFrames > 0)
+	{
+		std::cout << "Benchmark assertion failed: the heap was allocated from in " << mAllocatingFrames << " of " << mMeasured << " measured frames (first at frame " << mFirstAllocatingFrame << ", " << mFirstFrameAllocations << " allocations, see the per marker allocs in the report)\n";
+		failed = true;
+	}
+	return failed;
+}
+
+bool BenchmarkRunner::WriteCsv(const FrameProfiler& inProfiler) const
+{
+	FILE* file = fopen(mOptions.reportPath, "w");
+	if (file == 0) { return false; }
+
+	unsigned int markers = std::min(inProfiler.GetMarkerCount(), kMaxColumns);
+	unsigned int counters = std::min(inProfiler.GetCounterCount(), kMaxColumns);
+
+	// One row per measured frame, every marker gets a cpu column & markers with GPU queries a gpu column as well (empty in rows without GPU results)
+	// Allocation columns are only written when the counts are tracked
+	bool allocations = IsAllocationTrackingEnabled();
+	fprintf(file, "frame,dt_ms,frame_ms");
+	if (allocations) { fprintf(file, ",frame_allocs"); }
+	for (unsigned int i = 0; i < markers; ++i)
+	{
+		std::string path = GetMarkerPath(inProfiler, i);
+		fprintf(file, ",%s_cpu_ms", path.c_str());
+		if (inProfiler.MarkerHasGpu(i)) { fprintf(file, ",%s_gpu_ms", path.c_str()); }
+		if (allocations) { fprintf(file, ",%s_allocs", path.c_str()); }
+	}
+	for (unsigned int i = 0; i < counters; ++i) { fprintf(file, ",%s", inProfiler.GetCounterName(i)); }
+	fprintf(file, "\n");
+
+	for (unsigned int frame = 0; frame < mMeasured; ++frame)
+	{
+		unsigned int row = frame * kMaxColumns;
+		fprintf(file, "%u,%.4f,%.4f", frame, mOptions.deltaTime * 1000.0f, mFrameTimes[frame]);
+		if (allocations) { fprintf(file, ",%g", mFrameAllocations[frame]); }
+		for (unsigned int i = 0; i < markers; ++i)
+		{
+			fprintf(file, ",%.4f", mCpuSamples[row + i]);
+			if (inProfiler.MarkerHasGpu(i))
+			{
+				if (mGpuRecorded[frame]) { fprintf(file, ",%.4f", mGpuSamples[row + i]); }
+				else { fprintf(file, ","); }
+			}
+			if (allocations) { fprintf(file, ",%g", mAllocationSamples[row + i]); }
+		}
+		for (unsigned int i = 0; i < counters; ++i) { fprintf(file, ",%g", mCounterSamples[row + i]); }
+		fprintf(file, "\n");
+	}
+
+	fclose(file);
+	return true;
+}
+
+static void WriteJsonStats(FILE* inFile, const char* inName, const ProfileStats& inStats)
+{
+	fprintf(inFile, "\"%s\": { \"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f, \"max\": %.4f }", inName, inStats.min, inStats.avg, inStats.p99, inStats.max);
+}
+
+bool BenchmarkRunner::WriteJson(const FrameProfiler& inProfiler) const
+{
+	FILE* file = fopen(mOptions.reportPath, "w");
+	if (file == 0) { return false; }
+
+	unsigned int markers = std::min(inProfiler.GetMarkerCount(), kMaxColumns);
+	unsigned int counters = std::min(inProfiler.GetCounterCount(), kMaxColumns);
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"frames\": %u,\n  \"warmupFrames\": %u,\n  \"dt\": %.6f,\n", mMeasured, mOptions.warmupFrames, mOptions.deltaTime);
+	bool allocations = IsAllocationTrackingEnabled();
+	fprintf(file, "  \"frame\": { ");
+	WriteJsonStats(file, "cpu", Summarize(mFrameTimes, 0, 1, mMeasured));
+	if (allocations)
+	{
+		fprintf(file, ", ");
+		WriteJsonStats(file, "allocs", Summarize(mFrameAllocations, 0, 1, mMeasured));
+	}
+	fprintf(file, " },\n");
+
+	fprintf(file, "  \"markers\": [\n");
+	for (unsigned int i = 0; i < markers; ++i)
+	{
+		fprintf(file, "    { \"name\": \"%s\", ", GetMarkerPath(inProfiler, i).c_str());
+		WriteJsonStats(file, "cpu", Summarize(mCpuSamples, i, kMaxColumns, mMeasured));
+		if (inProfiler.MarkerHasGpu(i))
+		{
+			fprintf(file, ", ");
+			WriteJsonStats(file, "gpu", Summarize(mGpuSamples, i, kMaxColumns, mMeasured, mGpuRecorded.empty() ? 0 : &mGpuRecorded[0]));
+		}
+		if (allocations)
+		{
+			fprintf(file, ", ");
+			WriteJsonStats(file, "allocs", Summarize(mAllocationSamples, i, kMaxColumns, mMeasured));
+		}
+		fprintf(file, " }%s\n", (i + 1 < markers) ? "," : "");
+	}
+	fprintf(file, "  ],\n");
+
+	fprintf(file, "  \"counters\": [\n");
+	for (unsigned int i = 0; i < counters; ++i)
+	{
+		fprintf(file, "    { \"name\": \"%s\", ", inProfiler.GetCounterName(i));
+		WriteJsonStats(file, "value", Summarize(mCounterSamples, i, kMaxColumns, mMeasured));
+		fprintf(file, " }%s\n", (i + 1 < counters) ? "," : "");
+	}
+	fprintf(file, "  ],\n");
+
+	// Per frame samples, same layout as the csv columns
+	fprintf(file, "  \"samples\": [\n");
+	for (unsigned int frame = 0; frame < mMeasured; ++frame)
+	{
+		unsigned int row = frame * kMaxColumns;
+		fprintf(file, "    { \"frame_ms\": %.4f, \"cpu\": [", mFrameTimes[frame]);
+		for (unsigned int i = 0; i < markers; ++i) { fprintf(file, "%s%.4f", i ? ", " : "", mCpuSamples[row + i]); }
+		fprintf(file, "], \"gpu\": ");
+		if (mGpuRecorded[frame])
+		{
+			fprintf(file, "[");
+			for (unsigned int i = 0; i < markers; ++i) { fprintf(file, "%s%.4f", i ? ", " : "", mGpuSamples[row + i]); }
+			fprintf(file, "]");
+		}
+		else { fprintf(file, "null"); }
+		fprintf(file, " }%s\n", (frame + 1 < mMeasured) ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+
+	fclose(file);
+	return true;
+}
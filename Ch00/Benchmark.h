@@ -0,0 +1,81 @@
+#pragma once
+#ifndef _H_BENCHMARK_
+#define _H_BENCHMARK_
+
+#include <vector>
+#include <string>
+
+class FrameProfiler;
+
+/**
+* Options for the headless benchmark mode, parsed from the command line:
+* -benchmark               enables the mode (hidden window, vsync off, fixed dt)
+* -frames=N                number of measured frames (default 1000)
+* -warmup=N                frames that run before measuring starts (default 60)
+* -dt=seconds              fixed delta time passed to Update() (default 1/60)
+* -report=file.csv|.json   where the results are written (default benchmark.csv), the extension picks the format
+* -assertnoalloc           fails the run if any thread (Update, the render thread, job workers...) allocates from the heap in
+*                          any measured frame, needs allocation tracking (debug builds), see AllocationTracker.h
+* -renderthread isn't supported: the report comes from the WinMain thread's profiler, WinMain refuses to start with both
+*/
+struct BenchmarkOptions
+{
+	bool enabled;
+	unsigned int frames;
+	unsigned int warmupFrames;
+	float deltaTime;
+	bool assertNoAllocations;
+	char reportPath[260];
+};
+
+BenchmarkOptions ParseBenchmarkOptions(const char* inCmdLine);
+
+/**
+* BenchmarkRunner records the per frame timings of the profiler while the Application runs for a fixed number of frames
+* All storage is reserved up front so recording a frame doesn't allocate
+* GPU times arrive FrameProfiler::kGpuLatency frames after the CPU times, they're written into the row of the frame they were
+* measured in. Rows without GPU results (the last few frames & frames whose queries weren't ready) are left out of the GPU stats
+*/
+class BenchmarkRunner
+{
+public:
+	static const unsigned int kMaxColumns = 64;
+private:
+	BenchmarkOptions mOptions;
+	unsigned int mFrame; // Frames run so far, including warm up
+	unsigned int mMeasured;
+	std::vector<float> mFrameTimes;
+	std::vector<float> mCpuSamples; // mOptions.frames * kMaxColumns, a column for every profiler marker
+	std::vector<float> mGpuSamples;
+	std::vector<unsigned char> mGpuRecorded; // mOptions.frames flags, 1 once a row's GPU times arrived
+	unsigned long long mFirstFrameIndex; // Profiler frame index of row 0
+	long long mLastGpuFrame; // Last GPU frame that was written, see FrameProfiler::GetLastGpuFrameIndex()
+	std::vector<float> mCounterSamples;
+	std::vector<float> mAllocationSamples; // Same layout as mCpuSamples
+	std::vector<float> mFrameAllocations;
+	// -assertnoalloc uses the process wide count, so every thread is covered & not just the markers of this thread's profiler
+	unsigned long long mLastGlobalAllocations; // At the previous RecordFrame()
+	unsigned int mAllocatingFrames; // Measured frames where anything allocated
+	unsigned int mFirstAllocatingFrame;
+	unsigned long long mFirstFrameAllocations;
+private:
+	BenchmarkRunner(const BenchmarkRunner&);
+	BenchmarkRunner& operator=(const BenchmarkRunner&);
+	std::string GetMarkerPath(const FrameProfiler& inProfiler, unsigned int inMarker) const;
+	bool WriteCsv(const FrameProfiler& inProfiler) const;
+	bool WriteJson(const FrameProfiler& inProfiler) const;
+public:
+	BenchmarkRunner(const BenchmarkOptions& inOptions);
+
+	float GetDeltaTime() const;
+	bool IsWarmingUp() const;
+	bool IsFinished() const;
+	// Call once per frame after FrameProfiler::EndFrame()
+	void RecordFrame(FrameProfiler& inProfiler);
+	// Writes the report to mOptions.reportPath
+	bool WriteReport(const FrameProfiler& inProfiler) const;
+	// True if one of the assertions requested on the command line failed, prints why
+	bool CheckAssertions() const;
+};
+
+#endif
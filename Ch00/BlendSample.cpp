@@ -0,0 +1,361 @@
+#include "BlendSample.h"
+#include "Pose.h"
+#include "Arena.h"
+#include "FrameProfiler.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+static const float kSwitchInterval = 3.0f;
+static const float kFadeTime = 0.5f;
+// Bounding sphere of a character around its root, the chain is 3.75 units tall & sways a little
+static const float kBoundsHeight = 1.9f;
+static const float kBoundsRadius = 2.2f;
+
+BlendSample::BlendSample(unsigned int inCharacterCount, SkinningMode inMode, PaletteStorage inStorage) : SkinningSample(inCharacterCount, inMode, inStorage)
+{
+	mRestPose = 0;
+	mLeanReference = 0;
+	for (unsigned int i = 0; i < kJointsPerCharacter; ++i) { mUpperBodyMask[i] = 0.0f; }
+	mUseAnimationLOD = false;
+	mUseIK = false;
+	mIKSolver = IKSolverType::CCD;
+	mIKMaxIterations = 0;
+	mIKMaxMilliseconds = 0.0f;
+	mIKRootHeight = 0.0f;
+	mIKReach = 0.0f;
+	mIKRequestCount = 0;
+	mIKSettings.tolerance = 0.002f;
+}
+
+BlendSample::~BlendSample()
+{
+	Shutdown();
+}
+
+void BlendSample::SetAnimationLOD(bool inEnabled)
+{
+	mUseAnimationLOD = inEnabled;
+}
+
+void BlendSample::SetIK(IKSolverType inSolver, unsigned int inMaxIterations, float inMaxMilliseconds)
+{
+	mUseIK = true;
+	mIKSolver = inSolver;
+	mIKMaxIterations = inMaxIterations;
+	mIKMaxMilliseconds = inMaxMilliseconds;
+}
+
+// Looping rotation track on every joint in [inFirst, inLast) that swings around inAxis, inKeys keys spread over inDuration
+static void AddSwingTracks(Clip& outClip, unsigned int inFirst, unsigned int inLast, const vec3& inAxis, float inAngle, float inDuration, unsigned int inKeys)
+{
+	for (unsigned int joint = inFirst; joint < inLast; ++joint)
+	{
+		QuaternionTrack& track = outClip.GetTrackForJoint(joint).rotation;
+		track.Resize(inKeys);
+		track.SetInterpolation(Interpolation::Linear);
+		for (unsigned int k = 0; k < inKeys; ++k)
+		{
+			float t = (float)k / (float)(inKeys - 1);
+			float angle = sinf(t * 6.2831853f + (float)joint * 0.4f) * inAngle;
+			track.SetKey(k, t * inDuration, angleAxis(angle, inAxis));
+		}
+	}
+}
+
+void BlendSample::BuildClips()
+{
+	mClips[ClipSway].SetName("Sway");
+	AddSwingTracks(mClips[ClipSway], 1, kJointsPerCharacter, vec3(0, 0, 1), 0.15f, 2.0f, 9);
+	mClips[ClipTwist].SetName("Twist");
+	AddSwingTracks(mClips[ClipTwist], 1, kJointsPerCharacter, vec3(0, 1, 0), 0.2f, 3.0f, 13);
+	mClips[ClipNod].SetName("Nod");
+	AddSwingTracks(mClips[ClipNod], kJointsPerCharacter / 2, kJointsPerCharacter, vec3(1, 0, 0), 0.25f, 1.0f, 5);
+	mClips[ClipLean].SetName("Lean");
+	AddSwingTracks(mClips[ClipLean], 1, kJointsPerCharacter / 2, vec3(1, 0, 0), 0.1f, 4.0f, 9);
+	for (unsigned int i = 0; i < ClipCount; ++i)
+	{
+		mClips[i].SetLooping(true);
+		mClips[i].RecalculateDuration();
+	}
+}
+
+void BlendSample::Initialize()
+{
+	// The base class' pose only provides the skeleton here, Update() fills the palettes from the blended scratch pose
+	SkinningSample::Initialize();
+	if (!mReady) { return; }
+
+	mRestPose = new Pose(kJointsPerCharacter, *gPersistentArena);
+	mLeanReference = new Pose(kJointsPerCharacter, *gPersistentArena);
+	if (!mRestPose->IsValid() || !mLeanReference->IsValid())
+	{
+		std::cout << "BlendSample: the persistent arena is too small\n";
+		Shutdown();
+		return;
+	}
+	// Every character shares the rest pose of character 0, its root is moved into place after blending
+	for (unsigned int k = 0; k < kJointsPerCharacter; ++k)
+	{
+		mRestPose->SetParent(k, mPose->GetParent(k));
+		mRestPose->SetLocal(k, (k == 0) ? vec3() : mPose->GetPositions()[k], quat(), vec3(1, 1, 1));
+		// Upper body mask with a soft edge
+		float t = (float)k - (float)(kJointsPerCharacter / 2) + 1.0f;
+		mUpperBodyMask[k] = (t <= 0.0f) ? 0.0f : (t >= 2.0f ? 1.0f : t * 0.5f);
+	}
+
+	BuildClips();
+	MakeReferencePose(mClips[ClipLean], 0.0f, *mRestPose, *mLeanReference);
+	unsigned int maxCursors = 0;
+	for (unsigned int i = 0; i < ClipCount; ++i) { maxCursors = (mClips[i].GetCursorCount() > maxCursors) ? mClips[i].GetCursorCount() : maxCursors; }
+
+	mCharacters.resize(mCharacterCount);
+	for (unsigned int c = 0; c < mCharacterCount; ++c)
+	{
+		Character& character = mCharacters[c];
+		character.base.ReserveCursors(maxCursors);
+		character.layers.ReserveCursors(maxCursors);
+		character.base.Play(&mClips[(c & 1) ? ClipTwist : ClipSway]);
+		character.layers.AddLayer(&mClips[ClipNod], LayerBlend::Override, 0.8f, mUpperBodyMask, 0);
+		character.layers.AddLayer(&mClips[ClipLean], LayerBlend::Additive, 1.0f, 0, mLeanReference);
+		// Spread the switches out so the crowd doesn't fade in lock step
+		character.switchTimer = (float)(c % 31) / 31.0f * kSwitchInterval;
+		character.layers.GetPlayer(0).SetTime((float)(c % 7) * 0.13f);
+		if (mUseAnimationLOD)
+		{
+			character.from = Pose(kJointsPerCharacter, *gPersistentArena);
+			character.to = Pose(kJointsPerCharacter, *gPersistentArena);
+			if (!character.from.IsValid() || !character.to.IsValid())
+			{
+				std::cout << "BlendSample: the persistent arena is too small for the animation LOD poses\n";
+				Shutdown();
+				return;
+			}
+			character.to.CopyFrom(*mRestPose);
+		}
+	}
+	std::cout << "BlendSample: " << ClipCount << " clips, 1 crossfade & " << mCharacters[0].layers.Size() << " layers per character\n";
+	if (mUseAnimationLOD)
+	{
+		mAnimationLOD.Initialize(mCharacterCount, kJointsPerCharacter);
+		mAnimationLOD.SetFieldOfView(GetFieldOfView());
+		std::cout << "BlendSample: animation LOD with " << mAnimationLOD.GetLevelCount() << " levels\n";
+	}
+
+	if (mUseIK)
+	{
+		unsigned int length = (mIKSolver == IKSolverType::TwoBone) ? 3 : 6;
+		if (!mIKChain.Build(*mRestPose, kJointsPerCharacter - 1, length))
+		{
+			mUseIK = false;
+			return;
+		}
+		const vec3* positions = mRestPose->GetPositions();
+		mIKRootHeight = 0.0f;
+		for (unsigned int k = 1; k <= mIKChain.joints[0]; ++k) { mIKRootHeight += positions[k].y; }
+		mIKReach = 0.0f;
+		for (unsigned int k = 1; k < length; ++k) { mIKReach += len(positions[mIKChain.joints[k]]); }
+
+		mIKPoses.resize(mCharacterCount);
+		for (unsigned int c = 0; c < mCharacterCount; ++c)
+		{
+			mIKPoses[c] = Pose(kJointsPerCharacter, *gPersistentArena);
+			if (!mIKPoses[c].IsValid())
+			{
+				std::cout << "BlendSample: the persistent arena is too small for the IK poses\n";
+				Shutdown();
+				return;
+			}
+		}
+		mIKRequests.resize(mCharacterCount);
+		mIKQueued.assign(mCharacterCount, 0);
+		mIKCharacters.resize(mCharacterCount);
+		std::cout << "BlendSample: " << GetIKSolverName(mIKSolver) << " IK on the top " << length << " joints\n";
+	}
+}
+
+Pose& BlendSample::GetOutputPose(unsigned int inCharacter, Pose& inScratch)
+{
+	return mUseIK ? mIKPoses[inCharacter] : inScratch;
+}
+
+void BlendSample::FinishCharacter(unsigned int inCharacter, Pose& inPose)
+{
+	inPose.GetPositions()[0] = GetCharacterPosition(inCharacter);
+	if (!mUseIK)
+	{
+		inPose.GetSkinMatrices(mInverseBindPose, mPalettes + inCharacter * kJointsPerCharacter);
+		return;
+	}
+
+	float phase = mTime * 1.3f + (float)inCharacter * 0.9f;
+	vec3 offset(sinf(phase) * mIKReach * 0.5f, mIKRootHeight + mIKReach * 0.7f, cosf(phase) * mIKReach * 0.5f);
+	IKRequest& request = mIKRequests[inCharacter];
+	request.pose = &inPose;
+	request.chain = &mIKChain;
+	request.solver = mIKSolver;
+	request.target = GetCharacterPosition(inCharacter) + offset;
+	// Bend towards +z
+	request.pole = GetCharacterPosition(inCharacter) + vec3(0.0f, mIKRootHeight + mIKReach * 0.5f, 2.0f);
+	request.usePole = true;
+	mIKQueued[inCharacter] = 1;
+}
+
+void BlendSample::SolveIK()
+{
+	if (!mUseIK) { return; }
+	// Packed in character order, so the budget is handed out the same way every frame
+	mIKRequestCount = 0;
+	for (unsigned int c = 0; c < mCharacterCount; ++c)
+	{
+		if (mIKQueued[c] == 0) { continue; }
+		mIKQueued[c] = 0;
+		if (mIKRequestCount != c) { mIKRequests[mIKRequestCount] = mIKRequests[c]; }
+		mIKCharacters[mIKRequestCount] = c;
+		++mIKRequestCount;
+	}
+	mIKBudget.Reset(mIKMaxIterations, mIKMaxMilliseconds);
+	SolveMany(mIKRequests.empty() ? 0 : &mIKRequests[0], mIKRequestCount, mIKSettings, &mIKBudget, gJobSystem);
+	for (unsigned int i = 0; i < mIKRequestCount; ++i)
+	{
+		unsigned int c = mIKCharacters[i];
+		mIKRequests[i].pose->GetSkinMatrices(mInverseBindPose, mPalettes + c * kJointsPerCharacter);
+	}
+	mIKRequestCount = 0;
+}
+
+void BlendSample::UpdateSwitchTimer(Character& ioCharacter, float inDeltaTime)
+{
+	ioCharacter.switchTimer -= inDeltaTime;
+	if (ioCharacter.switchTimer <= 0.0f)
+	{
+		ioCharacter.switchTimer += kSwitchInterval;
+		const Clip* next = (ioCharacter.base.GetTargetClip() == &mClips[ClipSway]) ? &mClips[ClipTwist] : &mClips[ClipSway];
+		ioCharacter.base.FadeTo(next, kFadeTime);
+	}
+}
+
+unsigned int BlendSample::Evaluate(Character& ioCharacter, float inDeltaTime, Pose& outPose)
+{
+	ioCharacter.base.Update(inDeltaTime, *mRestPose, outPose);
+	ioCharacter.layers.Apply(inDeltaTime, outPose);
+	return ioCharacter.base.GetActiveClipCount() + ioCharacter.layers.GetActiveClipCount();
+}
+
+void BlendSample::GetCamera(vec3& outEye, vec3& outTarget) const
+{
+	if (!mUseAnimationLOD)
+	{
+		SkinningSample::GetCamera(outEye, outTarget);
+		return;
+	}
+	// Circles inside the crowd looking along the circle, so there are close, distant & culled characters every frame
+	unsigned int side = (unsigned int)ceilf(sqrtf((float)mCharacterCount));
+	vec3 center = GetCharacterPosition(side * side - 1) * 0.5f;
+	float radius = (center.x > center.z ? center.x : center.z) * 0.5f;
+	float angle = mTime * 0.15f;
+	outEye = center + vec3(cosf(angle) * radius, 3.0f, sinf(angle) * radius);
+	outTarget = outEye + vec3(-sinf(angle) * 10.0f, -1.5f, cosf(angle) * 10.0f);
+}
+
+unsigned int BlendSample::BlendRange(unsigned int inBegin, unsigned int inEnd, float inDeltaTime)
+{
+	Pose scratch(kJointsPerCharacter, *gFrameArena);
+	if (!scratch.IsValid()) { return 0; }
+	unsigned int activeClips = 0;
+	for (unsigned int c = inBegin; c < inEnd; ++c)
+	{
+		Character& character = mCharacters[c];
+		UpdateSwitchTimer(character, inDeltaTime);
+		Pose& pose = GetOutputPose(c, scratch);
+		activeClips += Evaluate(character, inDeltaTime, pose);
+		FinishCharacter(c, pose);
+	}
+	return activeClips;
+}
+
+void BlendSample::Update(float inDeltaTime)
+{
+	if (!mReady || mRestPose == 0) { return; }
+	mTime += inDeltaTime;
+	if (mUseAnimationLOD)
+	{
+		UpdateWithLOD(inDeltaTime);
+		return;
+	}
+
+	PROFILE_SCOPE("Blend");
+	std::atomic<unsigned int> activeClips(0);
+	auto blend = [this, inDeltaTime, &activeClips](unsigned int inBegin, unsigned int inEnd) { activeClips += BlendRange(inBegin, inEnd, inDeltaTime); };
+	if (gJobSystem != 0) { gJobSystem->ParallelFor(mCharacterCount, kCharactersPerJob, blend); }
+	else { blend(0, mCharacterCount); }
+	SolveIK();
+	if (gProfiler != 0) { gProfiler->AddCounter("Active clips", (float)activeClips.load()); }
+}
+
+unsigned int BlendSample::BlendRangeWithLOD(unsigned int inBegin, unsigned int inEnd, float inDeltaTime)
+{
+	Pose scratch(kJointsPerCharacter, *gFrameArena);
+	if (!scratch.IsValid()) { return 0; }
+	unsigned int activeClips = 0;
+	for (unsigned int c = inBegin; c < inEnd; ++c)
+	{
+		Character& character = mCharacters[c];
+		const AnimationLODInstance& lod = mAnimationLOD.GetInstance(c);
+		UpdateSwitchTimer(character, inDeltaTime);
+		if (lod.update)
+		{
+			// The last period always runs to alpha 1, so the pose on screen is the old target
+			std::swap(character.from, character.to);
+			// Joints past the level's count hold the rest pose
+			character.to.CopyFrom(*mRestPose);
+			Pose view = character.to.MakeView(mAnimationLOD.GetJointCount(c));
+			activeClips += Evaluate(character, inDeltaTime * (float)lod.period, view);
+		}
+
+		mVisible[c] = lod.visible ? 1 : 0;
+		if (!lod.visible) { continue; }
+		Pose& pose = GetOutputPose(c, scratch);
+		if (lod.alpha >= 1.0f) { pose.CopyFrom(character.to); }
+		else { BlendPoses(character.from, character.to, lod.alpha, pose); }
+		FinishCharacter(c, pose);
+	}
+	return activeClips;
+}
+
+void BlendSample::UpdateWithLOD(float inDeltaTime)
+{
+	PROFILE_SCOPE("Blend");
+	vec3 eye, target;
+	GetCamera(eye, target);
+	Frustum frustum(GetViewProjection(eye, target, mAspectRatio));
+	vec3* centers = gFrameArena->AllocateArray<vec3>(mCharacterCount);
+	if (centers == 0) { return; }
+	for (unsigned int c = 0; c < mCharacterCount; ++c) { centers[c] = GetCharacterPosition(c) + vec3(0.0f, kBoundsHeight, 0.0f); }
+	mAnimationLOD.Schedule(frustum, eye, centers, kBoundsRadius);
+
+	std::atomic<unsigned int> activeClips(0);
+	auto blend = [this, inDeltaTime, &activeClips](unsigned int inBegin, unsigned int inEnd) { activeClips += BlendRangeWithLOD(inBegin, inEnd, inDeltaTime); };
+	if (gJobSystem != 0) { gJobSystem->ParallelFor(mCharacterCount, kCharactersPerJob, blend); }
+	else { blend(0, mCharacterCount); }
+	SolveIK();
+	if (gProfiler != 0) { gProfiler->AddCounter("Active clips", (float)activeClips.load()); }
+}
+
+void BlendSample::Shutdown()
+{
+	// The pose arrays belong to gPersistentArena
+	delete mRestPose;
+	delete mLeanReference;
+	mRestPose = 0;
+	mLeanReference = 0;
+	mCharacters.clear();
+	mIKPoses.clear();
+	mIKRequests.clear();
+	mIKQueued.clear();
+	mIKCharacters.clear();
+	mIKRequestCount = 0;
+	SkinningSample::Shutdown();
+}
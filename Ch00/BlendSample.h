@@ -0,0 +1,94 @@
+#pragma once
+#ifndef _H_BLENDSAMPLE_
+#define _H_BLENDSAMPLE_
+
+#include "SkinningSample.h"
+#include "Blending.h"
+#include "Clip.h"
+#include "AnimationLOD.h"
+#include "IKSolver.h"
+#include "Pose.h"
+#include <vector>
+
+/**
+* Blend tree stress test (-sample=blend, -characters=N), rendered like SkinningSample
+* Every character crossfades between two base clips every few seconds, an upper body layer (masked override) & an additive lean
+* play on top, so 3 to 5 clips are active per character. The blended pose goes straight into the skin palette
+* with Pose::GetSkinMatrices(), the only pose per character is a scratch pose from gFrameArena
+* The characters are blended in batches on gJobSystem, each batch takes its scratch pose from the frame arena of the thread it runs on
+* -animlod flies the camera through the crowd & hands the characters to AnimationLOD: distant ones are evaluated every 2nd or
+* 4th frame with fewer joints & interpolated in between, culled ones are evaluated every 8th frame & never blended or skinned
+* -ik=ccd|fabrik|twobone makes the top of every visible character reach for a target circling above it after blending,
+* solved in one SolveMany() batch on gJobSystem. -ikbudget=N & -ikms=F cap the iterations & milliseconds per frame
+*/
+class BlendSample : public SkinningSample
+{
+public:
+	enum ClipId
+	{
+		ClipSway = 0,
+		ClipTwist,
+		ClipNod,
+		ClipLean,
+		ClipCount
+	};
+protected:
+	struct Character
+	{
+		CrossFadeController base;
+		LayerStack layers;
+		float switchTimer;
+		// -animlod only, the last two evaluated poses
+		Pose from;
+		Pose to;
+	};
+	Clip mClips[ClipCount];
+	Pose* mRestPose;
+	Pose* mLeanReference;
+	float mUpperBodyMask[kJointsPerCharacter];
+	std::vector<Character> mCharacters;
+	AnimationLOD mAnimationLOD;
+	bool mUseAnimationLOD;
+	// IK runs on a pose per character so the whole crowd can be solved in one batch, then skinned
+	bool mUseIK;
+	IKSolverType mIKSolver;
+	IKSettings mIKSettings;
+	IKBudget mIKBudget;
+	unsigned int mIKMaxIterations;
+	float mIKMaxMilliseconds;
+	IKChain mIKChain;
+	float mIKRootHeight; // Rest height of the chain's first joint above the character's root
+	float mIKReach;
+	std::vector<Pose> mIKPoses;
+	// Every character queues its request in its own slot & SolveIK() packs them, so characters can be finished in any order
+	std::vector<IKRequest> mIKRequests;
+	std::vector<unsigned char> mIKQueued;
+	std::vector<unsigned int> mIKCharacters; // Character of every packed request
+	unsigned int mIKRequestCount;
+protected:
+	void BuildClips();
+	void UpdateSwitchTimer(Character& ioCharacter, float inDeltaTime);
+	// Advances both controllers by inDeltaTime & writes the blend into outPose, returns the number of active clips
+	unsigned int Evaluate(Character& ioCharacter, float inDeltaTime, Pose& outPose);
+	// Blends & finishes the characters in [inBegin, inEnd), runs on gJobSystem. Returns the number of active clips
+	unsigned int BlendRange(unsigned int inBegin, unsigned int inEnd, float inDeltaTime);
+	unsigned int BlendRangeWithLOD(unsigned int inBegin, unsigned int inEnd, float inDeltaTime);
+	void UpdateWithLOD(float inDeltaTime);
+	// Skins the pose right away, or queues it for SolveIK() when IK is on. inPose is the character's IK pose in that case
+	void FinishCharacter(unsigned int inCharacter, Pose& inPose);
+	Pose& GetOutputPose(unsigned int inCharacter, Pose& inScratch);
+	void SolveIK();
+	void GetCamera(vec3& outEye, vec3& outTarget) const;
+public:
+	BlendSample(unsigned int inCharacterCount, SkinningMode inMode, PaletteStorage inStorage);
+	~BlendSample();
+	// Call before Initialize()
+	void SetAnimationLOD(bool inEnabled);
+	// inMaxIterations & inMaxMilliseconds are the per frame budget of the whole crowd, 0 for no limit
+	void SetIK(IKSolverType inSolver, unsigned int inMaxIterations, float inMaxMilliseconds);
+	void Initialize();
+	void Update(float inDeltaTime);
+	void Shutdown();
+};
+
+#endif
@@ -0,0 +1,332 @@
+#include "Blending.h"
+#include "Pose.h"
+#include "Clip.h"
+#include "Arena.h"
+#include <iostream>
+
+void BlendPosesMasked(const Pose& inA, const Pose& inB, const float* inJointWeights, float inT, Pose& outResult)
+{
+	unsigned int count = outResult.Size();
+	if (inA.Size() < count || inB.Size() < count)
+	{
+		std::cout << "BlendPosesMasked() needs input poses with at least " << count << " joints\n";
+		return;
+	}
+
+	// The kernels take a weight per element, so the mask is scaled once up front
+	ArenaScope scope(*gFrameArena);
+	float* weights = gFrameArena->AllocateArray<float>(count);
+	if (weights == 0) { return; }
+	for (unsigned int i = 0; i < count; ++i) { weights[i] = inJointWeights[i] * inT; }
+
+	LerpArray(inA.GetPositions(), inB.GetPositions(), weights, outResult.GetPositions(), count);
+	LerpArray(inA.GetScales(), inB.GetScales(), weights, outResult.GetScales(), count);
+	NlerpArray(inA.GetRotations(), inB.GetRotations(), weights, outResult.GetRotations(), count);
+}
+
+void AddPoses(const Pose& inBase, const Pose& inAdditive, const Pose& inReference, float inWeight, const float* inJointWeights, Pose& outResult)
+{
+	unsigned int count = outResult.Size();
+	if (inBase.Size() < count || inAdditive.Size() < count || inReference.Size() < count)
+	{
+		std::cout << "AddPoses() needs input poses with at least " << count << " joints\n";
+		return;
+	}
+
+	ArenaScope scope(*gFrameArena);
+	vec3* delta = gFrameArena->AllocateArray<vec3>(count);
+	quat* rotations = gFrameArena->AllocateArray<quat>(count);
+	quat* identity = gFrameArena->AllocateArray<quat>(count);
+	float* weights = (inJointWeights != 0) ? gFrameArena->AllocateArray<float>(count) : 0;
+	if (delta == 0 || rotations == 0 || identity == 0 || (inJointWeights != 0 && weights == 0)) { return; }
+
+	const quat* reference = inReference.GetRotations();
+	const quat* additive = inAdditive.GetRotations();
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		// Unit quaternions, so the conjugate is the inverse
+		rotations[i] = conjugate(reference[i]) * additive[i];
+		identity[i] = quat();
+	}
+	if (weights != 0)
+	{
+		for (unsigned int i = 0; i < count; ++i) { weights[i] = inJointWeights[i] * inWeight; }
+		NlerpArray(identity, rotations, weights, rotations, count);
+	}
+	else
+	{
+		NlerpArray(identity, rotations, inWeight, rotations, count);
+	}
+	MultiplyArray(inBase.GetRotations(), rotations, outResult.GetRotations(), count);
+
+	// Positions & scales: base + (additive - reference) * weight
+	const vec3* arrays[2][3] = {
+		{ inBase.GetPositions(), inAdditive.GetPositions(), inReference.GetPositions() },
+		{ inBase.GetScales(), inAdditive.GetScales(), inReference.GetScales() }
+	};
+	vec3* outArrays[2] = { outResult.GetPositions(), outResult.GetScales() };
+	for (unsigned int a = 0; a < 2; ++a)
+	{
+		for (unsigned int i = 0; i < count; ++i) { delta[i] = arrays[a][1][i] - arrays[a][2][i]; }
+		if (weights != 0)
+		{
+			for (unsigned int i = 0; i < count; ++i) { delta[i] = delta[i] * weights[i]; }
+			MultiplyAddArray(arrays[a][0], delta, 1.0f, outArrays[a], count);
+		}
+		else
+		{
+			MultiplyAddArray(arrays[a][0], delta, inWeight, outArrays[a], count);
+		}
+	}
+}
+
+void MakeReferencePose(const Clip& inClip, float inTime, const Pose& inRestPose, Pose& outReference)
+{
+	outReference.CopyFrom(inRestPose);
+	inClip.Sample(outReference, inTime, 0);
+}
+
+ClipPlayer::ClipPlayer()
+{
+	mClip = 0;
+	mTime = 0.0f;
+	mSpeed = 1.0f;
+}
+
+void ClipPlayer::SetClip(const Clip* inClip, float inTime)
+{
+	mClip = inClip;
+	mTime = inTime;
+	mCursors.assign(inClip != 0 ? inClip->GetCursorCount() : 0, TrackCursor());
+}
+
+void ClipPlayer::ReserveCursors(unsigned int inCount)
+{
+	mCursors.reserve(inCount);
+}
+
+void ClipPlayer::Update(float inDeltaTime, Pose& ioPose)
+{
+	if (mClip == 0) { return; }
+	mTime = mClip->Sample(ioPose, mTime + inDeltaTime * mSpeed, mCursors.empty() ? 0 : &mCursors[0]);
+}
+
+void ClipPlayer::Swap(ClipPlayer& inOther)
+{
+	const Clip* clip = mClip;
+	float time = mTime;
+	float speed = mSpeed;
+	mClip = inOther.mClip;
+	mTime = inOther.mTime;
+	mSpeed = inOther.mSpeed;
+	inOther.mClip = clip;
+	inOther.mTime = time;
+	inOther.mSpeed = speed;
+	mCursors.swap(inOther.mCursors);
+}
+
+const Clip* ClipPlayer::GetClip() const
+{
+	return mClip;
+}
+
+float ClipPlayer::GetTime() const
+{
+	return mTime;
+}
+
+void ClipPlayer::SetTime(float inTime)
+{
+	mTime = inTime;
+}
+
+float ClipPlayer::GetSpeed() const
+{
+	return mSpeed;
+}
+
+void ClipPlayer::SetSpeed(float inSpeed)
+{
+	mSpeed = inSpeed;
+}
+
+CrossFadeController::CrossFadeController()
+{
+	mFadeCount = 0;
+	for (unsigned int i = 0; i < kMaxFades; ++i)
+	{
+		mFades[i].duration = 0.0f;
+		mFades[i].elapsed = 0.0f;
+	}
+}
+
+void CrossFadeController::ReserveCursors(unsigned int inCount)
+{
+	mCurrent.ReserveCursors(inCount);
+	for (unsigned int i = 0; i < kMaxFades; ++i) { mFades[i].player.ReserveCursors(inCount); }
+}
+
+void CrossFadeController::Play(const Clip* inClip)
+{
+	mCurrent.SetClip(inClip);
+	mFadeCount = 0;
+}
+
+void CrossFadeController::FadeTo(const Clip* inClip, float inFadeTime)
+{
+	if (inClip == 0 || inClip == GetTargetClip()) { return; }
+	if (mCurrent.GetClip() == 0 || inFadeTime <= 0.0f)
+	{
+		Play(inClip);
+		return;
+	}
+	if (mFadeCount == kMaxFades)
+	{
+		// Cut the oldest fade, the slots keep their cursor arrays so nothing is reallocated
+		for (unsigned int i = 1; i < kMaxFades; ++i)
+		{
+			mFades[i - 1].player.Swap(mFades[i].player);
+			mFades[i - 1].duration = mFades[i].duration;
+			mFades[i - 1].elapsed = mFades[i].elapsed;
+		}
+		--mFadeCount;
+	}
+	Fade& fade = mFades[mFadeCount++];
+	fade.player.SetClip(inClip);
+	fade.duration = inFadeTime;
+	fade.elapsed = 0.0f;
+}
+
+void CrossFadeController::Update(float inDeltaTime, const Pose& inRestPose, Pose& outPose)
+{
+	outPose.CopyFrom(inRestPose);
+	mCurrent.Update(inDeltaTime, outPose);
+	if (mFadeCount == 0) { return; }
+
+	ArenaScope scope(*gFrameArena);
+	Pose scratch(outPose.Size(), *gFrameArena);
+	if (!scratch.IsValid()) { return; }
+
+	int completed = -1;
+	for (unsigned int i = 0; i < mFadeCount; ++i)
+	{
+		Fade& fade = mFades[i];
+		scratch.CopyFrom(inRestPose);
+		fade.player.Update(inDeltaTime, scratch);
+		fade.elapsed += inDeltaTime;
+		float t = fade.elapsed / fade.duration;
+		if (t >= 1.0f)
+		{
+			t = 1.0f;
+			completed = (int)i;
+		}
+		BlendPoses(outPose, scratch, t, outPose);
+	}
+
+	// The newest finished fade covers everything below it, it becomes the current clip & the ones underneath go away
+	if (completed >= 0)
+	{
+		mCurrent.Swap(mFades[completed].player);
+		unsigned int remaining = mFadeCount - (unsigned int)completed - 1;
+		for (unsigned int i = 0; i < remaining; ++i)
+		{
+			Fade& to = mFades[i];
+			Fade& from = mFades[completed + 1 + i];
+			to.player.Swap(from.player);
+			to.duration = from.duration;
+			to.elapsed = from.elapsed;
+		}
+		mFadeCount = remaining;
+	}
+}
+
+const Clip* CrossFadeController::GetTargetClip() const
+{
+	return (mFadeCount > 0) ? mFades[mFadeCount - 1].player.GetClip() : mCurrent.GetClip();
+}
+
+unsigned int CrossFadeController::GetActiveClipCount() const
+{
+	return (mCurrent.GetClip() != 0 ? 1 : 0) + mFadeCount;
+}
+
+LayerStack::LayerStack()
+{
+	mLayerCount = 0;
+}
+
+void LayerStack::ReserveCursors(unsigned int inCount)
+{
+	for (unsigned int i = 0; i < kMaxLayers; ++i) { mLayers[i].player.ReserveCursors(inCount); }
+}
+
+int LayerStack::AddLayer(const Clip* inClip, LayerBlend inBlend, float inWeight, const float* inMask, const Pose* inReference)
+{
+	if (mLayerCount == kMaxLayers)
+	{
+		std::cout << "LayerStack is full, only " << kMaxLayers << " layers are supported\n";
+		return -1;
+	}
+	if (inBlend == LayerBlend::Additive && inReference == 0)
+	{
+		std::cout << "Additive layers need a reference pose\n";
+		return -1;
+	}
+	Layer& layer = mLayers[mLayerCount];
+	layer.player.SetClip(inClip);
+	layer.blend = inBlend;
+	layer.weight = inWeight;
+	layer.mask = inMask;
+	layer.reference = inReference;
+	return (int)mLayerCount++;
+}
+
+void LayerStack::SetWeight(unsigned int inLayer, float inWeight)
+{
+	if (inLayer < mLayerCount) { mLayers[inLayer].weight = inWeight; }
+}
+
+ClipPlayer& LayerStack::GetPlayer(unsigned int inLayer)
+{
+	return mLayers[inLayer].player;
+}
+
+unsigned int LayerStack::Size() const
+{
+	return mLayerCount;
+}
+
+unsigned int LayerStack::GetActiveClipCount() const
+{
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < mLayerCount; ++i)
+	{
+		if (mLayers[i].weight > 0.0f && mLayers[i].player.GetClip() != 0) { ++count; }
+	}
+	return count;
+}
+
+void LayerStack::Apply(float inDeltaTime, Pose& ioPose)
+{
+	if (mLayerCount == 0) { return; }
+	ArenaScope scope(*gFrameArena);
+	Pose scratch(ioPose.Size(), *gFrameArena);
+	if (!scratch.IsValid()) { return; }
+
+	for (unsigned int i = 0; i < mLayerCount; ++i)
+	{
+		Layer& layer = mLayers[i];
+		// Weightless layers still advance so they're in step when they fade back in
+		if (layer.weight <= 0.0f)
+		{
+			layer.player.SetTime(layer.player.GetTime() + inDeltaTime * layer.player.GetSpeed());
+			continue;
+		}
+		// Joints the clip doesn't animate have to cancel out: the current pose for overrides, the reference for additives
+		scratch.CopyFrom(layer.blend == LayerBlend::Additive ? *layer.reference : ioPose);
+		layer.player.Update(inDeltaTime, scratch);
+		if (layer.blend == LayerBlend::Additive) { AddPoses(ioPose, scratch, *layer.reference, layer.weight, layer.mask, ioPose); }
+		else if (layer.mask != 0) { BlendPosesMasked(ioPose, scratch, layer.mask, layer.weight, ioPose); }
+		else { BlendPoses(ioPose, scratch, layer.weight, ioPose); }
+	}
+}
@@ -0,0 +1,136 @@
+#pragma once
+#ifndef _H_BLENDING_
+#define _H_BLENDING_
+
+#include <vector>
+#include "Track.h"
+
+class Pose;
+class Clip;
+
+/**
+* Pose blending
+* Every blend is a handful of batched kernels over the pose's arrays (LerpArray / NlerpArray / MultiplyAddArray),
+* never a per joint call into the math library. The output pose decides how many joints are blended, inputs can be larger,
+* so a view of the first joints (Pose::MakeView) can be blended against full size clips & reference poses.
+* Scratch poses come from gFrameArena, so the controllers below can only be updated on a thread that owns a frame arena: the Update
+* thread or a job (JobSystem gives every worker an arena & rewinds it after each job, see JobSystem.h)
+*/
+
+// Like BlendPoses() but every joint's weight is inT * inJointWeights[i], joints with a weight of 0 keep inA
+void BlendPosesMasked(const Pose& inA, const Pose& inB, const float* inJointWeights, float inT, Pose& outResult);
+
+/**
+* Additive blending, outResult = inBase + (inAdditive - inReference) * inWeight
+* Rotations are applied as inBase * (inverse(inReference) * inAdditive) scaled by nlerp from the identity
+* inJointWeights is an optional mask (0 applies the layer everywhere), outResult can be inBase
+*/
+void AddPoses(const Pose& inBase, const Pose& inAdditive, const Pose& inReference, float inWeight, const float* inJointWeights, Pose& outResult);
+
+// outReference = inRestPose sampled with inClip at inTime, the usual reference for an additive clip is its first frame
+void MakeReferencePose(const Clip& inClip, float inTime, const Pose& inRestPose, Pose& outReference);
+
+/**
+* Playback state of one clip (time, speed & key cursors), the clip itself is shared
+* Swap() moves the whole state without copying the cursor array
+*/
+class ClipPlayer
+{
+private:
+	const Clip* mClip;
+	float mTime;
+	float mSpeed;
+	std::vector<TrackCursor> mCursors;
+public:
+	ClipPlayer();
+
+	// Resets the cursors, doesn't allocate as long as the clip needs no more cursors than were reserved
+	void SetClip(const Clip* inClip, float inTime = 0.0f);
+	void ReserveCursors(unsigned int inCount);
+	// Advances the time by inDeltaTime * speed & samples the clip into ioPose, joints without tracks are left alone
+	void Update(float inDeltaTime, Pose& ioPose);
+	void Swap(ClipPlayer& inOther);
+
+	const Clip* GetClip() const;
+	float GetTime() const;
+	void SetTime(float inTime);
+	float GetSpeed() const;
+	void SetSpeed(float inSpeed);
+};
+
+/**
+* CrossFadeController plays one clip & fades into the next ones
+* Every fade in progress is sampled into a scratch pose & blended over the result so far, once a fade is complete
+* everything under it is hidden, so it becomes the current clip & the older ones are dropped
+* At most kMaxFades fades run at once, starting one more cuts the oldest
+*/
+class CrossFadeController
+{
+public:
+	static const unsigned int kMaxFades = 4;
+private:
+	struct Fade
+	{
+		ClipPlayer player;
+		float duration;
+		float elapsed;
+	};
+	ClipPlayer mCurrent;
+	Fade mFades[kMaxFades];
+	unsigned int mFadeCount;
+public:
+	CrossFadeController();
+
+	void ReserveCursors(unsigned int inCount);
+	void Play(const Clip* inClip);
+	// Ignored if inClip is already the clip being faded to
+	void FadeTo(const Clip* inClip, float inFadeTime);
+	// outPose starts as inRestPose, both need the same joint count
+	void Update(float inDeltaTime, const Pose& inRestPose, Pose& outPose);
+
+	const Clip* GetTargetClip() const;
+	unsigned int GetActiveClipCount() const;
+};
+
+enum class LayerBlend
+{
+	Override,
+	Additive
+};
+
+/**
+* LayerStack applies clips on top of a pose, in order
+* - Override layers blend towards their clip by weight, a joint mask limits them to part of the skeleton (upper body for example)
+* - Additive layers add the difference between their clip & a reference pose, so the base motion keeps playing underneath
+* Masks & reference poses are owned by the caller & have to outlive the stack
+*/
+class LayerStack
+{
+public:
+	static const unsigned int kMaxLayers = 8;
+private:
+	struct Layer
+	{
+		ClipPlayer player;
+		LayerBlend blend;
+		float weight;
+		const float* mask;
+		const Pose* reference;
+	};
+	Layer mLayers[kMaxLayers];
+	unsigned int mLayerCount;
+public:
+	LayerStack();
+
+	void ReserveCursors(unsigned int inCount);
+	// Returns the layer index or -1 when the stack is full, additive layers need inReference
+	int AddLayer(const Clip* inClip, LayerBlend inBlend, float inWeight, const float* inMask, const Pose* inReference);
+	void SetWeight(unsigned int inLayer, float inWeight);
+	ClipPlayer& GetPlayer(unsigned int inLayer);
+	unsigned int Size() const;
+	unsigned int GetActiveClipCount() const;
+
+	void Apply(float inDeltaTime, Pose& ioPose);
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "Clip.h"
+#include "Pose.h"
+#include <cmath>
+
+float TransformTrack::GetStartTime() const
+{
+	float result = 0.0f;
+	bool isSet = false;
+	if (position.Size() > 1) { result = position.GetStartTime(); isSet = true; }
+	if (rotation.Size() > 1 && (!isSet || rotation.GetStartTime() < result)) { result = rotation.GetStartTime(); isSet = true; }
+	if (scale.Size() > 1 && (!isSet || scale.GetStartTime() < result)) { result = scale.GetStartTime(); }
+	return result;
+}
+
+float TransformTrack::GetEndTime() const
+{
+	float result = 0.0f;
+	bool isSet = false;
+	if (position.Size() > 1) { result = position.GetEndTime(); isSet = true; }
+	if (rotation.Size() > 1 && (!isSet || rotation.GetEndTime() > result)) { result = rotation.GetEndTime(); isSet = true; }
+	if (scale.Size() > 1 && (!isSet || scale.GetEndTime() > result)) { result = scale.GetEndTime(); }
+	return result;
+}
+
+bool TransformTrack::IsValid() const
+{
+	return position.Size() > 0 || rotation.Size() > 0 || scale.Size() > 0;
+}
+
+Clip::Clip()
+{
+	mName = "No name given";
+	mStartTime = 0.0f;
+	mEndTime = 0.0f;
+	mLooping = true;
+}
+
+unsigned int Clip::Size() const
+{
+	return (unsigned int)mTracks.size();
+}
+
+TransformTrack& Clip::operator[](unsigned int inIndex)
+{
+	return mTracks[inIndex];
+}
+
+const TransformTrack& Clip::operator[](unsigned int inIndex) const
+{
+	return mTracks[inIndex];
+}
+
+TransformTrack& Clip::GetTrackForJoint(unsigned int inJoint)
+{
+	for (unsigned int i = 0; i < mTracks.size(); ++i)
+	{
+		if (mTracks[i].joint == inJoint) { return mTracks[i]; }
+	}
+	mTracks.push_back(TransformTrack());
+	mTracks.back().joint = inJoint;
+	return mTracks.back();
+}
+
+void Clip::RecalculateDuration()
+{
+	mStartTime = 0.0f;
+	mEndTime = 0.0f;
+	bool startSet = false;
+	bool endSet = false;
+	for (unsigned int i = 0; i < mTracks.size(); ++i)
+	{
+		if (!mTracks[i].IsValid()) { continue; }
+		float start = mTracks[i].GetStartTime();
+		float end = mTracks[i].GetEndTime();
+		if (!startSet || start < mStartTime) { mStartTime = start; startSet = true; }
+		if (!endSet || end > mEndTime) { mEndTime = end; endSet = true; }
+	}
+}
+
+float Clip::AdjustTime(float inTime) const
+{
+	float duration = mEndTime - mStartTime;
+	if (duration <= 0.0f) { return mStartTime; }
+	if (mLooping)
+	{
+		float time = fmodf(inTime - mStartTime, duration);
+		if (time < 0.0f) { time += duration; }
+		return time + mStartTime;
+	}
+	if (inTime < mStartTime) { return mStartTime; }
+	if (inTime > mEndTime) { return mEndTime; }
+	return inTime;
+}
+
+float Clip::Sample(Pose& outPose, float inTime, TrackCursor* ioCursors) const
+{
+	// A clip of single key tracks (a static pose) has no duration, AdjustTime() skips the wrap & clamp & its keys are still applied
+	float time = AdjustTime(inTime);
+
+	vec3* positions = outPose.GetPositions();
+	quat* rotations = outPose.GetRotations();
+	vec3* scales = outPose.GetScales();
+	unsigned int jointCount = outPose.Size();
+	unsigned int trackCount = (unsigned int)mTracks.size();
+	for (unsigned int i = 0; i < trackCount; ++i)
+	{
+		const TransformTrack& track = mTracks[i];
+		if (track.joint >= jointCount) { continue; }
+
+		// The clip already looped the time, so the tracks are sampled clamped
+		if (ioCursors != 0)
+		{
+			TrackCursor* cursors = ioCursors + i * 3;
+			if (track.position.Size() > 0) { positions[track.joint] = track.position.Sample(time, false, cursors[0]); }
+			if (track.rotation.Size() > 0) { rotations[track.joint] = track.rotation.Sample(time, false, cursors[1]); }
+			if (track.scale.Size() > 0) { scales[track.joint] = track.scale.Sample(time, false, cursors[2]); }
+		}
+		else
+		{
+			if (track.position.Size() > 0) { positions[track.joint] = track.position.Sample(time, false); }
+			if (track.rotation.Size() > 0) { rotations[track.joint] = track.rotation.Sample(time, false); }
+			if (track.scale.Size() > 0) { scales[track.joint] = track.scale.Sample(time, false); }
+		}
+	}
+	return time;
+}
+
+unsigned int Clip::GetCursorCount() const
+{
+	return (unsigned int)mTracks.size() * 3;
+}
+
+void Clip::ResampleUniform(float inSampleRate)
+{
+	for (unsigned int i = 0; i < mTracks.size(); ++i)
+	{
+		mTracks[i].position.ResampleUniform(inSampleRate);
+		mTracks[i].rotation.ResampleUniform(inSampleRate);
+		mTracks[i].scale.ResampleUniform(inSampleRate);
+	}
+}
+
+const std::string& Clip::GetName() const
+{
+	return mName;
+}
+
+void Clip::SetName(const std::string& inName)
+{
+	mName = inName;
+}
+
+float Clip::GetDuration() const
+{
+	return mEndTime - mStartTime;
+}
+
+float Clip::GetStartTime() const
+{
+	return mStartTime;
+}
+
+float Clip::GetEndTime() const
+{
+	return mEndTime;
+}
+
+bool Clip::GetLooping() const
+{
+	return mLooping;
+}
+
+void Clip::SetLooping(bool inLooping)
+{
+	mLooping = inLooping;
+}
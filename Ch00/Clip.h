@@ -0,0 +1,68 @@
+#pragma once
+#ifndef _H_CLIP_
+#define _H_CLIP_
+
+#include <string>
+#include <vector>
+#include "Track.h"
+
+class Pose;
+
+// The position, rotation & scale tracks of one joint, a track without keys leaves that part of the pose alone
+struct TransformTrack
+{
+	unsigned int joint;
+	VectorTrack position;
+	QuaternionTrack rotation;
+	VectorTrack scale;
+
+	float GetStartTime() const;
+	float GetEndTime() const;
+	bool IsValid() const;
+};
+
+/**
+* Clip is a set of transform tracks that's sampled into a Pose
+* A clip holds no playback state, every instance playing it keeps its own cursors (GetCursorCount() of them, all starting at 0)
+* so many characters can share one clip & still get O(1) key lookups
+*/
+class Clip
+{
+protected:
+	std::vector<TransformTrack> mTracks;
+	std::string mName;
+	float mStartTime;
+	float mEndTime;
+	bool mLooping;
+protected:
+	float AdjustTime(float inTime) const;
+public:
+	Clip();
+
+	unsigned int Size() const;
+	TransformTrack& operator[](unsigned int inIndex);
+	const TransformTrack& operator[](unsigned int inIndex) const;
+	// Returns the track animating inJoint, a new one is added if there isn't one yet
+	TransformTrack& GetTrackForJoint(unsigned int inJoint);
+	// Call after the tracks were filled in
+	void RecalculateDuration();
+
+	/**
+	* Samples every track at inTime (looped or clamped) into outPose & returns the adjusted time
+	* ioCursors needs GetCursorCount() entries, or 0 to always binary search
+	*/
+	float Sample(Pose& outPose, float inTime, TrackCursor* ioCursors) const;
+	unsigned int GetCursorCount() const;
+	// Bakes every track onto an even grid, see Track::ResampleUniform()
+	void ResampleUniform(float inSampleRate);
+
+	const std::string& GetName() const;
+	void SetName(const std::string& inName);
+	float GetDuration() const;
+	float GetStartTime() const;
+	float GetEndTime() const;
+	bool GetLooping() const;
+	void SetLooping(bool inLooping);
+};
+
+#endif
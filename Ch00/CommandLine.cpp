@@ -0,0 +1,64 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "CommandLine.h"
+#include <cstring>
+#include <cstdlib>
+
+/**
+* Finds "-name" as a whole switch, so -fixed doesn't match -fixedstep
+* Returns a pointer to the first character after the name or 0 if the switch isn't present
+*/
+static const char* FindSwitch(const char* inCmdLine, const char* inName)
+{
+	if (inCmdLine == 0 || inName == 0) { return 0; }
+	size_t nameLength = strlen(inName);
+
+	for (const char* cursor = strchr(inCmdLine, '-'); cursor != 0; cursor = strchr(cursor + 1, '-'))
+	{
+		bool startOfToken = cursor == inCmdLine || cursor[-1] == ' ' || cursor[-1] == '\t' || cursor[-1] == '"';
+		if (!startOfToken) { continue; }
+		if (strncmp(cursor + 1, inName, nameLength) != 0) { continue; }
+
+		const char* end = cursor + 1 + nameLength;
+		if (*end == '\0' || *end == ' ' || *end == '\t' || *end == '=' || *end == '"') { return end; }
+	}
+	return 0;
+}
+
+bool HasSwitch(const char* inCmdLine, const char* inName)
+{
+	return FindSwitch(inCmdLine, inName) != 0;
+}
+
+bool GetSwitchString(const char* inCmdLine, const char* inName, char* outValue, unsigned int inValueSize)
+{
+	const char* end = FindSwitch(inCmdLine, inName);
+	if (end == 0 || *end != '=' || inValueSize == 0) { return false; }
+	const char* value = end + 1;
+
+	// Values with spaces (file paths) can be wrapped in quotes: -out="my report.csv"
+	char terminator = ' ';
+	if (*value == '"') { terminator = '"'; ++value; }
+
+	unsigned int length = 0;
+	while (value[length] != '\0' && value[length] != terminator && value[length] != '\t' && length + 1 < inValueSize)
+	{
+		outValue[length] = value[length];
+		++length;
+	}
+	outValue[length] = '\0';
+	return length > 0;
+}
+
+int GetSwitchInt(const char* inCmdLine, const char* inName, int inDefault)
+{
+	char value[32];
+	if (!GetSwitchString(inCmdLine, inName, value, sizeof(value))) { return inDefault; }
+	return atoi(value);
+}
+
+float GetSwitchFloat(const char* inCmdLine, const char* inName, float inDefault)
+{
+	char value[32];
+	if (!GetSwitchString(inCmdLine, inName, value, sizeof(value))) { return inDefault; }
+	return (float)atof(value);
+}
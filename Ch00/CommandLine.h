@@ -0,0 +1,19 @@
+#pragma once
+#ifndef _H_COMMANDLINE_
+#define _H_COMMANDLINE_
+
+/**
+* Small helpers to read startup switches out of the szCmdLine string WinMain receives
+* Switches are written as -name or -name=value, for example: AnimationProject.exe -fixedstep=120
+* In debug builds WinMain is called from main() with GetCommandLineA() so the exe path is part of the string, which is harmless
+*/
+
+// Returns true if -inName is present on the command line
+bool HasSwitch(const char* inCmdLine, const char* inName);
+// Returns the value of -inName=value or inDefault if the switch (or its value) isn't there
+int GetSwitchInt(const char* inCmdLine, const char* inName, int inDefault);
+float GetSwitchFloat(const char* inCmdLine, const char* inName, float inDefault);
+// Copies the value of -inName=value into outValue, returns false if the switch doesn't have a value
+bool GetSwitchString(const char* inCmdLine, const char* inName, char* outValue, unsigned int inValueSize);
+
+#endif
@@ -0,0 +1,469 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "CompressedClip.h"
+#include "Clip.h"
+#include "Pose.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace ClipFormat;
+
+static const float kSqrt2 = 1.41421356237f;
+
+ClipCompressionSettings::ClipCompressionSettings()
+{
+	sampleRate = 30.0f;
+	positionTolerance = 0.0001f;
+	scaleTolerance = 0.0001f;
+	rotationTolerance = 0.999999f;
+}
+
+static inline unsigned short QuantizeUnit(float inValue, float inMin, float inExtent)
+{
+	if (inExtent <= 0.0f) { return 0; }
+	float normalized = (inValue - inMin) / inExtent;
+	if (normalized < 0.0f) { normalized = 0.0f; }
+	if (normalized > 1.0f) { normalized = 1.0f; }
+	return (unsigned short)(normalized * 65535.0f + 0.5f);
+}
+
+static inline float DequantizeUnit(unsigned short inValue, float inMin, float inExtent)
+{
+	return inMin + (float)inValue * (1.0f / 65535.0f) * inExtent;
+}
+
+static void EncodeRotation(const quat& inRotation, unsigned short* outValues)
+{
+	quat q = normalized(inRotation);
+	unsigned int largest = 0;
+	for (unsigned int i = 1; i < 4; ++i)
+	{
+		if (fabsf(q.v[i]) > fabsf(q.v[largest])) { largest = i; }
+	}
+	// q & -q are the same rotation, flipping makes the dropped component positive
+	if (q.v[largest] < 0.0f) { q = -q; }
+
+	// The other three are at most 1 / sqrt(2) in magnitude
+	unsigned short quantized[3];
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		if (i == largest) { continue; }
+		float unit = q.v[i] * kSqrt2 * 0.5f + 0.5f;
+		if (unit < 0.0f) { unit = 0.0f; }
+		if (unit > 1.0f) { unit = 1.0f; }
+		quantized[count++] = (unsigned short)(unit * 32767.0f + 0.5f);
+	}
+	outValues[0] = (unsigned short)(quantized[0] | ((largest & 1) << 15));
+	outValues[1] = (unsigned short)(quantized[1] | ((largest >> 1) << 15));
+	outValues[2] = quantized[2];
+}
+
+static quat DecodeRotation(const unsigned short* inValues)
+{
+	unsigned int largest = (unsigned int)(inValues[0] >> 15) | ((unsigned int)(inValues[1] >> 15) << 1);
+	float values[3];
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		float unit = (float)(inValues[i] & 0x7FFF) * (1.0f / 32767.0f);
+		values[i] = (unit - 0.5f) * 2.0f / kSqrt2;
+	}
+
+	quat result;
+	unsigned int count = 0;
+	float sumSq = 0.0f;
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		if (i == largest) { continue; }
+		result.v[i] = values[count];
+		sumSq += values[count] * values[count];
+		++count;
+	}
+	float remaining = 1.0f - sumSq;
+	result.v[largest] = remaining > 0.0f ? sqrtf(remaining) : 0.0f;
+	return normalized(result);
+}
+
+static unsigned int AlignOffset(size_t inOffset)
+{
+	return (unsigned int)((inOffset + 15) & ~(size_t)15);
+}
+
+bool CompressClip(const Clip& inClip, const ClipCompressionSettings& inSettings, std::vector<unsigned char>& outData)
+{
+	float duration = inClip.GetDuration();
+	if (duration <= 0.0f || inSettings.sampleRate <= 0.0f)
+	{
+		std::cout << "Can't compress clip " << inClip.GetName() << ", it has no duration\n";
+		return false;
+	}
+
+	unsigned int frameCount = (unsigned int)ceilf(duration * inSettings.sampleRate) + 1;
+	float start = inClip.GetStartTime();
+	unsigned int trackCount = inClip.Size();
+
+	// Sample every channel on the grid first, the raw samples decide which channels are constant
+	std::vector<TrackInfo> tracks(trackCount);
+	std::vector<float> constants;
+	std::vector<std::vector<float> > animatedSamples; // frameCount * 4 floats per animated channel
+	std::vector<unsigned int> animatedKinds;
+	std::vector<float> samples(frameCount * 4);
+	for (unsigned int t = 0; t < trackCount; ++t)
+	{
+		const TransformTrack& source = inClip[t];
+		TrackInfo& track = tracks[t];
+		memset(&track, 0, sizeof(TrackInfo));
+		track.joint = source.joint;
+
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			ChannelInfo& channel = track.channels[c];
+			unsigned int keys = (c == ChannelPosition) ? source.position.Size() : (c == ChannelRotation) ? source.rotation.Size() : source.scale.Size();
+			if (keys == 0)
+			{
+				channel.kind = ChannelNone;
+				continue;
+			}
+
+			TrackCursor cursor;
+			for (unsigned int f = 0; f < frameCount; ++f)
+			{
+				// Same grid the decoder uses (frameRate = (frameCount - 1) / duration), the last frame lands exactly on the end time
+				float time = (f == frameCount - 1) ? inClip.GetEndTime() : start + duration * (float)f / (float)(frameCount - 1);
+				float* sample = &samples[f * 4];
+				if (c == ChannelRotation)
+				{
+					quat q = source.rotation.Sample(time, false, cursor);
+					memcpy(sample, q.v, sizeof(float) * 4);
+				}
+				else
+				{
+					vec3 v = (c == ChannelPosition) ? source.position.Sample(time, false, cursor) : source.scale.Sample(time, false, cursor);
+					sample[0] = v.x;
+					sample[1] = v.y;
+					sample[2] = v.z;
+					sample[3] = 0.0f;
+				}
+			}
+
+			bool constant = true;
+			for (unsigned int f = 1; f < frameCount && constant; ++f)
+			{
+				if (c == ChannelRotation)
+				{
+					quat a(samples[0], samples[1], samples[2], samples[3]);
+					quat b(samples[f * 4], samples[f * 4 + 1], samples[f * 4 + 2], samples[f * 4 + 3]);
+					constant = fabsf(dot(a, b)) >= inSettings.rotationTolerance;
+				}
+				else
+				{
+					float tolerance = (c == ChannelPosition) ? inSettings.positionTolerance : inSettings.scaleTolerance;
+					for (unsigned int i = 0; i < 3; ++i)
+					{
+						if (fabsf(samples[f * 4 + i] - samples[i]) > tolerance) { constant = false; }
+					}
+				}
+			}
+
+			unsigned int floats = (c == ChannelRotation) ? 4 : 3;
+			if (constant)
+			{
+				channel.kind = ChannelConstant;
+				channel.index = (unsigned int)constants.size();
+				for (unsigned int i = 0; i < floats; ++i) { constants.push_back(samples[i]); }
+				continue;
+			}
+
+			channel.kind = ChannelAnimated;
+			channel.index = (unsigned int)animatedSamples.size();
+			if (c != ChannelRotation)
+			{
+				for (unsigned int i = 0; i < 3; ++i)
+				{
+					float low = samples[i];
+					float high = samples[i];
+					for (unsigned int f = 1; f < frameCount; ++f)
+					{
+						if (samples[f * 4 + i] < low) { low = samples[f * 4 + i]; }
+						if (samples[f * 4 + i] > high) { high = samples[f * 4 + i]; }
+					}
+					channel.min[i] = low;
+					channel.extent[i] = high - low;
+				}
+			}
+			animatedSamples.push_back(samples);
+			animatedKinds.push_back(t * 3 + c);
+		}
+	}
+
+	unsigned int animatedCount = (unsigned int)animatedSamples.size();
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	header.magic = kMagic;
+	header.version = kVersion;
+	strncpy(header.name, inClip.GetName().c_str(), sizeof(header.name) - 1);
+	header.trackCount = trackCount;
+	header.frameCount = frameCount;
+	header.frameRate = (float)(frameCount - 1) / duration;
+	header.startTime = start;
+	header.duration = duration;
+	header.looping = inClip.GetLooping() ? 1 : 0;
+	header.animatedChannelCount = animatedCount;
+	header.constantFloatCount = (unsigned int)constants.size();
+	header.tracksOffset = AlignOffset(sizeof(Header));
+	header.constantsOffset = AlignOffset(header.tracksOffset + sizeof(TrackInfo) * trackCount);
+	header.framesOffset = AlignOffset(header.constantsOffset + sizeof(float) * constants.size());
+	size_t totalSize = header.framesOffset + sizeof(unsigned short) * 3 * animatedCount * frameCount;
+
+	outData.assign(totalSize, 0);
+	memcpy(&outData[0], &header, sizeof(Header));
+	if (trackCount > 0) { memcpy(&outData[header.tracksOffset], &tracks[0], sizeof(TrackInfo) * trackCount); }
+	if (!constants.empty()) { memcpy(&outData[header.constantsOffset], &constants[0], sizeof(float) * constants.size()); }
+
+	unsigned short* frames = (unsigned short*)&outData[header.framesOffset];
+	for (unsigned int f = 0; f < frameCount; ++f)
+	{
+		unsigned short* frame = frames + f * animatedCount * 3;
+		for (unsigned int a = 0; a < animatedCount; ++a)
+		{
+			const ChannelInfo& channel = tracks[animatedKinds[a] / 3].channels[animatedKinds[a] % 3];
+			const float* sample = &animatedSamples[a][f * 4];
+			if (animatedKinds[a] % 3 == ChannelRotation)
+			{
+				EncodeRotation(quat(sample[0], sample[1], sample[2], sample[3]), frame + a * 3);
+			}
+			else
+			{
+				for (unsigned int i = 0; i < 3; ++i) { frame[a * 3 + i] = QuantizeUnit(sample[i], channel.min[i], channel.extent[i]); }
+			}
+		}
+	}
+	return true;
+}
+
+bool WriteCompressedClip(const Clip& inClip, const ClipCompressionSettings& inSettings, const char* inPath)
+{
+	std::vector<unsigned char> data;
+	if (!CompressClip(inClip, inSettings, data)) { return false; }
+
+	FILE* file = fopen(inPath, "wb");
+	if (file == 0)
+	{
+		std::cout << "Couldn't write compressed clip " << inPath << "\n";
+		return false;
+	}
+	bool result = fwrite(&data[0], 1, data.size(), file) == data.size();
+	fclose(file);
+	return result;
+}
+
+CompressedClip::CompressedClip()
+{
+	mData = 0;
+	mSize = 0;
+	mHeader = 0;
+	mTracks = 0;
+	mConstants = 0;
+	mFrames = 0;
+}
+
+CompressedClip::~CompressedClip()
+{
+	Unload();
+}
+
+bool CompressedClip::Load(const char* inPath)
+{
+	Unload();
+	if (!mFile.Open(inPath)) { return false; }
+	mData = mFile.GetData();
+	mSize = mFile.GetSize();
+	if (!Validate())
+	{
+		std::cout << inPath << " isn't a valid compressed clip\n";
+		Unload();
+		return false;
+	}
+	return true;
+}
+
+bool CompressedClip::LoadFromMemory(const void* inData, size_t inSize)
+{
+	Unload();
+	mData = (const unsigned char*)inData;
+	mSize = inSize;
+	if (!Validate())
+	{
+		Unload();
+		return false;
+	}
+	return true;
+}
+
+bool CompressedClip::Validate()
+{
+	if (mData == 0 || mSize < sizeof(Header)) { return false; }
+	const Header* header = (const Header*)mData;
+	if (header->magic != kMagic || header->version != kVersion) { return false; }
+	if (header->frameCount < 2 || header->duration <= 0.0f) { return false; }
+
+	// Every section has to be inside the file
+	size_t tracksEnd = (size_t)header->tracksOffset + sizeof(TrackInfo) * header->trackCount;
+	size_t constantsEnd = (size_t)header->constantsOffset + sizeof(float) * header->constantFloatCount;
+	size_t framesEnd = (size_t)header->framesOffset + sizeof(unsigned short) * 3 * (size_t)header->animatedChannelCount * header->frameCount;
+	if (tracksEnd > mSize || constantsEnd > mSize || framesEnd > mSize) { return false; }
+
+	const TrackInfo* tracks = (const TrackInfo*)(mData + header->tracksOffset);
+	for (unsigned int t = 0; t < header->trackCount; ++t)
+	{
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			const ChannelInfo& channel = tracks[t].channels[c];
+			if (channel.kind == ChannelConstant && channel.index + (c == ChannelRotation ? 4 : 3) > header->constantFloatCount) { return false; }
+			if (channel.kind == ChannelAnimated && channel.index >= header->animatedChannelCount) { return false; }
+			if (channel.kind > ChannelAnimated) { return false; }
+		}
+	}
+
+	mHeader = header;
+	mTracks = tracks;
+	mConstants = (const float*)(mData + header->constantsOffset);
+	mFrames = (const unsigned short*)(mData + header->framesOffset);
+	return true;
+}
+
+void CompressedClip::Unload()
+{
+	mFile.Close();
+	mData = 0;
+	mSize = 0;
+	mHeader = 0;
+	mTracks = 0;
+	mConstants = 0;
+	mFrames = 0;
+}
+
+bool CompressedClip::IsLoaded() const
+{
+	return mHeader != 0;
+}
+
+float CompressedClip::Sample(Pose& outPose, float inTime) const
+{
+	if (mHeader == 0) { return 0.0f; }
+
+	float start = mHeader->startTime;
+	float duration = mHeader->duration;
+	float time = inTime;
+	if (mHeader->looping)
+	{
+		time = fmodf(inTime - start, duration);
+		if (time < 0.0f) { time += duration; }
+		time += start;
+	}
+	else if (time < start) { time = start; }
+	else if (time > start + duration) { time = start + duration; }
+
+	float frame = (time - start) * mHeader->frameRate;
+	unsigned int frame0 = (unsigned int)frame;
+	if (frame0 > mHeader->frameCount - 2) { frame0 = mHeader->frameCount - 2; }
+	float t = frame - (float)frame0;
+	if (t > 1.0f) { t = 1.0f; }
+
+	unsigned int stride = mHeader->animatedChannelCount * 3;
+	const unsigned short* a = mFrames + frame0 * stride;
+	const unsigned short* b = a + stride;
+
+	vec3* positions = outPose.GetPositions();
+	quat* rotations = outPose.GetRotations();
+	vec3* scales = outPose.GetScales();
+	unsigned int jointCount = outPose.Size();
+	for (unsigned int i = 0; i < mHeader->trackCount; ++i)
+	{
+		const TrackInfo& track = mTracks[i];
+		if (track.joint >= jointCount) { continue; }
+
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			const ChannelInfo& channel = track.channels[c];
+			if (channel.kind == ChannelNone) { continue; }
+
+			if (c == ChannelRotation)
+			{
+				quat value;
+				if (channel.kind == ChannelConstant)
+				{
+					const float* constant = mConstants + channel.index;
+					value = quat(constant[0], constant[1], constant[2], constant[3]);
+				}
+				else
+				{
+					value = nlerp(DecodeRotation(a + channel.index * 3), DecodeRotation(b + channel.index * 3), t);
+				}
+				rotations[track.joint] = value;
+				continue;
+			}
+
+			vec3 value;
+			if (channel.kind == ChannelConstant)
+			{
+				value = vec3(mConstants + channel.index);
+			}
+			else
+			{
+				const unsigned short* valueA = a + channel.index * 3;
+				const unsigned short* valueB = b + channel.index * 3;
+				for (unsigned int k = 0; k < 3; ++k)
+				{
+					float from = DequantizeUnit(valueA[k], channel.min[k], channel.extent[k]);
+					float to = DequantizeUnit(valueB[k], channel.min[k], channel.extent[k]);
+					value.v[k] = from + (to - from) * t;
+				}
+			}
+			if (c == ChannelPosition) { positions[track.joint] = value; }
+			else { scales[track.joint] = value; }
+		}
+	}
+	return time;
+}
+
+const char* CompressedClip::GetName() const
+{
+	return mHeader != 0 ? mHeader->name : "";
+}
+
+float CompressedClip::GetStartTime() const
+{
+	return mHeader != 0 ? mHeader->startTime : 0.0f;
+}
+
+float CompressedClip::GetEndTime() const
+{
+	return mHeader != 0 ? mHeader->startTime + mHeader->duration : 0.0f;
+}
+
+float CompressedClip::GetDuration() const
+{
+	return mHeader != 0 ? mHeader->duration : 0.0f;
+}
+
+bool CompressedClip::GetLooping() const
+{
+	return mHeader != 0 && mHeader->looping != 0;
+}
+
+unsigned int CompressedClip::GetTrackCount() const
+{
+	return mHeader != 0 ? mHeader->trackCount : 0;
+}
+
+unsigned int CompressedClip::GetFrameCount() const
+{
+	return mHeader != 0 ? mHeader->frameCount : 0;
+}
+
+size_t CompressedClip::GetSizeInBytes() const
+{
+	return mSize;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#ifndef _H_COMPRESSEDCLIP_
+#define _H_COMPRESSEDCLIP_
+
+#include <vector>
+#include "MappedFile.h"
+
+class Clip;
+class Pose;
+
+/**
+* Binary clip format, made to be used straight from a memory mapped file
+* The clip is resampled on an even grid, so there are no key times, only frames:
+* - Rotations use smallest three: the largest component is dropped (its sign is made positive) & rebuilt from the
+*   other three, which are stored in 15 bits each, the index of the dropped one goes in the two spare bits (6 bytes per key)
+* - Positions & scales are 16 bit values inside the min / extent range of their channel (6 bytes per key)
+* - Channels that don't change over the clip are stored once as full floats, channels without keys aren't stored at all
+* Every frame holds the animated channels back to back, so sampling reads two small contiguous blocks
+* All values are little endian
+*/
+namespace ClipFormat
+{
+	const unsigned int kMagic = 0x504C4341; // "ACLP"
+	const unsigned int kVersion = 1;
+
+	enum ChannelKind
+	{
+		ChannelNone = 0,
+		ChannelConstant = 1,
+		ChannelAnimated = 2
+	};
+
+	enum ChannelIndex
+	{
+		ChannelPosition = 0,
+		ChannelRotation = 1,
+		ChannelScale = 2
+	};
+
+	struct Header
+	{
+		unsigned int magic;
+		unsigned int version;
+		char name[32];
+		unsigned int trackCount;
+		unsigned int frameCount;
+		float frameRate; // Frames per second of the grid, (frameCount - 1) / duration
+		float startTime;
+		float duration;
+		unsigned int looping;
+		unsigned int animatedChannelCount;
+		unsigned int constantFloatCount;
+		unsigned int tracksOffset; // Byte offsets from the start of the file, all 16 byte aligned
+		unsigned int constantsOffset;
+		unsigned int framesOffset;
+		unsigned int reserved;
+	};
+
+	struct ChannelInfo
+	{
+		unsigned int kind;
+		unsigned int index; // Float offset into the constants for constant channels, channel index in a frame for animated ones
+		float min[3];
+		float extent[3];
+	};
+
+	struct TrackInfo
+	{
+		unsigned int joint;
+		unsigned int reserved[3];
+		ChannelInfo channels[3];
+	};
+}
+
+struct ClipCompressionSettings
+{
+	float sampleRate;
+	// Largest change over the clip that still counts as constant, in units for positions & scales
+	float positionTolerance;
+	float scaleTolerance;
+	// Smallest |dot| between the first & any other rotation that still counts as constant
+	float rotationTolerance;
+	ClipCompressionSettings();
+};
+
+// Builds the binary image of inClip, returns false if the clip has no duration
+bool CompressClip(const Clip& inClip, const ClipCompressionSettings& inSettings, std::vector<unsigned char>& outData);
+bool WriteCompressedClip(const Clip& inClip, const ClipCompressionSettings& inSettings, const char* inPath);
+
+/**
+* Read only view of a compressed clip, either over a file mapped with Load() or over memory owned by the caller
+* Load() doesn't copy or decode anything, meant to be called from Application::Initialize()
+* Sample() decodes the two frames around the time & blends them into the pose, it has no state & is safe to call
+* from several threads at once
+*/
+class CompressedClip
+{
+private:
+	MappedFile mFile;
+	const unsigned char* mData;
+	size_t mSize;
+	const ClipFormat::Header* mHeader;
+	const ClipFormat::TrackInfo* mTracks;
+	const float* mConstants;
+	const unsigned short* mFrames;
+private:
+	CompressedClip(const CompressedClip&);
+	CompressedClip& operator=(const CompressedClip&);
+	bool Validate();
+public:
+	CompressedClip();
+	~CompressedClip();
+
+	bool Load(const char* inPath);
+	// inData has to stay valid & 16 byte aligned for as long as the clip is used
+	bool LoadFromMemory(const void* inData, size_t inSize);
+	void Unload();
+	bool IsLoaded() const;
+
+	// Returns the time that was sampled after looping or clamping
+	float Sample(Pose& outPose, float inTime) const;
+
+	const char* GetName() const;
+	float GetStartTime() const;
+	float GetEndTime() const;
+	float GetDuration() const;
+	bool GetLooping() const;
+	unsigned int GetTrackCount() const;
+	unsigned int GetFrameCount() const;
+	size_t GetSizeInBytes() const;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "Crowd.h"
+#include "RenderState.h"
+#include <cstring>
+#include <iostream>
+
+CrowdInstanceBuffer::CrowdInstanceBuffer()
+{
+	mCapacity = 0;
+	mCount = 0;
+	mOffset = 0;
+}
+
+CrowdInstanceBuffer::~CrowdInstanceBuffer()
+{
+	Shutdown();
+}
+
+bool CrowdInstanceBuffer::Initialize(unsigned int inMaxInstances)
+{
+	Shutdown();
+	if (inMaxInstances == 0) { return false; }
+	mCapacity = inMaxInstances;
+	return mStream.Initialize(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(CrowdInstance) * mCapacity), StreamBufferMode::Auto);
+}
+
+void CrowdInstanceBuffer::Shutdown()
+{
+	mStream.Shutdown();
+	mCapacity = 0;
+	mCount = 0;
+}
+
+void CrowdInstanceBuffer::Upload(const CrowdInstance* inInstances, unsigned int inCount)
+{
+	mCount = 0;
+	if (mStream.GetBuffer() == 0) { return; }
+	if (inCount > mCapacity)
+	{
+		std::cout << "CrowdInstanceBuffer: " << inCount << " instances, only " << mCapacity << " fit\n";
+		inCount = mCapacity;
+	}
+	if (inCount == 0) { return; }
+	mStream.BeginFrame();
+	GLsizeiptr size = (GLsizeiptr)(sizeof(CrowdInstance) * inCount);
+	void* mapped = mStream.Map(size, sizeof(CrowdInstance), mOffset);
+	if (mapped == 0) { return; }
+	memcpy(mapped, inInstances, (size_t)size);
+	mStream.Unmap();
+	mCount = inCount;
+}
+
+unsigned int CrowdInstanceBuffer::GetCount() const
+{
+	return mCount;
+}
+
+void CrowdInstanceBuffer::Bind(GLint inPosition, GLint inPaletteOffset)
+{
+	gRenderState->BindBuffer(GL_ARRAY_BUFFER, mStream.GetBuffer());
+	if (inPosition >= 0)
+	{
+		glEnableVertexAttribArray((GLuint)inPosition);
+		glVertexAttribPointer((GLuint)inPosition, 3, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), (void*)mOffset);
+		glVertexAttribDivisor((GLuint)inPosition, 1);
+	}
+	if (inPaletteOffset >= 0)
+	{
+		glEnableVertexAttribArray((GLuint)inPaletteOffset);
+		glVertexAttribIPointer((GLuint)inPaletteOffset, 1, GL_INT, sizeof(CrowdInstance), (void*)(mOffset + sizeof(float) * 3));
+		glVertexAttribDivisor((GLuint)inPaletteOffset, 1);
+	}
+}
+
+void CrowdInstanceBuffer::UnBind(GLint inPosition, GLint inPaletteOffset)
+{
+	if (inPosition >= 0)
+	{
+		glVertexAttribDivisor((GLuint)inPosition, 0);
+		glDisableVertexAttribArray((GLuint)inPosition);
+	}
+	if (inPaletteOffset >= 0)
+	{
+		glVertexAttribDivisor((GLuint)inPaletteOffset, 0);
+		glDisableVertexAttribArray((GLuint)inPaletteOffset);
+	}
+}
+
+void CrowdInstanceBuffer::EndFrame()
+{
+	mStream.EndFrame();
+}
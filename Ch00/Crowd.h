@@ -0,0 +1,52 @@
+#pragma once
+#ifndef _H_CROWD_
+#define _H_CROWD_
+
+#include "include/glad/glad.h"
+#include "StreamBuffer.h"
+
+/**
+* Per instance data of an instanced skinned draw, 16 bytes
+* paletteOffset is the index of the instance's first matrix in the texture buffer palette, so instances can have a palette
+* of their own (live crowds) or share the frames of a baked clip (baked crowds, the offset just picks the frame)
+* position is added after skinning, baked clips are stored at the origin & placed with it
+*/
+struct CrowdInstance
+{
+	float position[3];
+	int paletteOffset;
+};
+
+/**
+* CrowdInstanceBuffer streams the CrowdInstance array of one instanced draw through a StreamBuffer
+* Bind() points two attribute slots at it with a divisor of 1 & UnBind() resets the divisors, the sample shares one VAO
+* between every draw so a divisor left behind would break the next non instanced mesh
+*/
+class CrowdInstanceBuffer
+{
+private:
+	StreamBuffer mStream;
+	unsigned int mCapacity;
+	unsigned int mCount;
+	GLintptr mOffset; // Start of this frame's instances in the stream
+private:
+	CrowdInstanceBuffer(const CrowdInstanceBuffer&);
+	CrowdInstanceBuffer& operator=(const CrowdInstanceBuffer&);
+public:
+	CrowdInstanceBuffer();
+	~CrowdInstanceBuffer();
+
+	bool Initialize(unsigned int inMaxInstances);
+	void Shutdown();
+
+	// Once per frame, anything past the capacity is dropped
+	void Upload(const CrowdInstance* inInstances, unsigned int inCount);
+	unsigned int GetCount() const;
+
+	void Bind(GLint inPosition, GLint inPaletteOffset);
+	void UnBind(GLint inPosition, GLint inPaletteOffset);
+	// After the draw that reads this frame's instances
+	void EndFrame();
+};
+
+#endif
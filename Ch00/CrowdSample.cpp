@@ -0,0 +1,198 @@
+#include "CrowdSample.h"
+#include "Pose.h"
+#include "Arena.h"
+#include "FrameProfiler.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Length of one loop of GetSwayRotation()
+static const float kSwayPeriod = 3.14159265f;
+
+CrowdSample::CrowdSample(unsigned int inCharacterCount, bool inBaked) : SkinningSample(inCharacterCount, SkinningMode::Gpu, PaletteStorage::TextureBuffer)
+{
+	mBaked = inBaked;
+	mInstanced = true;
+	mLivePalettes = !inBaked;
+	mPaletteSkeletons = inBaked ? kBakedFrames : mCharacterCount;
+	mInstances = 0;
+	for (unsigned int i = 0; i < kMaxPackets; ++i) { mPacketInstances[i] = 0; }
+}
+
+CrowdSample::~CrowdSample()
+{
+	Shutdown();
+}
+
+bool CrowdSample::BakeClip()
+{
+	// Samples one character standing at the origin, the instance position moves it into place
+	ArenaScope scope(*gFrameArena);
+	Pose pose(kJointsPerCharacter, *gFrameArena);
+	mat4* world = gFrameArena->AllocateArray<mat4>(kJointsPerCharacter);
+	mat4* frames = gFrameArena->AllocateArray<mat4>(kJointsPerCharacter * kBakedFrames);
+	if (!pose.IsValid() || world == 0 || frames == 0)
+	{
+		std::cout << "CrowdSample: the frame arena is too small to bake the clip\n";
+		return false;
+	}
+	for (unsigned int k = 0; k < kJointsPerCharacter; ++k)
+	{
+		pose.SetParent(k, (int)k - 1);
+		pose.SetLocal(k, (k == 0) ? vec3() : mPose->GetPositions()[k], quat(), vec3(1, 1, 1));
+	}
+	for (unsigned int f = 0; f < kBakedFrames; ++f)
+	{
+		float time = (float)f / (float)kBakedFrames * kSwayPeriod;
+		for (unsigned int k = 0; k < kJointsPerCharacter; ++k) { pose.GetRotations()[k] = GetSwayRotation(time, 0, k); }
+		pose.GetGlobalMatrices(world);
+		MultiplyArray(world, mInverseBindPose, frames + f * kJointsPerCharacter, kJointsPerCharacter);
+	}
+	// Written once, ending the frame right away fences it & later frames never touch it again
+	if (UsesDualQuaternions())
+	{
+		dualquat* dualQuats = gFrameArena->AllocateArray<dualquat>(kJointsPerCharacter * kBakedFrames);
+		if (dualQuats == 0)
+		{
+			std::cout << "CrowdSample: the frame arena is too small to bake the clip\n";
+			return false;
+		}
+		Mat4ToDualQuatArray(frames, dualQuats, kJointsPerCharacter * kBakedFrames);
+		mPalette.Upload(dualQuats, kBakedFrames);
+	}
+	else { mPalette.Upload(frames, kBakedFrames); }
+	mPalette.EndFrame();
+	return true;
+}
+
+void CrowdSample::Initialize()
+{
+	SkinningSample::Initialize();
+	if (!mReady) { return; }
+	if (mMode != SkinningMode::Gpu)
+	{
+		std::cout << "CrowdSample: instancing needs a GPU palette, drawing one character at a time\n";
+		return;
+	}
+
+	mInstances = gPersistentArena->AllocateArray<CrowdInstance>(mCharacterCount);
+	bool allocated = mInstances != 0;
+	for (unsigned int i = 0; i < mPacketCount && allocated; ++i)
+	{
+		mPacketInstances[i] = gPersistentArena->AllocateArray<CrowdInstance>(mCharacterCount);
+		allocated = mPacketInstances[i] != 0;
+	}
+	if (!allocated || !mInstanceBuffer.Initialize(mCharacterCount) || (mBaked && !BakeClip()))
+	{
+		if (!allocated) { std::cout << "CrowdSample: the persistent arena is too small for " << mCharacterCount << " instances\n"; }
+		Shutdown();
+		return;
+	}
+
+	// Live palettes already contain the grid position (it's the root's translation), baked ones are placed by the instance
+	for (unsigned int c = 0; c < mCharacterCount; ++c)
+	{
+		vec3 position = mBaked ? GetCharacterPosition(c) : vec3();
+		mInstances[c].position[0] = position.x;
+		mInstances[c].position[1] = position.y;
+		mInstances[c].position[2] = position.z;
+		mInstances[c].paletteOffset = mBaked ? 0 : (int)(c * kJointsPerCharacter);
+	}
+	std::cout << "CrowdSample: " << (mBaked ? "baked" : "live") << " palettes, 1 instanced draw\n";
+}
+
+void CrowdSample::Update(float inDeltaTime)
+{
+	if (!mReady) { return; }
+	if (!mBaked || mInstances == 0)
+	{
+		SkinningSample::Update(inDeltaTime);
+		return;
+	}
+
+	mTime += inDeltaTime;
+	PROFILE_SCOPE("Animate");
+	// Character c runs the same loop as character 0, shifted by its phase (0.7 radians of sin(2t) is 0.35 seconds)
+	for (unsigned int c = 0; c < mCharacterCount; ++c)
+	{
+		float time = fmodf(mTime + (float)c * 0.35f, kSwayPeriod);
+		unsigned int frame = (unsigned int)(time / kSwayPeriod * (float)kBakedFrames) % kBakedFrames;
+		mInstances[c].paletteOffset = (int)(frame * kJointsPerCharacter);
+	}
+}
+
+void CrowdSample::ExtractRenderData(unsigned int inPacket)
+{
+	SkinningSample::ExtractRenderData(inPacket);
+	if (!mReady || mInstances == 0 || inPacket >= mPacketCount) { return; }
+	memcpy(mPacketInstances[inPacket], mInstances, sizeof(CrowdInstance) * mCharacterCount);
+}
+
+void CrowdSample::RenderPacket(unsigned int inPacket, float inAspectRatio)
+{
+	if (!mReady || mInstances == 0)
+	{
+		SkinningSample::RenderPacket(inPacket, inAspectRatio);
+		return;
+	}
+	if (inPacket >= mPacketCount) { return; }
+	PROFILE_SCOPE("Crowd");
+	// Baked palettes were uploaded in Initialize(), live ones change every frame
+	if (mLivePalettes) { UploadPalettes(mPackets[inPacket], mCharacterCount); }
+	mInstanceBuffer.Upload(mPacketInstances[inPacket], mCharacterCount);
+	if (mShowJoints && mLivePalettes) { UploadJoints(mPackets[inPacket]); }
+	DrawCrowd(inPacket, inAspectRatio);
+}
+
+void CrowdSample::RenderView(unsigned int inView, unsigned int inPacket, float inAspectRatio)
+{
+	if (!mReady || mInstances == 0)
+	{
+		SkinningSample::RenderView(inView, inPacket, inAspectRatio);
+		return;
+	}
+	if (inPacket >= mPacketCount) { return; }
+	PROFILE_SCOPE("Crowd");
+	DrawCrowd(inPacket, inAspectRatio);
+}
+
+void CrowdSample::EndRenderPacket(unsigned int inPacket)
+{
+	SkinningSample::EndRenderPacket(inPacket);
+	mInstanceBuffer.EndFrame();
+}
+
+void CrowdSample::DrawCrowd(unsigned int inPacket, float inAspectRatio)
+{
+	mat4 viewProjection = GetViewProjection(mPackets[inPacket].eye, mPackets[inPacket].target, inAspectRatio);
+	mShader.Bind();
+	mView.Upload(viewProjection, normalized(vec3(-0.3f, -1.0f, -0.5f)), vec3(0.4f, 0.6f, 0.8f));
+	mPalette.Bind(0, mShader.GetUniform("uPaletteOffset"));
+
+	GLint position = mShader.GetAttribute("aPosition");
+	GLint normal = mShader.GetAttribute("aNormal");
+	GLint weights = mShader.GetAttribute("aWeights");
+	GLint joints = mShader.GetAttribute("aJoints");
+	GLint instancePosition = mShader.GetAttribute("aInstancePosition");
+	GLint paletteOffset = mShader.GetAttribute("aPaletteOffset");
+	mMesh.Bind(position, normal, -1, weights, joints);
+	mInstanceBuffer.Bind(instancePosition, paletteOffset);
+	mMesh.DrawInstanced(mInstanceBuffer.GetCount());
+	mInstanceBuffer.UnBind(instancePosition, paletteOffset);
+	mMesh.UnBind(position, normal, -1, weights, joints);
+	if (mShowJoints && mLivePalettes) { mDebugDraw.Draw(viewProjection); }
+
+	if (gProfiler != 0)
+	{
+		gProfiler->AddCounter("Skinned vertices", (float)(mMesh.GetVertexCount() * mCharacterCount));
+		gProfiler->AddCounter("Crowd instances", (float)mCharacterCount);
+	}
+}
+
+void CrowdSample::Shutdown()
+{
+	mInstanceBuffer.Shutdown();
+	mInstances = 0;
+	for (unsigned int i = 0; i < kMaxPackets; ++i) { mPacketInstances[i] = 0; }
+	SkinningSample::Shutdown();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef _H_CROWDSAMPLE_
+#define _H_CROWDSAMPLE_
+
+#include "SkinningSample.h"
+#include "Crowd.h"
+
+/**
+* Instanced crowd (-sample=crowd, -characters=N, -crowd=live|baked)
+* The whole crowd is one glDrawElementsInstanced call, every instance finds its palette in a texture buffer through
+* the aPaletteOffset instance attribute
+* - live: same animation as SkinningSample, Update() still writes every character's palette & the render thread uploads all of them
+* - baked: one loop of the animation is baked into kBakedFrames palettes at startup & uploaded once, per frame only the
+*   instance array (position + frame offset) is written, so the cost no longer grows with the joint count
+* -showjoints only works with live palettes, the baked ones aren't kept on the CPU
+*/
+class CrowdSample : public SkinningSample
+{
+public:
+	static const unsigned int kBakedFrames = 32;
+protected:
+	bool mBaked;
+	CrowdInstanceBuffer mInstanceBuffer;
+	CrowdInstance* mInstances;
+	CrowdInstance* mPacketInstances[kMaxPackets];
+protected:
+	bool BakeClip();
+	void DrawCrowd(unsigned int inPacket, float inAspectRatio);
+public:
+	CrowdSample(unsigned int inCharacterCount, bool inBaked);
+	~CrowdSample();
+	void Initialize();
+	void Update(float inDeltaTime);
+	void ExtractRenderData(unsigned int inPacket);
+	void RenderPacket(unsigned int inPacket, float inAspectRatio);
+	void RenderView(unsigned int inView, unsigned int inPacket, float inAspectRatio);
+	void EndRenderPacket(unsigned int inPacket);
+	void Shutdown();
+};
+
+#endif
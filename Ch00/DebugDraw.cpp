@@ -0,0 +1,153 @@
+#include "DebugDraw.h"
+#include "RenderState.h"
+#include <cstring>
+#include <string>
+
+// The View block goes after #version
+static const char* kDebugVertexBody =
+	"in vec3 aPosition;\n"
+	"in vec4 aColor;\n"
+	"out vec4 vColor;\n"
+	"void main()\n"
+	"{\n"
+	"	vColor = aColor;\n"
+	"	gl_Position = uViewProjection * vec4(aPosition, 1.0);\n"
+	"}\n";
+
+static const char* kDebugFragmentShader =
+	"#version 330 core\n"
+	"in vec4 vColor;\n"
+	"out vec4 FragColor;\n"
+	"void main()\n"
+	"{\n"
+	"	FragColor = vColor;\n"
+	"}\n";
+
+DebugDraw::DebugDraw()
+{
+	mMaxVertices = 0;
+	mLineOffset = 0;
+	mLineCount = 0;
+	mPointOffset = 0;
+	mPointCount = 0;
+}
+
+DebugDraw::~DebugDraw()
+{
+	Shutdown();
+}
+
+bool DebugDraw::Initialize(unsigned int inMaxVertices)
+{
+	Shutdown();
+	mMaxVertices = inMaxVertices;
+	mLines.reserve(inMaxVertices);
+	mPoints.reserve(inMaxVertices);
+	// Both lists go through the same region every frame, lines first
+	if (!mStream.Initialize(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(Vertex) * inMaxVertices * 2), StreamBufferMode::Auto)) { return false; }
+	if (!mView.Initialize() || !mShader.Load(std::string("#version 330 core\n") + GetViewUniformBlock() + kDebugVertexBody, kDebugFragmentShader)) { return false; }
+	mView.ConfigureShader(mShader);
+	return true;
+}
+
+void DebugDraw::Shutdown()
+{
+	mStream.Shutdown();
+	mView.Shutdown();
+	mShader.Release();
+	mLines.clear();
+	mPoints.clear();
+	mLineCount = 0;
+	mPointCount = 0;
+}
+
+unsigned int DebugDraw::PackColor(const vec3& inColor)
+{
+	unsigned int r = (unsigned int)(inColor.x < 0.0f ? 0.0f : (inColor.x > 1.0f ? 1.0f : inColor.x) * 255.0f + 0.5f);
+	unsigned int g = (unsigned int)(inColor.y < 0.0f ? 0.0f : (inColor.y > 1.0f ? 1.0f : inColor.y) * 255.0f + 0.5f);
+	unsigned int b = (unsigned int)(inColor.z < 0.0f ? 0.0f : (inColor.z > 1.0f ? 1.0f : inColor.z) * 255.0f + 0.5f);
+	// Little endian, so the bytes in memory are r, g, b, a
+	return r | (g << 8) | (b << 16) | (255u << 24);
+}
+
+void DebugDraw::AddLine(const vec3& inFrom, const vec3& inTo, const vec3& inColor)
+{
+	if (mLines.size() + 2 > mMaxVertices) { return; }
+	unsigned int color = PackColor(inColor);
+	Vertex from = { { inFrom.x, inFrom.y, inFrom.z }, color };
+	Vertex to = { { inTo.x, inTo.y, inTo.z }, color };
+	mLines.push_back(from);
+	mLines.push_back(to);
+}
+
+void DebugDraw::AddPoint(const vec3& inPosition, const vec3& inColor)
+{
+	if (mPoints.size() + 1 > mMaxVertices) { return; }
+	Vertex point = { { inPosition.x, inPosition.y, inPosition.z }, PackColor(inColor) };
+	mPoints.push_back(point);
+}
+
+GLsizei DebugDraw::UploadList(std::vector<Vertex>& inVertices, GLintptr& outOffset)
+{
+	if (inVertices.empty()) { return 0; }
+	GLsizei count = (GLsizei)inVertices.size();
+	GLsizeiptr size = (GLsizeiptr)(sizeof(Vertex) * count);
+	void* mapped = mStream.Map(size, sizeof(Vertex), outOffset);
+	if (mapped != 0)
+	{
+		memcpy(mapped, &inVertices[0], (size_t)size);
+		mStream.Unmap();
+	}
+	inVertices.clear();
+	return mapped != 0 ? count : 0;
+}
+
+void DebugDraw::DrawList(GLintptr inOffset, GLsizei inCount, GLenum inMode)
+{
+	if (inCount == 0) { return; }
+	GLint position = mShader.GetAttribute("aPosition");
+	GLint color = mShader.GetAttribute("aColor");
+	gRenderState->BindBuffer(GL_ARRAY_BUFFER, mStream.GetBuffer());
+	if (position >= 0)
+	{
+		glEnableVertexAttribArray((GLuint)position);
+		glVertexAttribPointer((GLuint)position, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)inOffset);
+	}
+	if (color >= 0)
+	{
+		glEnableVertexAttribArray((GLuint)color);
+		glVertexAttribPointer((GLuint)color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)(inOffset + sizeof(float) * 3));
+	}
+	glDrawArrays(inMode, 0, inCount);
+	if (position >= 0) { glDisableVertexAttribArray((GLuint)position); }
+	if (color >= 0) { glDisableVertexAttribArray((GLuint)color); }
+}
+
+void DebugDraw::Upload()
+{
+	mLineCount = 0;
+	mPointCount = 0;
+	if (mShader.GetHandle() == 0 || (mLines.empty() && mPoints.empty())) { return; }
+	mStream.BeginFrame();
+	mLineCount = UploadList(mLines, mLineOffset);
+	mPointCount = UploadList(mPoints, mPointOffset);
+}
+
+void DebugDraw::Draw(const mat4& inViewProjection)
+{
+	if (mLineCount == 0 && mPointCount == 0) { return; }
+	mShader.Bind();
+	// Only the view projection is read, light & color are there for the lit shaders
+	mView.Upload(inViewProjection, vec3(), vec3(1.0f, 1.0f, 1.0f));
+	// Debug geometry is usually inside the mesh it describes, so it's drawn on top
+	gRenderState->Disable(GL_DEPTH_TEST);
+	DrawList(mLineOffset, mLineCount, GL_LINES);
+	DrawList(mPointOffset, mPointCount, GL_POINTS);
+	gRenderState->Enable(GL_DEPTH_TEST);
+}
+
+void DebugDraw::EndFrame()
+{
+	mStream.EndFrame();
+	mView.EndFrame();
+}
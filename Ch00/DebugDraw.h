@@ -0,0 +1,62 @@
+#pragma once
+#ifndef _H_DEBUGDRAW_
+#define _H_DEBUGDRAW_
+
+#include "StreamBuffer.h"
+#include "ViewUniforms.h"
+#include "Shader.h"
+#include "vec3.h"
+#include "mat4.h"
+#include <vector>
+
+/**
+* Immediate mode lines & points for debugging (skeletons, bounds, targets)
+* Add*() collects vertices on the CPU, Upload() streams them through a StreamBuffer & clears the lists for the next frame,
+* Draw() then streams the view projection through ViewUniforms, issues one GL_LINES & one GL_POINTS draw & can be called once per
+* view (see Application::RenderView())
+* EndFrame() fences the upload after the last Draw(). Point size comes from the game loop (gRenderState->PointSize)
+* Everything has to happen on the thread that renders, the vertex lists are reserved up front so Add*() doesn't allocate
+* until more than inMaxVertices are added in a frame
+*/
+class DebugDraw
+{
+private:
+	struct Vertex
+	{
+		float position[3];
+		unsigned int color; // RGBA8
+	};
+	std::vector<Vertex> mLines;
+	std::vector<Vertex> mPoints;
+	StreamBuffer mStream;
+	ViewUniforms mView;
+	Shader mShader;
+	unsigned int mMaxVertices;
+	// What the last Upload() streamed
+	GLintptr mLineOffset;
+	GLsizei mLineCount;
+	GLintptr mPointOffset;
+	GLsizei mPointCount;
+private:
+	DebugDraw(const DebugDraw&);
+	DebugDraw& operator=(const DebugDraw&);
+	static unsigned int PackColor(const vec3& inColor);
+	GLsizei UploadList(std::vector<Vertex>& inVertices, GLintptr& outOffset);
+	void DrawList(GLintptr inOffset, GLsizei inCount, GLenum inMode);
+public:
+	DebugDraw();
+	~DebugDraw();
+
+	bool Initialize(unsigned int inMaxVertices);
+	void Shutdown();
+
+	void AddLine(const vec3& inFrom, const vec3& inTo, const vec3& inColor);
+	void AddPoint(const vec3& inPosition, const vec3& inColor);
+	// Anything past inMaxVertices in a frame is dropped
+	void Upload();
+	// Drawn without depth testing
+	void Draw(const mat4& inViewProjection);
+	void EndFrame();
+};
+
+#endif
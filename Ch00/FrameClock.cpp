@@ -0,0 +1,97 @@
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#include <Windows.h>
+#include "FrameClock.h"
+
+FrameClock::FrameClock()
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	mFrequency = frequency.QuadPart;
+	mLastCounter = Now();
+}
+
+void FrameClock::Reset()
+{
+	mLastCounter = Now();
+}
+
+float FrameClock::Tick()
+{
+	long long thisCounter = Now();
+	long long delta = thisCounter - mLastCounter;
+	mLastCounter = thisCounter;
+	// Do the division in double precision, the raw counter values are too large to be accurate as floats
+	return (float)((double)delta / (double)mFrequency);
+}
+
+long long FrameClock::Now()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+double FrameClock::ToSeconds(long long inCounterDelta)
+{
+	// The frequency is fixed at boot so it's safe to query it once & cache it
+	static long long frequency = 0;
+	if (frequency == 0)
+	{
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		frequency = f.QuadPart;
+	}
+	return (double)inCounterDelta / (double)frequency;
+}
+
+FixedStepper::FixedStepper(float inStep, float inMaxFrameTime, unsigned int inMaxSteps)
+{
+	mStep = inStep;
+	mAccumulator = 0.0f;
+	mMaxFrameTime = inMaxFrameTime;
+	mMaxSteps = inMaxSteps;
+}
+
+unsigned int FixedStepper::Advance(float inFrameTime)
+{
+	// A long stall (breakpoint, window drag, loading) shouldn't be simulated in one go
+	if (inFrameTime > mMaxFrameTime) { inFrameTime = mMaxFrameTime; }
+	if (inFrameTime < 0.0f) { inFrameTime = 0.0f; }
+	mAccumulator += inFrameTime;
+
+	unsigned int steps = 0;
+	while (mAccumulator >= mStep && steps < mMaxSteps)
+	{
+		mAccumulator -= mStep;
+		++steps;
+	}
+
+	// If we hit the step limit, drop the backlog instead of carrying it into the next frame
+	if (steps == mMaxSteps && mAccumulator >= mStep)
+	{
+		mAccumulator = 0.0f;
+	}
+
+	return steps;
+}
+
+float FixedStepper::GetAlpha() const
+{
+	return mAccumulator / mStep;
+}
+
+float FixedStepper::GetStep() const
+{
+	return mStep;
+}
+
+void FixedStepper::SetStep(float inStep)
+{
+	if (inStep > 0.0f) { mStep = inStep; }
+}
+
+void FixedStepper::Reset()
+{
+	mAccumulator = 0.0f;
+}
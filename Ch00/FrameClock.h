@@ -0,0 +1,62 @@
+#pragma once
+#ifndef _H_FRAMECLOCK_
+#define _H_FRAMECLOCK_
+
+/**
+* GetTickCount() only has a resolution of ~15.6ms which means at 60+ Hz the delta time swings between 0 & 16ms
+* QueryPerformanceCounter (QPC) is a high resolution (< 1us) monotonic counter, so we use it to time frames instead
+* The Win32 calls are kept inside FrameClock.cpp so that this header doesn't have to pull in windows.h
+*/
+class FrameClock
+{
+private:
+	long long mFrequency; // Counts per second reported by QueryPerformanceFrequency
+	long long mLastCounter; // Counter value at the last call to Tick()
+public:
+	FrameClock();
+	// Restart the clock, the next Tick() returns the time elapsed since this call
+	void Reset();
+	// Returns the time in seconds since the last Tick() (or Reset()) & starts timing the next frame
+	float Tick();
+	// Raw QPC access, useful for timing sections of a frame
+	static long long Now();
+	static double ToSeconds(long long inCounterDelta);
+};
+
+/**
+* StepMode decides how the game loop advances the Application
+* Variable - Update() is called once per frame with the measured frame time
+* Fixed - Update() is called 0..n times per frame with a constant step, the left over time is passed on as an interpolation alpha
+* A fixed step makes animation playback deterministic & reproducible no matter how fast or slow the frame rate is
+*/
+enum class StepMode
+{
+	Variable,
+	Fixed
+};
+
+/**
+* FixedStepper is the accumulator used by StepMode::Fixed
+* Each frame the measured frame time is added to the accumulator & consumed in chunks of mStep
+* To avoid the "spiral of death" (updates taking longer than a step so we fall further behind every frame)
+* the frame time is clamped to mMaxFrameTime & at most mMaxSteps updates are run per frame, any extra time is dropped
+*/
+class FixedStepper
+{
+private:
+	float mStep;
+	float mAccumulator;
+	float mMaxFrameTime;
+	unsigned int mMaxSteps;
+public:
+	FixedStepper(float inStep = 1.0f / 60.0f, float inMaxFrameTime = 0.25f, unsigned int inMaxSteps = 8);
+	// Adds the frame time to the accumulator & returns the number of fixed updates that need to run this frame
+	unsigned int Advance(float inFrameTime);
+	// How far (0 to 1) we are between the last fixed update & the next one
+	float GetAlpha() const;
+	float GetStep() const;
+	void SetStep(float inStep);
+	void Reset();
+};
+
+#endif
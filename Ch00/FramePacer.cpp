@@ -0,0 +1,190 @@
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#include "FramePacer.h"
+#include "FrameProfiler.h"
+#include <Windows.h>
+#include <iostream>
+#include <cstring>
+
+// Instead of including wgl.h we just define the function pointer signatures required for swap control
+typedef const char* (WINAPI* PFNWGLGETEXTENSIONSSTRINGEXTPROC)(void);
+typedef BOOL (WINAPI* PFNWGLSWAPINTERVALEXTPROC)(int);
+typedef int (WINAPI* PFNWGLGETSWAPINTERVALEXTPROC)(void);
+
+FramePacer::FramePacer()
+{
+	mMode = FramePacing::None;
+	mFramesInFlight = 1;
+	for (unsigned int i = 0; i < kMaxFramesInFlight; ++i) { mFences[i] = 0; }
+	mFrameIndex = 0;
+	mSwapInterval = 0;
+	mWaitFailedReported = false;
+}
+
+FramePacer::~FramePacer()
+{
+	for (unsigned int i = 0; i < kMaxFramesInFlight; ++i)
+	{
+		if (mFences[i] != 0)
+		{
+			std::cout << "FramePacer destroyed without calling Shutdown()\n";
+			break;
+		}
+	}
+}
+
+void FramePacer::Initialize(FramePacing inMode, unsigned int inFramesInFlight, bool inVSync)
+{
+	mMode = inMode;
+	mFramesInFlight = inFramesInFlight;
+	if (mFramesInFlight < 1) { mFramesInFlight = 1; }
+	if (mFramesInFlight > kMaxFramesInFlight) { mFramesInFlight = kMaxFramesInFlight; }
+	mFrameIndex = 0;
+	mWaitFailedReported = false;
+
+	/**
+	* vsync is not a built-in function, it's an extension so it needs to be called using wglGetExtensionStringEXT
+	* The extension string for vsync is WGL_EXT_swap_control, adaptive vsync (negative swap intervals) is WGL_EXT_swap_control_tear
+	* strstr returns a ptr to the first occurence of the sub-string or a nullptr if the substring isn't present
+	*/
+	PFNWGLGETEXTENSIONSSTRINGEXTPROC _wglGetExtensionsStringEXT = (PFNWGLGETEXTENSIONSSTRINGEXTPROC)wglGetProcAddress("wglGetExtensionsStringEXT");
+	const char* extensions = (_wglGetExtensionsStringEXT != 0) ? _wglGetExtensionsStringEXT() : "";
+	bool swapControlSupported = strstr(extensions, "WGL_EXT_swap_control") != 0;
+	bool swapControlTearSupported = strstr(extensions, "WGL_EXT_swap_control_tear") != 0;
+
+	mSwapInterval = 0;
+	if (!swapControlSupported)
+	{
+		std::cout << "WGL_EXT_swap_control not enabled\n";
+	}
+	else
+	{
+		PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
+		PFNWGLGETSWAPINTERVALEXTPROC wglGetSwapIntervalEXT = (PFNWGLGETSWAPINTERVALEXTPROC)wglGetProcAddress("wglGetSwapIntervalEXT");
+
+		int interval = inVSync ? 1 : 0;
+		if (inVSync && mMode == FramePacing::AdaptiveVSync)
+		{
+			if (swapControlTearSupported) { interval = -1; }
+			else { std::cout << "WGL_EXT_swap_control_tear not supported, using regular vsynch\n"; }
+		}
+
+		if (wglSwapIntervalEXT(interval))
+		{
+			mSwapInterval = wglGetSwapIntervalEXT();
+			if (mSwapInterval < 0) { std::cout << "Enabled adaptive vsynch\n"; }
+			else if (mSwapInterval > 0) { std::cout << "Enabled vsynch\n"; }
+			else { std::cout << "Disabled vsynch\n"; }
+		}
+		else { std::cout << "Couldn't set swap interval " << interval << "\n"; }
+	}
+
+	std::cout << "Frame pacing: " << GetModeName(mMode);
+	if (mMode == FramePacing::Fence || mMode == FramePacing::AdaptiveVSync) { std::cout << " (" << mFramesInFlight << " frames in flight)"; }
+	std::cout << "\n";
+}
+
+void FramePacer::Shutdown()
+{
+	for (unsigned int i = 0; i < kMaxFramesInFlight; ++i)
+	{
+		if (mFences[i] != 0)
+		{
+			glDeleteSync(mFences[i]);
+			mFences[i] = 0;
+		}
+	}
+}
+
+void FramePacer::WaitForFence(GLsync inFence)
+{
+	/**
+	* The first wait flushes the command stream, otherwise the fence might never reach the GPU & we'd wait forever
+	* The wait is split into 1ms chunks so a lost device (GL_WAIT_FAILED) doesn't hang the loop
+	* Giving up after a second lets the frame go on unpaced, which is reported since it means the GPU is hung or lost
+	*/
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	const GLuint64 timeout = 1000000; // 1ms in nanoseconds
+	GLenum result = GL_TIMEOUT_EXPIRED;
+	for (unsigned int attempt = 0; attempt < 1000 && result == GL_TIMEOUT_EXPIRED; ++attempt)
+	{
+		result = glClientWaitSync(inFence, flags, timeout);
+		flags = 0;
+	}
+	if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) { return; }
+
+	if (gProfiler != 0) { gProfiler->AddCounter("Frame fence timeouts", 1.0f); }
+	if (result == GL_WAIT_FAILED)
+	{
+		if (!mWaitFailedReported) { std::cout << "FramePacer: waiting on the frame fence failed, the context may be lost\n"; }
+		mWaitFailedReported = true;
+	}
+	// Each of these took a whole second, so they can't flood the console
+	else { std::cout << "FramePacer: gave up waiting on the frame fence, the GPU is more than a second behind\n"; }
+}
+
+void FramePacer::FramePresented()
+{
+	switch (mMode)
+	{
+	case FramePacing::None:
+		break;
+	case FramePacing::Finish:
+		glFinish();
+		break;
+	case FramePacing::Fence:
+	case FramePacing::AdaptiveVSync:
+		{
+			/**
+			* Each slot of the ring holds the fence of the frame that was presented mFramesInFlight frames ago
+			* Waiting on it before reusing the slot keeps at most mFramesInFlight frames queued, while the CPU keeps working on the next frame
+			*/
+			unsigned int slot = mFrameIndex % mFramesInFlight;
+			if (mFences[slot] != 0)
+			{
+				WaitForFence(mFences[slot]);
+				glDeleteSync(mFences[slot]);
+			}
+			mFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			++mFrameIndex;
+		}
+		break;
+	}
+}
+
+FramePacing FramePacer::GetMode() const
+{
+	return mMode;
+}
+
+unsigned int FramePacer::GetFramesInFlight() const
+{
+	return mFramesInFlight;
+}
+
+int FramePacer::GetSwapInterval() const
+{
+	return mSwapInterval;
+}
+
+FramePacing FramePacer::ParseMode(const char* inName, FramePacing inDefault)
+{
+	if (inName == 0) { return inDefault; }
+	if (strcmp(inName, "none") == 0) { return FramePacing::None; }
+	if (strcmp(inName, "finish") == 0) { return FramePacing::Finish; }
+	if (strcmp(inName, "fence") == 0) { return FramePacing::Fence; }
+	if (strcmp(inName, "adaptive") == 0) { return FramePacing::AdaptiveVSync; }
+	return inDefault;
+}
+
+const char* FramePacer::GetModeName(FramePacing inMode)
+{
+	switch (inMode)
+	{
+	case FramePacing::None: return "none";
+	case FramePacing::Finish: return "finish";
+	case FramePacing::Fence: return "fence";
+	case FramePacing::AdaptiveVSync: return "adaptive";
+	}
+	return "unknown";
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef _H_FRAMEPACER_
+#define _H_FRAMEPACER_
+
+#include "include/glad/glad.h"
+
+/**
+* FramePacing decides how the CPU is kept from running too far ahead of the GPU after SwapBuffers
+* None - no CPU side sync, the driver decides how many frames can be queued (lowest CPU cost, highest latency)
+* Finish - glFinish() after every swap, the CPU waits until the GPU is completely idle (lowest latency, no CPU/GPU overlap)
+* Fence - a fence is inserted after every swap & the CPU only waits for the fence from N frames ago, so N frames can be in flight
+* AdaptiveVSync - same as Fence, but with a swap interval of -1 (WGL_EXT_swap_control_tear) so a late frame tears instead of waiting a whole refresh
+*/
+enum class FramePacing
+{
+	None,
+	Finish,
+	Fence,
+	AdaptiveVSync
+};
+
+class FramePacer
+{
+public:
+	static const unsigned int kMaxFramesInFlight = 4;
+private:
+	FramePacing mMode;
+	unsigned int mFramesInFlight;
+	GLsync mFences[kMaxFramesInFlight];
+	unsigned int mFrameIndex;
+	int mSwapInterval; // Swap interval reported by the driver after Initialize(), 0 if vsync is off
+	bool mWaitFailedReported; // A lost context fails every wait, it's only printed once
+private:
+	FramePacer(const FramePacer&);
+	FramePacer& operator=(const FramePacer&);
+	void WaitForFence(GLsync inFence);
+public:
+	FramePacer();
+	~FramePacer();
+
+	/**
+	* Sets the swap interval & pacing mode, needs the OpenGL context to be current
+	* inVSync = false requests a swap interval of 0, in that case AdaptiveVSync behaves like Fence
+	*/
+	void Initialize(FramePacing inMode, unsigned int inFramesInFlight, bool inVSync);
+	// Deletes any pending fences, needs the OpenGL context to be current
+	void Shutdown();
+	// Has to be called right after SwapBuffers()
+	void FramePresented();
+
+	FramePacing GetMode() const;
+	unsigned int GetFramesInFlight() const;
+	int GetSwapInterval() const;
+
+	// Parses none, finish, fence or adaptive. Returns inDefault for anything else
+	static FramePacing ParseMode(const char* inName, FramePacing inDefault);
+	static const char* GetModeName(FramePacing inMode);
+};
+
+#endif
@@ -0,0 +1,551 @@
+#include "FrameProfiler.h"
+#include "FrameClock.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+thread_local FrameProfiler* gProfiler = 0;
+
+RollingTimer::RollingTimer()
+{
+	Clear();
+}
+
+void RollingTimer::Add(float inSample)
+{
+	mSamples[mHead] = inSample;
+	mHead = (mHead + 1) % kWindow;
+	if (mCount < kWindow) { ++mCount; }
+}
+
+void RollingTimer::Clear()
+{
+	mHead = 0;
+	mCount = 0;
+}
+
+ProfileStats RollingTimer::Compute() const
+{
+	ProfileStats result;
+	result.min = result.avg = result.p99 = result.max = 0.0f;
+	result.count = mCount;
+	if (mCount == 0) { return result; }
+
+	// The ring is small enough to sort a copy, which gives us the percentile for free
+	float sorted[kWindow];
+	memcpy(sorted, mSamples, sizeof(float) * mCount);
+	std::sort(sorted, sorted + mCount);
+
+	double sum = 0.0;
+	for (unsigned int i = 0; i < mCount; ++i) { sum += sorted[i]; }
+
+	unsigned int p99Index = (mCount * 99) / 100;
+	if (p99Index >= mCount) { p99Index = mCount - 1; }
+
+	result.min = sorted[0];
+	result.avg = (float)(sum / (double)mCount);
+	result.p99 = sorted[p99Index];
+	result.max = sorted[mCount - 1];
+	return result;
+}
+
+float RollingTimer::GetLast() const
+{
+	if (mCount == 0) { return 0.0f; }
+	return mSamples[(mHead + kWindow - 1) % kWindow];
+}
+
+FrameProfiler::FrameProfiler()
+{
+	mMarkerCount = 0;
+	mCounterCount = 0;
+	mStackSize = 0;
+	mGpuEnabled = false;
+	mElapsedActive = false;
+	memset(mQueryPool, 0, sizeof(mQueryPool));
+	for (unsigned int i = 0; i < kGpuLatency; ++i)
+	{
+		mGpuFrames[i].count = 0;
+		mGpuFrames[i].frameIndex = 0;
+	}
+	mDroppedGpuFrames = 0;
+	mLastGpuFrame = -1;
+	mFrameStart = 0;
+	mFrameIndex = 0;
+	mFrameAllocStart = 0;
+	mInFrame = false;
+}
+
+FrameProfiler::~FrameProfiler()
+{
+	if (mGpuEnabled) { std::cout << "FrameProfiler destroyed without calling Shutdown()\n"; }
+}
+
+void FrameProfiler::Initialize(bool inGpuTimers)
+{
+	mGpuEnabled = inGpuTimers;
+	if (mGpuEnabled)
+	{
+		glGenQueries(kGpuLatency * kMaxGpuQueries * 2, &mQueryPool[0][0]);
+	}
+}
+
+void FrameProfiler::Shutdown()
+{
+	if (mGpuEnabled)
+	{
+		glDeleteQueries(kGpuLatency * kMaxGpuQueries * 2, &mQueryPool[0][0]);
+		memset(mQueryPool, 0, sizeof(mQueryPool));
+		mGpuEnabled = false;
+	}
+}
+
+int FrameProfiler::FindOrAddMarker(const char* inName, int inParent)
+{
+	for (unsigned int i = 0; i < mMarkerCount; ++i)
+	{
+		if (mMarkers[i].parent == inParent && (mMarkers[i].name == inName || strcmp(mMarkers[i].name, inName) == 0))
+		{
+			return (int)i;
+		}
+	}
+	if (mMarkerCount == kMaxMarkers) { return -1; }
+
+	Marker& marker = mMarkers[mMarkerCount];
+	marker.name = inName;
+	marker.parent = inParent;
+	marker.depth = (inParent < 0) ? 0 : mMarkers[inParent].depth + 1;
+	marker.hasGpu = false;
+	marker.seenThisFrame = false;
+	marker.seenLastFrame = false;
+	marker.gpuSeenLastCollect = false;
+	marker.cpuFrameTotal = 0.0;
+	marker.allocFrameTotal = 0;
+	marker.cpu.Clear();
+	marker.gpu.Clear();
+	marker.allocations.Clear();
+	return (int)(mMarkerCount++);
+}
+
+void FrameProfiler::CollectGpuFrame(GpuFrame& inFrame)
+{
+	if (inFrame.count == 0) { return; }
+
+	/**
+	* Every query that's read has to be available, otherwise GL_QUERY_RESULT blocks. The last query in the list isn't the last to
+	* end: the outer GL_TIME_ELAPSED query is recorded when its marker opens but ends after all the timestamps nested inside it
+	*/
+	for (unsigned int i = 0; i < inFrame.count; ++i)
+	{
+		const GpuQuery& query = inFrame.queries[i];
+		GLint available = 0;
+		glGetQueryObjectiv(query.elapsed ? query.begin : query.end, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available && !query.elapsed) { glGetQueryObjectiv(query.begin, GL_QUERY_RESULT_AVAILABLE, &available); }
+		if (!available)
+		{
+			++mDroppedGpuFrames;
+			inFrame.count = 0;
+			return;
+		}
+	}
+
+	double gpuTotals[kMaxMarkers];
+	bool gpuSeen[kMaxMarkers];
+	for (unsigned int i = 0; i < mMarkerCount; ++i)
+	{
+		gpuTotals[i] = 0.0;
+		gpuSeen[i] = false;
+	}
+
+	for (unsigned int i = 0; i < inFrame.count; ++i)
+	{
+		const GpuQuery& query = inFrame.queries[i];
+		GLuint64 nanoseconds = 0;
+		if (query.elapsed)
+		{
+			glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &nanoseconds);
+		}
+		else
+		{
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+			nanoseconds = (end > begin) ? end - begin : 0;
+		}
+		gpuTotals[query.marker] += (double)nanoseconds;
+		gpuSeen[query.marker] = true;
+	}
+
+	for (unsigned int i = 0; i < mMarkerCount; ++i)
+	{
+		mMarkers[i].gpuSeenLastCollect = gpuSeen[i];
+		if (gpuSeen[i]) { mMarkers[i].gpu.Add((float)(gpuTotals[i] / 1000000.0)); }
+	}
+	mLastGpuFrame = (long long)inFrame.frameIndex;
+	inFrame.count = 0;
+}
+
+void FrameProfiler::BeginFrame()
+{
+	if (mInFrame) { EndFrame(); }
+	mInFrame = true;
+	mFrameStart = FrameClock::Now();
+	mFrameAllocStart = GetGlobalAllocationCounts().allocations;
+
+	// The slot we're about to reuse was written kGpuLatency frames ago, its results should be ready by now
+	if (mGpuEnabled)
+	{
+		GpuFrame& frame = mGpuFrames[mFrameIndex % kGpuLatency];
+		CollectGpuFrame(frame);
+		frame.frameIndex = mFrameIndex;
+	}
+}
+
+void FrameProfiler::EndFrame()
+{
+	if (!mInFrame) { return; }
+	while (mStackSize > 0)
+	{
+		std::cout << "Profiler marker " << mMarkers[mStack[mStackSize - 1].marker].name << " wasn't closed before the end of the frame\n";
+		EndMarker();
+	}
+
+	mFrameTime.Add((float)(FrameClock::ToSeconds(FrameClock::Now() - mFrameStart) * 1000.0));
+	mFrameAllocations.Add((float)(GetGlobalAllocationCounts().allocations - mFrameAllocStart));
+	for (unsigned int i = 0; i < mMarkerCount; ++i)
+	{
+		Marker& marker = mMarkers[i];
+		marker.seenLastFrame = marker.seenThisFrame;
+		if (!marker.seenThisFrame) { continue; }
+		marker.cpu.Add((float)(marker.cpuFrameTotal * 1000.0));
+		marker.allocations.Add((float)marker.allocFrameTotal);
+		marker.cpuFrameTotal = 0.0;
+		marker.allocFrameTotal = 0;
+		marker.seenThisFrame = false;
+	}
+	for (unsigned int i = 0; i < mCounterCount; ++i)
+	{
+		Counter& counter = mCounters[i];
+		if (!counter.seenThisFrame) { continue; }
+		counter.values.Add(counter.frameTotal);
+		counter.frameTotal = 0.0f;
+		counter.seenThisFrame = false;
+	}
+
+	++mFrameIndex;
+	mInFrame = false;
+}
+
+void FrameProfiler::BeginMarker(const char* inName, bool inGpu)
+{
+	int parent = (mStackSize > 0) ? mStack[mStackSize - 1].marker : -1;
+	int index = (mStackSize < kMaxDepth) ? FindOrAddMarker(inName, parent) : -1;
+
+	// Out of markers or nested too deep, still push so Begin/End stay paired
+	OpenMarker open;
+	open.marker = index;
+	open.cpuStart = FrameClock::Now();
+	open.allocStart = GetThreadAllocationCounts().allocations;
+	open.gpuQuery = -1;
+
+	if (index >= 0 && inGpu && mGpuEnabled)
+	{
+		GpuFrame& frame = mGpuFrames[mFrameIndex % kGpuLatency];
+		if (frame.count < kMaxGpuQueries)
+		{
+			GpuQuery& query = frame.queries[frame.count];
+			query.marker = index;
+			query.begin = mQueryPool[mFrameIndex % kGpuLatency][frame.count * 2];
+			query.end = mQueryPool[mFrameIndex % kGpuLatency][frame.count * 2 + 1];
+			query.elapsed = !mElapsedActive;
+			if (query.elapsed)
+			{
+				glBeginQuery(GL_TIME_ELAPSED, query.begin);
+				mElapsedActive = true;
+			}
+			else
+			{
+				glQueryCounter(query.begin, GL_TIMESTAMP);
+			}
+			open.gpuQuery = (int)frame.count;
+			++frame.count;
+			mMarkers[index].hasGpu = true;
+		}
+	}
+
+	if (mStackSize < kMaxDepth) { mStack[mStackSize] = open; }
+	++mStackSize;
+}
+
+void FrameProfiler::EndMarker()
+{
+	if (mStackSize == 0)
+	{
+		std::cout << "Profiler EndMarker() called without a matching BeginMarker()\n";
+		return;
+	}
+	--mStackSize;
+	if (mStackSize >= kMaxDepth) { return; }
+
+	const OpenMarker& open = mStack[mStackSize];
+	if (open.marker < 0) { return; }
+
+	if (open.gpuQuery >= 0)
+	{
+		const GpuQuery& query = mGpuFrames[mFrameIndex % kGpuLatency].queries[open.gpuQuery];
+		if (query.elapsed)
+		{
+			glEndQuery(GL_TIME_ELAPSED);
+			mElapsedActive = false;
+		}
+		else
+		{
+			glQueryCounter(query.end, GL_TIMESTAMP);
+		}
+	}
+
+	Marker& marker = mMarkers[open.marker];
+	marker.cpuFrameTotal += FrameClock::ToSeconds(FrameClock::Now() - open.cpuStart);
+	marker.allocFrameTotal += GetThreadAllocationCounts().allocations - open.allocStart;
+	marker.seenThisFrame = true;
+}
+
+void FrameProfiler::AddCounter(const char* inName, float inValue)
+{
+	for (unsigned int i = 0; i < mCounterCount; ++i)
+	{
+		if (mCounters[i].name == inName || strcmp(mCounters[i].name, inName) == 0)
+		{
+			mCounters[i].frameTotal += inValue;
+			mCounters[i].seenThisFrame = true;
+			return;
+		}
+	}
+	if (mCounterCount == kMaxCounters) { return; }
+
+	Counter& counter = mCounters[mCounterCount++];
+	counter.name = inName;
+	counter.frameTotal = inValue;
+	counter.seenThisFrame = true;
+	counter.values.Clear();
+}
+
+bool FrameProfiler::GetMarkerStats(const char* inName, ProfileStats& outCpu, ProfileStats& outGpu) const
+{
+	for (unsigned int i = 0; i < mMarkerCount; ++i)
+	{
+		if (strcmp(mMarkers[i].name, inName) == 0)
+		{
+			outCpu = mMarkers[i].cpu.Compute();
+			outGpu = mMarkers[i].gpu.Compute();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FrameProfiler::GetCounterStats(const char* inName, ProfileStats& outStats) const
+{
+	for (unsigned int i = 0; i < mCounterCount; ++i)
+	{
+		if (strcmp(mCounters[i].name, inName) == 0)
+		{
+			outStats = mCounters[i].values.Compute();
+			return true;
+		}
+	}
+	return false;
+}
+
+ProfileStats FrameProfiler::GetFrameStats() const
+{
+	return mFrameTime.Compute();
+}
+
+unsigned long long FrameProfiler::GetFrameIndex() const
+{
+	return mFrameIndex;
+}
+
+unsigned int FrameProfiler::GetDroppedGpuFrames() const
+{
+	return mDroppedGpuFrames;
+}
+
+long long FrameProfiler::GetLastGpuFrameIndex() const
+{
+	return mLastGpuFrame;
+}
+
+static void PrintStats(std::ostream& inStream, const ProfileStats& inStats)
+{
+	inStream << std::setw(9) << inStats.min << std::setw(9) << inStats.avg << std::setw(9) << inStats.p99 << std::setw(9) << inStats.max;
+}
+
+static void PrintAllocations(std::ostream& inStream, const ProfileStats& inStats)
+{
+	if (!IsAllocationTrackingEnabled()) { return; }
+	inStream << "  allocs" << std::setw(9) << inStats.avg << std::setw(7) << (unsigned int)inStats.max;
+}
+
+void FrameProfiler::ReportMarker(std::ostream& inStream, int inMarker) const
+{
+	const Marker& marker = mMarkers[inMarker];
+	std::string label(marker.depth * 2, ' ');
+	label += marker.name;
+
+	inStream << std::left << std::setw(28) << label << std::right << " cpu";
+	PrintStats(inStream, marker.cpu.Compute());
+	if (marker.hasGpu)
+	{
+		inStream << "  gpu";
+		PrintStats(inStream, marker.gpu.Compute());
+	}
+	PrintAllocations(inStream, marker.allocations.Compute());
+	inStream << "\n";
+
+	// Markers are added in the order they are first seen, so children always come after their parent
+	for (unsigned int i = inMarker + 1; i < mMarkerCount; ++i)
+	{
+		if (mMarkers[i].parent == inMarker) { ReportMarker(inStream, (int)i); }
+	}
+}
+
+void FrameProfiler::Report(std::ostream& inStream) const
+{
+	std::ios::fmtflags flags = inStream.flags();
+	std::streamsize precision = inStream.precision();
+	inStream << std::fixed << std::setprecision(3);
+
+	inStream << std::left << std::setw(28) << "(ms)" << std::right << "    " << std::setw(9) << "min" << std::setw(9) << "avg" << std::setw(9) << "p99" << std::setw(9) << "max" << "\n";
+	inStream << std::left << std::setw(28) << "Frame" << std::right << " cpu";
+	PrintStats(inStream, mFrameTime.Compute());
+	PrintAllocations(inStream, mFrameAllocations.Compute());
+	inStream << "\n";
+	for (unsigned int i = 0; i < mMarkerCount; ++i)
+	{
+		if (mMarkers[i].parent < 0) { ReportMarker(inStream, (int)i); }
+	}
+	for (unsigned int i = 0; i < mCounterCount; ++i)
+	{
+		inStream << std::left << std::setw(28) << mCounters[i].name << std::right << "    ";
+		PrintStats(inStream, mCounters[i].values.Compute());
+		inStream << "\n";
+	}
+	if (mDroppedGpuFrames > 0) { inStream << "Dropped GPU samples: " << mDroppedGpuFrames << "\n"; }
+
+	inStream.flags(flags);
+	inStream.precision(precision);
+}
+
+void FrameProfiler::Reset()
+{
+	mFrameTime.Clear();
+	mFrameAllocations.Clear();
+	for (unsigned int i = 0; i < mMarkerCount; ++i)
+	{
+		mMarkers[i].cpu.Clear();
+		mMarkers[i].gpu.Clear();
+		mMarkers[i].allocations.Clear();
+	}
+	for (unsigned int i = 0; i < mCounterCount; ++i) { mCounters[i].values.Clear(); }
+	mDroppedGpuFrames = 0;
+}
+
+unsigned int FrameProfiler::GetMarkerCount() const
+{
+	return mMarkerCount;
+}
+
+const char* FrameProfiler::GetMarkerName(unsigned int inIndex) const
+{
+	return mMarkers[inIndex].name;
+}
+
+unsigned int FrameProfiler::GetMarkerDepth(unsigned int inIndex) const
+{
+	return mMarkers[inIndex].depth;
+}
+
+int FrameProfiler::GetMarkerParent(unsigned int inIndex) const
+{
+	return mMarkers[inIndex].parent;
+}
+
+bool FrameProfiler::MarkerHasGpu(unsigned int inIndex) const
+{
+	return mMarkers[inIndex].hasGpu;
+}
+
+ProfileStats FrameProfiler::GetMarkerCpuStats(unsigned int inIndex) const
+{
+	return mMarkers[inIndex].cpu.Compute();
+}
+
+ProfileStats FrameProfiler::GetMarkerGpuStats(unsigned int inIndex) const
+{
+	return mMarkers[inIndex].gpu.Compute();
+}
+
+float FrameProfiler::GetMarkerLastCpu(unsigned int inIndex) const
+{
+	// Markers that weren't opened during the last frame didn't take any time
+	if (!mMarkers[inIndex].seenLastFrame) { return 0.0f; }
+	return mMarkers[inIndex].cpu.GetLast();
+}
+
+float FrameProfiler::GetMarkerLastGpu(unsigned int inIndex) const
+{
+	if (!mMarkers[inIndex].gpuSeenLastCollect) { return 0.0f; }
+	return mMarkers[inIndex].gpu.GetLast();
+}
+
+unsigned int FrameProfiler::GetCounterCount() const
+{
+	return mCounterCount;
+}
+
+const char* FrameProfiler::GetCounterName(unsigned int inIndex) const
+{
+	return mCounters[inIndex].name;
+}
+
+float FrameProfiler::GetCounterLast(unsigned int inIndex) const
+{
+	return mCounters[inIndex].values.GetLast();
+}
+
+ProfileStats FrameProfiler::GetCounterStats(unsigned int inIndex) const
+{
+	return mCounters[inIndex].values.Compute();
+}
+
+float FrameProfiler::GetLastFrameTime() const
+{
+	return mFrameTime.GetLast();
+}
+
+ProfileStats FrameProfiler::GetMarkerAllocationStats(unsigned int inIndex) const
+{
+	return mMarkers[inIndex].allocations.Compute();
+}
+
+unsigned int FrameProfiler::GetMarkerLastAllocations(unsigned int inIndex) const
+{
+	if (!mMarkers[inIndex].seenLastFrame) { return 0; }
+	return (unsigned int)mMarkers[inIndex].allocations.GetLast();
+}
+
+ProfileStats FrameProfiler::GetFrameAllocationStats() const
+{
+	return mFrameAllocations.Compute();
+}
+
+unsigned int FrameProfiler::GetLastFrameAllocations() const
+{
+	return (unsigned int)mFrameAllocations.GetLast();
+}
@@ -0,0 +1,215 @@
+#pragma once
+#ifndef _H_FRAMEPROFILER_
+#define _H_FRAMEPROFILER_
+
+#include "include/glad/glad.h"
+#include <ostream>
+
+// Summary of the samples currently held by a RollingTimer, all values are in milliseconds (or raw units for counters)
+struct ProfileStats
+{
+	float min;
+	float avg;
+	float p99;
+	float max;
+	unsigned int count;
+};
+
+/**
+* RollingTimer keeps the last kWindow samples in a ring buffer
+* The stats are only computed when asked for, so adding a sample every frame is just a store
+*/
+class RollingTimer
+{
+public:
+	static const unsigned int kWindow = 256;
+private:
+	float mSamples[kWindow];
+	unsigned int mHead;
+	unsigned int mCount;
+public:
+	RollingTimer();
+	void Add(float inSample);
+	void Clear();
+	ProfileStats Compute() const;
+	float GetLast() const;
+};
+
+/**
+* FrameProfiler measures where the time of a frame goes
+* Markers are opened & closed in pairs (use the PROFILE_SCOPE macros below) & can be nested, each (name, parent) pair is a separate node
+* CPU times come from QPC, GPU times from ARB_timer_query (core in 3.3):
+*  - The outermost GPU marker uses a GL_TIME_ELAPSED query, since only one of those can be active at a time
+*  - Markers nested inside it use a pair of GL_TIMESTAMP queries instead
+* Queries are kept in a ring of kGpuLatency frames & a frame's results are only read once they are available,
+* so reading them never stalls the pipeline. If the GPU is more than kGpuLatency frames behind, that frame's GPU sample is dropped
+* Markers & counters must come from the thread that owns the OpenGL context
+* When allocation tracking is enabled (debug builds, see AllocationTracker.h) every marker also counts the heap allocations
+* its thread made while it was open, & the frame counts the allocations of every thread
+*/
+class FrameProfiler
+{
+public:
+	static const unsigned int kMaxMarkers = 64;
+	static const unsigned int kMaxDepth = 16;
+	static const unsigned int kMaxCounters = 32;
+	static const unsigned int kGpuLatency = 4;
+	static const unsigned int kMaxGpuQueries = 64;
+private:
+	struct Marker
+	{
+		const char* name;
+		int parent;
+		unsigned int depth;
+		bool hasGpu;
+		bool seenThisFrame;
+		bool seenLastFrame;
+		bool gpuSeenLastCollect; // Had a query in the frame the latest GPU results belong to
+		double cpuFrameTotal; // Seconds accumulated during the current frame, a marker can be opened more than once per frame
+		unsigned long long allocFrameTotal;
+		RollingTimer cpu;
+		RollingTimer gpu;
+		RollingTimer allocations;
+	};
+	struct Counter
+	{
+		const char* name;
+		float frameTotal;
+		bool seenThisFrame;
+		RollingTimer values;
+	};
+	struct OpenMarker
+	{
+		int marker;
+		long long cpuStart;
+		unsigned long long allocStart;
+		int gpuQuery; // Index into the current GpuFrame or -1
+	};
+	struct GpuQuery
+	{
+		int marker;
+		bool elapsed;
+		GLuint begin;
+		GLuint end;
+	};
+	struct GpuFrame
+	{
+		GpuQuery queries[kMaxGpuQueries];
+		unsigned int count;
+		unsigned long long frameIndex; // Frame the queries were issued in
+	};
+private:
+	Marker mMarkers[kMaxMarkers];
+	unsigned int mMarkerCount;
+	Counter mCounters[kMaxCounters];
+	unsigned int mCounterCount;
+	OpenMarker mStack[kMaxDepth];
+	unsigned int mStackSize;
+
+	bool mGpuEnabled;
+	bool mElapsedActive;
+	GLuint mQueryPool[kGpuLatency][kMaxGpuQueries * 2];
+	GpuFrame mGpuFrames[kGpuLatency];
+	unsigned int mDroppedGpuFrames;
+	long long mLastGpuFrame; // Frame the latest collected GPU results belong to, -1 before the first
+
+	long long mFrameStart;
+	unsigned long long mFrameIndex;
+	RollingTimer mFrameTime;
+	unsigned long long mFrameAllocStart;
+	RollingTimer mFrameAllocations;
+	bool mInFrame;
+private:
+	FrameProfiler(const FrameProfiler&);
+	FrameProfiler& operator=(const FrameProfiler&);
+	int FindOrAddMarker(const char* inName, int inParent);
+	void CollectGpuFrame(GpuFrame& inFrame);
+	void ReportMarker(std::ostream& inStream, int inMarker) const;
+public:
+	FrameProfiler();
+	~FrameProfiler();
+
+	// inGpuTimers = true allocates the timer queries, which needs the OpenGL context to be current
+	void Initialize(bool inGpuTimers);
+	void Shutdown();
+
+	void BeginFrame();
+	void EndFrame();
+
+	// inName has to stay valid for the lifetime of the profiler (string literals are expected)
+	void BeginMarker(const char* inName, bool inGpu);
+	void EndMarker();
+	// Counters are summed over a frame & tracked like timers, for example draw calls or recomputed joints
+	void AddCounter(const char* inName, float inValue);
+
+	// Lookup by name of a top level or nested marker (first match), returns false if the marker was never opened
+	bool GetMarkerStats(const char* inName, ProfileStats& outCpu, ProfileStats& outGpu) const;
+	bool GetCounterStats(const char* inName, ProfileStats& outStats) const;
+	ProfileStats GetFrameStats() const;
+	// Index of the current frame (the next one between EndFrame() & BeginFrame()), counted from 0
+	unsigned long long GetFrameIndex() const;
+	unsigned int GetDroppedGpuFrames() const;
+	// GPU results arrive kGpuLatency frames late, this is the frame GetMarkerLastGpu() belongs to (-1 before the first)
+	long long GetLastGpuFrameIndex() const;
+
+	// Prints an indented table with min / avg / p99 / max of every marker & counter
+	void Report(std::ostream& inStream) const;
+	void Reset();
+
+	// Iteration over the marker tree, used by reports that need the raw samples
+	unsigned int GetMarkerCount() const;
+	const char* GetMarkerName(unsigned int inIndex) const;
+	unsigned int GetMarkerDepth(unsigned int inIndex) const;
+	int GetMarkerParent(unsigned int inIndex) const;
+	bool MarkerHasGpu(unsigned int inIndex) const;
+	ProfileStats GetMarkerCpuStats(unsigned int inIndex) const;
+	ProfileStats GetMarkerGpuStats(unsigned int inIndex) const;
+	float GetMarkerLastCpu(unsigned int inIndex) const;
+	// 0 for markers without a query in the frame GetLastGpuFrameIndex()
+	float GetMarkerLastGpu(unsigned int inIndex) const;
+	unsigned int GetCounterCount() const;
+	const char* GetCounterName(unsigned int inIndex) const;
+	float GetCounterLast(unsigned int inIndex) const;
+	ProfileStats GetCounterStats(unsigned int inIndex) const;
+	float GetLastFrameTime() const;
+
+	// Heap allocation counts, always 0 unless allocation tracking is enabled
+	ProfileStats GetMarkerAllocationStats(unsigned int inIndex) const;
+	unsigned int GetMarkerLastAllocations(unsigned int inIndex) const;
+	ProfileStats GetFrameAllocationStats() const;
+	unsigned int GetLastFrameAllocations() const;
+};
+
+/**
+* The profiler used by the game loop, created in WinMain once the OpenGL context exists
+* Application subclasses can add their own nested markers with PROFILE_SCOPE / PROFILE_GPU_SCOPE
+* Every thread has its own profiler (the render thread creates one when it starts), threads without one just skip their markers
+*/
+extern thread_local FrameProfiler* gProfiler;
+
+// RAII helper that closes the marker when it goes out of scope
+class ProfileScope
+{
+private:
+	bool mActive;
+	ProfileScope(const ProfileScope&);
+	ProfileScope& operator=(const ProfileScope&);
+public:
+	inline ProfileScope(const char* inName, bool inGpu)
+	{
+		mActive = gProfiler != 0;
+		if (mActive) { gProfiler->BeginMarker(inName, inGpu); }
+	}
+	inline ~ProfileScope()
+	{
+		// The profiler can be destroyed while a scope is open (WM_DESTROY is handled inside the message pump)
+		if (mActive && gProfiler != 0) { gProfiler->EndMarker(); }
+	}
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, false)
+#define PROFILE_GPU_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, true)
+
+#endif
@@ -0,0 +1,47 @@
+#include "Frustum.h"
+#include <cmath>
+
+Frustum::Frustum()
+{
+	// Everything passes until a matrix is extracted
+	for (unsigned int i = 0; i < kPlaneCount; ++i) { mPlanes[i] = vec4(0.0f, 0.0f, 0.0f, 1.0f); }
+}
+
+Frustum::Frustum(const mat4& inViewProjection)
+{
+	Extract(inViewProjection);
+}
+
+void Frustum::Extract(const mat4& inViewProjection)
+{
+	// Gribb & Hartmann: a clip space point is inside when -w <= x, y, z <= w, so every plane is the last row plus or minus another one
+	const float* m = inViewProjection.v;
+	for (unsigned int i = 0; i < kPlaneCount; ++i)
+	{
+		unsigned int row = i / 2;
+		float sign = (i & 1) ? -1.0f : 1.0f;
+		vec4 plane(m[3] + sign * m[row], m[7] + sign * m[4 + row], m[11] + sign * m[8 + row], m[15] + sign * m[12 + row]);
+		float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if (length > 0.0f)
+		{
+			float inverse = 1.0f / length;
+			plane = vec4(plane.x * inverse, plane.y * inverse, plane.z * inverse, plane.w * inverse);
+		}
+		mPlanes[i] = plane;
+	}
+}
+
+const vec4& Frustum::GetPlane(unsigned int inIndex) const
+{
+	return mPlanes[inIndex];
+}
+
+bool Frustum::ContainsSphere(const vec3& inCenter, float inRadius) const
+{
+	for (unsigned int i = 0; i < kPlaneCount; ++i)
+	{
+		const vec4& plane = mPlanes[i];
+		if (plane.x * inCenter.x + plane.y * inCenter.y + plane.z * inCenter.z + plane.w < -inRadius) { return false; }
+	}
+	return true;
+}
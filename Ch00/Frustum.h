@@ -0,0 +1,28 @@
+#pragma once
+#ifndef _H_FRUSTUM_
+#define _H_FRUSTUM_
+
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+
+/**
+* View frustum as 6 planes (left, right, bottom, top, near, far) pulled straight out of a view projection matrix
+* Every plane is xyz = normal pointing into the frustum & w = distance, normalized so sphere tests can use the radius directly
+*/
+class Frustum
+{
+public:
+	static const unsigned int kPlaneCount = 6;
+private:
+	vec4 mPlanes[kPlaneCount];
+public:
+	Frustum();
+	Frustum(const mat4& inViewProjection);
+	void Extract(const mat4& inViewProjection);
+	const vec4& GetPlane(unsigned int inIndex) const;
+	// Conservative, spheres near the corners can pass without touching the frustum
+	bool ContainsSphere(const vec3& inCenter, float inRadius) const;
+};
+
+#endif
@@ -0,0 +1,160 @@
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#include "include/glad/glad.h"
+#include <Windows.h>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include "GLLoader.h"
+#include "FrameClock.h"
+
+namespace
+{
+	const unsigned int kMaxRequestedExtensions = 32;
+	const unsigned int kMaxCachedProcs = 128;
+
+	struct CachedProc
+	{
+		const char* name;
+		void* proc;
+	};
+
+	HMODULE gOpenGLModule = 0;
+	GLLoadMode gLoadMode = GLLoadMode::Eager;
+	GLExtensionRequest gRequests[kMaxRequestedExtensions];
+	bool gRequestSupported[kMaxRequestedExtensions];
+	unsigned int gRequestCount = 0;
+	// Lazy mode fills the cache from whichever thread asks first (main, render & asset loader contexts), so it's locked
+	std::mutex gProcCacheMutex;
+	CachedProc gProcCache[kMaxCachedProcs];
+	unsigned int gProcCacheCount = 0;
+	std::atomic<unsigned int> gResolvedCount(0);
+	double gLoadTime = 0.0;
+}
+
+/**
+* wglGetProcAddress only knows about functions that aren't exported by opengl32.dll (anything newer than 1.1)
+* Some drivers return 1, 2, 3 or -1 instead of NULL for unknown functions, those have to be treated as failures too
+*/
+static void* ResolveProc(const char* inName)
+{
+	void* result = (void*)wglGetProcAddress(inName);
+	if (result == (void*)0 || result == (void*)1 || result == (void*)2 || result == (void*)3 || result == (void*)-1)
+	{
+		result = (gOpenGLModule != 0) ? (void*)GetProcAddress(gOpenGLModule, inName) : 0;
+	}
+	if (result != 0) { ++gResolvedCount; }
+	return result;
+}
+
+// glad only needs a loader function, this one keeps opengl32.dll open for the lifetime of the process
+static void* GladLoadProc(const char* inName)
+{
+	return ResolveProc(inName);
+}
+
+// Walks the extension list once without copying any strings, marking every requested extension that's present
+static void FindRequestedExtensions(const char* inSingleName, bool* outSingleSupported)
+{
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint i = 0; i < extensionCount; ++i)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if (extension == 0) { continue; }
+		if (inSingleName != 0)
+		{
+			if (strcmp(extension, inSingleName) == 0)
+			{
+				*outSingleSupported = true;
+				return;
+			}
+			continue;
+		}
+		for (unsigned int r = 0; r < gRequestCount; ++r)
+		{
+			if (!gRequestSupported[r] && strcmp(extension, gRequests[r].name) == 0) { gRequestSupported[r] = true; }
+		}
+	}
+}
+
+bool LoadOpenGL(GLLoadMode inMode, const GLExtensionRequest* inExtensions, unsigned int inExtensionCount)
+{
+	long long start = FrameClock::Now();
+	gLoadMode = inMode;
+
+	if (gOpenGLModule == 0) { gOpenGLModule = LoadLibraryW(L"opengl32.dll"); }
+	if (!gladLoadGLLoader(&GladLoadProc))
+	{
+		gLoadTime = FrameClock::ToSeconds(FrameClock::Now() - start);
+		return false;
+	}
+
+	gRequestCount = 0;
+	for (unsigned int i = 0; i < inExtensionCount && i < kMaxRequestedExtensions; ++i)
+	{
+		gRequests[i] = inExtensions[i];
+		gRequestSupported[i] = false;
+		++gRequestCount;
+	}
+	if (inExtensionCount > kMaxRequestedExtensions) { std::cout << "Too many GL extensions requested, only the first " << kMaxRequestedExtensions << " are checked\n"; }
+
+	if (gRequestCount > 0) { FindRequestedExtensions(0, 0); }
+
+	// In eager mode every function of every supported extension is resolved now, lazy mode waits for GetGLProcAddress()
+	if (inMode == GLLoadMode::Eager)
+	{
+		for (unsigned int r = 0; r < gRequestCount; ++r)
+		{
+			if (!gRequestSupported[r]) { continue; }
+			for (unsigned int f = 0; f < gRequests[r].functionCount; ++f)
+			{
+				GetGLProcAddress(gRequests[r].functions[f]);
+			}
+		}
+	}
+
+	gLoadTime = FrameClock::ToSeconds(FrameClock::Now() - start);
+	return true;
+}
+
+bool IsGLExtensionSupported(const char* inName)
+{
+	for (unsigned int r = 0; r < gRequestCount; ++r)
+	{
+		if (strcmp(gRequests[r].name, inName) == 0) { return gRequestSupported[r]; }
+	}
+	bool supported = false;
+	FindRequestedExtensions(inName, &supported);
+	return supported;
+}
+
+void* GetGLProcAddress(const char* inName)
+{
+	std::lock_guard<std::mutex> lock(gProcCacheMutex);
+	for (unsigned int i = 0; i < gProcCacheCount; ++i)
+	{
+		if (gProcCache[i].name == inName || strcmp(gProcCache[i].name, inName) == 0) { return gProcCache[i].proc; }
+	}
+
+	void* proc = ResolveProc(inName);
+	if (gProcCacheCount < kMaxCachedProcs)
+	{
+		// Names are expected to be string literals, so the pointer itself can be cached
+		gProcCache[gProcCacheCount].name = inName;
+		gProcCache[gProcCacheCount].proc = proc;
+		++gProcCacheCount;
+	}
+	return proc;
+}
+
+double GetGLLoadTime()
+{
+	return gLoadTime;
+}
+
+unsigned int GetGLResolvedFunctionCount()
+{
+	return gResolvedCount.load();
+}
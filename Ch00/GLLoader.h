@@ -0,0 +1,41 @@
+#pragma once
+#ifndef _H_GLLOADER_
+#define _H_GLLOADER_
+
+/**
+* GLLoader replaces the plain gladLoadGL() call at startup
+* glad was generated for the 3.3 core profile without any extensions, so gladLoadGLLoader only resolves the core set
+* gladLoadGL() loads & frees opengl32.dll around the load, which short lived tool processes pay for every launch
+* GLLoader keeps opengl32.dll open & hands gladLoadGLLoader a proc loader of its own, then checks only the extensions that were
+* explicitly requested in a single pass over the driver's list. Their functions are resolved either at load time (Eager)
+* or the first time they are asked for (Lazy)
+* Note: glad.c is generated code & left untouched, so gladLoadGLLoader still does its own (empty) extension scan
+*/
+enum class GLLoadMode
+{
+	Eager,
+	Lazy
+};
+
+// An extension the application wants to use & the functions it needs from it
+struct GLExtensionRequest
+{
+	const char* name; // For example "GL_ARB_buffer_storage"
+	const char* const* functions;
+	unsigned int functionCount;
+};
+
+// Needs the OpenGL context to be current, returns false if the core functions couldn't be loaded
+bool LoadOpenGL(GLLoadMode inMode, const GLExtensionRequest* inExtensions, unsigned int inExtensionCount);
+
+// Requested extensions are answered from a cache, anything else is looked up in the driver's extension list
+bool IsGLExtensionSupported(const char* inName);
+// Resolves inName through wglGetProcAddress the first time it's asked for & caches the result, returns 0 if it doesn't exist
+// Safe to call from any thread with a context current, the cache is shared by all of them
+void* GetGLProcAddress(const char* inName);
+
+// Seconds spent inside LoadOpenGL()
+double GetGLLoadTime();
+unsigned int GetGLResolvedFunctionCount();
+
+#endif
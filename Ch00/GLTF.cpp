@@ -0,0 +1,755 @@
+#include "GLTF.h"
+#include "Json.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+#include "FrameClock.h"
+#include "Mesh.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+static const GLTFAccessor kEmptyAccessor;
+
+GLTFAccessor::GLTFAccessor()
+{
+	data = 0;
+	count = 0;
+	stride = 0;
+	componentType = 0;
+	components = 0;
+	normalized = false;
+}
+
+static unsigned int GetComponentSize(unsigned int inType)
+{
+	switch (inType)
+	{
+	case GLTFFormat::Byte: case GLTFFormat::UnsignedByte: return 1;
+	case GLTFFormat::Short: case GLTFFormat::UnsignedShort: return 2;
+	case GLTFFormat::UnsignedInt: case GLTFFormat::Float: return 4;
+	}
+	return 0;
+}
+
+void GLTFAccessor::ReadFloats(unsigned int inIndex, float* outValues) const
+{
+	const unsigned char* element = data + (size_t)inIndex * stride;
+	for (unsigned int i = 0; i < components; ++i)
+	{
+		switch (componentType)
+		{
+		case GLTFFormat::Float: outValues[i] = ((const float*)element)[i]; break;
+		case GLTFFormat::UnsignedByte: outValues[i] = normalized ? element[i] / 255.0f : (float)element[i]; break;
+		case GLTFFormat::UnsignedShort: outValues[i] = normalized ? ((const unsigned short*)element)[i] / 65535.0f : (float)((const unsigned short*)element)[i]; break;
+		case GLTFFormat::UnsignedInt: outValues[i] = (float)((const unsigned int*)element)[i]; break;
+		// The most negative value maps to -1 like the one above it
+		case GLTFFormat::Byte:
+		{
+			float value = (float)((const signed char*)element)[i];
+			outValues[i] = normalized ? (value < -127.0f ? -1.0f : value / 127.0f) : value;
+			break;
+		}
+		case GLTFFormat::Short:
+		{
+			float value = (float)((const short*)element)[i];
+			outValues[i] = normalized ? (value < -32767.0f ? -1.0f : value / 32767.0f) : value;
+			break;
+		}
+		default: outValues[i] = 0.0f;
+		}
+	}
+}
+
+void GLTFAccessor::ReadUInts(unsigned int inIndex, unsigned int* outValues) const
+{
+	const unsigned char* element = data + (size_t)inIndex * stride;
+	for (unsigned int i = 0; i < components; ++i)
+	{
+		switch (componentType)
+		{
+		case GLTFFormat::UnsignedByte: outValues[i] = element[i]; break;
+		case GLTFFormat::UnsignedShort: outValues[i] = ((const unsigned short*)element)[i]; break;
+		case GLTFFormat::UnsignedInt: outValues[i] = ((const unsigned int*)element)[i]; break;
+		case GLTFFormat::Byte: outValues[i] = (unsigned int)((const signed char*)element)[i]; break;
+		case GLTFFormat::Short: outValues[i] = (unsigned int)((const short*)element)[i]; break;
+		case GLTFFormat::Float: outValues[i] = (unsigned int)((const float*)element)[i]; break;
+		default: outValues[i] = 0;
+		}
+	}
+}
+
+GLTFFile::GLTFFile()
+{
+	mParseTime = 0.0;
+}
+
+GLTFFile::~GLTFFile()
+{
+	Close();
+}
+
+void GLTFFile::Close()
+{
+	for (size_t i = 0, size = mMappings.size(); i < size; ++i) { delete mMappings[i]; }
+	mMappings.clear();
+	mBuffers.clear();
+	mBufferSizes.clear();
+	mAccessors.clear();
+	mNodes.clear();
+	mPrimitives.clear();
+	mSkins.clear();
+	mAnimations.clear();
+	mParseTime = 0.0;
+}
+
+const unsigned char* GLTFFile::MapBuffer(const std::string& inDirectory, const std::string& inUri, size_t& outSize)
+{
+	// URIs are percent encoded, the usual offender is a space in the file name
+	std::string path = inDirectory;
+	for (size_t i = 0; i < inUri.size(); ++i)
+	{
+		if (inUri[i] == '%' && i + 2 < inUri.size())
+		{
+			char hex[3] = { inUri[i + 1], inUri[i + 2], 0 };
+			path += (char)strtol(hex, 0, 16);
+			i += 2;
+		}
+		else { path += inUri[i]; }
+	}
+	MappedFile* mapping = new MappedFile();
+	if (!mapping->Open(path.c_str()))
+	{
+		std::cout << "GLTF: can't map buffer " << path << "\n";
+		delete mapping;
+		return 0;
+	}
+	mMappings.push_back(mapping);
+	outSize = mapping->GetSize();
+	return mapping->GetData();
+}
+
+namespace
+{
+	struct BufferView
+	{
+		const unsigned char* data;
+		size_t length;
+		unsigned int stride;
+	};
+
+	int GetIndex(const JsonValue& inObject, const char* inName)
+	{
+		return inObject.GetInt(inName, -1);
+	}
+
+	unsigned int GetComponentCount(const std::string& inType)
+	{
+		if (inType == "SCALAR") { return 1; }
+		if (inType == "VEC2") { return 2; }
+		if (inType == "VEC3") { return 3; }
+		if (inType == "VEC4" || inType == "MAT2") { return 4; }
+		if (inType == "MAT3") { return 9; }
+		if (inType == "MAT4") { return 16; }
+		return 0;
+	}
+
+	// A node given as a matrix is split into translation, rotation & scale, shear is lost
+	void DecomposeMatrix(const mat4& inMatrix, GLTFFile::Node& outNode)
+	{
+		outNode.position = vec3(inMatrix.tx, inMatrix.ty, inMatrix.tz);
+		vec3 x(inMatrix.xx, inMatrix.xy, inMatrix.xz);
+		vec3 y(inMatrix.yx, inMatrix.yy, inMatrix.yz);
+		vec3 z(inMatrix.zx, inMatrix.zy, inMatrix.zz);
+		float sx = len(x), sy = len(y), sz = len(z);
+		// A mirrored basis keeps its handedness in the scale
+		if (determinant(inMatrix) < 0.0f) { sx = -sx; }
+		outNode.scale = vec3(sx, sy, sz);
+		mat4 rotation;
+		if (sx != 0.0f && sy != 0.0f && sz != 0.0f)
+		{
+			rotation.xx = x.x / sx; rotation.xy = x.y / sx; rotation.xz = x.z / sx;
+			rotation.yx = y.x / sy; rotation.yy = y.y / sy; rotation.yz = y.z / sy;
+			rotation.zx = z.x / sz; rotation.zy = z.y / sz; rotation.zz = z.z / sz;
+		}
+		outNode.rotation = normalized(mat4ToQuat(rotation));
+	}
+}
+
+bool GLTFFile::Load(const char* inPath)
+{
+	Close();
+	long long start = FrameClock::Now();
+	MappedFile* file = new MappedFile();
+	if (!file->Open(inPath))
+	{
+		std::cout << "GLTF: can't map " << inPath << "\n";
+		delete file;
+		return false;
+	}
+	mMappings.push_back(file);
+	const unsigned char* data = file->GetData();
+	size_t size = file->GetSize();
+
+	// Either the whole file is JSON or it's a .glb with the JSON in its first chunk
+	const char* json = (const char*)data;
+	size_t jsonLength = size;
+	const unsigned char* binChunk = 0;
+	size_t binLength = 0;
+	GLTFFormat::GlbHeader header;
+	if (size >= sizeof(header)) { memcpy(&header, data, sizeof(header)); }
+	if (size >= sizeof(header) && header.magic == GLTFFormat::kGlbMagic)
+	{
+		GLTFFormat::ChunkHeader chunk;
+		size_t offset = sizeof(header) + sizeof(chunk);
+		// header.length < offset would wrap the header.length - offset checks below
+		if (header.version != GLTFFormat::kGlbVersion || header.length > size || header.length < offset)
+		{
+			std::cout << "GLTF: " << inPath << " isn't a version 2 .glb or is truncated\n";
+			Close();
+			return false;
+		}
+		memcpy(&chunk, data + sizeof(header), sizeof(chunk));
+		if (chunk.type != GLTFFormat::kChunkJson || chunk.length > header.length - offset)
+		{
+			std::cout << "GLTF: " << inPath << " doesn't start with a JSON chunk\n";
+			Close();
+			return false;
+		}
+		json = (const char*)(data + offset);
+		jsonLength = chunk.length;
+		// Chunks are padded to 4 bytes, done in size_t so a length near 4GB can't wrap around to a small offset
+		// An unpadded JSON chunk at the very end is tolerated, there's just no room for a BIN chunk after it
+		size_t padded = ((size_t)chunk.length + 3) & ~(size_t)3;
+		offset += (padded <= header.length - offset) ? padded : header.length - offset;
+		if (offset + sizeof(chunk) <= header.length)
+		{
+			memcpy(&chunk, data + offset, sizeof(chunk));
+			offset += sizeof(chunk);
+			if (chunk.type == GLTFFormat::kChunkBin && chunk.length <= header.length - offset)
+			{
+				binChunk = data + offset;
+				binLength = chunk.length;
+			}
+		}
+	}
+
+	JsonValue document;
+	if (!ParseJson(json, jsonLength, document))
+	{
+		std::cout << "GLTF: " << inPath << " has invalid JSON\n";
+		Close();
+		return false;
+	}
+	const std::string& version = document.Get("asset").GetString("version");
+	if (version.compare(0, 2, "2.") != 0)
+	{
+		std::cout << "GLTF: " << inPath << " is glTF " << (version.empty() ? "?" : version.c_str()) << ", only 2.x is supported\n";
+		Close();
+		return false;
+	}
+
+	std::string directory = inPath;
+	size_t slash = directory.find_last_of("\\/");
+	directory = (slash == std::string::npos) ? std::string() : directory.substr(0, slash + 1);
+
+	// Buffers, a missing uri is the .glb binary chunk
+	const JsonValue& buffers = document.Get("buffers");
+	for (unsigned int i = 0; i < buffers.Size(); ++i)
+	{
+		const std::string& uri = buffers[i].GetString("uri");
+		const unsigned char* buffer = 0;
+		size_t bufferSize = 0;
+		if (uri.empty()) { buffer = binChunk; bufferSize = binLength; }
+		else if (uri.compare(0, 5, "data:") == 0) { std::cout << "GLTF: buffer " << i << " is a data: URI, only external & .glb buffers are supported\n"; }
+		else { buffer = MapBuffer(directory, uri, bufferSize); }
+		size_t byteLength = (size_t)buffers[i].Get("byteLength").number;
+		if (buffer != 0 && bufferSize < byteLength)
+		{
+			std::cout << "GLTF: buffer " << i << " is " << bufferSize << " bytes, " << byteLength << " expected\n";
+			buffer = 0;
+		}
+		mBuffers.push_back(buffer);
+		mBufferSizes.push_back(buffer != 0 ? bufferSize : 0);
+	}
+
+	const JsonValue& views = document.Get("bufferViews");
+	std::vector<BufferView> bufferViews(views.Size());
+	for (unsigned int i = 0; i < views.Size(); ++i)
+	{
+		const JsonValue& view = views[i];
+		int buffer = GetIndex(view, "buffer");
+		size_t offset = (size_t)view.Get("byteOffset").number;
+		size_t length = (size_t)view.Get("byteLength").number;
+		bufferViews[i].data = 0;
+		bufferViews[i].length = 0;
+		bufferViews[i].stride = (unsigned int)view.GetInt("byteStride", 0);
+		if (buffer < 0 || buffer >= (int)mBuffers.size() || mBuffers[buffer] == 0) { continue; }
+		if (offset > mBufferSizes[buffer] || length > mBufferSizes[buffer] - offset)
+		{
+			std::cout << "GLTF: buffer view " << i << " is out of bounds\n";
+			continue;
+		}
+		bufferViews[i].data = mBuffers[buffer] + offset;
+		bufferViews[i].length = length;
+	}
+
+	const JsonValue& accessors = document.Get("accessors");
+	mAccessors.resize(accessors.Size());
+	for (unsigned int i = 0; i < accessors.Size(); ++i)
+	{
+		const JsonValue& source = accessors[i];
+		GLTFAccessor& accessor = mAccessors[i];
+		accessor.componentType = (unsigned int)source.GetInt("componentType", 0);
+		accessor.components = GetComponentCount(source.GetString("type"));
+		accessor.count = (unsigned int)source.GetInt("count", 0);
+		accessor.normalized = source.GetBool("normalized", false);
+		unsigned int componentSize = GetComponentSize(accessor.componentType);
+		unsigned int elementSize = componentSize * accessor.components;
+		int view = GetIndex(source, "bufferView");
+		if (source.Find("sparse") != 0) { std::cout << "GLTF: accessor " << i << " is sparse, which isn't supported\n"; continue; }
+		if (view < 0 || view >= (int)bufferViews.size() || bufferViews[view].data == 0 || elementSize == 0) { continue; }
+		const BufferView& bufferView = bufferViews[view];
+		size_t offset = (size_t)source.Get("byteOffset").number;
+		accessor.stride = bufferView.stride != 0 ? bufferView.stride : elementSize;
+		size_t extent = accessor.count > 0 ? (size_t)accessor.stride * (accessor.count - 1) + elementSize : 0;
+		if (offset > bufferView.length || extent > bufferView.length - offset)
+		{
+			std::cout << "GLTF: accessor " << i << " is out of bounds\n";
+			continue;
+		}
+		// The spans hand out typed pointers, so the alignment glTF requires is checked instead of trusted
+		const unsigned char* first = bufferView.data + offset;
+		if (((size_t)first % componentSize) != 0 || (accessor.stride % componentSize) != 0)
+		{
+			std::cout << "GLTF: accessor " << i << " isn't aligned to its component size\n";
+			continue;
+		}
+		accessor.data = first;
+	}
+
+	const JsonValue& nodes = document.Get("nodes");
+	mNodes.resize(nodes.Size());
+	for (unsigned int i = 0; i < nodes.Size(); ++i)
+	{
+		const JsonValue& source = nodes[i];
+		Node& node = mNodes[i];
+		node.name = source.GetString("name");
+		node.mesh = GetIndex(source, "mesh");
+		node.skin = GetIndex(source, "skin");
+		float values[16] = { 0, 0, 0, 1, 1, 1 };
+		if (source.GetFloats("matrix", values, 16) == 16) { DecomposeMatrix(mat4(values), node); }
+		else
+		{
+			node.position = source.GetFloats("translation", values, 3) == 3 ? vec3(values) : vec3();
+			node.rotation = source.GetFloats("rotation", values, 4) == 4 ? quat(values[0], values[1], values[2], values[3]) : quat();
+			node.scale = source.GetFloats("scale", values, 3) == 3 ? vec3(values) : vec3(1, 1, 1);
+		}
+	}
+	for (unsigned int i = 0; i < nodes.Size(); ++i) { mNodes[i].parent = -1; }
+	for (unsigned int i = 0; i < nodes.Size(); ++i)
+	{
+		const JsonValue& children = nodes[i].Get("children");
+		for (unsigned int c = 0; c < children.Size(); ++c)
+		{
+			int child = (int)children[c].number;
+			if (child >= 0 && child < (int)mNodes.size()) { mNodes[child].parent = (int)i; }
+		}
+	}
+
+	const JsonValue& meshes = document.Get("meshes");
+	for (unsigned int m = 0; m < meshes.Size(); ++m)
+	{
+		const JsonValue& primitives = meshes[m].Get("primitives");
+		for (unsigned int p = 0; p < primitives.Size(); ++p)
+		{
+			const JsonValue& attributes = primitives[p].Get("attributes");
+			Primitive primitive;
+			primitive.name = meshes[m].GetString("name");
+			primitive.mesh = (int)m;
+			primitive.node = -1;
+			primitive.position = GetIndex(attributes, "POSITION");
+			primitive.normal = GetIndex(attributes, "NORMAL");
+			primitive.texCoord = GetIndex(attributes, "TEXCOORD_0");
+			primitive.joints = GetIndex(attributes, "JOINTS_0");
+			primitive.weights = GetIndex(attributes, "WEIGHTS_0");
+			primitive.indices = GetIndex(primitives[p], "indices");
+			primitive.mode = primitives[p].GetInt("mode", 4);
+			mPrimitives.push_back(primitive);
+		}
+	}
+	for (size_t p = 0, size = mPrimitives.size(); p < size; ++p)
+	{
+		for (size_t n = 0; n < mNodes.size() && mPrimitives[p].node < 0; ++n)
+		{
+			if (mNodes[n].mesh == mPrimitives[p].mesh) { mPrimitives[p].node = (int)n; }
+		}
+	}
+
+	const JsonValue& skins = document.Get("skins");
+	mSkins.resize(skins.Size());
+	for (unsigned int i = 0; i < skins.Size(); ++i)
+	{
+		mSkins[i].name = skins[i].GetString("name");
+		mSkins[i].inverseBindMatrices = GetIndex(skins[i], "inverseBindMatrices");
+		const JsonValue& joints = skins[i].Get("joints");
+		for (unsigned int j = 0; j < joints.Size(); ++j) { mSkins[i].joints.push_back((int)joints[j].number); }
+	}
+
+	const JsonValue& animations = document.Get("animations");
+	mAnimations.resize(animations.Size());
+	for (unsigned int i = 0; i < animations.Size(); ++i)
+	{
+		const JsonValue& samplers = animations[i].Get("samplers");
+		const JsonValue& channels = animations[i].Get("channels");
+		mAnimations[i].name = animations[i].GetString("name");
+		for (unsigned int c = 0; c < channels.Size(); ++c)
+		{
+			const JsonValue& target = channels[c].Get("target");
+			const JsonValue& sampler = samplers[(unsigned int)channels[c].GetInt("sampler", -1)];
+			const std::string& path = target.GetString("path");
+			const std::string& interpolation = sampler.GetString("interpolation");
+			Channel channel;
+			channel.node = GetIndex(target, "node");
+			channel.path = (path == "translation") ? Path::Translation : (path == "rotation") ? Path::Rotation : (path == "scale") ? Path::Scale : Path::Weights;
+			channel.input = GetIndex(sampler, "input");
+			channel.output = GetIndex(sampler, "output");
+			channel.interpolation = (interpolation == "STEP") ? Interpolation::Constant : (interpolation == "CUBICSPLINE") ? Interpolation::Cubic : Interpolation::Linear;
+			mAnimations[i].channels.push_back(channel);
+		}
+	}
+
+	mParseTime = FrameClock::ToSeconds(FrameClock::Now() - start);
+	return true;
+}
+
+unsigned int GLTFFile::GetAccessorCount() const
+{
+	return (unsigned int)mAccessors.size();
+}
+
+const GLTFAccessor& GLTFFile::GetAccessor(int inIndex) const
+{
+	if (inIndex < 0 || inIndex >= (int)mAccessors.size()) { return kEmptyAccessor; }
+	return mAccessors[inIndex];
+}
+
+const std::vector<GLTFFile::Node>& GLTFFile::GetNodes() const
+{
+	return mNodes;
+}
+
+const std::vector<GLTFFile::Primitive>& GLTFFile::GetPrimitives() const
+{
+	return mPrimitives;
+}
+
+const std::vector<GLTFFile::Skin>& GLTFFile::GetSkins() const
+{
+	return mSkins;
+}
+
+const std::vector<GLTFFile::Animation>& GLTFFile::GetAnimations() const
+{
+	return mAnimations;
+}
+
+double GLTFFile::GetParseTime() const
+{
+	return mParseTime;
+}
+
+bool ImportSkeleton(const GLTFFile& inFile, GLTFSkeleton& outSkeleton)
+{
+	const std::vector<GLTFFile::Node>& nodes = inFile.GetNodes();
+	const std::vector<GLTFFile::Skin>& skins = inFile.GetSkins();
+	unsigned int nodeCount = (unsigned int)nodes.size();
+	outSkeleton.nodeJoints.assign(nodeCount, -1);
+
+	// Every skin joint & everything above it, the marks are walked up until a node that's already in
+	std::vector<unsigned char> used(nodeCount, 0);
+	for (size_t s = 0; s < skins.size(); ++s)
+	{
+		for (size_t j = 0; j < skins[s].joints.size(); ++j)
+		{
+			int node = skins[s].joints[j];
+			if (node < 0 || node >= (int)nodeCount)
+			{
+				std::cout << "GLTF: skin " << s << " has an invalid joint\n";
+				return false;
+			}
+			for (unsigned int depth = 0; node >= 0 && !used[node] && depth < nodeCount; ++depth)
+			{
+				used[node] = 1;
+				node = nodes[node].parent;
+			}
+		}
+	}
+	std::vector<int> jointNodes;
+	for (unsigned int n = 0; n < nodeCount; ++n)
+	{
+		if (used[n]) { jointNodes.push_back((int)n); }
+	}
+	unsigned int jointCount = (unsigned int)jointNodes.size();
+	std::vector<int> parents(jointCount);
+	std::vector<int> nodeToCompact(nodeCount, -1);
+	for (unsigned int j = 0; j < jointCount; ++j) { nodeToCompact[jointNodes[j]] = (int)j; }
+	for (unsigned int j = 0; j < jointCount; ++j)
+	{
+		int parent = nodes[jointNodes[j]].parent;
+		parents[j] = parent >= 0 ? nodeToCompact[parent] : -1;
+	}
+	std::vector<unsigned int> order(jointCount);
+	if (jointCount > 0 && !ComputeTopologicalOrder(&parents[0], jointCount, &order[0]))
+	{
+		std::cout << "GLTF: the node hierarchy has a cycle\n";
+		return false;
+	}
+
+	outSkeleton.restPose.Resize(jointCount);
+	outSkeleton.jointNodes.resize(jointCount);
+	outSkeleton.jointNames.resize(jointCount);
+	outSkeleton.inverseBindPose.assign(jointCount, mat4());
+	for (unsigned int j = 0; j < jointCount; ++j)
+	{
+		int node = jointNodes[order[j]];
+		outSkeleton.jointNodes[j] = node;
+		outSkeleton.jointNames[j] = nodes[node].name;
+		outSkeleton.nodeJoints[node] = (int)j;
+	}
+	for (unsigned int j = 0; j < jointCount; ++j)
+	{
+		const GLTFFile::Node& node = nodes[outSkeleton.jointNodes[j]];
+		outSkeleton.restPose.SetParent(j, node.parent >= 0 ? outSkeleton.nodeJoints[node.parent] : -1);
+		outSkeleton.restPose.SetLocal(j, node.position, node.rotation, node.scale);
+	}
+
+	for (size_t s = 0; s < skins.size(); ++s)
+	{
+		const GLTFAccessor& matrices = inFile.GetAccessor(skins[s].inverseBindMatrices);
+		GLTFSpan<float> span = matrices.AsSpan<float>();
+		if (skins[s].inverseBindMatrices >= 0 && (!span.IsValid() || span.components != 16 || span.count < skins[s].joints.size()))
+		{
+			std::cout << "GLTF: skin " << s << " has unusable inverse bind matrices\n";
+			continue;
+		}
+		for (size_t j = 0; j < skins[s].joints.size() && span.IsValid(); ++j)
+		{
+			outSkeleton.inverseBindPose[outSkeleton.nodeJoints[skins[s].joints[j]]] = mat4(span[(unsigned int)j]);
+		}
+	}
+	return true;
+}
+
+bool ImportMesh(const GLTFFile& inFile, unsigned int inPrimitive, const GLTFSkeleton& inSkeleton, GLTFMeshData& outMesh)
+{
+	const GLTFFile::Primitive& primitive = inFile.GetPrimitives()[inPrimitive];
+	outMesh.name = primitive.name;
+	const GLTFAccessor& positions = inFile.GetAccessor(primitive.position);
+	GLTFSpan<float> positionSpan = positions.AsSpan<float>();
+	if (primitive.mode != 4 || !positionSpan.IsValid() || positionSpan.components != 3)
+	{
+		std::cout << "GLTF: primitive " << inPrimitive << " of " << primitive.name << " isn't a triangle list with float positions\n";
+		return false;
+	}
+	unsigned int vertexCount = positionSpan.count;
+	outMesh.positions.resize(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; ++v) { outMesh.positions[v] = vec3(positionSpan[v]); }
+
+	const GLTFAccessor& normals = inFile.GetAccessor(primitive.normal);
+	GLTFSpan<float> normalSpan = normals.AsSpan<float>();
+	if (normalSpan.IsValid() && normalSpan.components == 3 && normalSpan.count == vertexCount)
+	{
+		outMesh.normals.resize(vertexCount);
+		for (unsigned int v = 0; v < vertexCount; ++v) { outMesh.normals[v] = vec3(normalSpan[v]); }
+	}
+
+	// Texture coordinates & weights may be normalized integers, those go through ReadFloats()
+	const GLTFAccessor& texCoords = inFile.GetAccessor(primitive.texCoord);
+	if (texCoords.data != 0 && texCoords.components == 2 && texCoords.count == vertexCount)
+	{
+		outMesh.texCoords.resize(vertexCount);
+		for (unsigned int v = 0; v < vertexCount; ++v) { texCoords.ReadFloats(v, outMesh.texCoords[v].v); }
+	}
+
+	const GLTFAccessor& joints = inFile.GetAccessor(primitive.joints);
+	const GLTFAccessor& weights = inFile.GetAccessor(primitive.weights);
+	int skinIndex = primitive.node >= 0 ? inFile.GetNodes()[primitive.node].skin : -1;
+	if (joints.data != 0 && weights.data != 0 && joints.components == 4 && weights.components == 4 &&
+		joints.count == vertexCount && weights.count == vertexCount && skinIndex >= 0 && skinIndex < (int)inFile.GetSkins().size())
+	{
+		const std::vector<int>& skinJoints = inFile.GetSkins()[skinIndex].joints;
+		outMesh.weights.resize(vertexCount);
+		outMesh.influences.resize(vertexCount);
+		for (unsigned int v = 0; v < vertexCount; ++v)
+		{
+			unsigned int influences[4];
+			joints.ReadUInts(v, influences);
+			float values[4];
+			weights.ReadFloats(v, values);
+			for (unsigned int k = 0; k < 4; ++k)
+			{
+				// Out of range joints are dropped with their weight instead of reading past the palette
+				bool valid = influences[k] < skinJoints.size();
+				outMesh.influences[v].v[k] = valid ? inSkeleton.nodeJoints[skinJoints[influences[k]]] : 0;
+				if (!valid) { values[k] = 0.0f; }
+			}
+			outMesh.weights[v] = vec4(values);
+		}
+	}
+
+	const GLTFAccessor& indices = inFile.GetAccessor(primitive.indices);
+	if (primitive.indices >= 0)
+	{
+		if (indices.data == 0 || indices.components != 1)
+		{
+			std::cout << "GLTF: primitive " << inPrimitive << " of " << primitive.name << " has unusable indices\n";
+			return false;
+		}
+		outMesh.indices.resize(indices.count);
+		// The common case is 16 or 32 bit indices packed tightly, which are widened in one loop over the span
+		GLTFSpan<unsigned short> shorts = indices.AsSpan<unsigned short>();
+		GLTFSpan<unsigned int> ints = indices.AsSpan<unsigned int>();
+		for (unsigned int i = 0; i < indices.count; ++i)
+		{
+			unsigned int index = 0;
+			if (shorts.IsValid()) { index = *shorts[i]; }
+			else if (ints.IsValid()) { index = *ints[i]; }
+			else { indices.ReadUInts(i, &index); }
+			if (index >= vertexCount)
+			{
+				std::cout << "GLTF: primitive " << inPrimitive << " of " << primitive.name << " indexes past its vertices\n";
+				return false;
+			}
+			outMesh.indices[i] = index;
+		}
+	}
+	return true;
+}
+
+bool ImportClip(const GLTFFile& inFile, unsigned int inAnimation, const GLTFSkeleton& inSkeleton, Clip& outClip)
+{
+	const GLTFFile::Animation& animation = inFile.GetAnimations()[inAnimation];
+	outClip.SetName(animation.name);
+	const std::vector<GLTFFile::Node>& nodes = inFile.GetNodes();
+	for (size_t c = 0, size = animation.channels.size(); c < size; ++c)
+	{
+		const GLTFFile::Channel& channel = animation.channels[c];
+		if (channel.path == GLTFFile::Path::Weights || channel.node < 0 || channel.node >= (int)nodes.size()) { continue; }
+		int joint = inSkeleton.nodeJoints[channel.node];
+		if (joint < 0) { continue; }
+		GLTFSpan<float> times = inFile.GetAccessor(channel.input).AsSpan<float>();
+		const GLTFAccessor& output = inFile.GetAccessor(channel.output);
+		unsigned int components = (channel.path == GLTFFile::Path::Rotation) ? 4 : 3;
+		bool cubic = channel.interpolation == Interpolation::Cubic;
+		unsigned int keyCount = times.count;
+		if (!times.IsValid() || output.data == 0 || output.components != components || output.count != keyCount * (cubic ? 3 : 1))
+		{
+			std::cout << "GLTF: channel " << c << " of " << animation.name << " has mismatched keys, skipped\n";
+			continue;
+		}
+
+		TransformTrack& track = outClip.GetTrackForJoint((unsigned int)joint);
+		float in[4], value[4], out[4];
+		if (channel.path == GLTFFile::Path::Rotation)
+		{
+			track.rotation.Resize(keyCount);
+			track.rotation.SetInterpolation(channel.interpolation);
+			for (unsigned int k = 0; k < keyCount; ++k)
+			{
+				if (!cubic)
+				{
+					output.ReadFloats(k, value);
+					track.rotation.SetKey(k, *times[k], quat(value[0], value[1], value[2], value[3]));
+					continue;
+				}
+				output.ReadFloats(k * 3, in);
+				output.ReadFloats(k * 3 + 1, value);
+				output.ReadFloats(k * 3 + 2, out);
+				track.rotation.SetKey(k, *times[k], quat(value[0], value[1], value[2], value[3]), quat(in[0], in[1], in[2], in[3]), quat(out[0], out[1], out[2], out[3]));
+			}
+			continue;
+		}
+		VectorTrack& vectors = (channel.path == GLTFFile::Path::Translation) ? track.position : track.scale;
+		vectors.Resize(keyCount);
+		vectors.SetInterpolation(channel.interpolation);
+		for (unsigned int k = 0; k < keyCount; ++k)
+		{
+			if (!cubic)
+			{
+				output.ReadFloats(k, value);
+				vectors.SetKey(k, *times[k], vec3(value));
+				continue;
+			}
+			output.ReadFloats(k * 3, in);
+			output.ReadFloats(k * 3 + 1, value);
+			output.ReadFloats(k * 3 + 2, out);
+			vectors.SetKey(k, *times[k], vec3(value), vec3(in), vec3(out));
+		}
+	}
+	outClip.RecalculateDuration();
+	return outClip.Size() > 0;
+}
+
+bool ImportGLTF(const GLTFFile& inFile, JobSystem* inJobs, GLTFImport& outImport)
+{
+	long long start = FrameClock::Now();
+	outImport.failed = 0;
+	if (!ImportSkeleton(inFile, outImport.skeleton)) { return false; }
+
+	// Every primitive & every animation is its own work item, the outputs are sized up front so the workers never resize them
+	unsigned int primitiveCount = (unsigned int)inFile.GetPrimitives().size();
+	unsigned int animationCount = (unsigned int)inFile.GetAnimations().size();
+	unsigned int itemCount = primitiveCount + animationCount;
+	outImport.meshes.clear();
+	outImport.clips.clear();
+	outImport.meshes.resize(primitiveCount);
+	outImport.clips.resize(animationCount);
+	std::vector<unsigned char> imported(itemCount, 0);
+	auto decode = [&](unsigned int inBegin, unsigned int inEnd)
+	{
+		for (unsigned int i = inBegin; i < inEnd; ++i)
+		{
+			bool done = (i < primitiveCount) ? ImportMesh(inFile, i, outImport.skeleton, outImport.meshes[i]) :
+				ImportClip(inFile, i - primitiveCount, outImport.skeleton, outImport.clips[i - primitiveCount]);
+			imported[i] = done ? 1 : 0;
+		}
+	};
+	if (inJobs != 0 && itemCount > 1) { inJobs->ParallelFor(itemCount, 1, decode); }
+	else { decode(0, itemCount); }
+
+	// The failed ones are dropped, the survivors keep their order
+	unsigned int meshCount = 0;
+	for (unsigned int i = 0; i < primitiveCount; ++i)
+	{
+		if (!imported[i]) { ++outImport.failed; continue; }
+		if (meshCount != i) { std::swap(outImport.meshes[meshCount], outImport.meshes[i]); }
+		++meshCount;
+	}
+	outImport.meshes.resize(meshCount);
+	unsigned int clipCount = 0;
+	for (unsigned int i = 0; i < animationCount; ++i)
+	{
+		if (!imported[primitiveCount + i]) { ++outImport.failed; continue; }
+		if (clipCount != i) { std::swap(outImport.clips[clipCount], outImport.clips[i]); }
+		++clipCount;
+	}
+	outImport.clips.resize(clipCount);
+
+	double decodeTime = FrameClock::ToSeconds(FrameClock::Now() - start);
+	std::cout << "GLTF: " << outImport.skeleton.restPose.Size() << " joints, " << meshCount << " meshes, " << clipCount << " clips, parsed in " <<
+		inFile.GetParseTime() * 1000.0 << " ms, decoded in " << decodeTime * 1000.0 << " ms on " << (inJobs != 0 ? inJobs->GetThreadCount() : 1) << " threads";
+	if (outImport.failed > 0) { std::cout << ", " << outImport.failed << " failed"; }
+	std::cout << "\n";
+	return true;
+}
+
+void MoveToMesh(GLTFMeshData& ioData, Mesh& outMesh)
+{
+	outMesh.GetPositions().swap(ioData.positions);
+	outMesh.GetNormals().swap(ioData.normals);
+	outMesh.GetTexCoords().swap(ioData.texCoords);
+	outMesh.GetWeights().swap(ioData.weights);
+	outMesh.GetInfluences().swap(ioData.influences);
+	outMesh.GetIndices().swap(ioData.indices);
+}
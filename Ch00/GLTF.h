@@ -0,0 +1,258 @@
+#pragma once
+#ifndef _H_GLTF_
+#define _H_GLTF_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "quat.h"
+#include "mat4.h"
+#include "Pose.h"
+#include "Clip.h"
+
+class MappedFile;
+class JobSystem;
+class Mesh;
+
+/**
+* glTF 2.0 container constants (.glb), see the Khronos spec
+* A .glb is a 12 byte header followed by a JSON chunk & an optional binary chunk, every chunk is 4 byte aligned
+*/
+namespace GLTFFormat
+{
+	const unsigned int kGlbMagic = 0x46546C67; // "glTF"
+	const unsigned int kGlbVersion = 2;
+	const unsigned int kChunkJson = 0x4E4F534A; // "JSON"
+	const unsigned int kChunkBin = 0x004E4942; // "BIN\0"
+
+	enum ComponentType
+	{
+		Byte = 5120,
+		UnsignedByte = 5121,
+		Short = 5122,
+		UnsignedShort = 5123,
+		UnsignedInt = 5125,
+		Float = 5126
+	};
+
+	struct GlbHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int length; // Of the whole file
+	};
+
+	struct ChunkHeader
+	{
+		unsigned int length; // Of the data that follows
+		unsigned int type;
+	};
+}
+
+// The accessor component type a C++ type reads
+template<typename T> struct GLTFComponent;
+template<> struct GLTFComponent<signed char> { static const unsigned int kType = GLTFFormat::Byte; };
+template<> struct GLTFComponent<unsigned char> { static const unsigned int kType = GLTFFormat::UnsignedByte; };
+template<> struct GLTFComponent<short> { static const unsigned int kType = GLTFFormat::Short; };
+template<> struct GLTFComponent<unsigned short> { static const unsigned int kType = GLTFFormat::UnsignedShort; };
+template<> struct GLTFComponent<unsigned int> { static const unsigned int kType = GLTFFormat::UnsignedInt; };
+template<> struct GLTFComponent<float> { static const unsigned int kType = GLTFFormat::Float; };
+
+/**
+* Typed view of an accessor's elements right inside the mapped buffer, nothing is copied
+* span[i] points at the components of element i. glTF aligns every accessor to its component size, so the pointers are safe to read
+* Views are only valid while the GLTFFile they came from is open
+*/
+template<typename T>
+struct GLTFSpan
+{
+	const unsigned char* data;
+	unsigned int count;
+	unsigned int stride; // Bytes from one element to the next, interleaved buffer views have a stride larger than the element
+	unsigned int components;
+
+	inline GLTFSpan() : data(0), count(0), stride(0), components(0) { }
+	inline const T* operator[](unsigned int inIndex) const { return (const T*)(data + (size_t)inIndex * stride); }
+	inline bool IsValid() const { return data != 0; }
+};
+
+struct GLTFAccessor
+{
+	const unsigned char* data; // First element, 0 if the accessor couldn't be resolved (sparse, no buffer view, out of bounds)
+	unsigned int count;
+	unsigned int stride;
+	unsigned int componentType;
+	unsigned int components; // 1 for SCALAR up to 16 for MAT4
+	bool normalized;
+
+	GLTFAccessor();
+	// An invalid span if the components aren't of type T
+	template<typename T>
+	GLTFSpan<T> AsSpan() const;
+	/**
+	* Element inIndex as floats, whatever the component type, outValues needs `components` entries
+	* Normalized integers are scaled to 0..1 (unsigned) or -1..1 (signed), other integers are converted as they are
+	*/
+	void ReadFloats(unsigned int inIndex, float* outValues) const;
+	// Integer components (joint indices, vertex indices), floats are truncated
+	void ReadUInts(unsigned int inIndex, unsigned int* outValues) const;
+};
+
+template<typename T>
+GLTFSpan<T> GLTFAccessor::AsSpan() const
+{
+	GLTFSpan<T> span;
+	if (data == 0 || componentType != GLTFComponent<T>::kType) { return span; }
+	span.data = data;
+	span.count = count;
+	span.stride = stride;
+	span.components = components;
+	return span;
+}
+
+/**
+* A glTF 2.0 asset (.gltf + .bin files or a single .glb), loaded without copying any binary data
+* Load() maps the file & every buffer it references with MappedFile, parses the JSON once & keeps only the tables the importers
+* need (nodes, primitives, skins, animations, accessors). The JSON tree is thrown away afterwards
+* Accessors point straight into the mappings, so everything decoded from them is read exactly once, from the page cache
+* Only external buffers & the .glb binary chunk are supported, data: URIs (base64) would need a decode & a copy & are rejected
+*/
+class GLTFFile
+{
+public:
+	enum class Path
+	{
+		Translation,
+		Rotation,
+		Scale,
+		Weights // Morph targets, not imported
+	};
+	struct Node
+	{
+		std::string name;
+		int parent; // -1 for roots
+		int mesh;
+		int skin;
+		vec3 position;
+		quat rotation;
+		vec3 scale;
+	};
+	// Every primitive of every mesh, flattened, accessor indices are -1 when missing
+	struct Primitive
+	{
+		std::string name; // Of its mesh
+		int mesh;
+		int node; // The first node that instances the mesh, -1 if none does
+		int position;
+		int normal;
+		int texCoord;
+		int joints;
+		int weights;
+		int indices;
+		int mode; // 4 for triangles, the only mode imported
+	};
+	struct Skin
+	{
+		std::string name;
+		std::vector<int> joints; // Nodes, JOINTS_0 indexes this list
+		int inverseBindMatrices;
+	};
+	// A channel with its sampler folded in
+	struct Channel
+	{
+		int node;
+		Path path;
+		int input; // Key times
+		int output; // Values, 3 per key (in tangent, value, out tangent) for cubic splines
+		Interpolation interpolation;
+	};
+	struct Animation
+	{
+		std::string name;
+		std::vector<Channel> channels;
+	};
+protected:
+	std::vector<MappedFile*> mMappings; // [0] is the .gltf / .glb itself
+	std::vector<const unsigned char*> mBuffers;
+	std::vector<size_t> mBufferSizes;
+	std::vector<GLTFAccessor> mAccessors;
+	std::vector<Node> mNodes;
+	std::vector<Primitive> mPrimitives;
+	std::vector<Skin> mSkins;
+	std::vector<Animation> mAnimations;
+	double mParseTime;
+protected:
+	GLTFFile(const GLTFFile&);
+	GLTFFile& operator=(const GLTFFile&);
+	const unsigned char* MapBuffer(const std::string& inDirectory, const std::string& inUri, size_t& outSize);
+public:
+	GLTFFile();
+	~GLTFFile();
+
+	// Returns false with a message if the file can't be mapped or isn't valid glTF 2.0
+	bool Load(const char* inPath);
+	void Close();
+
+	unsigned int GetAccessorCount() const;
+	// An accessor that fails to resolve (or index -1) gives an empty one
+	const GLTFAccessor& GetAccessor(int inIndex) const;
+	const std::vector<Node>& GetNodes() const;
+	const std::vector<Primitive>& GetPrimitives() const;
+	const std::vector<Skin>& GetSkins() const;
+	const std::vector<Animation>& GetAnimations() const;
+	// Seconds Load() spent parsing the JSON
+	double GetParseTime() const;
+};
+
+/**
+* The skeleton is every joint of every skin plus their ancestors, so transforms of nodes above the joints (an armature node
+* with a scale or an up axis rotation) are part of the pose instead of getting lost
+* Joints are in topological order (see ComputeTopologicalOrder()), the rest pose is the node transforms
+*/
+struct GLTFSkeleton
+{
+	Pose restPose;
+	std::vector<mat4> inverseBindPose; // Identity for joints no skin lists
+	std::vector<std::string> jointNames;
+	std::vector<int> jointNodes; // Node of every joint
+	std::vector<int> nodeJoints; // Joint of every node, -1 if it's not in the skeleton
+};
+
+// One primitive in the layout of Mesh's CPU arrays, so MoveToMesh() can swap the arrays in without a copy
+struct GLTFMeshData
+{
+	std::string name;
+	std::vector<vec3> positions;
+	std::vector<vec3> normals;
+	std::vector<vec2> texCoords;
+	std::vector<vec4> weights;
+	std::vector<ivec4> influences; // Skeleton joints, not skin joints
+	std::vector<unsigned int> indices;
+};
+
+struct GLTFImport
+{
+	GLTFSkeleton skeleton;
+	std::vector<GLTFMeshData> meshes; // One per triangle primitive, in GetPrimitives() order
+	std::vector<Clip> clips;
+	unsigned int failed; // Primitives & animations that didn't import
+};
+
+bool ImportSkeleton(const GLTFFile& inFile, GLTFSkeleton& outSkeleton);
+// Skinned primitives need the skeleton to remap their joints, static ones stay in the mesh's own space
+bool ImportMesh(const GLTFFile& inFile, unsigned int inPrimitive, const GLTFSkeleton& inSkeleton, GLTFMeshData& outMesh);
+// Channels of nodes outside the skeleton & morph weights are skipped
+bool ImportClip(const GLTFFile& inFile, unsigned int inAnimation, const GLTFSkeleton& inSkeleton, Clip& outClip);
+/**
+* Imports the skeleton, then decodes every primitive & animation at once on inJobs (gJobSystem, 0 for the calling thread)
+* Workers only fill CPU arrays, nothing here touches OpenGL, so this is fine from Initialize() before any upload
+* Prints how long parsing & decoding took
+*/
+bool ImportGLTF(const GLTFFile& inFile, JobSystem* inJobs, GLTFImport& outImport);
+// Swaps the arrays into the mesh, the caller still has to OptimizeMesh() / UpdateOpenGLBuffers() on the GL thread
+void MoveToMesh(GLTFMeshData& ioData, Mesh& outMesh);
+
+#endif
@@ -0,0 +1,326 @@
+#include "GLTFSample.h"
+#include "GLTF.h"
+#include "Mesh.h"
+#include "PackedMesh.h"
+#include "Skinning.h"
+#include "JobSystem.h"
+#include "Arena.h"
+#include "AssetLoader.h"
+#include "FrameProfiler.h"
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const float kFieldOfView = 60.0f;
+
+GLTFSample::GLTFSample(const char* inPath, unsigned int inClip)
+{
+	mPath = inPath != 0 ? inPath : "";
+	mClipIndex = inClip;
+	mPackedMesh = false;
+	mClipCache = false;
+	mPalettes = 0;
+	for (unsigned int i = 0; i < kMaxPackets; ++i)
+	{
+		mPackets[i].palettes = 0;
+		mPackets[i].dualQuats = 0;
+		mPackets[i].ready = false;
+	}
+	mPacketCount = 1;
+	mMethod = gDefaultSkinningMethod;
+	mRadius = 1.0f;
+	mAspectRatio = 1.0f;
+	mTime = 0.0f;
+	mReady = false;
+	mGpuReady = false;
+	mGpuFailed = false;
+	mSkippedPrimitives = 0;
+	mVertexCount = 0;
+	mClipCount = 0;
+}
+
+GLTFSample::~GLTFSample()
+{
+	Shutdown();
+}
+
+void GLTFSample::SetPackedMesh(bool inPacked)
+{
+	mPackedMesh = inPacked;
+}
+
+void GLTFSample::SetClipCache(bool inClipCache)
+{
+	mClipCache = inClipCache;
+}
+
+bool GLTFSample::LoadCompressedClip()
+{
+	const Clip& clip = mClips[mClipIndex];
+	std::string cachePath = mPath + ".clip" + std::to_string(mClipIndex) + ".aclp";
+	// A cache written for another clip (different name or tracks) is rebuilt, names are stored truncated to 31 characters
+	FILE* existing = fopen(cachePath.c_str(), "rb");
+	if (existing != 0)
+	{
+		fclose(existing);
+		if (mCompressedClip.Load(cachePath.c_str()) && mCompressedClip.GetTrackCount() == clip.Size() &&
+			strncmp(mCompressedClip.GetName(), clip.GetName().c_str(), 31) == 0) { return true; }
+		mCompressedClip.Unload();
+	}
+	if (!WriteCompressedClip(clip, ClipCompressionSettings(), cachePath.c_str())) { return false; }
+	std::cout << "GLTFSample: compressed " << clip.GetName() << " into " << cachePath << "\n";
+	return mCompressedClip.Load(cachePath.c_str());
+}
+
+void GLTFSample::SetRenderPacketCount(unsigned int inCount)
+{
+	mPacketCount = (inCount < 1) ? 1 : (inCount > kMaxPackets ? kMaxPackets : inCount);
+}
+
+void GLTFSample::Initialize()
+{
+	if (mPath.empty())
+	{
+		std::cout << "GLTFSample: no file, use -gltf=path\n";
+		return;
+	}
+	// Without a loading thread Submit() runs the load right away, the result still arrives through gAssetLoader->Update()
+	if (gAssetLoader != 0) { gAssetLoader->Submit(&GLTFSample::LoadAssets, &GLTFSample::AssetsLoaded, this); }
+	else { FinishLoad(Load()); }
+}
+
+bool GLTFSample::LoadAssets(void* inUserData)
+{
+	return ((GLTFSample*)inUserData)->Load();
+}
+
+void GLTFSample::AssetsLoaded(void* inUserData, bool inSuccess)
+{
+	((GLTFSample*)inUserData)->FinishLoad(inSuccess);
+}
+
+bool GLTFSample::Load()
+{
+	// The file's mappings are only needed until everything is decoded
+	GLTFImport import;
+	{
+		GLTFFile file;
+		if (!file.Load(mPath.c_str()) || !ImportGLTF(file, gJobSystem, import)) { return false; }
+	}
+	unsigned int jointCount = import.skeleton.restPose.Size();
+	if (jointCount == 0)
+	{
+		std::cout << "GLTFSample: " << mPath << " has no skin\n";
+		return false;
+	}
+	mPose = import.skeleton.restPose;
+	mInverseBindPose.swap(import.skeleton.inverseBindPose);
+	mClips.swap(import.clips);
+	if (mClipIndex >= mClips.size()) { mClipIndex = 0; }
+	mClipCount = (unsigned int)mClips.size();
+	if (!mClips.empty())
+	{
+		mClipName = mClips[mClipIndex].GetName();
+		// The mapped clip replaces every decoded one, the decoded clips were only needed to build it
+		if (mClipCache && LoadCompressedClip())
+		{
+			std::cout << "GLTFSample: playing the compressed clip, " << mCompressedClip.GetSizeInBytes() / 1024 << "KB mapped\n";
+			mClips.clear();
+		}
+		else { mCursors.resize(mClips[mClipIndex].GetCursorCount()); }
+	}
+
+	// The loading thread's context shares buffers with the main one, the meshes are drawn from there once the load completed
+	vec3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+	vec3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	mSkippedPrimitives = 0;
+	mVertexCount = 0;
+	for (size_t i = 0; i < import.meshes.size(); ++i)
+	{
+		GLTFMeshData& data = import.meshes[i];
+		if (data.weights.empty() || data.normals.empty()) { ++mSkippedPrimitives; continue; }
+		for (size_t v = 0; v < data.positions.size(); ++v)
+		{
+			const vec3& p = data.positions[v];
+			boundsMin = vec3(p.x < boundsMin.x ? p.x : boundsMin.x, p.y < boundsMin.y ? p.y : boundsMin.y, p.z < boundsMin.z ? p.z : boundsMin.z);
+			boundsMax = vec3(p.x > boundsMax.x ? p.x : boundsMax.x, p.y > boundsMax.y ? p.y : boundsMax.y, p.z > boundsMax.z ? p.z : boundsMax.z);
+		}
+		Mesh* mesh = new Mesh();
+		mesh->SetSkinningMethod(mMethod);
+		MoveToMesh(data, *mesh);
+		OptimizeMesh(*mesh);
+		std::vector<unsigned char> image;
+		if (!(mPackedMesh && PackMesh(*mesh, image) && UploadPackedMesh(&image[0], image.size(), *mesh))) { mesh->UpdateOpenGLBuffers(); }
+		mVertexCount += mesh->GetVertexCount();
+		mMeshes.push_back(mesh);
+	}
+	if (mMeshes.empty())
+	{
+		std::cout << "GLTFSample: " << mPath << " has no skinned triangle meshes with normals\n";
+		return false;
+	}
+	mCenter = (boundsMin + boundsMax) * 0.5f;
+	mRadius = len(boundsMax - boundsMin) * 0.5f;
+	if (mRadius <= 0.0f) { mRadius = 1.0f; }
+	return true;
+}
+
+void GLTFSample::FinishLoad(bool inSuccess)
+{
+	if (!inSuccess)
+	{
+		std::cout << "GLTFSample: couldn't load " << mPath << "\n";
+		return;
+	}
+	unsigned int jointCount = mPose.Size();
+	mPalettes = gPersistentArena->AllocateArray<mat4>(jointCount);
+	bool allocated = mPalettes != 0 && mHierarchy.Initialize(jointCount, gPersistentArena);
+	for (unsigned int i = 0; i < mPacketCount && allocated; ++i)
+	{
+		if (mMethod == SkinningMethod::DualQuaternion)
+		{
+			mPackets[i].dualQuats = gPersistentArena->AllocateArray<dualquat>(jointCount);
+			allocated = mPackets[i].dualQuats != 0;
+		}
+		else
+		{
+			mPackets[i].palettes = gPersistentArena->AllocateArray<mat4>(jointCount);
+			allocated = mPackets[i].palettes != 0;
+		}
+	}
+	if (!allocated)
+	{
+		// The meshes are GL objects, they're left for Shutdown() which runs where the context is
+		std::cout << "GLTFSample: the persistent arena is too small for " << jointCount << " joints\n";
+		return;
+	}
+	mReady = true;
+	std::cout << "GLTFSample: " << mMeshes.size() << " meshes (" << mVertexCount << (mPackedMesh ? " packed" : "") << " vertices), " << jointCount << " joints, ";
+	if (mSkippedPrimitives > 0) { std::cout << mSkippedPrimitives << " unskinned primitives skipped, "; }
+	if (mClipCount == 0) { std::cout << "no clips, showing the rest pose\n"; }
+	else { std::cout << "playing " << mClipName << " (" << mClipIndex + 1 << " of " << mClipCount << ")\n"; }
+}
+
+bool GLTFSample::CreateGpuObjects()
+{
+	if (mGpuReady || mGpuFailed) { return mGpuReady; }
+	if (!mPalette.Initialize(mPose.Size(), 1, PaletteStorage::Auto, mMethod) || !mView.Initialize() ||
+		!mShader.Load(GetSkinnedVertexShader(mPalette), GetLitFragmentShader()))
+	{
+		std::cout << "GLTFSample: couldn't create the skinning palette or shader\n";
+		mPalette.Shutdown();
+		mView.Shutdown();
+		mGpuFailed = true;
+		return false;
+	}
+	mPalette.ConfigureShader(mShader);
+	mView.ConfigureShader(mShader);
+	mGpuReady = true;
+	return true;
+}
+
+void GLTFSample::Update(float inDeltaTime)
+{
+	if (!mReady) { return; }
+	mTime += inDeltaTime;
+	PROFILE_SCOPE("Animate");
+	if (mCompressedClip.IsLoaded()) { mTime = mCompressedClip.Sample(mPose, mTime); }
+	else if (!mClips.empty()) { mTime = mClips[mClipIndex].Sample(mPose, mTime, mCursors.empty() ? 0 : &mCursors[0]); }
+	mHierarchy.Update(mPose);
+	MultiplyArray(mHierarchy.GetWorldMatrices(), &mInverseBindPose[0], mPalettes, mPose.Size());
+}
+
+void GLTFSample::ExtractRenderData(unsigned int inPacket)
+{
+	if (!mReady || inPacket >= mPacketCount) { return; }
+	FramePacket& packet = mPackets[inPacket];
+	packet.ready = true;
+	packet.target = mCenter;
+	packet.eye = mCenter + vec3(0.0f, mRadius * 0.4f, mRadius * 2.5f);
+	if (mMethod == SkinningMethod::DualQuaternion) { Mat4ToDualQuatArray(mPalettes, packet.dualQuats, mPose.Size()); }
+	else { memcpy(packet.palettes, mPalettes, sizeof(mat4) * mPose.Size()); }
+}
+
+void GLTFSample::Resize(int inWidth, int inHeight)
+{
+	if (inWidth > 0 && inHeight > 0) { mAspectRatio = (float)inWidth / (float)inHeight; }
+}
+
+void GLTFSample::RenderPacket(unsigned int inPacket, float inAspectRatio)
+{
+	// mReady belongs to the Update thread, the packet says whether the load is visible here
+	if (inPacket >= mPacketCount || !mPackets[inPacket].ready || !CreateGpuObjects()) { return; }
+	PROFILE_SCOPE("Skinning");
+	const FramePacket& packet = mPackets[inPacket];
+	if (mMethod == SkinningMethod::DualQuaternion) { mPalette.Upload(packet.dualQuats, 1); }
+	else { mPalette.Upload(packet.palettes, 1); }
+	DrawPacket(packet, inAspectRatio);
+}
+
+void GLTFSample::RenderView(unsigned int inView, unsigned int inPacket, float inAspectRatio)
+{
+	if (inPacket >= mPacketCount || !mPackets[inPacket].ready || !mGpuReady) { return; }
+	PROFILE_SCOPE("Skinning");
+	DrawPacket(mPackets[inPacket], inAspectRatio);
+}
+
+void GLTFSample::EndRenderPacket(unsigned int inPacket)
+{
+	mPalette.EndFrame();
+	mView.EndFrame();
+}
+
+bool GLTFSample::HasDrawOnlyViews() const
+{
+	return true;
+}
+
+void GLTFSample::DrawPacket(const FramePacket& inPacket, float inAspectRatio)
+{
+	float nearPlane = mRadius * 0.01f;
+	mat4 viewProjection = perspective(kFieldOfView, inAspectRatio, nearPlane, mRadius * 10.0f) * lookAt(inPacket.eye, inPacket.target, vec3(0, 1, 0));
+
+	mShader.Bind();
+	mView.Upload(viewProjection, normalized(vec3(-0.3f, -1.0f, -0.5f)), vec3(0.8f, 0.55f, 0.4f));
+	mPalette.Bind(0, mShader.GetUniform("uPaletteOffset"));
+	GLint position = mShader.GetAttribute("aPosition");
+	GLint normal = mShader.GetAttribute("aNormal");
+	GLint weights = mShader.GetAttribute("aWeights");
+	GLint joints = mShader.GetAttribute("aJoints");
+	unsigned int vertices = 0;
+	for (size_t i = 0, size = mMeshes.size(); i < size; ++i)
+	{
+		mMeshes[i]->Bind(position, normal, -1, weights, joints);
+		mMeshes[i]->Draw();
+		mMeshes[i]->UnBind(position, normal, -1, weights, joints);
+		vertices += mMeshes[i]->GetVertexCount();
+	}
+	mShader.UnBind();
+	if (gProfiler != 0) { gProfiler->AddCounter("Skinned vertices", (float)vertices); }
+}
+
+void GLTFSample::Shutdown()
+{
+	mReady = false;
+	mGpuReady = false;
+	mGpuFailed = false;
+	mPalette.Shutdown();
+	mView.Shutdown();
+	mShader.Release();
+	for (size_t i = 0, size = mMeshes.size(); i < size; ++i) { delete mMeshes[i]; }
+	mMeshes.clear();
+	mClips.clear();
+	mCompressedClip.Unload();
+	mCursors.clear();
+	mInverseBindPose.clear();
+	mHierarchy.Release();
+	// The arrays belong to gPersistentArena
+	mPalettes = 0;
+	for (unsigned int i = 0; i < kMaxPackets; ++i)
+	{
+		mPackets[i].palettes = 0;
+		mPackets[i].dualQuats = 0;
+		mPackets[i].ready = false;
+	}
+}
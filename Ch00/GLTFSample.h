@@ -0,0 +1,102 @@
+#pragma once
+#ifndef _H_GLTFSAMPLE_
+#define _H_GLTFSAMPLE_
+
+#include "Application.h"
+#include "SkinningPalette.h"
+#include "ViewUniforms.h"
+#include "Shader.h"
+#include "Pose.h"
+#include "Clip.h"
+#include "CompressedClip.h"
+#include "TransformHierarchy.h"
+#include "dualquat.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+class Mesh;
+
+/**
+* Plays a clip of a glTF character (-sample=gltf -gltf=path [-clip=N])
+* Initialize() only queues the load on gAssetLoader, the loading thread maps the file, imports it with ImportGLTF() (meshes & clips
+* are decoded in parallel on gJobSystem) & uploads the meshes, so the window keeps presenting while that runs. The character shows
+* up once the load completed on the Update thread, the palette & shader are created by the first RenderPacket() after that since
+* they need the skeleton & the thread that renders. GPU skinned with one palette of every joint, primitives without a skin aren't drawn
+* -packedmesh uploads the meshes as 28 byte vertices (see PackedMesh.h), -hotreload & the render thread work like in SkinningSample
+* -clipcache compresses the clip into <file>.clip<N>.aclp the first time (see CompressedClip.h) & from then on plays it from a
+* mapping of that file, the decoded Clip isn't kept. Delete the .aclp after changing the animation
+*/
+class GLTFSample : public Application
+{
+public:
+	static const unsigned int kMaxPackets = 3;
+protected:
+	struct FramePacket
+	{
+		mat4* palettes; // One skin matrix per joint, or a dual quaternion
+		dualquat* dualQuats;
+		vec3 eye;
+		vec3 target;
+		bool ready; // Extracted after the load completed, carries the loaded data over to the render thread
+	};
+	std::string mPath;
+	unsigned int mClipIndex;
+	bool mPackedMesh;
+	Pose mPose;
+	TransformHierarchy mHierarchy; // Joints the clip doesn't animate keep their world matrices
+	std::vector<mat4> mInverseBindPose;
+	std::vector<Clip> mClips;
+	std::vector<TrackCursor> mCursors;
+	bool mClipCache;
+	CompressedClip mCompressedClip; // Played instead of mClips when it's loaded
+	std::vector<Mesh*> mMeshes;
+	mat4* mPalettes;
+	FramePacket mPackets[kMaxPackets];
+	unsigned int mPacketCount;
+	Shader mShader;
+	SkinningPalette mPalette;
+	ViewUniforms mView;
+	SkinningMethod mMethod;
+	vec3 mCenter; // Bounds of the bind pose, the camera frames them
+	float mRadius;
+	std::atomic<float> mAspectRatio;
+	float mTime;
+	bool mReady; // Update thread: the load completed & the arrays are allocated
+	bool mGpuReady; // Thread that renders: palette & shader were created
+	bool mGpuFailed;
+	// Written by the load for the summary printed when it completes
+	unsigned int mSkippedPrimitives;
+	unsigned int mVertexCount;
+	unsigned int mClipCount;
+	std::string mClipName;
+protected:
+	GLTFSample(const GLTFSample&);
+	GLTFSample& operator=(const GLTFSample&);
+	bool LoadCompressedClip();
+	// AssetLoader callbacks, inUserData is the sample
+	static bool LoadAssets(void* inUserData);
+	static void AssetsLoaded(void* inUserData, bool inSuccess);
+	bool Load();
+	void FinishLoad(bool inSuccess);
+	bool CreateGpuObjects();
+	void DrawPacket(const FramePacket& inPacket, float inAspectRatio);
+public:
+	GLTFSample(const char* inPath, unsigned int inClip);
+	~GLTFSample();
+	// Call before Initialize()
+	void SetPackedMesh(bool inPacked);
+	void SetClipCache(bool inClipCache);
+	void SetRenderPacketCount(unsigned int inCount);
+	void Initialize();
+	void Update(float inDeltaTime);
+	void ExtractRenderData(unsigned int inPacket);
+	void RenderPacket(unsigned int inPacket, float inAspectRatio);
+	void RenderView(unsigned int inView, unsigned int inPacket, float inAspectRatio);
+	void EndRenderPacket(unsigned int inPacket);
+	bool HasDrawOnlyViews() const;
+	void Resize(int inWidth, int inHeight);
+	void Shutdown();
+};
+
+#endif
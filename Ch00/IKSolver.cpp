@@ -0,0 +1,403 @@
+#include "IKSolver.h"
+#include "Pose.h"
+#include "JobSystem.h"
+#include "FrameClock.h"
+#include "FrameProfiler.h"
+#include <cmath>
+#include <iostream>
+
+const char* GetIKSolverName(IKSolverType inType)
+{
+	switch (inType)
+	{
+	case IKSolverType::CCD: return "ccd";
+	case IKSolverType::FABRIK: return "fabrik";
+	case IKSolverType::TwoBone: return "twobone";
+	}
+	return "unknown";
+}
+
+bool IKChain::Build(const Pose& inPose, unsigned int inEndJoint, unsigned int inLength)
+{
+	length = 0;
+	if (inLength < 2 || inLength > kMaxLength || inEndJoint >= inPose.Size())
+	{
+		std::cout << "IKChain::Build() needs 2 to " << kMaxLength << " joints of the pose, got " << inLength << " ending at " << inEndJoint << "\n";
+		return false;
+	}
+	int joint = (int)inEndJoint;
+	for (unsigned int i = inLength; i > 0; --i)
+	{
+		if (joint < 0)
+		{
+			std::cout << "IKChain::Build(): joint " << inEndJoint << " has less than " << inLength - 1 << " ancestors\n";
+			return false;
+		}
+		joints[i - 1] = (unsigned int)joint;
+		joint = inPose.GetParent((unsigned int)joint);
+	}
+	length = inLength;
+	return true;
+}
+
+IKBudget::IKBudget()
+{
+	mRemaining = 0;
+	mUsed = 0;
+	mTruncated = 0;
+	mDeadline = 0;
+	mLimited = false;
+}
+
+void IKBudget::Reset(unsigned int inMaxIterations, float inMaxMilliseconds)
+{
+	mLimited = inMaxIterations > 0;
+	mRemaining = mLimited ? (int)inMaxIterations : 0;
+	mUsed = 0;
+	mTruncated = 0;
+	mDeadline = 0;
+	if (inMaxMilliseconds > 0.0f)
+	{
+		// Go through ToSeconds() once to get the counter rate instead of querying it here
+		double countsPerSecond = 1.0 / FrameClock::ToSeconds(1);
+		mDeadline = FrameClock::Now() + (long long)(countsPerSecond * (double)inMaxMilliseconds * 0.001);
+	}
+}
+
+bool IKBudget::Consume()
+{
+	if (mLimited && mRemaining.fetch_sub(1) <= 0) { return false; }
+	if (mDeadline != 0 && FrameClock::Now() > mDeadline) { return false; }
+	mUsed.fetch_add(1);
+	return true;
+}
+
+void IKBudget::ReportTruncated()
+{
+	mTruncated.fetch_add(1);
+}
+
+unsigned int IKBudget::GetUsedIterations() const
+{
+	return mUsed.load();
+}
+
+unsigned int IKBudget::GetTruncatedSolves() const
+{
+	return mTruncated.load();
+}
+
+// World space copy of a chain, index k is inChain.joints[k]
+struct IKWorkspace
+{
+	vec3 positions[IKChain::kMaxLength];
+	quat rotations[IKChain::kMaxLength];
+	quat parentRotation; // World rotation of the chain root's parent
+	unsigned int length;
+};
+
+static void ReadChain(const Pose& inPose, const IKChain& inChain, IKWorkspace& outWork)
+{
+	const vec3* positions = inPose.GetPositions();
+	const quat* rotations = inPose.GetRotations();
+	const vec3* scales = inPose.GetScales();
+
+	// World transform of the root's parent, combined from the parent upwards
+	vec3 position;
+	quat rotation;
+	vec3 scale(1, 1, 1);
+	for (int joint = inPose.GetParent(inChain.joints[0]); joint >= 0; joint = inPose.GetParent((unsigned int)joint))
+	{
+		position = positions[joint] + rotations[joint] * (scales[joint] * position);
+		rotation = rotations[joint] * rotation;
+		scale = scales[joint] * scale;
+	}
+	outWork.parentRotation = rotation;
+	outWork.length = inChain.length;
+
+	for (unsigned int k = 0; k < inChain.length; ++k)
+	{
+		unsigned int joint = inChain.joints[k];
+		position = position + rotation * (scale * positions[joint]);
+		rotation = rotation * rotations[joint];
+		scale = scale * scales[joint];
+		outWork.positions[k] = position;
+		outWork.rotations[k] = rotation;
+	}
+}
+
+static void WriteChain(const IKWorkspace& inWork, const IKChain& inChain, Pose& ioPose)
+{
+	quat* rotations = ioPose.GetRotations();
+	quat parent = inWork.parentRotation;
+	for (unsigned int k = 0; k < inWork.length; ++k)
+	{
+		rotations[inChain.joints[k]] = normalized(inverse(parent) * inWork.rotations[k]);
+		parent = inWork.rotations[k];
+	}
+}
+
+// Rotates joint inJoint & everything below it around the joint's position by a world space delta
+static void RotateChain(IKWorkspace& ioWork, unsigned int inJoint, const quat& inDelta)
+{
+	vec3 pivot = ioWork.positions[inJoint];
+	ioWork.rotations[inJoint] = inDelta * ioWork.rotations[inJoint];
+	for (unsigned int k = inJoint + 1; k < ioWork.length; ++k)
+	{
+		ioWork.positions[k] = pivot + inDelta * (ioWork.positions[k] - pivot);
+		ioWork.rotations[k] = inDelta * ioWork.rotations[k];
+	}
+}
+
+static float GetError(const IKWorkspace& inWork, const vec3& inTarget)
+{
+	return len(inWork.positions[inWork.length - 1] - inTarget);
+}
+
+static IKResult MakeResult(float inError, unsigned int inIterations, const IKSettings& inSettings)
+{
+	IKResult result;
+	result.error = inError;
+	result.iterations = inIterations;
+	result.reached = inError <= inSettings.tolerance;
+	return result;
+}
+
+static bool IsValidChain(const Pose& inPose, const IKChain& inChain, unsigned int inMinLength)
+{
+	if (inChain.length < inMinLength || inChain.length > IKChain::kMaxLength) { return false; }
+	for (unsigned int k = 0; k < inChain.length; ++k)
+	{
+		if (inChain.joints[k] >= inPose.Size()) { return false; }
+	}
+	return true;
+}
+
+IKResult SolveCCD(Pose& ioPose, const IKChain& inChain, const vec3& inTarget, const IKSettings& inSettings, IKBudget* ioBudget)
+{
+	if (!IsValidChain(ioPose, inChain, 2)) { return MakeResult(0.0f, 0, inSettings); }
+	IKWorkspace work;
+	ReadChain(ioPose, inChain, work);
+	unsigned int end = work.length - 1;
+
+	float error = GetError(work, inTarget);
+	unsigned int iteration = 0;
+	for (; iteration < inSettings.maxIterations && error > inSettings.tolerance; ++iteration)
+	{
+		if (ioBudget != 0 && !ioBudget->Consume())
+		{
+			ioBudget->ReportTruncated();
+			break;
+		}
+		// From the joint closest to the end effector to the root, each one points the effector at the target
+		for (unsigned int i = end; i > 0; --i)
+		{
+			unsigned int joint = i - 1;
+			vec3 toEffector = work.positions[end] - work.positions[joint];
+			vec3 toTarget = inTarget - work.positions[joint];
+			if (lenSq(toEffector) < 1e-10f || lenSq(toTarget) < 1e-10f) { continue; }
+			RotateChain(work, joint, fromTo(toEffector, toTarget));
+		}
+		error = GetError(work, inTarget);
+	}
+	if (iteration > 0) { WriteChain(work, inChain, ioPose); }
+	return MakeResult(error, iteration, inSettings);
+}
+
+IKResult SolveFABRIK(Pose& ioPose, const IKChain& inChain, const vec3& inTarget, const IKSettings& inSettings, IKBudget* ioBudget)
+{
+	if (!IsValidChain(ioPose, inChain, 2)) { return MakeResult(0.0f, 0, inSettings); }
+	IKWorkspace work;
+	ReadChain(ioPose, inChain, work);
+	unsigned int end = work.length - 1;
+
+	float lengths[IKChain::kMaxLength];
+	float reach = 0.0f;
+	for (unsigned int k = 0; k < end; ++k)
+	{
+		lengths[k] = len(work.positions[k + 1] - work.positions[k]);
+		reach += lengths[k];
+	}
+
+	// FABRIK only moves positions, the rotations are rebuilt from them at the end
+	vec3 solved[IKChain::kMaxLength];
+	for (unsigned int k = 0; k < work.length; ++k) { solved[k] = work.positions[k]; }
+	vec3 root = solved[0];
+	float error = GetError(work, inTarget);
+	unsigned int iteration = 0;
+	bool outOfReach = len(inTarget - root) >= reach;
+	for (; iteration < inSettings.maxIterations && error > inSettings.tolerance; ++iteration)
+	{
+		if (ioBudget != 0 && !ioBudget->Consume())
+		{
+			ioBudget->ReportTruncated();
+			break;
+		}
+		if (outOfReach)
+		{
+			// Straight line towards the target, the closest the chain can get
+			vec3 direction = normalized(inTarget - root);
+			for (unsigned int k = 1; k < work.length; ++k) { solved[k] = solved[k - 1] + direction * lengths[k - 1]; }
+			error = len(solved[end] - inTarget);
+			++iteration;
+			break;
+		}
+		// Backward: pin the effector to the target & pull every joint after it
+		solved[end] = inTarget;
+		for (unsigned int k = end; k > 0; --k)
+		{
+			vec3 direction = solved[k - 1] - solved[k];
+			if (lenSq(direction) < 1e-10f) { continue; }
+			solved[k - 1] = solved[k] + normalized(direction) * lengths[k - 1];
+		}
+		// Forward: pin the root back in place
+		solved[0] = root;
+		for (unsigned int k = 1; k < work.length; ++k)
+		{
+			vec3 direction = solved[k] - solved[k - 1];
+			if (lenSq(direction) < 1e-10f) { continue; }
+			solved[k] = solved[k - 1] + normalized(direction) * lengths[k - 1];
+		}
+		error = len(solved[end] - inTarget);
+	}
+	if (iteration == 0) { return MakeResult(error, 0, inSettings); }
+
+	// Rotate every bone onto its solved direction, parents first so each child already starts from its final position
+	for (unsigned int k = 0; k < end; ++k)
+	{
+		vec3 current = work.positions[k + 1] - work.positions[k];
+		vec3 wanted = solved[k + 1] - solved[k];
+		if (lenSq(current) < 1e-10f || lenSq(wanted) < 1e-10f) { continue; }
+		RotateChain(work, k, fromTo(current, wanted));
+	}
+	WriteChain(work, inChain, ioPose);
+	return MakeResult(GetError(work, inTarget), iteration, inSettings);
+}
+
+static float SafeAngle(const vec3& inA, const vec3& inB)
+{
+	float cosine = dot(normalized(inA), normalized(inB));
+	return acosf(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+}
+
+IKResult SolveTwoBone(Pose& ioPose, const IKChain& inChain, const vec3& inTarget, const vec3* inPole, const IKSettings& inSettings, IKBudget* ioBudget)
+{
+	if (!IsValidChain(ioPose, inChain, 3) || inChain.length != 3)
+	{
+		std::cout << "SolveTwoBone() needs a chain of exactly 3 joints\n";
+		return MakeResult(0.0f, 0, inSettings);
+	}
+	IKWorkspace work;
+	ReadChain(ioPose, inChain, work);
+	float error = GetError(work, inTarget);
+	if (error <= inSettings.tolerance) { return MakeResult(error, 0, inSettings); }
+	if (ioBudget != 0 && !ioBudget->Consume())
+	{
+		ioBudget->ReportTruncated();
+		return MakeResult(error, 0, inSettings);
+	}
+
+	const vec3& a = work.positions[0];
+	vec3 b = work.positions[1];
+	vec3 c = work.positions[2];
+	float upper = len(b - a);
+	float lower = len(c - b);
+	// Keep the target a hair inside the reach, a fully straight limb has no bend plane left for the next frame
+	float distance = len(inTarget - a);
+	float minReach = fabsf(upper - lower) + 1e-4f;
+	float maxReach = (upper + lower) * 0.9999f;
+	distance = distance < minReach ? minReach : (distance > maxReach ? maxReach : distance);
+
+	// 1. Open or close the knee until the root to effector distance matches, law of cosines
+	vec3 bendAxis = cross(a - b, c - b);
+	if (lenSq(bendAxis) < 1e-10f)
+	{
+		// Straight limb: bend towards the pole, or around any axis perpendicular to it
+		vec3 hint = (inPole != 0) ? *inPole - a : vec3(0, 0, 1);
+		bendAxis = cross(c - a, hint);
+		if (lenSq(bendAxis) < 1e-10f) { bendAxis = cross(c - a, vec3(1, 0, 0)); }
+	}
+	if (upper > 1e-6f && lower > 1e-6f)
+	{
+		float cosine = (upper * upper + lower * lower - distance * distance) / (2.0f * upper * lower);
+		float wanted = acosf(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+		float current = SafeAngle(a - b, c - b);
+		RotateChain(work, 1, angleAxis(wanted - current, normalized(bendAxis)));
+	}
+
+	// 2. Swing the whole limb from the root so the effector lands on the target
+	c = work.positions[2];
+	if (lenSq(inTarget - a) > 1e-10f) { RotateChain(work, 0, fromTo(c - a, inTarget - a)); }
+
+	// 3. Twist around the root to target axis until the knee points at the pole
+	if (inPole != 0)
+	{
+		vec3 axis = work.positions[2] - a;
+		if (lenSq(axis) > 1e-10f)
+		{
+			axis = normalized(axis);
+			vec3 knee = work.positions[1] - a;
+			vec3 pole = *inPole - a;
+			knee = knee - axis * dot(knee, axis);
+			pole = pole - axis * dot(pole, axis);
+			if (lenSq(knee) > 1e-10f && lenSq(pole) > 1e-10f)
+			{
+				float angle = SafeAngle(knee, pole);
+				if (dot(cross(knee, pole), axis) < 0.0f) { angle = -angle; }
+				RotateChain(work, 0, angleAxis(angle, axis));
+			}
+		}
+	}
+
+	WriteChain(work, inChain, ioPose);
+	return MakeResult(GetError(work, inTarget), 1, inSettings);
+}
+
+IKResult Solve(IKRequest& ioRequest, const IKSettings& inSettings, IKBudget* ioBudget)
+{
+	if (ioRequest.pose == 0 || ioRequest.chain == 0)
+	{
+		ioRequest.result = MakeResult(0.0f, 0, inSettings);
+		return ioRequest.result;
+	}
+	switch (ioRequest.solver)
+	{
+	case IKSolverType::CCD:
+		ioRequest.result = SolveCCD(*ioRequest.pose, *ioRequest.chain, ioRequest.target, inSettings, ioBudget);
+		break;
+	case IKSolverType::FABRIK:
+		ioRequest.result = SolveFABRIK(*ioRequest.pose, *ioRequest.chain, ioRequest.target, inSettings, ioBudget);
+		break;
+	case IKSolverType::TwoBone:
+		ioRequest.result = SolveTwoBone(*ioRequest.pose, *ioRequest.chain, ioRequest.target, ioRequest.usePole ? &ioRequest.pole : 0, inSettings, ioBudget);
+		break;
+	}
+	return ioRequest.result;
+}
+
+void SolveMany(IKRequest* ioRequests, unsigned int inCount, const IKSettings& inSettings, IKBudget* ioBudget, JobSystem* inJobs, unsigned int inBatchSize)
+{
+	if (inCount == 0) { return; }
+	PROFILE_SCOPE("IK");
+	if (inBatchSize == 0) { inBatchSize = 1; }
+	if (inJobs != 0 && inCount > inBatchSize)
+	{
+		inJobs->ParallelFor(inCount, inBatchSize, [ioRequests, &inSettings, ioBudget](unsigned int inBegin, unsigned int inEnd)
+		{
+			for (unsigned int i = inBegin; i < inEnd; ++i) { Solve(ioRequests[i], inSettings, ioBudget); }
+		});
+	}
+	else
+	{
+		for (unsigned int i = 0; i < inCount; ++i) { Solve(ioRequests[i], inSettings, ioBudget); }
+	}
+
+	if (gProfiler != 0)
+	{
+		unsigned int iterations = 0;
+		for (unsigned int i = 0; i < inCount; ++i) { iterations += ioRequests[i].result.iterations; }
+		gProfiler->AddCounter("IK solves", (float)inCount);
+		gProfiler->AddCounter("IK iterations", (float)iterations);
+		if (ioBudget != 0) { gProfiler->AddCounter("IK truncated", (float)ioBudget->GetTruncatedSolves()); }
+	}
+}
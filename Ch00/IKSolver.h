@@ -0,0 +1,113 @@
+#pragma once
+#ifndef _H_IKSOLVER_
+#define _H_IKSOLVER_
+
+#include "vec3.h"
+#include "quat.h"
+#include <atomic>
+
+class Pose;
+class JobSystem;
+
+/**
+* Inverse kinematics on the SoA Pose layout
+* A solve reads the chain's world transforms out of the pose once, works on a small world space copy (on the stack)
+* & writes only the local rotations of the chain's joints back, so bone lengths & the rest of the pose stay as animated
+* Scales are taken into account when going to world space, but rotations are only exact for uniform scales
+*/
+
+enum class IKSolverType
+{
+	CCD, // Cyclic coordinate descent, rotates one joint at a time towards the target, cheap per iteration & stable
+	FABRIK, // Forward & backward reaching, moves joint positions & rebuilds rotations, converges in fewer iterations
+	TwoBone // Analytic, exactly 3 joints (hip, knee, ankle), always one iteration
+};
+
+const char* GetIKSolverName(IKSolverType inType);
+
+// Joints from the root of the chain to the end effector, every joint is the parent of the next one
+struct IKChain
+{
+	static const unsigned int kMaxLength = 16;
+	unsigned int joints[kMaxLength];
+	unsigned int length;
+
+	inline IKChain() { length = 0; }
+	// Walks inLength - 1 parents up from inEndJoint, fails if the chain would leave the skeleton or is too long
+	bool Build(const Pose& inPose, unsigned int inEndJoint, unsigned int inLength);
+};
+
+struct IKSettings
+{
+	unsigned int maxIterations; // Per solve, TwoBone ignores it
+	float tolerance; // Stops as soon as the end effector is this close to the target
+
+	inline IKSettings() { maxIterations = 10; tolerance = 0.001f; }
+};
+
+/**
+* IKBudget limits the work of every solve sharing it, usually everything solved in one frame
+* Each iteration takes one from the budget, once the iterations or the time run out the remaining solves stop
+* where they are (requests that didn't get a single iteration keep their animated pose). Thread safe, so a
+* SolveMany() spread over the job system shares one budget
+*/
+class IKBudget
+{
+private:
+	std::atomic<int> mRemaining;
+	std::atomic<unsigned int> mUsed;
+	std::atomic<unsigned int> mTruncated;
+	long long mDeadline; // FrameClock::Now() counter, 0 for no time limit
+	bool mLimited;
+private:
+	IKBudget(const IKBudget&);
+	IKBudget& operator=(const IKBudget&);
+public:
+	IKBudget();
+	// 0 for no limit, call once per frame before solving
+	void Reset(unsigned int inMaxIterations, float inMaxMilliseconds);
+	// Takes one iteration, false when the budget is spent
+	bool Consume();
+	// Solves that had to stop before reaching the target or their own iteration limit
+	void ReportTruncated();
+	unsigned int GetUsedIterations() const;
+	unsigned int GetTruncatedSolves() const;
+};
+
+struct IKResult
+{
+	float error; // Distance from the end effector to the target after solving
+	unsigned int iterations;
+	bool reached; // error <= tolerance
+};
+
+// inBudget can be 0, inPole is a world position the bend (knee) should point at, only TwoBone uses it
+IKResult SolveCCD(Pose& ioPose, const IKChain& inChain, const vec3& inTarget, const IKSettings& inSettings, IKBudget* ioBudget);
+IKResult SolveFABRIK(Pose& ioPose, const IKChain& inChain, const vec3& inTarget, const IKSettings& inSettings, IKBudget* ioBudget);
+IKResult SolveTwoBone(Pose& ioPose, const IKChain& inChain, const vec3& inTarget, const vec3* inPole, const IKSettings& inSettings, IKBudget* ioBudget);
+
+// One solve for SolveMany(), targets are in the pose's space (world space if the root holds the character's position)
+struct IKRequest
+{
+	Pose* pose;
+	const IKChain* chain;
+	IKSolverType solver;
+	vec3 target;
+	vec3 pole;
+	bool usePole;
+	IKResult result;
+
+	inline IKRequest() { pose = 0; chain = 0; solver = IKSolverType::CCD; usePole = false; result.error = 0.0f; result.iterations = 0; result.reached = false; }
+};
+
+IKResult Solve(IKRequest& ioRequest, const IKSettings& inSettings, IKBudget* ioBudget);
+
+/**
+* Solves every request, in batches of inBatchSize on inJobs (gJobSystem or 0 to solve on the calling thread)
+* Requests never share a pose, so batches don't need any locking. Earlier requests tend to get the budget first,
+* put the most important ones (closest characters) at the front
+* Adds the "IK solves", "IK iterations" & "IK truncated" counters, waits for every batch before returning
+*/
+void SolveMany(IKRequest* ioRequests, unsigned int inCount, const IKSettings& inSettings, IKBudget* ioBudget, JobSystem* inJobs, unsigned int inBatchSize = 16);
+
+#endif
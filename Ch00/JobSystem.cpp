@@ -0,0 +1,283 @@
+#include "JobSystem.h"
+#include "Arena.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+JobSystem* gJobSystem = 0;
+
+namespace
+{
+	// Index of the queue that belongs to the current thread, -1 for threads the job system doesn't know about
+	thread_local int tQueueIndex = -1;
+	thread_local unsigned int tStealSeed = 0;
+}
+
+JobSystem::JobSystem(unsigned int inWorkerCount)
+{
+	if (inWorkerCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		inWorkerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	mQueueCount = inWorkerCount + 1;
+	mQueues = new WorkQueue[mQueueCount];
+	for (unsigned int i = 0; i < mQueueCount; ++i)
+	{
+		mQueues[i].top = 0;
+		mQueues[i].bottom = 0;
+	}
+	mJobMemory = new unsigned char[sizeof(Job) * kMaxJobs + alignof(Job)];
+	size_t misalignment = (size_t)mJobMemory % alignof(Job);
+	mJobs = (Job*)(mJobMemory + (misalignment == 0 ? 0 : alignof(Job) - misalignment));
+	for (unsigned int i = 0; i < kMaxJobs; ++i) { new (&mJobs[i]) Job(); }
+	mNextJob = 0;
+	mPendingJobs = 0;
+	mStopping = false;
+
+	tQueueIndex = 0;
+	mWorkers.reserve(inWorkerCount);
+	mWorkerArenas.reserve(inWorkerCount);
+	for (unsigned int i = 0; i < inWorkerCount; ++i) { mWorkerArenas.push_back(new LinearArena("JobWorker", kWorkerArenaSize)); }
+	for (unsigned int i = 0; i < inWorkerCount; ++i)
+	{
+		mWorkers.push_back(std::thread(&JobSystem::WorkerMain, this, i + 1));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+	// Job only holds plain data & atomics, so the memory can be released without running destructors
+	delete[] mJobMemory;
+	delete[] mQueues;
+	for (unsigned int i = 0; i < mWorkerArenas.size(); ++i) { delete mWorkerArenas[i]; }
+}
+
+void JobSystem::Shutdown()
+{
+	if (mWorkers.empty()) { return; }
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStopping = true;
+	}
+	mWakeUp.notify_all();
+	for (unsigned int i = 0; i < mWorkers.size(); ++i) { mWorkers[i].join(); }
+	mWorkers.clear();
+
+	// Anything still queued runs on the calling thread, so no job (or its continuations) is silently dropped
+	for (Job* job = FindJob(); job != 0; job = FindJob()) { Execute(job); }
+}
+
+void JobSystem::WorkerMain(unsigned int inQueueIndex)
+{
+	tQueueIndex = (int)inQueueIndex;
+	tStealSeed = inQueueIndex;
+	gFrameArena = mWorkerArenas[inQueueIndex - 1];
+
+	while (!mStopping)
+	{
+		Job* job = FindJob();
+		if (job != 0)
+		{
+			Execute(job);
+			continue;
+		}
+
+		// Nothing to do, sleep until new work is pushed. The timeout covers a wake up that's missed between the check & the wait
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mWakeUp.wait_for(lock, std::chrono::milliseconds(1), [this]() { return mPendingJobs.load() > 0 || mStopping.load(); });
+	}
+}
+
+unsigned int JobSystem::GetQueueIndex() const
+{
+	// Threads that aren't part of the pool share the creating thread's queue, the queue is locked so that's safe
+	return tQueueIndex >= 0 ? (unsigned int)tQueueIndex : 0;
+}
+
+bool JobSystem::Push(Job* inJob)
+{
+	WorkQueue& queue = mQueues[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.bottom - queue.top >= kQueueCapacity) { return false; }
+		queue.jobs[queue.bottom % kQueueCapacity] = inJob;
+		++queue.bottom;
+	}
+	++mPendingJobs;
+	mWakeUp.notify_one();
+	return true;
+}
+
+Job* JobSystem::Pop(unsigned int inQueueIndex)
+{
+	WorkQueue& queue = mQueues[inQueueIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.bottom == queue.top) { return 0; }
+	--queue.bottom;
+	--mPendingJobs;
+	return queue.jobs[queue.bottom % kQueueCapacity];
+}
+
+Job* JobSystem::Steal(unsigned int inQueueIndex)
+{
+	WorkQueue& queue = mQueues[inQueueIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.bottom == queue.top) { return 0; }
+	Job* job = queue.jobs[queue.top % kQueueCapacity];
+	++queue.top;
+	--mPendingJobs;
+	return job;
+}
+
+Job* JobSystem::FindJob()
+{
+	unsigned int own = GetQueueIndex();
+	Job* job = Pop(own);
+	if (job != 0) { return job; }
+
+	// Start stealing at a different queue every time so the thieves don't all hit the same one
+	tStealSeed = tStealSeed * 1664525u + 1013904223u;
+	unsigned int start = (tStealSeed >> 16) % mQueueCount;
+	for (unsigned int i = 0; i < mQueueCount; ++i)
+	{
+		unsigned int victim = (start + i) % mQueueCount;
+		if (victim == own) { continue; }
+		job = Steal(victim);
+		if (job != 0) { return job; }
+	}
+	return 0;
+}
+
+void JobSystem::Execute(Job* inJob)
+{
+	// Jobs nest when a thread waits inside one, the scopes rewind in the same order so a waiting job keeps its scratch memory
+	if (gFrameArena != 0)
+	{
+		ArenaScope scope(*gFrameArena);
+		inJob->function(inJob, inJob->data);
+	}
+	else { inJob->function(inJob, inJob->data); }
+	Finish(inJob);
+}
+
+void JobSystem::Finish(Job* inJob)
+{
+	int unfinished = --inJob->unfinished;
+	if (unfinished != 0) { return; }
+
+	if (inJob->parent != 0) { Finish(inJob->parent); }
+	int continuations = inJob->continuationCount.load();
+	for (int i = 0; i < continuations; ++i) { Run(inJob->continuations[i]); }
+}
+
+Job* JobSystem::AllocateJob(Job::Function inFunction, Job* inParent, const void* inData, unsigned int inDataSize)
+{
+	unsigned int index = mNextJob.fetch_add(1) % kMaxJobs;
+	Job* job = &mJobs[index];
+	job->function = inFunction;
+	job->parent = inParent;
+	job->system = this;
+	job->unfinished = 1;
+	job->continuationCount = 0;
+	if (inParent != 0) { ++inParent->unfinished; }
+
+	if (inDataSize > Job::kDataSize)
+	{
+		std::cout << "Job data is " << inDataSize << " bytes, only " << Job::kDataSize << " fit. Pass a pointer instead\n";
+		inDataSize = Job::kDataSize;
+	}
+	if (inData != 0 && inDataSize > 0) { memcpy(job->data, inData, inDataSize); }
+	return job;
+}
+
+Job* JobSystem::CreateJob(Job::Function inFunction, const void* inData, unsigned int inDataSize)
+{
+	return AllocateJob(inFunction, 0, inData, inDataSize);
+}
+
+Job* JobSystem::CreateChildJob(Job* inParent, Job::Function inFunction, const void* inData, unsigned int inDataSize)
+{
+	return AllocateJob(inFunction, inParent, inData, inDataSize);
+}
+
+bool JobSystem::AddContinuation(Job* inAncestor, Job* inContinuation)
+{
+	int index = inAncestor->continuationCount.load();
+	if (index >= (int)Job::kMaxContinuations) { return false; }
+	inAncestor->continuations[index] = inContinuation;
+	inAncestor->continuationCount = index + 1;
+	return true;
+}
+
+void JobSystem::Run(Job* inJob)
+{
+	// A full queue (or a system that's shutting down) runs the job right away instead of failing
+	if (mWorkers.empty() || !Push(inJob)) { Execute(inJob); }
+}
+
+void JobSystem::Wait(Job* inJob)
+{
+	while (inJob->unfinished.load() > 0)
+	{
+		Job* job = FindJob();
+		if (job != 0) { Execute(job); }
+		else { std::this_thread::yield(); }
+	}
+}
+
+bool JobSystem::IsFinished(const Job* inJob) const
+{
+	return inJob->unfinished.load() <= 0;
+}
+
+void JobSystem::ParallelForJob(Job* inJob, const void* inData)
+{
+	ParallelForData range = *(const ParallelForData*)inData;
+
+	// Keep splitting off the upper half as a child job until the range left for this job fits in a batch
+	while (range.end - range.begin > range.batchSize)
+	{
+		unsigned int middle = range.begin + (range.end - range.begin) / 2;
+		ParallelForData upper = range;
+		upper.begin = middle;
+		Job* child = inJob->system->CreateChildJob(inJob, &JobSystem::ParallelForJob, &upper, sizeof(ParallelForData));
+		inJob->system->Run(child);
+		range.end = middle;
+	}
+	range.function(range.begin, range.end, range.userData);
+}
+
+void JobSystem::ParallelFor(unsigned int inCount, unsigned int inBatchSize, ParallelForFunction inFunction, void* inUserData)
+{
+	if (inCount == 0) { return; }
+	if (inBatchSize == 0) { inBatchSize = 1; }
+	if (inCount <= inBatchSize)
+	{
+		inFunction(0, inCount, inUserData);
+		return;
+	}
+
+	ParallelForData range;
+	range.function = inFunction;
+	range.userData = inUserData;
+	range.begin = 0;
+	range.end = inCount;
+	range.batchSize = inBatchSize;
+
+	Job* root = CreateJob(&JobSystem::ParallelForJob, &range, sizeof(ParallelForData));
+	Run(root);
+	Wait(root);
+}
+
+unsigned int JobSystem::GetThreadCount() const
+{
+	return mQueueCount;
+}
+
+int JobSystem::GetThreadIndex()
+{
+	return tQueueIndex;
+}
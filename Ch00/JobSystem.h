@@ -0,0 +1,174 @@
+#pragma once
+#ifndef _H_JOBSYSTEM_
+#define _H_JOBSYSTEM_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+class LinearArena;
+
+/**
+* A Job is a function pointer plus a small block of inline data (the arguments), so creating one never touches the heap
+* Jobs come from a ring buffer inside the JobSystem & are recycled once the ring wraps around, which means a job
+* must be finished before kMaxJobs newer jobs have been created (several thousand per frame is fine)
+* unfinished counts the job itself & all of its children, a job is done once it reaches 0
+*/
+struct alignas(64) Job
+{
+	static const unsigned int kDataSize = 64;
+	static const unsigned int kMaxContinuations = 8;
+	typedef void (*Function)(Job* inJob, const void* inData);
+
+	Function function;
+	Job* parent;
+	JobSystem* system;
+	std::atomic<int> unfinished;
+	std::atomic<int> continuationCount;
+	Job* continuations[kMaxContinuations];
+	alignas(16) unsigned char data[kDataSize];
+};
+
+/**
+* JobSystem is a work-stealing thread pool
+* Every thread (workers & the thread that created the system) has its own queue. A thread pushes & pops work at the back
+* of its own queue (newest first, which keeps caches warm), idle threads steal from the front of other queues (oldest first)
+* Dependencies are expressed in 2 ways:
+*  - Children: a job isn't finished until every child created with CreateChildJob() is, Wait() on the parent waits for all of them
+*  - Continuations: jobs added with AddContinuation() are started once their ancestor finishes, they must be added before the ancestor runs
+* Threads that wait on a job don't block, they keep executing other jobs until the one they wait for is done
+* Scratch memory: every worker owns a frame arena (gFrameArena is set on the worker threads) & every job runs inside an ArenaScope
+* of the executing thread's gFrameArena, so what a job allocates from it is released when the job returns. Results have to be
+* written to memory the caller owns. Threads that run jobs need a gFrameArena, which the main, render & asset loader threads have
+*/
+class JobSystem
+{
+public:
+	static const unsigned int kMaxJobs = 8192;
+	static const unsigned int kQueueCapacity = 4096;
+	static const size_t kWorkerArenaSize = 1024 * 1024;
+	typedef void (*ParallelForFunction)(unsigned int inBegin, unsigned int inEnd, void* inUserData);
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		Job* jobs[kQueueCapacity];
+		unsigned long long top; // Steal end, only grows
+		unsigned long long bottom; // Owner end
+	};
+	struct ParallelForData
+	{
+		ParallelForFunction function;
+		void* userData;
+		unsigned int begin;
+		unsigned int end;
+		unsigned int batchSize;
+	};
+private:
+	std::vector<std::thread> mWorkers;
+	std::vector<LinearArena*> mWorkerArenas; // One per worker, in the same order
+	WorkQueue* mQueues; // mWorkers.size() + 1, queue 0 belongs to the thread that created the system
+	unsigned int mQueueCount;
+	unsigned char* mJobMemory; // new[] doesn't respect alignas(64) before C++17, so the ring is aligned by hand
+	Job* mJobs;
+	std::atomic<unsigned int> mNextJob;
+	std::atomic<int> mPendingJobs;
+	std::atomic<bool> mStopping;
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeUp;
+private:
+	JobSystem(const JobSystem&);
+	JobSystem& operator=(const JobSystem&);
+	void WorkerMain(unsigned int inQueueIndex);
+	unsigned int GetQueueIndex() const;
+	bool Push(Job* inJob);
+	Job* Pop(unsigned int inQueueIndex);
+	Job* Steal(unsigned int inQueueIndex);
+	Job* FindJob();
+	void Execute(Job* inJob);
+	void Finish(Job* inJob);
+	Job* AllocateJob(Job::Function inFunction, Job* inParent, const void* inData, unsigned int inDataSize);
+	static void ParallelForJob(Job* inJob, const void* inData);
+	template<typename T>
+	static void LambdaJob(Job* inJob, const void* inData);
+	template<typename T>
+	static void LambdaRange(unsigned int inBegin, unsigned int inEnd, void* inUserData);
+public:
+	// inWorkerCount = 0 uses one worker per hardware thread, minus the calling thread
+	JobSystem(unsigned int inWorkerCount = 0);
+	~JobSystem();
+
+	// Waits for the workers to finish their current job & joins them, called from WM_CLOSE
+	void Shutdown();
+
+	// inData (up to Job::kDataSize bytes) is copied into the job
+	Job* CreateJob(Job::Function inFunction, const void* inData = 0, unsigned int inDataSize = 0);
+	Job* CreateChildJob(Job* inParent, Job::Function inFunction, const void* inData = 0, unsigned int inDataSize = 0);
+	// Captures are copied into the job, they must fit in Job::kDataSize bytes
+	template<typename T>
+	Job* CreateJob(const T& inLambda, Job* inParent = 0);
+
+	// inContinuation runs once inAncestor (& all of its children) finished. Returns false if inAncestor has no room left
+	bool AddContinuation(Job* inAncestor, Job* inContinuation);
+
+	void Run(Job* inJob);
+	// Executes other jobs until inJob is finished
+	void Wait(Job* inJob);
+	bool IsFinished(const Job* inJob) const;
+
+	/**
+	* Calls inFunction over [0, inCount) in ranges of at most inBatchSize, spread across all threads, & waits for it to finish
+	* The range is split recursively so the first ranges start running while the rest are still being created
+	*/
+	void ParallelFor(unsigned int inCount, unsigned int inBatchSize, ParallelForFunction inFunction, void* inUserData);
+	// Same as above, inBody is called as inBody(begin, end). It isn't copied, ParallelFor waits before returning
+	template<typename T>
+	void ParallelFor(unsigned int inCount, unsigned int inBatchSize, const T& inBody);
+
+	// Worker threads + the thread that created the system
+	unsigned int GetThreadCount() const;
+	// 0 for the thread that created the system, 1..n for the workers & -1 for any other thread. Useful for per thread scratch memory
+	static int GetThreadIndex();
+};
+
+template<typename T>
+void JobSystem::LambdaJob(Job* inJob, const void* inData)
+{
+	const T* lambda = (const T*)inData;
+	(*lambda)();
+	lambda->~T();
+}
+
+template<typename T>
+Job* JobSystem::CreateJob(const T& inLambda, Job* inParent)
+{
+	static_assert(sizeof(T) <= Job::kDataSize, "Lambda captures too much data to fit in a job");
+	Job* job = AllocateJob(&JobSystem::LambdaJob<T>, inParent, 0, 0);
+	new (job->data) T(inLambda);
+	return job;
+}
+
+template<typename T>
+void JobSystem::LambdaRange(unsigned int inBegin, unsigned int inEnd, void* inUserData)
+{
+	(*(const T*)inUserData)(inBegin, inEnd);
+}
+
+template<typename T>
+void JobSystem::ParallelFor(unsigned int inCount, unsigned int inBatchSize, const T& inBody)
+{
+	ParallelFor(inCount, inBatchSize, &JobSystem::LambdaRange<T>, (void*)&inBody);
+}
+
+/**
+* The engine wide job system, created in WinMain before Application::Initialize() & shut down in WM_CLOSE
+* -jobthreads=N overrides the number of worker threads
+*/
+extern JobSystem* gJobSystem;
+
+#endif
@@ -0,0 +1,305 @@
+#include "Json.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static const JsonValue kNullValue;
+static const std::string kEmptyString;
+// Deeper documents are rejected instead of running out of stack
+static const unsigned int kMaxDepth = 256;
+
+JsonValue::JsonValue()
+{
+	type = JsonType::Null;
+	boolean = false;
+	number = 0.0;
+}
+
+bool JsonValue::IsNull() const
+{
+	return type == JsonType::Null;
+}
+
+bool JsonValue::IsArray() const
+{
+	return type == JsonType::Array;
+}
+
+bool JsonValue::IsObject() const
+{
+	return type == JsonType::Object;
+}
+
+unsigned int JsonValue::Size() const
+{
+	if (type == JsonType::Array) { return (unsigned int)elements.size(); }
+	if (type == JsonType::Object) { return (unsigned int)members.size(); }
+	return 0;
+}
+
+const JsonValue& JsonValue::operator[](unsigned int inIndex) const
+{
+	if (type != JsonType::Array || inIndex >= elements.size()) { return kNullValue; }
+	return elements[inIndex];
+}
+
+const JsonValue* JsonValue::Find(const char* inName) const
+{
+	if (type != JsonType::Object) { return 0; }
+	for (size_t i = 0, size = members.size(); i < size; ++i)
+	{
+		if (members[i].first == inName) { return &members[i].second; }
+	}
+	return 0;
+}
+
+const JsonValue& JsonValue::Get(const char* inName) const
+{
+	const JsonValue* value = Find(inName);
+	return value != 0 ? *value : kNullValue;
+}
+
+int JsonValue::GetInt(const char* inName, int inDefault) const
+{
+	const JsonValue* value = Find(inName);
+	return (value != 0 && value->type == JsonType::Number) ? (int)value->number : inDefault;
+}
+
+float JsonValue::GetFloat(const char* inName, float inDefault) const
+{
+	const JsonValue* value = Find(inName);
+	return (value != 0 && value->type == JsonType::Number) ? (float)value->number : inDefault;
+}
+
+bool JsonValue::GetBool(const char* inName, bool inDefault) const
+{
+	const JsonValue* value = Find(inName);
+	return (value != 0 && value->type == JsonType::Bool) ? value->boolean : inDefault;
+}
+
+const std::string& JsonValue::GetString(const char* inName) const
+{
+	const JsonValue* value = Find(inName);
+	return (value != 0 && value->type == JsonType::String) ? value->string : kEmptyString;
+}
+
+unsigned int JsonValue::GetFloats(const char* inName, float* outValues, unsigned int inCount) const
+{
+	const JsonValue* value = Find(inName);
+	if (value == 0 || value->type != JsonType::Array) { return 0; }
+	unsigned int size = value->Size();
+	for (unsigned int i = 0; i < size && i < inCount; ++i) { outValues[i] = (float)value->elements[i].number; }
+	return size;
+}
+
+namespace
+{
+	struct JsonParser
+	{
+		const char* text;
+		const char* end;
+		const char* cursor;
+		const char* error;
+
+		void SkipSpace()
+		{
+			while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) { ++cursor; }
+		}
+
+		bool Fail(const char* inError)
+		{
+			if (error == 0) { error = inError; }
+			return false;
+		}
+
+		bool Match(const char* inWord)
+		{
+			size_t length = strlen(inWord);
+			if ((size_t)(end - cursor) < length || memcmp(cursor, inWord, length) != 0) { return Fail("unknown literal"); }
+			cursor += length;
+			return true;
+		}
+
+		static void AppendUtf8(std::string& outString, unsigned int inCode)
+		{
+			if (inCode < 0x80) { outString += (char)inCode; }
+			else if (inCode < 0x800)
+			{
+				outString += (char)(0xC0 | (inCode >> 6));
+				outString += (char)(0x80 | (inCode & 0x3F));
+			}
+			else if (inCode < 0x10000)
+			{
+				outString += (char)(0xE0 | (inCode >> 12));
+				outString += (char)(0x80 | ((inCode >> 6) & 0x3F));
+				outString += (char)(0x80 | (inCode & 0x3F));
+			}
+			else
+			{
+				outString += (char)(0xF0 | (inCode >> 18));
+				outString += (char)(0x80 | ((inCode >> 12) & 0x3F));
+				outString += (char)(0x80 | ((inCode >> 6) & 0x3F));
+				outString += (char)(0x80 | (inCode & 0x3F));
+			}
+		}
+
+		bool ParseHex(unsigned int& outCode)
+		{
+			if (end - cursor < 4) { return Fail("truncated \\u escape"); }
+			outCode = 0;
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				char c = *cursor++;
+				unsigned int digit = (c >= '0' && c <= '9') ? (unsigned int)(c - '0') : (c >= 'a' && c <= 'f') ? (unsigned int)(c - 'a' + 10) :
+					(c >= 'A' && c <= 'F') ? (unsigned int)(c - 'A' + 10) : 16;
+				if (digit > 15) { return Fail("bad \\u escape"); }
+				outCode = (outCode << 4) | digit;
+			}
+			return true;
+		}
+
+		bool ParseString(std::string& outString)
+		{
+			++cursor; // "
+			// Most strings have no escapes, those are copied in one go
+			const char* start = cursor;
+			while (cursor < end && *cursor != '"' && *cursor != '\\') { ++cursor; }
+			outString.assign(start, cursor);
+			while (cursor < end && *cursor != '"')
+			{
+				char c = *cursor++;
+				if (c != '\\') { outString += c; continue; }
+				if (cursor >= end) { break; }
+				c = *cursor++;
+				switch (c)
+				{
+				case '"': outString += '"'; break;
+				case '\\': outString += '\\'; break;
+				case '/': outString += '/'; break;
+				case 'b': outString += '\b'; break;
+				case 'f': outString += '\f'; break;
+				case 'n': outString += '\n'; break;
+				case 'r': outString += '\r'; break;
+				case 't': outString += '\t'; break;
+				case 'u':
+				{
+					unsigned int code = 0;
+					if (!ParseHex(code)) { return false; }
+					// A surrogate pair is two escapes
+					if (code >= 0xD800 && code < 0xDC00 && end - cursor >= 6 && cursor[0] == '\\' && cursor[1] == 'u')
+					{
+						cursor += 2;
+						unsigned int low = 0;
+						if (!ParseHex(low)) { return false; }
+						code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+					}
+					AppendUtf8(outString, code);
+					break;
+				}
+				default: return Fail("bad escape");
+				}
+			}
+			if (cursor >= end) { return Fail("unterminated string"); }
+			++cursor; // "
+			return true;
+		}
+
+		bool ParseNumber(double& outNumber)
+		{
+			// strtod would accept more than JSON does (hex, inf) & could read past the end, so the token is checked & copied first
+			const char* start = cursor;
+			if (cursor < end && *cursor == '-') { ++cursor; }
+			while (cursor < end && ((*cursor >= '0' && *cursor <= '9') || *cursor == '.' || *cursor == 'e' || *cursor == 'E' || *cursor == '+' || *cursor == '-')) { ++cursor; }
+			char buffer[64];
+			size_t length = (size_t)(cursor - start);
+			if (length == 0 || length >= sizeof(buffer)) { return Fail("bad number"); }
+			memcpy(buffer, start, length);
+			buffer[length] = 0;
+			char* parsed = 0;
+			outNumber = strtod(buffer, &parsed);
+			if (parsed != buffer + length) { return Fail("bad number"); }
+			return true;
+		}
+
+		bool ParseValue(JsonValue& outValue, unsigned int inDepth)
+		{
+			if (inDepth > kMaxDepth) { return Fail("nested too deep"); }
+			SkipSpace();
+			if (cursor >= end) { return Fail("unexpected end"); }
+			char c = *cursor;
+			if (c == '{')
+			{
+				outValue.type = JsonType::Object;
+				++cursor;
+				SkipSpace();
+				if (cursor < end && *cursor == '}') { ++cursor; return true; }
+				while (true)
+				{
+					SkipSpace();
+					if (cursor >= end || *cursor != '"') { return Fail("expected a member name"); }
+					outValue.members.push_back(std::pair<std::string, JsonValue>());
+					std::pair<std::string, JsonValue>& member = outValue.members.back();
+					if (!ParseString(member.first)) { return false; }
+					SkipSpace();
+					if (cursor >= end || *cursor != ':') { return Fail("expected ':'"); }
+					++cursor;
+					if (!ParseValue(member.second, inDepth + 1)) { return false; }
+					SkipSpace();
+					if (cursor < end && *cursor == ',') { ++cursor; continue; }
+					if (cursor < end && *cursor == '}') { ++cursor; return true; }
+					return Fail("expected ',' or '}'");
+				}
+			}
+			if (c == '[')
+			{
+				outValue.type = JsonType::Array;
+				++cursor;
+				SkipSpace();
+				if (cursor < end && *cursor == ']') { ++cursor; return true; }
+				while (true)
+				{
+					outValue.elements.push_back(JsonValue());
+					if (!ParseValue(outValue.elements.back(), inDepth + 1)) { return false; }
+					SkipSpace();
+					if (cursor < end && *cursor == ',') { ++cursor; continue; }
+					if (cursor < end && *cursor == ']') { ++cursor; return true; }
+					return Fail("expected ',' or ']'");
+				}
+			}
+			if (c == '"')
+			{
+				outValue.type = JsonType::String;
+				return ParseString(outValue.string);
+			}
+			if (c == 't') { outValue.type = JsonType::Bool; outValue.boolean = true; return Match("true"); }
+			if (c == 'f') { outValue.type = JsonType::Bool; outValue.boolean = false; return Match("false"); }
+			if (c == 'n') { outValue.type = JsonType::Null; return Match("null"); }
+			outValue.type = JsonType::Number;
+			return ParseNumber(outValue.number);
+		}
+	};
+}
+
+bool ParseJson(const char* inText, size_t inLength, JsonValue& outValue)
+{
+	outValue = JsonValue();
+	JsonParser parser;
+	parser.text = inText;
+	parser.end = inText + inLength;
+	parser.cursor = inText;
+	parser.error = 0;
+	// A UTF-8 byte order mark is allowed in front
+	if (inLength >= 3 && memcmp(inText, "\xEF\xBB\xBF", 3) == 0) { parser.cursor += 3; }
+	bool parsed = parser.ParseValue(outValue, 0);
+	if (parsed)
+	{
+		parser.SkipSpace();
+		if (parser.cursor != parser.end) { parsed = parser.Fail("trailing characters"); }
+	}
+	if (!parsed)
+	{
+		std::cout << "JSON: " << parser.error << " at byte " << (size_t)(parser.cursor - parser.text) << "\n";
+		outValue = JsonValue();
+	}
+	return parsed;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef _H_JSON_
+#define _H_JSON_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum class JsonType
+{
+	Null,
+	Bool,
+	Number,
+	String,
+	Array,
+	Object
+};
+
+/**
+* Minimal JSON document, enough for asset manifests like glTF
+* The whole text is parsed once into a tree of values, objects keep their members in file order & are searched linearly,
+* which is fine for the handful of keys an asset object has. Numbers are doubles, strings are UTF-8 with the escapes resolved
+* The accessors never fail: a missing member or a value of the wrong type gives the default (or the shared null value)
+*/
+struct JsonValue
+{
+	JsonType type;
+	bool boolean;
+	double number;
+	std::string string;
+	std::vector<JsonValue> elements; // Array
+	std::vector<std::pair<std::string, JsonValue> > members; // Object
+
+	JsonValue();
+
+	bool IsNull() const;
+	bool IsArray() const;
+	bool IsObject() const;
+	// Elements of an array, members of an object, 0 otherwise
+	unsigned int Size() const;
+	// Array element, null if out of range
+	const JsonValue& operator[](unsigned int inIndex) const;
+	// Object member, 0 if there isn't one
+	const JsonValue* Find(const char* inName) const;
+	const JsonValue& Get(const char* inName) const;
+
+	int GetInt(const char* inName, int inDefault) const;
+	float GetFloat(const char* inName, float inDefault) const;
+	bool GetBool(const char* inName, bool inDefault) const;
+	const std::string& GetString(const char* inName) const; // Empty if missing
+	// Copies up to inCount numbers of the array member inName into outValues, returns how many there were
+	unsigned int GetFloats(const char* inName, float* outValues, unsigned int inCount) const;
+};
+
+// Returns false with a message (& the byte offset of the problem) if inText isn't a single valid JSON value
+bool ParseJson(const char* inText, size_t inLength, JsonValue& outValue);
+
+#endif
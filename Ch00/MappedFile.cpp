@@ -0,0 +1,85 @@
+#include "MappedFile.h"
+#include <Windows.h>
+#include <iostream>
+
+MappedFile::MappedFile()
+{
+	mFile = 0;
+	mMapping = 0;
+	mData = 0;
+	mSize = 0;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char* inPath)
+{
+	Close();
+
+	HANDLE file = CreateFileA(inPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Couldn't open " << inPath << " (error " << GetLastError() << ")\n";
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		std::cout << "Couldn't map " << inPath << ", the file is empty\n";
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		std::cout << "CreateFileMapping failed for " << inPath << " (error " << GetLastError() << ")\n";
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		std::cout << "MapViewOfFile failed for " << inPath << " (error " << GetLastError() << ")\n";
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mMapping = mapping;
+	mData = (const unsigned char*)view;
+	mSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mData != 0) { UnmapViewOfFile(mData); }
+	if (mMapping != 0) { CloseHandle((HANDLE)mMapping); }
+	if (mFile != 0) { CloseHandle((HANDLE)mFile); }
+	mFile = 0;
+	mMapping = 0;
+	mData = 0;
+	mSize = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+	return mData != 0;
+}
+
+const unsigned char* MappedFile::GetData() const
+{
+	return mData;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return mSize;
+}
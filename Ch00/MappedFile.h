@@ -0,0 +1,34 @@
+#pragma once
+#ifndef _H_MAPPEDFILE_
+#define _H_MAPPEDFILE_
+
+#include <cstddef>
+
+/**
+* Read only view of a whole file through CreateFileMapping / MapViewOfFile
+* Nothing is read up front, pages are faulted in by the OS the first time they're touched & are shared with the file cache,
+* so binary assets can be used in place without a parse or a copy
+* The view stays valid until Close() (or the destructor)
+*/
+class MappedFile
+{
+private:
+	void* mFile; // HANDLE, kept as void* so this header doesn't need Windows.h
+	void* mMapping;
+	const unsigned char* mData;
+	size_t mSize;
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const char* inPath);
+	void Close();
+	bool IsOpen() const;
+	const unsigned char* GetData() const;
+	size_t GetSize() const;
+};
+
+#endif
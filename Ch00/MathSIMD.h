@@ -0,0 +1,58 @@
+#pragma once
+#ifndef _H_MATHSIMD_
+#define _H_MATHSIMD_
+
+/**
+* Compile time selection of the instruction set used by the math library (vec3, vec4, quat, mat4)
+* - MATH_SSE is on for every x64 build & for x86 builds with /arch:SSE2 or higher
+* - MATH_AVX is added on top when the compiler targets AVX (/arch:AVX or /arch:AVX2 define __AVX__),
+*   it's used by the kernels that can work on two vec4s at once (mat4 * mat4 & the batch functions)
+* - Defining MATH_FORCE_SCALAR (project wide) disables both, which is handy to check the SIMD paths against plain C++
+* All math types are alignas(16), so they can be loaded with aligned SSE loads. That holds on the stack, in the arenas & in std::vector,
+* but heap storage is only aligned with C++17's aligned new: 32 bit MSVC's operator new returns 8 byte aligned memory otherwise,
+* which faults on the first _mm_load_ps. The project builds with /std:c++17 & anything older is refused below
+*/
+#if !defined(MATH_FORCE_SCALAR) && (defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+	#define MATH_SSE 1
+	#include <xmmintrin.h>
+	#include <emmintrin.h>
+#else
+	#define MATH_SSE 0
+#endif
+
+#if MATH_SSE && !defined(__cpp_aligned_new)
+	#error The SSE math kernels need C++17 aligned new for heap allocated math types (/std:c++17), or define MATH_FORCE_SCALAR
+#endif
+
+#if MATH_SSE && defined(__AVX__)
+	#define MATH_AVX 1
+	#include <immintrin.h>
+#else
+	#define MATH_AVX 0
+#endif
+
+#define MATH_EPSILON 0.000001f
+
+#if MATH_SSE
+// Shuffle of a single register, lanes are listed from x to w (the reverse of _MM_SHUFFLE)
+#define MATH_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(w, z, y, x))
+
+// Dot product of the xyz lanes of a & b, broadcast to all four lanes (SSE2 only, no _mm_dp_ps)
+inline __m128 MathDot3(__m128 a, __m128 b)
+{
+	__m128 m = _mm_mul_ps(a, b);
+	__m128 sum = _mm_add_ss(m, MATH_SWIZZLE(m, 1, 1, 1, 1));
+	sum = _mm_add_ss(sum, MATH_SWIZZLE(m, 2, 2, 2, 2));
+	return MATH_SWIZZLE(sum, 0, 0, 0, 0);
+}
+
+// Dot product of all four lanes, broadcast to all four lanes
+inline __m128 MathDot4(__m128 a, __m128 b)
+{
+	__m128 m = _mm_mul_ps(a, b);
+	__m128 sum = _mm_add_ps(m, MATH_SWIZZLE(m, 1, 0, 3, 2));
+	return _mm_add_ps(sum, MATH_SWIZZLE(sum, 2, 3, 0, 1));
+}
+#endif
+
+#endif
@@ -0,0 +1,267 @@
+#include "Mesh.h"
+#include "Skinning.h"
+#include "RenderState.h"
+#include "dualquat.h"
+#include "PackedMesh.h"
+#include <cstddef>
+
+Mesh::Mesh()
+{
+	for (unsigned int i = 0; i < BufferCount; ++i) { mBuffers[i] = 0; }
+	mIndexBuffer = 0;
+	mPackedBuffer = 0;
+	mPackedVertexCount = 0;
+	mPackedIndexCount = 0;
+	mSkinningMethod = gDefaultSkinningMethod;
+}
+
+Mesh::~Mesh()
+{
+	Release();
+}
+
+std::vector<vec3>& Mesh::GetPositions()
+{
+	return mPositions;
+}
+
+std::vector<vec3>& Mesh::GetNormals()
+{
+	return mNormals;
+}
+
+std::vector<vec2>& Mesh::GetTexCoords()
+{
+	return mTexCoords;
+}
+
+std::vector<vec4>& Mesh::GetWeights()
+{
+	return mWeights;
+}
+
+std::vector<ivec4>& Mesh::GetInfluences()
+{
+	return mInfluences;
+}
+
+std::vector<unsigned int>& Mesh::GetIndices()
+{
+	return mIndices;
+}
+
+unsigned int Mesh::GetVertexCount() const
+{
+	return mPositions.empty() ? mPackedVertexCount : (unsigned int)mPositions.size();
+}
+
+unsigned int Mesh::GetIndexCount() const
+{
+	return mIndices.empty() ? mPackedIndexCount : (unsigned int)mIndices.size();
+}
+
+// Uploads inCount elements of inSize bytes, empty arrays leave the buffer alone
+static void UploadBuffer(GLuint inBuffer, const void* inData, size_t inCount, size_t inSize, GLenum inUsage)
+{
+	if (inCount == 0) { return; }
+	gRenderState->BindBuffer(GL_ARRAY_BUFFER, inBuffer);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(inCount * inSize), inData, inUsage);
+}
+
+void Mesh::CreateBuffers()
+{
+	if (mBuffers[0] == 0)
+	{
+		glGenBuffers(BufferCount, mBuffers);
+		glGenBuffers(1, &mIndexBuffer);
+	}
+}
+
+void Mesh::UpdateOpenGLBuffers()
+{
+	CreateBuffers();
+
+	UploadBuffer(mBuffers[BufferPosition], mPositions.empty() ? 0 : &mPositions[0], mPositions.size(), sizeof(vec3), GL_STATIC_DRAW);
+	UploadBuffer(mBuffers[BufferNormal], mNormals.empty() ? 0 : &mNormals[0], mNormals.size(), sizeof(vec3), GL_STATIC_DRAW);
+	UploadBuffer(mBuffers[BufferTexCoord], mTexCoords.empty() ? 0 : &mTexCoords[0], mTexCoords.size(), sizeof(vec2), GL_STATIC_DRAW);
+	UploadBuffer(mBuffers[BufferWeights], mWeights.empty() ? 0 : &mWeights[0], mWeights.size(), sizeof(vec4), GL_STATIC_DRAW);
+	UploadBuffer(mBuffers[BufferInfluences], mInfluences.empty() ? 0 : &mInfluences[0], mInfluences.size(), sizeof(ivec4), GL_STATIC_DRAW);
+
+	if (!mIndices.empty())
+	{
+		// The element array binding is VAO state, so it bypasses gRenderState & is set again by Bind()
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(mIndices.size() * sizeof(unsigned int)), &mIndices[0], GL_STATIC_DRAW);
+	}
+}
+
+void Mesh::UploadPacked(const MeshFormat::Vertex* inVertices, unsigned int inVertexCount, const unsigned int* inIndices, unsigned int inIndexCount)
+{
+	CreateBuffers();
+	if (mPackedBuffer == 0) { glGenBuffers(1, &mPackedBuffer); }
+	UploadBuffer(mPackedBuffer, inVertices, inVertexCount, sizeof(MeshFormat::Vertex), GL_STATIC_DRAW);
+	mPackedVertexCount = inVertexCount;
+	mPackedIndexCount = inIndexCount;
+	if (inIndexCount > 0)
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)(inIndexCount * sizeof(unsigned int)), inIndices, GL_STATIC_DRAW);
+	}
+}
+
+bool Mesh::IsPacked() const
+{
+	return mPackedBuffer != 0;
+}
+
+void Mesh::Release()
+{
+	if (mBuffers[0] != 0)
+	{
+		for (unsigned int i = 0; i < BufferCount; ++i)
+		{
+			if (gRenderState != 0) { gRenderState->OnBufferDeleted(mBuffers[i]); }
+		}
+		glDeleteBuffers(BufferCount, mBuffers);
+		glDeleteBuffers(1, &mIndexBuffer);
+		for (unsigned int i = 0; i < BufferCount; ++i) { mBuffers[i] = 0; }
+		mIndexBuffer = 0;
+	}
+	if (mPackedBuffer != 0)
+	{
+		if (gRenderState != 0) { gRenderState->OnBufferDeleted(mPackedBuffer); }
+		glDeleteBuffers(1, &mPackedBuffer);
+		mPackedBuffer = 0;
+	}
+	mPackedVertexCount = 0;
+	mPackedIndexCount = 0;
+}
+
+bool Mesh::PrepareCpuSkin()
+{
+	unsigned int count = GetVertexCount();
+	if (count == 0 || mWeights.size() != count || mInfluences.size() != count) { return false; }
+	if (mSkinnedPositions.size() != count)
+	{
+		mSkinnedPositions.resize(count);
+		mSkinnedNormals.resize(count);
+	}
+	return true;
+}
+
+void Mesh::CpuSkin(const mat4* inPalette)
+{
+	if (!PrepareCpuSkin()) { return; }
+	unsigned int count = GetVertexCount();
+	bool hasNormals = mNormals.size() == count;
+	SkinVertices(&mPositions[0], hasNormals ? &mNormals[0] : 0, &mWeights[0], &mInfluences[0], inPalette, count,
+		&mSkinnedPositions[0], hasNormals ? &mSkinnedNormals[0] : 0);
+	UploadSkinned();
+}
+
+void Mesh::CpuSkin(const dualquat* inPalette)
+{
+	if (!PrepareCpuSkin()) { return; }
+	unsigned int count = GetVertexCount();
+	bool hasNormals = mNormals.size() == count;
+	SkinVertices(&mPositions[0], hasNormals ? &mNormals[0] : 0, &mWeights[0], &mInfluences[0], inPalette, count,
+		&mSkinnedPositions[0], hasNormals ? &mSkinnedNormals[0] : 0);
+	UploadSkinned();
+}
+
+void Mesh::UploadSkinned()
+{
+	unsigned int count = GetVertexCount();
+	if (mBuffers[0] == 0) { return; }
+	// Orphaning the old storage lets the driver hand out fresh memory instead of waiting for draws that still read it
+	UploadBuffer(mBuffers[BufferSkinnedPosition], &mSkinnedPositions[0], count, sizeof(vec3), GL_STREAM_DRAW);
+	if (mNormals.size() == count) { UploadBuffer(mBuffers[BufferSkinnedNormal], &mSkinnedNormals[0], count, sizeof(vec3), GL_STREAM_DRAW); }
+}
+
+void Mesh::SetSkinningMethod(SkinningMethod inMethod)
+{
+	mSkinningMethod = inMethod;
+}
+
+SkinningMethod Mesh::GetSkinningMethod() const
+{
+	return mSkinningMethod;
+}
+
+void Mesh::BindAttribute(GLint inSlot, GLuint inBuffer, GLint inComponents, GLsizei inStride, bool inInteger)
+{
+	if (inSlot < 0) { return; }
+	gRenderState->BindBuffer(GL_ARRAY_BUFFER, inBuffer);
+	glEnableVertexAttribArray((GLuint)inSlot);
+	if (inInteger) { glVertexAttribIPointer((GLuint)inSlot, inComponents, GL_INT, inStride, (void*)0); }
+	else { glVertexAttribPointer((GLuint)inSlot, inComponents, GL_FLOAT, GL_FALSE, inStride, (void*)0); }
+}
+
+void Mesh::BindPacked(GLint inSlot, size_t inOffset, GLint inComponents, GLenum inType, bool inNormalized, bool inInteger)
+{
+	if (inSlot < 0) { return; }
+	gRenderState->BindBuffer(GL_ARRAY_BUFFER, mPackedBuffer);
+	glEnableVertexAttribArray((GLuint)inSlot);
+	GLsizei stride = (GLsizei)sizeof(MeshFormat::Vertex);
+	if (inInteger) { glVertexAttribIPointer((GLuint)inSlot, inComponents, inType, stride, (void*)inOffset); }
+	else { glVertexAttribPointer((GLuint)inSlot, inComponents, inType, inNormalized ? GL_TRUE : GL_FALSE, stride, (void*)inOffset); }
+}
+
+void Mesh::Bind(GLint inPosition, GLint inNormal, GLint inTexCoord, GLint inWeights, GLint inInfluences, bool inCpuSkinned)
+{
+	if (mPackedBuffer != 0)
+	{
+		// CPU skinned positions & normals are still written as floats
+		if (inCpuSkinned)
+		{
+			BindAttribute(inPosition, mBuffers[BufferSkinnedPosition], 3, sizeof(vec3), false);
+			BindAttribute(inNormal, mBuffers[BufferSkinnedNormal], 3, sizeof(vec3), false);
+		}
+		else
+		{
+			BindPacked(inPosition, offsetof(MeshFormat::Vertex, position), 3, GL_FLOAT, false, false);
+			// vec3 in the shader, the 2 bit w is dropped
+			BindPacked(inNormal, offsetof(MeshFormat::Vertex, normal), 4, GL_INT_2_10_10_10_REV, true, false);
+		}
+		BindPacked(inTexCoord, offsetof(MeshFormat::Vertex, texCoord), 2, GL_HALF_FLOAT, false, false);
+		BindPacked(inWeights, offsetof(MeshFormat::Vertex, weights), 4, GL_UNSIGNED_BYTE, true, false);
+		BindPacked(inInfluences, offsetof(MeshFormat::Vertex, joints), 4, GL_UNSIGNED_BYTE, false, true);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+		return;
+	}
+	// vec3 is padded to 16 bytes, so the position & normal strides are sizeof(vec3) rather than 3 floats
+	BindAttribute(inPosition, mBuffers[inCpuSkinned ? BufferSkinnedPosition : BufferPosition], 3, sizeof(vec3), false);
+	BindAttribute(inNormal, mBuffers[inCpuSkinned ? BufferSkinnedNormal : BufferNormal], 3, sizeof(vec3), false);
+	BindAttribute(inTexCoord, mBuffers[BufferTexCoord], 2, sizeof(vec2), false);
+	BindAttribute(inWeights, mBuffers[BufferWeights], 4, sizeof(vec4), false);
+	BindAttribute(inInfluences, mBuffers[BufferInfluences], 4, sizeof(ivec4), true);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+}
+
+void Mesh::Draw()
+{
+	if (GetIndexCount() > 0) { glDrawElements(GL_TRIANGLES, (GLsizei)GetIndexCount(), GL_UNSIGNED_INT, 0); }
+	else { glDrawArrays(GL_TRIANGLES, 0, (GLsizei)GetVertexCount()); }
+}
+
+void Mesh::DrawInstanced(unsigned int inInstanceCount)
+{
+	if (GetIndexCount() > 0) { glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)GetIndexCount(), GL_UNSIGNED_INT, 0, (GLsizei)inInstanceCount); }
+	else { glDrawArraysInstanced(GL_TRIANGLES, 0, (GLsizei)GetVertexCount(), (GLsizei)inInstanceCount); }
+}
+
+void Mesh::MultiDraw(const GLsizei* inCounts, const void* const* inIndexOffsets, const GLint* inBaseVertices, unsigned int inDrawCount)
+{
+	if (GetIndexCount() == 0 || inDrawCount == 0) { return; }
+	if (inDrawCount == 1) { glDrawElementsBaseVertex(GL_TRIANGLES, inCounts[0], GL_UNSIGNED_INT, inIndexOffsets[0], inBaseVertices[0]); }
+	else { glMultiDrawElementsBaseVertex(GL_TRIANGLES, inCounts, GL_UNSIGNED_INT, inIndexOffsets, (GLsizei)inDrawCount, inBaseVertices); }
+}
+
+void Mesh::UnBind(GLint inPosition, GLint inNormal, GLint inTexCoord, GLint inWeights, GLint inInfluences)
+{
+	GLint slots[5] = { inPosition, inNormal, inTexCoord, inWeights, inInfluences };
+	for (unsigned int i = 0; i < 5; ++i)
+	{
+		if (slots[i] >= 0) { glDisableVertexAttribArray((GLuint)slots[i]); }
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef _H_MESH_
+#define _H_MESH_
+
+#include "include/glad/glad.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "Skinning.h"
+#include <vector>
+
+struct dualquat;
+namespace MeshFormat { struct Vertex; }
+
+/**
+* Mesh keeps its vertex data on the CPU & mirrors it into one vertex buffer per attribute
+* Skinned meshes carry 4 joint influences & weights per vertex, they can be deformed either in the vertex shader
+* (see Skinning.h) or on the CPU with CpuSkin(), which writes into a second pair of position / normal buffers
+* so the bind pose buffers stay untouched & the skinning path can be switched at runtime
+* Every mesh also records its SkinningMethod, whoever builds its palette & shader reads it from here
+* The sample uses one global VAO, so Bind() points the attribute slots at this mesh's buffers before each batch of draws
+* UploadPacked() replaces the float streams with one interleaved buffer of 28 byte vertices (see PackedMesh.h), Bind() reads
+* from that instead. The CPU arrays can stay (CPU skinning still needs them) or be empty when the mesh came from a packed file
+*/
+class Mesh
+{
+private:
+	enum Buffer
+	{
+		BufferPosition = 0,
+		BufferNormal,
+		BufferTexCoord,
+		BufferWeights,
+		BufferInfluences,
+		BufferSkinnedPosition,
+		BufferSkinnedNormal,
+		BufferCount
+	};
+	std::vector<vec3> mPositions;
+	std::vector<vec3> mNormals;
+	std::vector<vec2> mTexCoords;
+	std::vector<vec4> mWeights;
+	std::vector<ivec4> mInfluences;
+	std::vector<unsigned int> mIndices;
+	std::vector<vec3> mSkinnedPositions;
+	std::vector<vec3> mSkinnedNormals;
+	GLuint mBuffers[BufferCount];
+	GLuint mIndexBuffer;
+	GLuint mPackedBuffer;
+	unsigned int mPackedVertexCount;
+	unsigned int mPackedIndexCount;
+	SkinningMethod mSkinningMethod;
+private:
+	Mesh(const Mesh&);
+	Mesh& operator=(const Mesh&);
+	static void BindAttribute(GLint inSlot, GLuint inBuffer, GLint inComponents, GLsizei inStride, bool inInteger);
+	void BindPacked(GLint inSlot, size_t inOffset, GLint inComponents, GLenum inType, bool inNormalized, bool inInteger);
+	void CreateBuffers();
+	// CpuSkin() helpers, the first one sizes the skinned arrays & fails if the mesh has no skinning data
+	bool PrepareCpuSkin();
+	void UploadSkinned();
+public:
+	Mesh();
+	~Mesh();
+
+	// Edit these & call UpdateOpenGLBuffers() to upload the changes
+	std::vector<vec3>& GetPositions();
+	std::vector<vec3>& GetNormals();
+	std::vector<vec2>& GetTexCoords();
+	std::vector<vec4>& GetWeights();
+	std::vector<ivec4>& GetInfluences();
+	std::vector<unsigned int>& GetIndices();
+	// The packed counts when the mesh has no CPU arrays
+	unsigned int GetVertexCount() const;
+	unsigned int GetIndexCount() const;
+
+	// Creates the buffers on the first call, attributes that are empty are skipped
+	void UpdateOpenGLBuffers();
+	// inIndices may be 0 (with inIndexCount 0), from now on Bind() reads the packed vertices
+	void UploadPacked(const MeshFormat::Vertex* inVertices, unsigned int inVertexCount, const unsigned int* inIndices, unsigned int inIndexCount);
+	bool IsPacked() const;
+	void Release();
+
+	/**
+	* Deforms the bind pose with inPalette (one skin matrix per joint, world * inverse bind) & uploads the result
+	* into the skinned position / normal buffers, Bind() with inCpuSkinned reads from those
+	*/
+	void CpuSkin(const mat4* inPalette);
+	void CpuSkin(const dualquat* inPalette);
+
+	// Starts out as gDefaultSkinningMethod
+	void SetSkinningMethod(SkinningMethod inMethod);
+	SkinningMethod GetSkinningMethod() const;
+
+	// A slot of -1 leaves that attribute disabled
+	void Bind(GLint inPosition, GLint inNormal, GLint inTexCoord, GLint inWeights, GLint inInfluences, bool inCpuSkinned = false);
+	void Draw();
+	void DrawInstanced(unsigned int inInstanceCount);
+	/**
+	* Draws inDrawCount index ranges with a single glMultiDrawElementsBaseVertex, inIndexOffsets are byte offsets into
+	* the index buffer (first index * sizeof(unsigned int)). Only for meshes with indices, see RenderQueue.h
+	*/
+	void MultiDraw(const GLsizei* inCounts, const void* const* inIndexOffsets, const GLint* inBaseVertices, unsigned int inDrawCount);
+	void UnBind(GLint inPosition, GLint inNormal, GLint inTexCoord, GLint inWeights, GLint inInfluences);
+};
+
+#endif
@@ -0,0 +1,412 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "PackedMesh.h"
+#include "Mesh.h"
+#include "MappedFile.h"
+#include "vec2.h"
+#include "vec3.h"
+#include "vec4.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace MeshFormat;
+
+// Simulated LRU cache of OptimizeVertexCache(), larger than any real post transform cache so the order works well on all of them
+static const unsigned int kCacheSize = 32;
+
+static float Clamp(float inValue, float inMin, float inMax)
+{
+	return inValue < inMin ? inMin : (inValue > inMax ? inMax : inValue);
+}
+
+unsigned int PackNormal(const vec3& inNormal)
+{
+	int x = (int)floorf(Clamp(inNormal.x, -1.0f, 1.0f) * 511.0f + 0.5f);
+	int y = (int)floorf(Clamp(inNormal.y, -1.0f, 1.0f) * 511.0f + 0.5f);
+	int z = (int)floorf(Clamp(inNormal.z, -1.0f, 1.0f) * 511.0f + 0.5f);
+	return ((unsigned int)x & 0x3FF) | (((unsigned int)y & 0x3FF) << 10) | (((unsigned int)z & 0x3FF) << 20);
+}
+
+vec3 UnpackNormal(unsigned int inPacked)
+{
+	// Shifting the 10 bits to the top & back sign extends them
+	int x = (int)(inPacked << 22) >> 22;
+	int y = (int)(inPacked << 12) >> 22;
+	int z = (int)(inPacked << 2) >> 22;
+	return vec3(Clamp((float)x / 511.0f, -1.0f, 1.0f), Clamp((float)y / 511.0f, -1.0f, 1.0f), Clamp((float)z / 511.0f, -1.0f, 1.0f));
+}
+
+unsigned short FloatToHalf(float inValue)
+{
+	unsigned int bits = 0;
+	memcpy(&bits, &inValue, sizeof(float));
+	unsigned int sign = (bits >> 16) & 0x8000;
+	unsigned int mantissa = bits & 0x7FFFFF;
+	if (((bits >> 23) & 0xFF) == 0xFF) { return (unsigned short)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0)); }
+
+	int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	if (exponent >= 31) { return (unsigned short)(sign | 0x7C00); }
+	if (exponent <= 0)
+	{
+		// Too small for a normal half, either a denormal or zero
+		if (exponent < -10) { return (unsigned short)sign; }
+		mantissa |= 0x800000;
+		unsigned int shift = (unsigned int)(14 - exponent);
+		unsigned int half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1) { ++half; }
+		return (unsigned short)(sign | half);
+	}
+	unsigned int half = sign | ((unsigned int)exponent << 10) | (mantissa >> 13);
+	// Rounding up can carry into the exponent, which is still the right result
+	if (mantissa & 0x1000) { ++half; }
+	return (unsigned short)half;
+}
+
+float HalfToFloat(unsigned short inValue)
+{
+	unsigned int sign = ((unsigned int)inValue & 0x8000) << 16;
+	unsigned int exponent = ((unsigned int)inValue >> 10) & 0x1F;
+	unsigned int mantissa = (unsigned int)inValue & 0x3FF;
+	if (exponent == 0)
+	{
+		float value = ldexpf((float)mantissa, -24);
+		return sign != 0 ? -value : value;
+	}
+	unsigned int bits = sign | (exponent == 31 ? 0x7F800000 | (mantissa << 13) : ((exponent + 112) << 23) | (mantissa << 13));
+	float result = 0.0f;
+	memcpy(&result, &bits, sizeof(float));
+	return result;
+}
+
+void PackWeights(const vec4& inWeights, unsigned char* outWeights)
+{
+	float sum = inWeights.x + inWeights.y + inWeights.z + inWeights.w;
+	float scale = sum > 0.0f ? 255.0f / sum : 0.0f;
+	int total = 0;
+	unsigned int largest = 0;
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		int weight = (int)floorf(Clamp(inWeights.v[i] * scale, 0.0f, 255.0f) + 0.5f);
+		outWeights[i] = (unsigned char)weight;
+		total += weight;
+		if (outWeights[i] > outWeights[largest]) { largest = i; }
+	}
+	if (sum > 0.0f) { outWeights[largest] = (unsigned char)(outWeights[largest] + 255 - total); }
+}
+
+static float GetVertexScore(int inCachePosition, unsigned int inValence)
+{
+	// No triangles left to emit, the vertex doesn't matter any more
+	if (inValence == 0) { return -1.0f; }
+	float score = 0.0f;
+	if (inCachePosition >= 0)
+	{
+		// The last triangle's vertices get a fixed score, otherwise the next triangle would keep reusing exactly those
+		if (inCachePosition < 3) { score = 0.75f; }
+		else { score = powf(1.0f - (float)(inCachePosition - 3) / (float)(kCacheSize - 3), 1.5f); }
+	}
+	// Vertices with few triangles left are finished first, so they don't get stranded & have to be fetched again later
+	return score + 2.0f * powf((float)inValence, -0.5f);
+}
+
+void OptimizeVertexCache(unsigned int* ioIndices, unsigned int inIndexCount, unsigned int inVertexCount)
+{
+	unsigned int triangleCount = inIndexCount / 3;
+	if (triangleCount == 0 || inVertexCount == 0) { return; }
+	for (unsigned int i = 0; i < triangleCount * 3; ++i)
+	{
+		if (ioIndices[i] >= inVertexCount)
+		{
+			std::cout << "OptimizeVertexCache: index " << ioIndices[i] << " is out of range\n";
+			return;
+		}
+	}
+
+	// The triangles of every vertex, the first valence entries of each list are the ones that weren't emitted yet
+	std::vector<unsigned int> valence(inVertexCount, 0);
+	for (unsigned int i = 0; i < triangleCount * 3; ++i) { ++valence[ioIndices[i]]; }
+	std::vector<unsigned int> offsets(inVertexCount + 1, 0);
+	for (unsigned int v = 0; v < inVertexCount; ++v) { offsets[v + 1] = offsets[v] + valence[v]; }
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (unsigned int t = 0; t < triangleCount; ++t)
+	{
+		for (unsigned int k = 0; k < 3; ++k) { adjacency[fill[ioIndices[t * 3 + k]]++] = t; }
+	}
+
+	std::vector<int> cachePosition(inVertexCount, -1);
+	std::vector<float> vertexScore(inVertexCount);
+	for (unsigned int v = 0; v < inVertexCount; ++v) { vertexScore[v] = GetVertexScore(-1, valence[v]); }
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<unsigned char> emitted(triangleCount, 0);
+	int best = 0;
+	for (unsigned int t = 0; t < triangleCount; ++t)
+	{
+		const unsigned int* triangle = ioIndices + t * 3;
+		triangleScore[t] = vertexScore[triangle[0]] + vertexScore[triangle[1]] + vertexScore[triangle[2]];
+		if (triangleScore[t] > triangleScore[best]) { best = (int)t; }
+	}
+
+	std::vector<unsigned int> output(triangleCount * 3);
+	unsigned int cache[kCacheSize + 3];
+	unsigned int cacheCount = 0;
+	unsigned int cursor = 0;
+	for (unsigned int o = 0; o < triangleCount; ++o)
+	{
+		// Nothing in the cache has triangles left, carry on with the next one in the original order
+		if (best < 0)
+		{
+			while (emitted[cursor]) { ++cursor; }
+			best = (int)cursor;
+		}
+		const unsigned int* triangle = ioIndices + best * 3;
+		unsigned int newCache[kCacheSize + 3];
+		unsigned int newCount = 0;
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			unsigned int vertex = triangle[k];
+			output[o * 3 + k] = vertex;
+			newCache[newCount++] = vertex;
+			// Swap the triangle with the last one that's still left in the vertex's list
+			unsigned int* list = &adjacency[offsets[vertex]];
+			unsigned int last = --valence[vertex];
+			for (unsigned int i = 0; i < last; ++i)
+			{
+				if (list[i] == (unsigned int)best)
+				{
+					list[i] = list[last];
+					list[last] = (unsigned int)best;
+					break;
+				}
+			}
+		}
+		emitted[best] = 1;
+
+		// The triangle's vertices move to the front, everything pushed past kCacheSize falls out
+		for (unsigned int c = 0; c < cacheCount; ++c)
+		{
+			unsigned int vertex = cache[c];
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) { newCache[newCount++] = vertex; }
+		}
+		for (unsigned int c = 0; c < newCount; ++c)
+		{
+			unsigned int vertex = newCache[c];
+			cachePosition[vertex] = (c < kCacheSize) ? (int)c : -1;
+			vertexScore[vertex] = GetVertexScore(cachePosition[vertex], valence[vertex]);
+		}
+		cacheCount = newCount < kCacheSize ? newCount : kCacheSize;
+		memcpy(cache, newCache, sizeof(unsigned int) * cacheCount);
+
+		// Only the triangles of vertices whose score changed can change, the best next triangle is one of them
+		best = -1;
+		float bestScore = -1.0f;
+		for (unsigned int c = 0; c < newCount; ++c)
+		{
+			unsigned int vertex = newCache[c];
+			const unsigned int* list = &adjacency[offsets[vertex]];
+			for (unsigned int i = 0; i < valence[vertex]; ++i)
+			{
+				unsigned int t = list[i];
+				const unsigned int* other = ioIndices + t * 3;
+				triangleScore[t] = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					best = (int)t;
+				}
+			}
+		}
+	}
+	memcpy(ioIndices, &output[0], sizeof(unsigned int) * triangleCount * 3);
+}
+
+unsigned int OptimizeVertexFetch(unsigned int* ioIndices, unsigned int inIndexCount, unsigned int inVertexCount, unsigned int* outRemap)
+{
+	const unsigned int unused = ~0u;
+	for (unsigned int v = 0; v < inVertexCount; ++v) { outRemap[v] = unused; }
+	unsigned int next = 0;
+	for (unsigned int i = 0; i < inIndexCount; ++i)
+	{
+		unsigned int vertex = ioIndices[i];
+		if (vertex >= inVertexCount) { continue; }
+		if (outRemap[vertex] == unused) { outRemap[vertex] = next++; }
+		ioIndices[i] = outRemap[vertex];
+	}
+	unsigned int used = next;
+	for (unsigned int v = 0; v < inVertexCount; ++v)
+	{
+		if (outRemap[v] == unused) { outRemap[v] = next++; }
+	}
+	return used;
+}
+
+float GetACMR(const unsigned int* inIndices, unsigned int inIndexCount, unsigned int inCacheSize)
+{
+	unsigned int triangleCount = inIndexCount / 3;
+	if (triangleCount == 0 || inCacheSize == 0) { return 0.0f; }
+	std::vector<unsigned int> fifo(inCacheSize, ~0u);
+	unsigned int head = 0;
+	unsigned int misses = 0;
+	for (unsigned int i = 0; i < triangleCount * 3; ++i)
+	{
+		bool hit = false;
+		for (unsigned int c = 0; c < inCacheSize && !hit; ++c) { hit = fifo[c] == inIndices[i]; }
+		if (hit) { continue; }
+		fifo[head] = inIndices[i];
+		head = (head + 1) % inCacheSize;
+		++misses;
+	}
+	return (float)misses / (float)triangleCount;
+}
+
+template<typename T>
+static void RemapVertices(std::vector<T>& ioArray, const std::vector<unsigned int>& inRemap)
+{
+	// Attributes the mesh doesn't have are empty
+	if (ioArray.size() != inRemap.size()) { return; }
+	std::vector<T> remapped(ioArray.size());
+	for (size_t i = 0; i < ioArray.size(); ++i) { remapped[inRemap[i]] = ioArray[i]; }
+	ioArray.swap(remapped);
+}
+
+void OptimizeMesh(Mesh& ioMesh)
+{
+	std::vector<unsigned int>& indices = ioMesh.GetIndices();
+	unsigned int vertexCount = (unsigned int)ioMesh.GetPositions().size();
+	if (indices.size() < 3 || vertexCount == 0) { return; }
+
+	float before = GetACMR(&indices[0], (unsigned int)indices.size());
+	OptimizeVertexCache(&indices[0], (unsigned int)indices.size(), vertexCount);
+	std::vector<unsigned int> remap(vertexCount);
+	OptimizeVertexFetch(&indices[0], (unsigned int)indices.size(), vertexCount, &remap[0]);
+	RemapVertices(ioMesh.GetPositions(), remap);
+	RemapVertices(ioMesh.GetNormals(), remap);
+	RemapVertices(ioMesh.GetTexCoords(), remap);
+	RemapVertices(ioMesh.GetWeights(), remap);
+	RemapVertices(ioMesh.GetInfluences(), remap);
+	std::cout << "OptimizeMesh: " << indices.size() / 3 << " triangles, ACMR " << before << " -> " << GetACMR(&indices[0], (unsigned int)indices.size()) << "\n";
+}
+
+static unsigned int AlignOffset(size_t inOffset)
+{
+	return (unsigned int)((inOffset + 15) & ~(size_t)15);
+}
+
+bool PackMesh(Mesh& inMesh, std::vector<unsigned char>& outData)
+{
+	std::vector<vec3>& positions = inMesh.GetPositions();
+	std::vector<vec3>& normals = inMesh.GetNormals();
+	std::vector<vec2>& texCoords = inMesh.GetTexCoords();
+	std::vector<vec4>& weights = inMesh.GetWeights();
+	std::vector<ivec4>& influences = inMesh.GetInfluences();
+	std::vector<unsigned int>& indices = inMesh.GetIndices();
+	unsigned int vertexCount = (unsigned int)positions.size();
+	if (vertexCount == 0)
+	{
+		std::cout << "PackMesh: the mesh has no vertices\n";
+		return false;
+	}
+
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	header.magic = kMagic;
+	header.version = kVersion;
+	if (normals.size() == vertexCount) { header.flags |= FlagNormals; }
+	if (texCoords.size() == vertexCount) { header.flags |= FlagTexCoords; }
+	if (weights.size() == vertexCount && influences.size() == vertexCount) { header.flags |= FlagSkinned; }
+	header.vertexCount = vertexCount;
+	header.indexCount = (unsigned int)indices.size();
+	header.verticesOffset = AlignOffset(sizeof(Header));
+	header.indicesOffset = AlignOffset(header.verticesOffset + sizeof(Vertex) * (size_t)vertexCount);
+	outData.assign(header.indicesOffset + sizeof(unsigned int) * indices.size(), 0);
+
+	Vertex* vertices = (Vertex*)&outData[header.verticesOffset];
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		header.boundsMin[i] = positions[0].v[i];
+		header.boundsMax[i] = positions[0].v[i];
+	}
+	for (unsigned int v = 0; v < vertexCount; ++v)
+	{
+		Vertex& vertex = vertices[v];
+		for (unsigned int i = 0; i < 3; ++i)
+		{
+			vertex.position[i] = positions[v].v[i];
+			if (positions[v].v[i] < header.boundsMin[i]) { header.boundsMin[i] = positions[v].v[i]; }
+			if (positions[v].v[i] > header.boundsMax[i]) { header.boundsMax[i] = positions[v].v[i]; }
+		}
+		if (header.flags & FlagNormals) { vertex.normal = PackNormal(normals[v]); }
+		if (header.flags & FlagTexCoords)
+		{
+			vertex.texCoord[0] = FloatToHalf(texCoords[v].x);
+			vertex.texCoord[1] = FloatToHalf(texCoords[v].y);
+		}
+		if (header.flags & FlagSkinned)
+		{
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				if (influences[v].v[i] < 0 || influences[v].v[i] > 255)
+				{
+					std::cout << "PackMesh: joint " << influences[v].v[i] << " doesn't fit in a byte\n";
+					outData.clear();
+					return false;
+				}
+				vertex.joints[i] = (unsigned char)influences[v].v[i];
+			}
+			PackWeights(weights[v], vertex.weights);
+		}
+	}
+	memcpy(&outData[0], &header, sizeof(Header));
+	if (!indices.empty()) { memcpy(&outData[header.indicesOffset], &indices[0], sizeof(unsigned int) * indices.size()); }
+	return true;
+}
+
+bool WritePackedMesh(Mesh& inMesh, const char* inPath)
+{
+	std::vector<unsigned char> data;
+	if (!PackMesh(inMesh, data)) { return false; }
+
+	FILE* file = fopen(inPath, "wb");
+	if (file == 0)
+	{
+		std::cout << "Couldn't write packed mesh " << inPath << "\n";
+		return false;
+	}
+	bool result = fwrite(&data[0], 1, data.size(), file) == data.size();
+	fclose(file);
+	return result;
+}
+
+bool UploadPackedMesh(const void* inData, size_t inSize, Mesh& outMesh)
+{
+	const unsigned char* data = (const unsigned char*)inData;
+	if (data == 0 || inSize < sizeof(Header)) { return false; }
+	const Header* header = (const Header*)data;
+	if (header->magic != kMagic || header->version != kVersion || header->vertexCount == 0) { return false; }
+	// Both sections have to be inside the data
+	size_t verticesEnd = (size_t)header->verticesOffset + sizeof(Vertex) * (size_t)header->vertexCount;
+	size_t indicesEnd = (size_t)header->indicesOffset + sizeof(unsigned int) * (size_t)header->indexCount;
+	if (verticesEnd > inSize || indicesEnd > inSize) { return false; }
+
+	const unsigned int* indices = (const unsigned int*)(data + header->indicesOffset);
+	for (unsigned int i = 0; i < header->indexCount; ++i)
+	{
+		if (indices[i] >= header->vertexCount) { return false; }
+	}
+	outMesh.UploadPacked((const Vertex*)(data + header->verticesOffset), header->vertexCount, header->indexCount > 0 ? indices : 0, header->indexCount);
+	return true;
+}
+
+bool LoadPackedMesh(const char* inPath, Mesh& outMesh)
+{
+	// glBufferData copies the vertices, the mapping isn't needed once the upload returned
+	MappedFile file;
+	if (!file.Open(inPath)) { return false; }
+	if (!UploadPackedMesh(file.GetData(), file.GetSize(), outMesh))
+	{
+		std::cout << inPath << " isn't a valid packed mesh\n";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#ifndef _H_PACKEDMESH_
+#define _H_PACKEDMESH_
+
+#include <cstddef>
+#include <vector>
+
+struct vec3;
+struct vec4;
+class Mesh;
+
+/**
+* Binary mesh format, the vertices are stored exactly the way the GPU reads them, so loading is one glBufferData per buffer
+* straight from the mapped file
+* Every vertex is interleaved into 28 bytes (the float streams of Mesh take 72, vec3 is padded to 16 bytes):
+* - position as 3 floats
+* - normal as GL_INT_2_10_10_10_REV, signed normalized, the 2 bit w is 0
+* - texture coordinates as half floats
+* - 4 joint indices as unsigned bytes (so at most 256 joints) & 4 weights as unsigned normalized bytes that sum to exactly 255
+* Indices stay 32 bit, the RenderQueue & Mesh::MultiDraw() assume unsigned int indices
+* All values are little endian
+*/
+namespace MeshFormat
+{
+	const unsigned int kMagic = 0x48534D41; // "AMSH"
+	const unsigned int kVersion = 1;
+
+	enum Flags
+	{
+		FlagNormals = 1,
+		FlagTexCoords = 2,
+		FlagSkinned = 4
+	};
+
+	struct Vertex
+	{
+		float position[3];
+		unsigned int normal;
+		unsigned short texCoord[2];
+		unsigned char joints[4];
+		unsigned char weights[4];
+	};
+
+	struct Header
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int flags;
+		unsigned int vertexCount;
+		unsigned int indexCount;
+		unsigned int verticesOffset; // Byte offsets from the start of the file, 16 byte aligned
+		unsigned int indicesOffset;
+		unsigned int reserved;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+}
+
+// Quantization helpers, the unpack functions are what the GPU does with the packed values
+unsigned int PackNormal(const vec3& inNormal);
+vec3 UnpackNormal(unsigned int inPacked);
+unsigned short FloatToHalf(float inValue);
+float HalfToFloat(unsigned short inValue);
+// The weights are normalized first, rounding is corrected on the largest one so the bytes always add up to 255
+void PackWeights(const vec4& inWeights, unsigned char* outWeights);
+
+/**
+* Reorders the triangles for the post transform vertex cache with Tom Forsyth's linear speed algorithm:
+* every vertex is scored by its position in a simulated LRU cache & by how many triangles still use it,
+* the triangle with the best score is emitted next
+*/
+void OptimizeVertexCache(unsigned int* ioIndices, unsigned int inIndexCount, unsigned int inVertexCount);
+/**
+* Renumbers the vertices in the order the (cache optimized) indices first use them, so vertex fetches walk the buffer forwards
+* outRemap[old] is the new index of every vertex, vertices no triangle uses go to the end. Returns the number of used vertices
+*/
+unsigned int OptimizeVertexFetch(unsigned int* ioIndices, unsigned int inIndexCount, unsigned int inVertexCount, unsigned int* outRemap);
+// Average cache miss ratio (transformed vertices per triangle) with a FIFO cache of inCacheSize entries, 0.5 - 3
+float GetACMR(const unsigned int* inIndices, unsigned int inIndexCount, unsigned int inCacheSize = 16);
+
+// Both of the above on a mesh's CPU arrays, the GPU buffers have to be updated afterwards. Prints the ACMR before & after
+void OptimizeMesh(Mesh& ioMesh);
+
+// Builds the binary image of the mesh's CPU arrays, returns false (with a message) if a joint index doesn't fit in a byte
+bool PackMesh(Mesh& inMesh, std::vector<unsigned char>& outData);
+bool WritePackedMesh(Mesh& inMesh, const char* inPath);
+// Maps inPath & uploads its buffers with Mesh::UploadPacked(), the mesh has no CPU copy of the vertices afterwards
+bool LoadPackedMesh(const char* inPath, Mesh& outMesh);
+// Validates an image made by PackMesh() (or a mapped file) & uploads it
+bool UploadPackedMesh(const void* inData, size_t inSize, Mesh& outMesh);
+
+#endif
@@ -0,0 +1,351 @@
+#include "Pose.h"
+#include "Arena.h"
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Every array starts on a 16 byte boundary, vec3 & quat are already multiples of 16 so only the parents need padding
+static size_t GetPoseBlockSize(unsigned int inJointCount)
+{
+	size_t parents = ((sizeof(int) * inJointCount) + 15) & ~(size_t)15;
+	return (sizeof(vec3) * 2 + sizeof(quat)) * inJointCount + parents;
+}
+
+Pose::Pose()
+{
+	mMemory = 0;
+	mJointCount = 0;
+	mPositions = 0;
+	mRotations = 0;
+	mScales = 0;
+	mParents = 0;
+}
+
+Pose::Pose(unsigned int inJointCount)
+{
+	mMemory = 0;
+	mJointCount = 0;
+	Allocate(inJointCount, 0);
+}
+
+Pose::Pose(unsigned int inJointCount, LinearArena& inArena)
+{
+	mMemory = 0;
+	mJointCount = 0;
+	Allocate(inJointCount, &inArena);
+}
+
+Pose::Pose(const Pose& inOther)
+{
+	mMemory = 0;
+	mJointCount = 0;
+	Allocate(inOther.mJointCount, 0);
+	CopyFrom(inOther);
+}
+
+Pose& Pose::operator=(const Pose& inOther)
+{
+	if (this == &inOther) { return *this; }
+	if (mJointCount != inOther.mJointCount)
+	{
+		if (mMemory == 0 && mPositions != 0)
+		{
+			std::cout << "Can't resize an arena backed pose from " << mJointCount << " to " << inOther.mJointCount << " joints\n";
+			return *this;
+		}
+		Release();
+		Allocate(inOther.mJointCount, 0);
+	}
+	CopyFrom(inOther);
+	return *this;
+}
+
+Pose::Pose(Pose&& inOther)
+{
+	mMemory = inOther.mMemory;
+	mJointCount = inOther.mJointCount;
+	mPositions = inOther.mPositions;
+	mRotations = inOther.mRotations;
+	mScales = inOther.mScales;
+	mParents = inOther.mParents;
+	// Release() on the source must not free the block it no longer owns
+	inOther.mMemory = 0;
+	inOther.Release();
+}
+
+Pose& Pose::operator=(Pose&& inOther)
+{
+	if (this == &inOther) { return *this; }
+	Release();
+	mMemory = inOther.mMemory;
+	mJointCount = inOther.mJointCount;
+	mPositions = inOther.mPositions;
+	mRotations = inOther.mRotations;
+	mScales = inOther.mScales;
+	mParents = inOther.mParents;
+	inOther.mMemory = 0;
+	inOther.Release();
+	return *this;
+}
+
+Pose::~Pose()
+{
+	Release();
+}
+
+void Pose::Allocate(unsigned int inJointCount, LinearArena* inArena)
+{
+	mJointCount = 0;
+	mPositions = 0;
+	mRotations = 0;
+	mScales = 0;
+	mParents = 0;
+	if (inJointCount == 0) { return; }
+
+	size_t size = GetPoseBlockSize(inJointCount);
+	unsigned char* block = 0;
+	if (inArena != 0)
+	{
+		block = (unsigned char*)inArena->Allocate(size, 16);
+		if (block == 0) { return; }
+	}
+	else
+	{
+		mMemory = new unsigned char[size + 15];
+		block = (unsigned char*)(((size_t)mMemory + 15) & ~(size_t)15);
+	}
+
+	mJointCount = inJointCount;
+	mPositions = (vec3*)block;
+	mRotations = (quat*)(block + sizeof(vec3) * inJointCount);
+	mScales = (vec3*)(block + (sizeof(vec3) + sizeof(quat)) * inJointCount);
+	mParents = (int*)(block + (sizeof(vec3) * 2 + sizeof(quat)) * inJointCount);
+	for (unsigned int i = 0; i < inJointCount; ++i)
+	{
+		mPositions[i] = vec3(0, 0, 0);
+		mRotations[i] = quat();
+		mScales[i] = vec3(1, 1, 1);
+		mParents[i] = -1;
+	}
+}
+
+void Pose::Release()
+{
+	if (mMemory != 0) { delete[] mMemory; }
+	mMemory = 0;
+	mJointCount = 0;
+	mPositions = 0;
+	mRotations = 0;
+	mScales = 0;
+	mParents = 0;
+}
+
+void Pose::Resize(unsigned int inJointCount)
+{
+	if (mMemory == 0 && mPositions != 0)
+	{
+		std::cout << "Can't resize an arena backed pose\n";
+		return;
+	}
+	Release();
+	Allocate(inJointCount, 0);
+}
+
+unsigned int Pose::Size() const
+{
+	return mJointCount;
+}
+
+bool Pose::IsValid() const
+{
+	return mPositions != 0;
+}
+
+bool Pose::SetParent(unsigned int inJoint, int inParent)
+{
+	if (inJoint >= mJointCount) { return false; }
+	if (inParent >= (int)inJoint || inParent < -1)
+	{
+		std::cout << "Joint " << inJoint << " can't have parent " << inParent << ", parents must come before their children\n";
+		return false;
+	}
+	mParents[inJoint] = inParent;
+	return true;
+}
+
+int Pose::GetParent(unsigned int inJoint) const
+{
+	return mParents[inJoint];
+}
+
+void Pose::SetLocal(unsigned int inJoint, const vec3& inPosition, const quat& inRotation, const vec3& inScale)
+{
+	mPositions[inJoint] = inPosition;
+	mRotations[inJoint] = inRotation;
+	mScales[inJoint] = inScale;
+}
+
+vec3* Pose::GetPositions()
+{
+	return mPositions;
+}
+
+quat* Pose::GetRotations()
+{
+	return mRotations;
+}
+
+vec3* Pose::GetScales()
+{
+	return mScales;
+}
+
+const vec3* Pose::GetPositions() const
+{
+	return mPositions;
+}
+
+const quat* Pose::GetRotations() const
+{
+	return mRotations;
+}
+
+const vec3* Pose::GetScales() const
+{
+	return mScales;
+}
+
+const int* Pose::GetParents() const
+{
+	return mParents;
+}
+
+void Pose::CopyFrom(const Pose& inOther)
+{
+	if (inOther.mJointCount < mJointCount)
+	{
+		std::cout << "Pose::CopyFrom() needs a pose with at least " << mJointCount << " joints, got " << inOther.mJointCount << "\n";
+		return;
+	}
+	if (mJointCount == 0 || this == &inOther) { return; }
+	// One copy per array, views (see MakeView()) don't have their arrays back to back
+	memcpy(mPositions, inOther.mPositions, sizeof(vec3) * mJointCount);
+	memcpy(mRotations, inOther.mRotations, sizeof(quat) * mJointCount);
+	memcpy(mScales, inOther.mScales, sizeof(vec3) * mJointCount);
+	memcpy(mParents, inOther.mParents, sizeof(int) * mJointCount);
+}
+
+Pose Pose::MakeView(unsigned int inJointCount)
+{
+	Pose view;
+	if (inJointCount > mJointCount) { inJointCount = mJointCount; }
+	view.mJointCount = inJointCount;
+	view.mPositions = mPositions;
+	view.mRotations = mRotations;
+	view.mScales = mScales;
+	view.mParents = mParents;
+	return view;
+}
+
+// Rotation matrix straight from the quaternion, scaled per column, no branches so loops over it stay tight
+static inline mat4 ComposeLocal(const vec3& t, const quat& q, const vec3& s)
+{
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	return mat4(
+		(1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f,
+		2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f,
+		2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f,
+		t.x, t.y, t.z, 1.0f);
+}
+
+void Pose::GetLocalMatrices(mat4* outMatrices) const
+{
+	for (unsigned int i = 0; i < mJointCount; ++i)
+	{
+		outMatrices[i] = ComposeLocal(mPositions[i], mRotations[i], mScales[i]);
+	}
+}
+
+void Pose::GetLocalMatrices(unsigned int inFirst, unsigned int inCount, mat4* outMatrices) const
+{
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		unsigned int joint = inFirst + i;
+		outMatrices[i] = ComposeLocal(mPositions[joint], mRotations[joint], mScales[joint]);
+	}
+}
+
+void Pose::GetGlobalMatrices(mat4* outMatrices) const
+{
+	GetLocalMatrices(outMatrices);
+	// Parents come first, so by the time a joint is reached its parent already holds the world matrix
+	for (unsigned int i = 0; i < mJointCount; ++i)
+	{
+		int parent = mParents[i];
+		if (parent >= 0) { outMatrices[i] = outMatrices[parent] * outMatrices[i]; }
+	}
+}
+
+mat4 Pose::GetGlobalMatrix(unsigned int inJoint) const
+{
+	mat4 result = ComposeLocal(mPositions[inJoint], mRotations[inJoint], mScales[inJoint]);
+	for (int joint = mParents[inJoint]; joint >= 0; joint = mParents[joint])
+	{
+		result = ComposeLocal(mPositions[joint], mRotations[joint], mScales[joint]) * result;
+	}
+	return result;
+}
+
+void Pose::GetSkinMatrices(const mat4* inInverseBindPose, mat4* outPalette) const
+{
+	GetGlobalMatrices(outPalette);
+	// Every product only reads its own entry before writing it, so the multiply can run in place
+	MultiplyArray(outPalette, inInverseBindPose, outPalette, mJointCount);
+}
+
+void BlendPoses(const Pose& inA, const Pose& inB, float inT, Pose& outResult)
+{
+	unsigned int count = outResult.Size();
+	if (inA.Size() < count || inB.Size() < count)
+	{
+		std::cout << "BlendPoses() needs input poses with at least " << count << " joints\n";
+		return;
+	}
+
+	vec3* positions = outResult.GetPositions();
+	vec3* scales = outResult.GetScales();
+	const vec3* positionsA = inA.GetPositions();
+	const vec3* positionsB = inB.GetPositions();
+	const vec3* scalesA = inA.GetScales();
+	const vec3* scalesB = inB.GetScales();
+	LerpArray(positionsA, positionsB, inT, positions, count);
+	LerpArray(scalesA, scalesB, inT, scales, count);
+	NlerpArray(inA.GetRotations(), inB.GetRotations(), inT, outResult.GetRotations(), count);
+}
+
+bool ComputeTopologicalOrder(const int* inParents, unsigned int inCount, unsigned int* outOrder)
+{
+	// Every pass emits the joints whose parent was already emitted, a pass that emits nothing means a cycle
+	std::vector<bool> emitted(inCount, false);
+	unsigned int written = 0;
+	while (written < inCount)
+	{
+		unsigned int before = written;
+		for (unsigned int i = 0; i < inCount; ++i)
+		{
+			if (emitted[i]) { continue; }
+			int parent = inParents[i];
+			if (parent >= (int)inCount || parent < -1) { return false; }
+			if (parent == -1 || emitted[parent])
+			{
+				emitted[i] = true;
+				outOrder[written++] = i;
+			}
+		}
+		if (written == before) { return false; }
+	}
+	return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#ifndef _H_POSE_
+#define _H_POSE_
+
+#include "vec3.h"
+#include "quat.h"
+#include "mat4.h"
+
+class LinearArena;
+
+/**
+* Pose stores the local transforms of a skeleton as a structure of arrays, one array each for positions, rotations & scales
+* Parents are kept in topological order (a joint's parent always has a lower index, roots are -1), so the world matrices
+* can be computed in a single forward pass & blending is a straight loop over each array
+* The arrays live in one 16 byte aligned block, either owned by the pose (heap) or taken from a LinearArena,
+* which is how transient poses should be made during Update() (see gFrameArena)
+*/
+class Pose
+{
+private:
+	unsigned char* mMemory; // Heap block, 0 for arena backed poses
+	unsigned int mJointCount;
+	vec3* mPositions;
+	quat* mRotations;
+	vec3* mScales;
+	int* mParents;
+private:
+	void Allocate(unsigned int inJointCount, LinearArena* inArena);
+	void Release();
+public:
+	Pose();
+	Pose(unsigned int inJointCount);
+	// The pose is only valid until inArena is reset
+	Pose(unsigned int inJointCount, LinearArena& inArena);
+	Pose(const Pose& inOther);
+	Pose& operator=(const Pose& inOther);
+	// Moving hands the arrays over (heap or arena) without copying, the source is left empty
+	Pose(Pose&& inOther);
+	Pose& operator=(Pose&& inOther);
+	~Pose();
+
+	// Heap backed poses only, every joint is reset to the identity & made a root
+	void Resize(unsigned int inJointCount);
+	unsigned int Size() const;
+	bool IsValid() const;
+
+	/**
+	* inParent has to be lower than inJoint (or -1), anything else is rejected with a message
+	* Importers with unsorted joints can use ComputeTopologicalOrder() to remap them first
+	*/
+	bool SetParent(unsigned int inJoint, int inParent);
+	int GetParent(unsigned int inJoint) const;
+	void SetLocal(unsigned int inJoint, const vec3& inPosition, const quat& inRotation, const vec3& inScale);
+
+	// Direct access to the arrays for batched code
+	vec3* GetPositions();
+	quat* GetRotations();
+	vec3* GetScales();
+	const vec3* GetPositions() const;
+	const quat* GetRotations() const;
+	const vec3* GetScales() const;
+	const int* GetParents() const;
+
+	// Copies the joint data & hierarchy of the first Size() joints of inOther, which can't be smaller
+	void CopyFrom(const Pose& inOther);
+	/**
+	* A pose made of the first inJointCount joints of this one, sharing its arrays (like an arena pose it doesn't own them)
+	* Parents always come first, so the view is a complete skeleton. Used to evaluate fewer joints at lower animation LODs
+	*/
+	Pose MakeView(unsigned int inJointCount);
+
+	// outMatrices needs Size() entries, each one is translation * rotation * scale of the joint
+	void GetLocalMatrices(mat4* outMatrices) const;
+	// Only joints inFirst to inFirst + inCount - 1, into outMatrices[0] onwards
+	void GetLocalMatrices(unsigned int inFirst, unsigned int inCount, mat4* outMatrices) const;
+	// Local to world (model space) matrices of every joint, outMatrices needs Size() entries
+	void GetGlobalMatrices(mat4* outMatrices) const;
+	mat4 GetGlobalMatrix(unsigned int inJoint) const;
+	/**
+	* Skinning palette straight from the pose: world matrix * inInverseBindPose[i] for every joint
+	* The world matrices are built in outPalette & multiplied in place, so there's no intermediate array
+	*/
+	void GetSkinMatrices(const mat4* inInverseBindPose, mat4* outPalette) const;
+};
+
+// Linear blend of positions & scales & shortest arc nlerp of rotations of outResult.Size() joints, a & b can be larger (out can be a or b)
+void BlendPoses(const Pose& inA, const Pose& inB, float inT, Pose& outResult);
+
+/**
+* Orders joints so every parent comes before its children
+* outOrder[newIndex] = oldIndex, returns false if inParents has a cycle or an out of range parent
+*/
+bool ComputeTopologicalOrder(const int* inParents, unsigned int inCount, unsigned int* outOrder);
+
+#endif
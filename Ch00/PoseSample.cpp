@@ -0,0 +1,82 @@
+#include "PoseSample.h"
+#include "Pose.h"
+#include "Arena.h"
+#include "FrameProfiler.h"
+#include <cmath>
+#include <iostream>
+
+PoseSample::PoseSample(unsigned int inJointCount)
+{
+	// Whole skeletons only
+	unsigned int skeletons = (inJointCount + kJointsPerSkeleton - 1) / kJointsPerSkeleton;
+	mJointCount = (skeletons > 0 ? skeletons : 1) * kJointsPerSkeleton;
+	mRestPose = 0;
+	mBentPose = 0;
+	mAnimatedPose = 0;
+	mWorldMatrices = 0;
+	mTime = 0.0f;
+}
+
+PoseSample::~PoseSample()
+{
+	Shutdown();
+}
+
+void PoseSample::Initialize()
+{
+	mRestPose = new Pose(mJointCount, *gPersistentArena);
+	mBentPose = new Pose(mJointCount, *gPersistentArena);
+	mAnimatedPose = new Pose(mJointCount, *gPersistentArena);
+	mWorldMatrices = gPersistentArena->AllocateArray<mat4>(mJointCount);
+	if (!mRestPose->IsValid() || !mBentPose->IsValid() || !mAnimatedPose->IsValid() || mWorldMatrices == 0)
+	{
+		std::cout << "PoseSample: the persistent arena is too small for " << mJointCount << " joints\n";
+		Shutdown();
+		return;
+	}
+
+	// Every skeleton is a binary tree, a joint's parent is (k - 1) / 2 within its skeleton, which is always sorted
+	quat bend = angleAxis(0.35f, vec3(0, 0, 1));
+	for (unsigned int i = 0; i < mJointCount; ++i)
+	{
+		unsigned int k = i % kJointsPerSkeleton;
+		unsigned int skeleton = i / kJointsPerSkeleton;
+		int parent = (k == 0) ? -1 : (int)(i - k + (k - 1) / 2);
+		mRestPose->SetParent(i, parent);
+		mBentPose->SetParent(i, parent);
+
+		vec3 offset = (k == 0) ? vec3((float)(skeleton % 32) * 2.0f, 0.0f, (float)(skeleton / 32) * 2.0f) : vec3((k & 1) ? 0.1f : -0.1f, 0.25f, 0.0f);
+		mRestPose->SetLocal(i, offset, quat(), vec3(1, 1, 1));
+		mBentPose->SetLocal(i, offset, (k == 0) ? quat() : bend, vec3(1, 1, 1));
+	}
+	mAnimatedPose->CopyFrom(*mRestPose);
+	std::cout << "PoseSample: " << mJointCount / kJointsPerSkeleton << " skeletons, " << mJointCount << " joints\n";
+}
+
+void PoseSample::Update(float inDeltaTime)
+{
+	if (mWorldMatrices == 0) { return; }
+	mTime += inDeltaTime;
+	float t = 0.5f + 0.5f * sinf(mTime * 2.0f);
+	{
+		PROFILE_SCOPE("BlendPoses");
+		BlendPoses(*mRestPose, *mBentPose, t, *mAnimatedPose);
+	}
+	{
+		PROFILE_SCOPE("GlobalMatrices");
+		mAnimatedPose->GetGlobalMatrices(mWorldMatrices);
+	}
+	if (gProfiler != 0) { gProfiler->AddCounter("Joints evaluated", (float)mJointCount); }
+}
+
+void PoseSample::Shutdown()
+{
+	// The pose arrays belong to gPersistentArena, only the Pose objects themselves are on the heap
+	delete mRestPose;
+	delete mBentPose;
+	delete mAnimatedPose;
+	mRestPose = 0;
+	mBentPose = 0;
+	mAnimatedPose = 0;
+	mWorldMatrices = 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef _H_POSESAMPLE_
+#define _H_POSESAMPLE_
+
+#include "Application.h"
+
+class Pose;
+struct mat4;
+
+/**
+* Stress test for the pose code (-sample=pose, -joints=N)
+* Builds a crowd of 64 joint skeletons & every Update() blends two poses of all of them & computes their world matrices
+* Everything is allocated from gPersistentArena in Initialize(), Update() doesn't allocate
+*/
+class PoseSample : public Application
+{
+public:
+	static const unsigned int kJointsPerSkeleton = 64;
+private:
+	unsigned int mJointCount;
+	Pose* mRestPose;
+	Pose* mBentPose;
+	Pose* mAnimatedPose;
+	mat4* mWorldMatrices;
+	float mTime;
+public:
+	PoseSample(unsigned int inJointCount);
+	~PoseSample();
+	void Initialize();
+	void Update(float inDeltaTime);
+	void Shutdown();
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "Mesh.h"
+#include "Arena.h"
+#include "FrameProfiler.h"
+#include <cstring>
+#include <iostream>
+
+RenderQueue::RenderQueue()
+{
+	mCommands = 0;
+	mItems = 0;
+	mCount = 0;
+	mCapacity = 0;
+	mOverflowReported = false;
+	mDrawCalls = 0;
+	mStateChanges = 0;
+}
+
+RenderQueue::~RenderQueue()
+{
+	Clear();
+}
+
+int RenderQueue::AddMaterial(const RenderMaterial& inMaterial)
+{
+	if (inMaterial.shader == 0 || inMaterial.mesh == 0)
+	{
+		std::cout << "RenderQueue: a material needs a shader & a mesh\n";
+		return -1;
+	}
+	unsigned int program = 0;
+	while (program < (unsigned int)mPrograms.size() && mPrograms[program] != inMaterial.shader) { ++program; }
+	unsigned int mesh = 0;
+	while (mesh < (unsigned int)mMeshes.size() && mMeshes[mesh] != inMaterial.mesh) { ++mesh; }
+	if (program >= kMaxPrograms || mesh >= kMaxMeshes || mMaterials.size() >= kMaxMaterials)
+	{
+		std::cout << "RenderQueue: out of sort key bits for another material\n";
+		return -1;
+	}
+	if (program == (unsigned int)mPrograms.size()) { mPrograms.push_back(inMaterial.shader); }
+	if (mesh == (unsigned int)mMeshes.size()) { mMeshes.push_back(inMaterial.mesh); }
+
+	Material material;
+	material.material = inMaterial;
+	material.key = ((unsigned long long)program << 52) | ((unsigned long long)mesh << 40) | ((unsigned long long)mMaterials.size() << 24);
+	mMaterials.push_back(material);
+	return (int)mMaterials.size() - 1;
+}
+
+void RenderQueue::Clear()
+{
+	mMaterials.clear();
+	mPrograms.clear();
+	mMeshes.clear();
+	mCommands = 0;
+	mItems = 0;
+	mCount = 0;
+	mCapacity = 0;
+}
+
+unsigned int RenderQueue::GetMaterialCount() const
+{
+	return (unsigned int)mMaterials.size();
+}
+
+bool RenderQueue::Begin(unsigned int inCapacity)
+{
+	mCount = 0;
+	// The items are followed by the sort's scratch copy
+	mCommands = gFrameArena->AllocateArray<DrawCommand>(inCapacity);
+	mItems = gFrameArena->AllocateArray<SortItem>((size_t)inCapacity * 2);
+	if (mCommands == 0 || mItems == 0)
+	{
+		std::cout << "RenderQueue: the frame arena has no room for " << inCapacity << " draws\n";
+		mCommands = 0;
+		mItems = 0;
+		mCapacity = 0;
+		return false;
+	}
+	mCapacity = inCapacity;
+	return true;
+}
+
+void RenderQueue::Submit(unsigned int inMaterial, float inDepth, unsigned int inParameter, GLsizei inIndexCount, unsigned int inFirstIndex, GLint inBaseVertex)
+{
+	if (mCount >= mCapacity || inMaterial >= (unsigned int)mMaterials.size())
+	{
+		if (!mOverflowReported)
+		{
+			std::cout << "RenderQueue: draw dropped, " << (mCount >= mCapacity ? "the queue is full\n" : "unknown material\n");
+			mOverflowReported = true;
+		}
+		return;
+	}
+
+	// The sign bit of a depth >= 0 is always clear, the next 24 bits are the exponent & the top of the mantissa
+	unsigned int depthBits = 0;
+	if (inDepth > 0.0f) { memcpy(&depthBits, &inDepth, sizeof(float)); }
+	DrawCommand& command = mCommands[mCount];
+	command.material = inMaterial;
+	command.parameter = inParameter;
+	command.indexCount = inIndexCount;
+	command.firstIndex = inFirstIndex;
+	command.baseVertex = inBaseVertex;
+	mItems[mCount].key = mMaterials[inMaterial].key | (unsigned long long)(depthBits >> 7);
+	mItems[mCount].command = mCount;
+	++mCount;
+}
+
+RenderQueue::SortItem* RenderQueue::Sort()
+{
+	// One pass over the keys builds the histogram of all 8 bytes
+	unsigned int histogram[8][256];
+	memset(histogram, 0, sizeof(histogram));
+	for (unsigned int i = 0; i < mCount; ++i)
+	{
+		unsigned long long key = mItems[i].key;
+		for (unsigned int b = 0; b < 8; ++b) { ++histogram[b][(key >> (b * 8)) & 0xFF]; }
+	}
+
+	SortItem* source = mItems;
+	SortItem* target = mItems + mCapacity;
+	for (unsigned int b = 0; b < 8; ++b)
+	{
+		unsigned int* counts = histogram[b];
+		// Every key has the same byte here, the pass wouldn't move anything
+		if (counts[(source[0].key >> (b * 8)) & 0xFF] == mCount) { continue; }
+		unsigned int offset = 0;
+		for (unsigned int d = 0; d < 256; ++d)
+		{
+			unsigned int count = counts[d];
+			counts[d] = offset;
+			offset += count;
+		}
+		for (unsigned int i = 0; i < mCount; ++i)
+		{
+			target[counts[(source[i].key >> (b * 8)) & 0xFF]++] = source[i];
+		}
+		SortItem* swap = source;
+		source = target;
+		target = swap;
+	}
+	return source;
+}
+
+void RenderQueue::BindMesh(const RenderMaterial& inMaterial, bool inBind)
+{
+	Shader& shader = *inMaterial.shader;
+	GLint position = shader.GetAttribute("aPosition");
+	GLint normal = inMaterial.normals ? shader.GetAttribute("aNormal") : -1;
+	GLint texCoord = inMaterial.texCoords ? shader.GetAttribute("aTexCoord") : -1;
+	GLint weights = inMaterial.skinned ? shader.GetAttribute("aWeights") : -1;
+	GLint joints = inMaterial.skinned ? shader.GetAttribute("aJoints") : -1;
+	if (inBind) { inMaterial.mesh->Bind(position, normal, texCoord, weights, joints, inMaterial.cpuSkinned); }
+	else { inMaterial.mesh->UnBind(position, normal, texCoord, weights, joints); }
+}
+
+unsigned int RenderQueue::Flush()
+{
+	mDrawCalls = 0;
+	mStateChanges = 0;
+	unsigned int submitted = mCount;
+	if (mCommands != 0 && mCount > 0)
+	{
+		PROFILE_SCOPE("RenderQueue");
+		SortItem* sorted = Sort();
+		// The ranges of one call, the other half of the item array is free again once the sort is done
+		GLsizei* counts = gFrameArena->AllocateArray<GLsizei>(mCount);
+		const void** offsets = gFrameArena->AllocateArray<const void*>(mCount);
+		GLint* baseVertices = gFrameArena->AllocateArray<GLint>(mCount);
+		bool canMerge = counts != 0 && offsets != 0 && baseVertices != 0;
+
+		Shader* program = 0;
+		const RenderMaterial* boundMesh = 0; // The material whose mesh attributes are set up
+		unsigned int material = (unsigned int)mMaterials.size();
+		bool parameterSet = false;
+		unsigned int parameter = 0;
+		unsigned int i = 0;
+		while (i < mCount)
+		{
+			const DrawCommand& command = mCommands[sorted[i].command];
+			const RenderMaterial& current = mMaterials[command.material].material;
+			if (current.shader != program)
+			{
+				// The old program's slots are the ones that were enabled
+				if (boundMesh != 0) { BindMesh(*boundMesh, false); }
+				boundMesh = 0;
+				current.shader->Bind();
+				program = current.shader;
+				material = (unsigned int)mMaterials.size();
+				++mStateChanges;
+			}
+			if (boundMesh == 0 || boundMesh->mesh != current.mesh || boundMesh->normals != current.normals || boundMesh->texCoords != current.texCoords ||
+				boundMesh->skinned != current.skinned || boundMesh->cpuSkinned != current.cpuSkinned)
+			{
+				if (boundMesh != 0) { BindMesh(*boundMesh, false); }
+				BindMesh(current, true);
+				boundMesh = &current;
+				++mStateChanges;
+			}
+			if (command.material != material)
+			{
+				if (current.bind != 0) { current.bind(current.userData, *program); }
+				material = command.material;
+				parameterSet = false;
+				++mStateChanges;
+			}
+			if (current.drawSetup != 0 && (!parameterSet || parameter != command.parameter))
+			{
+				current.drawSetup(current.userData, *program, command.parameter);
+				parameter = command.parameter;
+				parameterSet = true;
+				++mStateChanges;
+			}
+
+			// Everything up to the next material (or parameter) change goes out in one call
+			Mesh& mesh = *current.mesh;
+			bool indexed = mesh.GetIndexCount() > 0;
+			unsigned int run = 0;
+			while (i < mCount)
+			{
+				const DrawCommand& next = mCommands[sorted[i].command];
+				if (next.material != command.material || (current.drawSetup != 0 && next.parameter != command.parameter)) { break; }
+				if (!indexed || !canMerge)
+				{
+					// Without indices a command always draws the whole mesh
+					if (indexed && next.indexCount > 0)
+					{
+						const void* offset = (const void*)((size_t)next.firstIndex * sizeof(unsigned int));
+						mesh.MultiDraw(&next.indexCount, &offset, &next.baseVertex, 1);
+					}
+					else { mesh.Draw(); }
+					++mDrawCalls;
+				}
+				else
+				{
+					counts[run] = next.indexCount > 0 ? next.indexCount : (GLsizei)mesh.GetIndexCount();
+					offsets[run] = (const void*)((size_t)(next.indexCount > 0 ? next.firstIndex : 0) * sizeof(unsigned int));
+					baseVertices[run] = next.baseVertex;
+					++run;
+				}
+				++i;
+			}
+			if (run > 0)
+			{
+				mesh.MultiDraw(counts, offsets, baseVertices, run);
+				++mDrawCalls;
+			}
+		}
+		if (boundMesh != 0) { BindMesh(*boundMesh, false); }
+	}
+	mCommands = 0;
+	mCount = 0;
+	mCapacity = 0;
+
+	if (gProfiler != 0)
+	{
+		gProfiler->AddCounter("Draw commands", (float)submitted);
+		gProfiler->AddCounter("Draw calls", (float)mDrawCalls);
+		gProfiler->AddCounter("Draw state changes", (float)mStateChanges);
+	}
+	return mDrawCalls;
+}
+
+unsigned int RenderQueue::GetSubmittedCount() const
+{
+	return mCount;
+}
+
+unsigned int RenderQueue::GetDrawCallCount() const
+{
+	return mDrawCalls;
+}
+
+unsigned int RenderQueue::GetStateChangeCount() const
+{
+	return mStateChanges;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#ifndef _H_RENDERQUEUE_
+#define _H_RENDERQUEUE_
+
+#include "include/glad/glad.h"
+#include <vector>
+
+class Shader;
+class Mesh;
+
+/**
+* A RenderMaterial is everything a run of draws shares: the program, the geometry & the uniforms set in between
+* bind sets the material's uniforms & textures, it's called whenever the sorted draws switch to this material
+* drawSetup is optional, it's called before every draw whose parameter differs from the last one's (which palette to read for example)
+* Draws of a material with a drawSetup are only merged when their parameter is the same
+* The attribute flags say which of the mesh's attributes the shader reads, the slots are looked up by their usual names
+* (aPosition, aNormal, aTexCoord, aWeights, aJoints) whenever the program is bound, so a hot reloaded program keeps working
+*/
+struct RenderMaterial
+{
+	typedef void (*BindFn)(void* inUserData, Shader& inShader);
+	typedef void (*DrawSetupFn)(void* inUserData, Shader& inShader, unsigned int inParameter);
+
+	Shader* shader;
+	Mesh* mesh;
+	BindFn bind;
+	DrawSetupFn drawSetup;
+	void* userData;
+	bool normals;
+	bool texCoords;
+	bool skinned; // Weights & joints
+	bool cpuSkinned; // Reads the mesh's CPU skinned positions & normals
+
+	RenderMaterial() : shader(0), mesh(0), bind(0), drawSetup(0), userData(0), normals(true), texCoords(false), skinned(false), cpuSkinned(false) { }
+};
+
+/**
+* RenderQueue collects the draws of a frame, sorts them & submits them with as few state changes as the sort allows
+* Every draw gets a 64 bit key, from the most significant bits down:
+*   12 bits program | 12 bits mesh | 16 bits material | 24 bits depth
+* Programs & meshes are numbered in the order AddMaterial() first sees them, materials in the order they were added
+* The depth bits are the top of the float's bit pattern, positive floats sort like integers, so draws inside a material go front to back
+* Sorting is an LSD radix sort over the key bytes in gFrameArena, passes where every key has the same byte are skipped,
+* which with few programs & meshes leaves only the material & depth passes
+*
+* Flush() walks the sorted draws: a program is bound when it changes, a mesh's attributes are pointed at its buffers when the
+* program or the mesh changes, bind runs when the material changes. Consecutive draws of the same material (& parameter)
+* become a single glMultiDrawElementsBaseVertex
+* The one global VAO stays bound, it's the attribute setup inside it that's only redone per unique program & mesh
+*
+* Begin(), Submit() & Flush() are for the thread that renders, materials are added up front (Initialize())
+*/
+class RenderQueue
+{
+public:
+	static const unsigned int kMaxPrograms = 1 << 12;
+	static const unsigned int kMaxMeshes = 1 << 12;
+	static const unsigned int kMaxMaterials = 1 << 16;
+private:
+	struct Material
+	{
+		RenderMaterial material;
+		unsigned long long key; // Program, mesh & material bits
+	};
+	struct DrawCommand
+	{
+		unsigned int material;
+		unsigned int parameter;
+		GLsizei indexCount; // 0 draws the whole mesh
+		unsigned int firstIndex;
+		GLint baseVertex;
+	};
+	struct SortItem
+	{
+		unsigned long long key;
+		unsigned int command;
+	};
+	std::vector<Material> mMaterials;
+	std::vector<Shader*> mPrograms;
+	std::vector<Mesh*> mMeshes;
+	DrawCommand* mCommands; // gFrameArena, Begin() to Flush()
+	SortItem* mItems;
+	unsigned int mCount;
+	unsigned int mCapacity;
+	bool mOverflowReported;
+	// Stats of the last Flush()
+	unsigned int mDrawCalls;
+	unsigned int mStateChanges;
+private:
+	RenderQueue(const RenderQueue&);
+	RenderQueue& operator=(const RenderQueue&);
+	// Sorts mItems by key, returns the sorted array (either mItems or the scratch copy)
+	SortItem* Sort();
+	static void BindMesh(const RenderMaterial& inMaterial, bool inBind);
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	// Returns the material's index for Submit(), or -1 (with a message) if the program, mesh or material bits would overflow
+	int AddMaterial(const RenderMaterial& inMaterial);
+	void Clear();
+	unsigned int GetMaterialCount() const;
+
+	// Room for inCapacity draws is taken from gFrameArena, returns false if the arena is out of memory
+	bool Begin(unsigned int inCapacity);
+	/**
+	* inDepth is the view distance (anything >= 0), inParameter is handed to the material's drawSetup
+	* inIndexCount 0 draws the whole mesh, otherwise the range starts at inFirstIndex & its indices are offset by inBaseVertex
+	*/
+	void Submit(unsigned int inMaterial, float inDepth, unsigned int inParameter, GLsizei inIndexCount = 0, unsigned int inFirstIndex = 0, GLint inBaseVertex = 0);
+	// Sorts & draws everything submitted since Begin(), returns the number of draw calls it took
+	unsigned int Flush();
+
+	unsigned int GetSubmittedCount() const;
+	unsigned int GetDrawCallCount() const;
+	// Program, mesh, material & draw parameter changes of the last Flush()
+	unsigned int GetStateChangeCount() const;
+};
+
+#endif
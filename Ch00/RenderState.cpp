@@ -0,0 +1,337 @@
+#include "RenderState.h"
+
+thread_local RenderState* gRenderState = 0;
+
+RenderState::RenderState()
+{
+	ResetCounters();
+	Invalidate();
+}
+
+int RenderState::CapabilityIndex(GLenum inCap)
+{
+	switch (inCap)
+	{
+	case GL_DEPTH_TEST: return CapDepthTest;
+	case GL_CULL_FACE: return CapCullFace;
+	case GL_BLEND: return CapBlend;
+	case GL_SCISSOR_TEST: return CapScissorTest;
+	case GL_STENCIL_TEST: return CapStencilTest;
+	case GL_POLYGON_OFFSET_FILL: return CapPolygonOffsetFill;
+	case GL_PROGRAM_POINT_SIZE: return CapProgramPointSize;
+	}
+	return -1;
+}
+
+int RenderState::BufferTargetIndex(GLenum inTarget)
+{
+	switch (inTarget)
+	{
+	case GL_ARRAY_BUFFER: return TargetArrayBuffer;
+	case GL_UNIFORM_BUFFER: return TargetUniformBuffer;
+	case GL_TEXTURE_BUFFER: return TargetTextureBuffer;
+	case GL_COPY_READ_BUFFER: return TargetCopyReadBuffer;
+	case GL_COPY_WRITE_BUFFER: return TargetCopyWriteBuffer;
+	case GL_PIXEL_UNPACK_BUFFER: return TargetPixelUnpackBuffer;
+	}
+	return -1;
+}
+
+void RenderState::Invalidate()
+{
+	for (unsigned int i = 0; i < CapCount; ++i)
+	{
+		mCapabilityValid[i] = false;
+		mCapabilityEnabled[i] = false;
+	}
+	for (unsigned int i = 0; i < TargetCount; ++i)
+	{
+		mBufferValid[i] = false;
+		mBuffer[i] = 0;
+	}
+	for (unsigned int i = 0; i < kTextureUnitCount; ++i)
+	{
+		mTextureValid[i] = false;
+		mTextureTarget[i] = GL_TEXTURE_2D;
+		mTexture[i] = 0;
+	}
+	mViewportValid = false;
+	mViewport[0] = mViewport[1] = mViewport[2] = mViewport[3] = 0;
+	mPointSizeValid = false;
+	mPointSize = 1.0f;
+	mClearColorValid = false;
+	mClearColor[0] = mClearColor[1] = mClearColor[2] = mClearColor[3] = 0.0f;
+	mVertexArrayValid = false;
+	mVertexArray = 0;
+	mProgramValid = false;
+	mProgram = 0;
+	mActiveTextureValid = false;
+	mActiveTexture = 0;
+	mDepthFuncValid = false;
+	mDepthFunc = GL_LESS;
+	mCullFaceModeValid = false;
+	mCullFaceMode = GL_BACK;
+	mBlendFuncValid = false;
+	mBlendSource = GL_ONE;
+	mBlendDestination = GL_ZERO;
+	mDepthMaskValid = false;
+	mDepthMask = GL_TRUE;
+}
+
+void RenderState::Enable(GLenum inCap)
+{
+	int index = CapabilityIndex(inCap);
+	if (index < 0)
+	{
+		++mIssuedCalls;
+		glEnable(inCap);
+		return;
+	}
+	if (mCapabilityValid[index] && mCapabilityEnabled[index])
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glEnable(inCap);
+	mCapabilityValid[index] = true;
+	mCapabilityEnabled[index] = true;
+}
+
+void RenderState::Disable(GLenum inCap)
+{
+	int index = CapabilityIndex(inCap);
+	if (index < 0)
+	{
+		++mIssuedCalls;
+		glDisable(inCap);
+		return;
+	}
+	if (mCapabilityValid[index] && !mCapabilityEnabled[index])
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glDisable(inCap);
+	mCapabilityValid[index] = true;
+	mCapabilityEnabled[index] = false;
+}
+
+void RenderState::Viewport(GLint inX, GLint inY, GLsizei inWidth, GLsizei inHeight)
+{
+	if (mViewportValid && mViewport[0] == inX && mViewport[1] == inY && mViewport[2] == inWidth && mViewport[3] == inHeight)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glViewport(inX, inY, inWidth, inHeight);
+	mViewportValid = true;
+	mViewport[0] = inX;
+	mViewport[1] = inY;
+	mViewport[2] = inWidth;
+	mViewport[3] = inHeight;
+}
+
+void RenderState::PointSize(GLfloat inSize)
+{
+	if (mPointSizeValid && mPointSize == inSize)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glPointSize(inSize);
+	mPointSizeValid = true;
+	mPointSize = inSize;
+}
+
+void RenderState::ClearColor(GLfloat inR, GLfloat inG, GLfloat inB, GLfloat inA)
+{
+	if (mClearColorValid && mClearColor[0] == inR && mClearColor[1] == inG && mClearColor[2] == inB && mClearColor[3] == inA)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glClearColor(inR, inG, inB, inA);
+	mClearColorValid = true;
+	mClearColor[0] = inR;
+	mClearColor[1] = inG;
+	mClearColor[2] = inB;
+	mClearColor[3] = inA;
+}
+
+void RenderState::BindVertexArray(GLuint inVAO)
+{
+	if (mVertexArrayValid && mVertexArray == inVAO)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glBindVertexArray(inVAO);
+	mVertexArrayValid = true;
+	mVertexArray = inVAO;
+}
+
+void RenderState::UseProgram(GLuint inProgram)
+{
+	if (mProgramValid && mProgram == inProgram)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glUseProgram(inProgram);
+	mProgramValid = true;
+	mProgram = inProgram;
+}
+
+void RenderState::BindBuffer(GLenum inTarget, GLuint inBuffer)
+{
+	int index = BufferTargetIndex(inTarget);
+	if (index < 0)
+	{
+		++mIssuedCalls;
+		glBindBuffer(inTarget, inBuffer);
+		return;
+	}
+	if (mBufferValid[index] && mBuffer[index] == inBuffer)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glBindBuffer(inTarget, inBuffer);
+	mBufferValid[index] = true;
+	mBuffer[index] = inBuffer;
+}
+
+void RenderState::BindTexture(GLuint inUnit, GLenum inTarget, GLuint inTexture)
+{
+	if (inUnit >= kTextureUnitCount)
+	{
+		// Units we don't track still need to go through the active texture cache
+		mActiveTextureValid = false;
+		mIssuedCalls += 2;
+		glActiveTexture(GL_TEXTURE0 + inUnit);
+		glBindTexture(inTarget, inTexture);
+		return;
+	}
+	if (mTextureValid[inUnit] && mTextureTarget[inUnit] == inTarget && mTexture[inUnit] == inTexture)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	if (!mActiveTextureValid || mActiveTexture != inUnit)
+	{
+		++mIssuedCalls;
+		glActiveTexture(GL_TEXTURE0 + inUnit);
+		mActiveTextureValid = true;
+		mActiveTexture = inUnit;
+	}
+	++mIssuedCalls;
+	glBindTexture(inTarget, inTexture);
+	mTextureValid[inUnit] = true;
+	mTextureTarget[inUnit] = inTarget;
+	mTexture[inUnit] = inTexture;
+}
+
+void RenderState::DepthFunc(GLenum inFunc)
+{
+	if (mDepthFuncValid && mDepthFunc == inFunc)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glDepthFunc(inFunc);
+	mDepthFuncValid = true;
+	mDepthFunc = inFunc;
+}
+
+void RenderState::CullFace(GLenum inMode)
+{
+	if (mCullFaceModeValid && mCullFaceMode == inMode)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glCullFace(inMode);
+	mCullFaceModeValid = true;
+	mCullFaceMode = inMode;
+}
+
+void RenderState::BlendFunc(GLenum inSource, GLenum inDestination)
+{
+	if (mBlendFuncValid && mBlendSource == inSource && mBlendDestination == inDestination)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glBlendFunc(inSource, inDestination);
+	mBlendFuncValid = true;
+	mBlendSource = inSource;
+	mBlendDestination = inDestination;
+}
+
+void RenderState::DepthMask(GLboolean inEnabled)
+{
+	if (mDepthMaskValid && mDepthMask == inEnabled)
+	{
+		++mSkippedCalls;
+		return;
+	}
+	++mIssuedCalls;
+	glDepthMask(inEnabled);
+	mDepthMaskValid = true;
+	mDepthMask = inEnabled;
+}
+
+void RenderState::OnVertexArrayDeleted(GLuint inVAO)
+{
+	// Deleting a bound VAO reverts the binding to 0
+	if (mVertexArray == inVAO) { mVertexArray = 0; }
+}
+
+void RenderState::OnProgramDeleted(GLuint inProgram)
+{
+	// A program that is in use is only flagged for deletion, so the binding is unknown from now on
+	if (mProgram == inProgram) { mProgramValid = false; }
+}
+
+void RenderState::OnBufferDeleted(GLuint inBuffer)
+{
+	for (unsigned int i = 0; i < TargetCount; ++i)
+	{
+		if (mBuffer[i] == inBuffer) { mBuffer[i] = 0; }
+	}
+}
+
+void RenderState::OnTextureDeleted(GLuint inTexture)
+{
+	for (unsigned int i = 0; i < kTextureUnitCount; ++i)
+	{
+		if (mTexture[i] == inTexture) { mTexture[i] = 0; }
+	}
+}
+
+void RenderState::ResetCounters()
+{
+	mIssuedCalls = 0;
+	mSkippedCalls = 0;
+}
+
+unsigned int RenderState::GetIssuedCalls() const
+{
+	return mIssuedCalls;
+}
+
+unsigned int RenderState::GetSkippedCalls() const
+{
+	return mSkippedCalls;
+}
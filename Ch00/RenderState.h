@@ -0,0 +1,121 @@
+#pragma once
+#ifndef _H_RENDERSTATE_
+#define _H_RENDERSTATE_
+
+#include "include/glad/glad.h"
+
+/**
+* RenderState is a small cache that sits in front of the OpenGL state functions
+* Every request is compared against the last value that was sent to the driver & the GL call is skipped if nothing changed
+* Redundant state changes still cost CPU time inside the driver, which adds up once a scene has hundreds of draws
+* Both the game loop & Application subclasses should go through gRenderState instead of calling glEnable/glBindVertexArray etc. directly,
+* if a GL call changes state behind the cache's back, Invalidate() needs to be called so the next request is always issued
+*/
+class RenderState
+{
+public:
+	// Capabilities tracked by Enable()/Disable(), anything else is passed straight through to the driver
+	enum Capability
+	{
+		CapDepthTest = 0,
+		CapCullFace,
+		CapBlend,
+		CapScissorTest,
+		CapStencilTest,
+		CapPolygonOffsetFill,
+		CapProgramPointSize,
+		CapCount
+	};
+	// Buffer targets tracked by BindBuffer(), GL_ELEMENT_ARRAY_BUFFER is part of the VAO so it's not cached here
+	enum BufferTarget
+	{
+		TargetArrayBuffer = 0,
+		TargetUniformBuffer,
+		TargetTextureBuffer,
+		TargetCopyReadBuffer,
+		TargetCopyWriteBuffer,
+		TargetPixelUnpackBuffer,
+		TargetCount
+	};
+	static const unsigned int kTextureUnitCount = 16;
+private:
+	// Each cached value has a valid flag, an invalid value is always sent to the driver
+	bool mCapabilityValid[CapCount];
+	bool mCapabilityEnabled[CapCount];
+	bool mViewportValid;
+	GLint mViewport[4];
+	bool mPointSizeValid;
+	GLfloat mPointSize;
+	bool mClearColorValid;
+	GLfloat mClearColor[4];
+	bool mVertexArrayValid;
+	GLuint mVertexArray;
+	bool mProgramValid;
+	GLuint mProgram;
+	bool mBufferValid[TargetCount];
+	GLuint mBuffer[TargetCount];
+	bool mActiveTextureValid;
+	GLuint mActiveTexture;
+	bool mTextureValid[kTextureUnitCount];
+	GLenum mTextureTarget[kTextureUnitCount];
+	GLuint mTexture[kTextureUnitCount];
+	bool mDepthFuncValid;
+	GLenum mDepthFunc;
+	bool mCullFaceModeValid;
+	GLenum mCullFaceMode;
+	bool mBlendFuncValid;
+	GLenum mBlendSource;
+	GLenum mBlendDestination;
+	bool mDepthMaskValid;
+	GLboolean mDepthMask;
+
+	// Statistics, reset by ResetCounters() at the start of every frame
+	unsigned int mIssuedCalls;
+	unsigned int mSkippedCalls;
+private:
+	RenderState(const RenderState&);
+	RenderState& operator=(const RenderState&);
+	static int CapabilityIndex(GLenum inCap);
+	static int BufferTargetIndex(GLenum inTarget);
+public:
+	RenderState();
+
+	// Forget every cached value, call this after GL state was changed without going through the cache
+	void Invalidate();
+
+	void Enable(GLenum inCap);
+	void Disable(GLenum inCap);
+	void Viewport(GLint inX, GLint inY, GLsizei inWidth, GLsizei inHeight);
+	void PointSize(GLfloat inSize);
+	void ClearColor(GLfloat inR, GLfloat inG, GLfloat inB, GLfloat inA);
+	void BindVertexArray(GLuint inVAO);
+	void UseProgram(GLuint inProgram);
+	void BindBuffer(GLenum inTarget, GLuint inBuffer);
+	void BindTexture(GLuint inUnit, GLenum inTarget, GLuint inTexture);
+	void DepthFunc(GLenum inFunc);
+	void CullFace(GLenum inMode);
+	void BlendFunc(GLenum inSource, GLenum inDestination);
+	void DepthMask(GLboolean inEnabled);
+
+	/**
+	* Objects that are deleted while bound need to be forgotten, otherwise a new object that reuses the same name
+	* would be treated as already bound
+	*/
+	void OnVertexArrayDeleted(GLuint inVAO);
+	void OnProgramDeleted(GLuint inProgram);
+	void OnBufferDeleted(GLuint inBuffer);
+	void OnTextureDeleted(GLuint inTexture);
+
+	void ResetCounters();
+	unsigned int GetIssuedCalls() const;
+	unsigned int GetSkippedCalls() const;
+};
+
+/**
+* The render state cache of the OpenGL context that's current on this thread
+* WinMain creates the main context's once it's current & hands it to the render thread, the asset loader has one for its own context
+* Each is deleted together with its context
+*/
+extern thread_local RenderState* gRenderState;
+
+#endif
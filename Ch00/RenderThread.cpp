@@ -0,0 +1,173 @@
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#include "include/glad/glad.h"
+#include <Windows.h>
+#include <iostream>
+#include "RenderThread.h"
+
+FramePacketQueue::FramePacketQueue()
+{
+	Reset(2);
+}
+
+void FramePacketQueue::Reset(unsigned int inPacketCount)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (inPacketCount < 2) { inPacketCount = 2; }
+	if (inPacketCount > kMaxPackets) { inPacketCount = kMaxPackets; }
+	mPacketCount = inPacketCount;
+	for (unsigned int i = 0; i < kMaxPackets; ++i)
+	{
+		mState[i] = PacketState::Free;
+		mSequence[i] = 0;
+	}
+	mNextSequence = 0;
+	mStopped = false;
+}
+
+unsigned int FramePacketQueue::GetPacketCount() const
+{
+	return mPacketCount;
+}
+
+bool FramePacketQueue::BeginWrite(unsigned int& outPacket)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		if (mStopped) { return false; }
+		for (unsigned int i = 0; i < mPacketCount; ++i)
+		{
+			if (mState[i] == PacketState::Free)
+			{
+				mState[i] = PacketState::Writing;
+				outPacket = i;
+				return true;
+			}
+		}
+		mChanged.wait(lock);
+	}
+}
+
+void FramePacketQueue::EndWrite(unsigned int inPacket)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mState[inPacket] = PacketState::Ready;
+		mSequence[inPacket] = mNextSequence++;
+	}
+	mChanged.notify_all();
+}
+
+bool FramePacketQueue::BeginRead(unsigned int& outPacket)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		if (mStopped) { return false; }
+		int oldest = -1;
+		for (unsigned int i = 0; i < mPacketCount; ++i)
+		{
+			if (mState[i] == PacketState::Ready && (oldest < 0 || mSequence[i] < mSequence[oldest])) { oldest = (int)i; }
+		}
+		if (oldest >= 0)
+		{
+			mState[oldest] = PacketState::Rendering;
+			outPacket = (unsigned int)oldest;
+			return true;
+		}
+		mChanged.wait(lock);
+	}
+}
+
+void FramePacketQueue::EndRead(unsigned int inPacket)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mState[inPacket] = PacketState::Free;
+	}
+	mChanged.notify_all();
+}
+
+void FramePacketQueue::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopped = true;
+	}
+	mChanged.notify_all();
+}
+
+RenderThread::RenderThread()
+{
+	mDeviceContext = 0;
+	mRenderContext = 0;
+	mRenderFrame = 0;
+	mOnStart = 0;
+	mOnStop = 0;
+	mRunning = false;
+}
+
+RenderThread::~RenderThread()
+{
+	if (mRunning)
+	{
+		std::cout << "RenderThread destroyed while running, stopping it\n";
+		Stop();
+	}
+}
+
+void RenderThread::Start(void* inHDC, void* inHGLRC, unsigned int inPacketCount, RenderFrameFn inRenderFrame, ThreadEventFn inOnStart, ThreadEventFn inOnStop)
+{
+	if (mRunning) { return; }
+	mDeviceContext = inHDC;
+	mRenderContext = inHGLRC;
+	mRenderFrame = inRenderFrame;
+	mOnStart = inOnStart;
+	mOnStop = inOnStop;
+	mQueue.Reset(inPacketCount);
+
+	// A context can only be current on one thread at a time
+	wglMakeCurrent(NULL, NULL);
+	mRunning = true;
+	mThread = std::thread(&RenderThread::Run, this);
+}
+
+void RenderThread::Stop()
+{
+	if (!mRunning) { return; }
+	mQueue.Stop();
+	mThread.join();
+	mRunning = false;
+
+	// Hand the context back to the thread that stopped the render thread
+	wglMakeCurrent((HDC)mDeviceContext, (HGLRC)mRenderContext);
+}
+
+bool RenderThread::IsRunning() const
+{
+	return mRunning;
+}
+
+FramePacketQueue& RenderThread::GetQueue()
+{
+	return mQueue;
+}
+
+void RenderThread::Run()
+{
+	wglMakeCurrent((HDC)mDeviceContext, (HGLRC)mRenderContext);
+	if (mOnStart != 0) { mOnStart(); }
+
+	unsigned int packet = 0;
+	while (mQueue.BeginRead(packet))
+	{
+		mRenderFrame(packet);
+		mQueue.EndRead(packet);
+	}
+
+	if (mOnStop != 0) { mOnStop(); }
+	// Make sure all submitted work is done before the context moves back to the other thread
+	glFinish();
+	wglMakeCurrent(NULL, NULL);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef _H_RENDERTHREAD_
+#define _H_RENDERTHREAD_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+* FramePacketQueue hands frame packets from the thread that runs Update() to the render thread
+* There are 2 (double buffered) or 3 (triple buffered) packets, each one is either free, being written, ready or being rendered
+* The update thread writes packet N+1 while the render thread is still submitting packet N, so both can work at the same time
+* Packets are rendered in the order they were published, no frame is ever skipped
+*/
+class FramePacketQueue
+{
+public:
+	static const unsigned int kMaxPackets = 3;
+private:
+	enum class PacketState
+	{
+		Free,
+		Writing,
+		Ready,
+		Rendering
+	};
+	PacketState mState[kMaxPackets];
+	unsigned long long mSequence[kMaxPackets]; // Publish order of the ready packets
+	unsigned long long mNextSequence;
+	unsigned int mPacketCount;
+	bool mStopped;
+	std::mutex mMutex;
+	std::condition_variable mChanged;
+private:
+	FramePacketQueue(const FramePacketQueue&);
+	FramePacketQueue& operator=(const FramePacketQueue&);
+public:
+	FramePacketQueue();
+	void Reset(unsigned int inPacketCount);
+	unsigned int GetPacketCount() const;
+
+	// Update thread: blocks until a packet is free, returns false if the queue was stopped
+	bool BeginWrite(unsigned int& outPacket);
+	void EndWrite(unsigned int inPacket);
+	// Render thread: blocks until a packet is ready, returns false if the queue was stopped
+	bool BeginRead(unsigned int& outPacket);
+	void EndRead(unsigned int inPacket);
+
+	// Wakes up both threads, every Begin call fails from now on
+	void Stop();
+};
+
+/**
+* RenderThread owns the OpenGL context while it's running
+* The context is released on the calling thread in Start() & made current on the render thread, Stop() joins the thread
+* & makes the context current on the calling thread again, so shutdown code can keep deleting GL objects as usual
+* inRenderFrame is called once per ready packet on the render thread, it's responsible for rendering & presenting the frame
+*/
+class RenderThread
+{
+public:
+	typedef void (*RenderFrameFn)(unsigned int inPacket);
+	typedef void (*ThreadEventFn)();
+private:
+	std::thread mThread;
+	FramePacketQueue mQueue;
+	void* mDeviceContext; // HDC & HGLRC, kept as void* so this header doesn't need windows.h
+	void* mRenderContext;
+	RenderFrameFn mRenderFrame;
+	ThreadEventFn mOnStart;
+	ThreadEventFn mOnStop;
+	bool mRunning;
+private:
+	RenderThread(const RenderThread&);
+	RenderThread& operator=(const RenderThread&);
+	void Run();
+public:
+	RenderThread();
+	~RenderThread();
+
+	/**
+	* inOnStart & inOnStop run on the render thread right after the context was made current & right before it's released,
+	* they can be used to set up per thread state like the render thread's profiler
+	*/
+	void Start(void* inHDC, void* inHGLRC, unsigned int inPacketCount, RenderFrameFn inRenderFrame, ThreadEventFn inOnStart, ThreadEventFn inOnStop);
+	void Stop();
+	bool IsRunning() const;
+	FramePacketQueue& GetQueue();
+};
+
+#endif
@@ -0,0 +1,306 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "Shader.h"
+#include "ShaderCache.h"
+#include "RenderState.h"
+#include "GLLoader.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// GL_ARB_get_program_binary isn't part of the generated 3.3 core glad, the entry point comes from GLLoader
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+Shader::Shader()
+{
+	mHandle = 0;
+}
+
+Shader::~Shader()
+{
+	Release();
+}
+
+std::string Shader::ReadSource(const std::string& inSourceOrPath)
+{
+	if (inSourceOrPath.find('\n') != std::string::npos) { return inSourceOrPath; }
+
+	std::ifstream file(inSourceOrPath.c_str());
+	if (!file.is_open())
+	{
+		std::cout << "Shader: can't open " << inSourceOrPath << "\n";
+		return std::string();
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+std::string Shader::InsertDefines(const std::string& inSource, const std::string& inDefines)
+{
+	if (inDefines.empty()) { return inSource; }
+	// #version has to stay the first line
+	std::string::size_type line = (inSource.compare(0, 8, "#version") == 0) ? inSource.find('\n') : std::string::npos;
+	if (line == std::string::npos) { return inDefines + inSource; }
+	return inSource.substr(0, line + 1) + inDefines + inSource.substr(line + 1);
+}
+
+GLuint Shader::Compile(GLenum inType, const std::string& inSource)
+{
+	GLuint shader = glCreateShader(inType);
+	const char* source = inSource.c_str();
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	return shader;
+}
+
+void Shader::PrintLog(GLuint inShader, GLenum inType)
+{
+	GLint success = 0;
+	glGetShaderiv(inShader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		char infoLog[512];
+		glGetShaderInfoLog(inShader, sizeof(infoLog), NULL, infoLog);
+		std::cout << (inType == GL_VERTEX_SHADER ? "Vertex" : "Fragment") << " shader compilation failed.\n\t" << infoLog << "\n";
+	}
+}
+
+void Shader::StartBuild(const std::string& inVertexSource, const std::string& inFragmentSource, bool inRetrievable, ShaderBuild& outBuild)
+{
+	outBuild.vertex = Compile(GL_VERTEX_SHADER, inVertexSource);
+	outBuild.fragment = Compile(GL_FRAGMENT_SHADER, inFragmentSource);
+	outBuild.program = glCreateProgram();
+	if (inRetrievable)
+	{
+		ProgramParameteriProc programParameteri = (ProgramParameteriProc)GetGLProcAddress("glProgramParameteri");
+		if (programParameteri != 0) { programParameteri(outBuild.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); }
+	}
+	glAttachShader(outBuild.program, outBuild.vertex);
+	glAttachShader(outBuild.program, outBuild.fragment);
+	// A stage that didn't compile makes the link fail, its log is printed by FinishBuild()
+	glLinkProgram(outBuild.program);
+}
+
+GLuint Shader::FinishBuild(ShaderBuild& ioBuild)
+{
+	if (ioBuild.program == 0) { return 0; }
+
+	GLint success = 0;
+	glGetProgramiv(ioBuild.program, GL_LINK_STATUS, &success);
+	GLuint program = ioBuild.program;
+	if (!success)
+	{
+		PrintLog(ioBuild.vertex, GL_VERTEX_SHADER);
+		PrintLog(ioBuild.fragment, GL_FRAGMENT_SHADER);
+		char infoLog[512];
+		glGetProgramInfoLog(ioBuild.program, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Shader linking failed.\n\t" << infoLog << "\n";
+		DeleteBuild(ioBuild);
+		return 0;
+	}
+
+	// The program keeps the compiled code, the shader objects aren't needed after linking
+	glDetachShader(program, ioBuild.vertex);
+	glDetachShader(program, ioBuild.fragment);
+	glDeleteShader(ioBuild.vertex);
+	glDeleteShader(ioBuild.fragment);
+	ioBuild = ShaderBuild();
+	return program;
+}
+
+void Shader::DeleteBuild(ShaderBuild& ioBuild)
+{
+	if (ioBuild.program != 0) { glDeleteProgram(ioBuild.program); }
+	if (ioBuild.vertex != 0) { glDeleteShader(ioBuild.vertex); }
+	if (ioBuild.fragment != 0) { glDeleteShader(ioBuild.fragment); }
+	ioBuild = ShaderBuild();
+}
+
+bool Shader::Load(const std::string& inVertex, const std::string& inFragment, const std::string& inDefines)
+{
+	Release();
+	std::string vertexSource = ReadSource(inVertex);
+	std::string fragmentSource = ReadSource(inFragment);
+	if (vertexSource.empty() || fragmentSource.empty()) { return false; }
+	vertexSource = InsertDefines(vertexSource, inDefines);
+	fragmentSource = InsertDefines(fragmentSource, inDefines);
+
+	GLuint program = 0;
+	if (gShaderCache != 0) { program = gShaderCache->GetProgram(vertexSource, fragmentSource); }
+	else
+	{
+		ShaderBuild build;
+		StartBuild(vertexSource, fragmentSource, false, build);
+		program = FinishBuild(build);
+	}
+	if (program == 0) { return false; }
+	Adopt(program);
+
+	// Only shaders that came from files can change while running
+	bool fromFile = inVertex.find('\n') == std::string::npos || inFragment.find('\n') == std::string::npos;
+	if (fromFile && gShaderCache != 0 && gShaderCache->IsHotReloadEnabled()) { gShaderCache->Watch(this, inVertex, inFragment, inDefines); }
+	return true;
+}
+
+void Shader::Adopt(GLuint inProgram)
+{
+	DeleteProgram();
+	mHandle = inProgram;
+	PopulateLocations();
+	ApplyBindings();
+}
+
+void Shader::PopulateLocations()
+{
+	char name[128];
+	GLint count = 0;
+	GLint size = 0;
+	GLenum type = 0;
+	GLsizei length = 0;
+
+	glGetProgramiv(mHandle, GL_ACTIVE_ATTRIBUTES, &count);
+	for (GLint i = 0; i < count; ++i)
+	{
+		glGetActiveAttrib(mHandle, (GLuint)i, sizeof(name), &length, &size, &type, name);
+		mAttributes[name] = glGetAttribLocation(mHandle, name);
+	}
+
+	glGetProgramiv(mHandle, GL_ACTIVE_UNIFORMS, &count);
+	for (GLint i = 0; i < count; ++i)
+	{
+		glGetActiveUniform(mHandle, (GLuint)i, sizeof(name), &length, &size, &type, name);
+		GLint location = glGetUniformLocation(mHandle, name);
+		// Members of uniform blocks have no location
+		if (location < 0) { continue; }
+		std::string uniform = name;
+		std::string::size_type bracket = uniform.find('[');
+		if (bracket != std::string::npos) { uniform.erase(bracket); }
+		mUniforms[uniform] = location;
+	}
+
+	glGetProgramiv(mHandle, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+	for (GLint i = 0; i < count; ++i)
+	{
+		glGetActiveUniformBlockName(mHandle, (GLuint)i, sizeof(name), &length, name);
+		mUniformBlocks[name] = (GLuint)i;
+	}
+}
+
+void Shader::ApplyBindings()
+{
+	for (std::map<std::string, GLuint>::const_iterator it = mBlockBindings.begin(); it != mBlockBindings.end(); ++it)
+	{
+		std::map<std::string, GLuint>::const_iterator block = mUniformBlocks.find(it->first);
+		if (block != mUniformBlocks.end()) { glUniformBlockBinding(mHandle, block->second, it->second); }
+	}
+	if (mSamplerUnits.empty()) { return; }
+	gRenderState->UseProgram(mHandle);
+	for (std::map<std::string, int>::const_iterator it = mSamplerUnits.begin(); it != mSamplerUnits.end(); ++it)
+	{
+		SetUniform(GetUniform(it->first), it->second);
+	}
+}
+
+void Shader::DeleteProgram()
+{
+	if (mHandle != 0)
+	{
+		if (gRenderState != 0) { gRenderState->OnProgramDeleted(mHandle); }
+		glDeleteProgram(mHandle);
+		mHandle = 0;
+	}
+	mAttributes.clear();
+	mUniforms.clear();
+	mUniformBlocks.clear();
+}
+
+void Shader::Release()
+{
+	if (gShaderCache != 0) { gShaderCache->Unwatch(this); }
+	DeleteProgram();
+	mBlockBindings.clear();
+	mSamplerUnits.clear();
+}
+
+void Shader::Bind()
+{
+	gRenderState->UseProgram(mHandle);
+}
+
+void Shader::UnBind()
+{
+	gRenderState->UseProgram(0);
+}
+
+GLint Shader::GetAttribute(const std::string& inName) const
+{
+	std::map<std::string, GLint>::const_iterator it = mAttributes.find(inName);
+	return (it == mAttributes.end()) ? -1 : it->second;
+}
+
+GLint Shader::GetUniform(const std::string& inName) const
+{
+	std::map<std::string, GLint>::const_iterator it = mUniforms.find(inName);
+	return (it == mUniforms.end()) ? -1 : it->second;
+}
+
+bool Shader::BindUniformBlock(const std::string& inName, GLuint inBindingPoint)
+{
+	std::map<std::string, GLuint>::const_iterator it = mUniformBlocks.find(inName);
+	if (it == mUniformBlocks.end()) { return false; }
+	glUniformBlockBinding(mHandle, it->second, inBindingPoint);
+	mBlockBindings[inName] = inBindingPoint;
+	return true;
+}
+
+bool Shader::SetSampler(const std::string& inName, int inUnit)
+{
+	GLint slot = GetUniform(inName);
+	if (slot < 0) { return false; }
+	gRenderState->UseProgram(mHandle);
+	SetUniform(slot, inUnit);
+	mSamplerUnits[inName] = inUnit;
+	return true;
+}
+
+GLuint Shader::GetHandle() const
+{
+	return mHandle;
+}
+
+void SetUniform(GLint inSlot, int inValue)
+{
+	glUniform1i(inSlot, inValue);
+}
+
+void SetUniform(GLint inSlot, float inValue)
+{
+	glUniform1f(inSlot, inValue);
+}
+
+void SetUniform(GLint inSlot, const vec3& inValue)
+{
+	glUniform3fv(inSlot, 1, inValue.v);
+}
+
+void SetUniform(GLint inSlot, const vec4& inValue)
+{
+	glUniform4fv(inSlot, 1, inValue.v);
+}
+
+void SetUniform(GLint inSlot, const mat4& inValue)
+{
+	glUniformMatrix4fv(inSlot, 1, GL_FALSE, inValue.v);
+}
+
+void SetUniformArray(GLint inSlot, const mat4* inValues, unsigned int inCount)
+{
+	// mat4 is 16 tightly packed floats, so an array of them can be passed straight through
+	glUniformMatrix4fv(inSlot, (GLsizei)inCount, GL_FALSE, inValues[0].v);
+}
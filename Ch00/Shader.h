@@ -0,0 +1,99 @@
+#pragma once
+#ifndef _H_SHADER_
+#define _H_SHADER_
+
+#include "include/glad/glad.h"
+#include <map>
+#include <string>
+
+struct vec3;
+struct vec4;
+struct mat4;
+
+/**
+* A program whose link was issued but not waited for, see Shader::StartBuild()
+* The shader objects stay around until the build is finished so their logs can be printed if the link failed
+*/
+struct ShaderBuild
+{
+	GLuint program;
+	GLuint vertex;
+	GLuint fragment;
+	ShaderBuild() : program(0), vertex(0), fragment(0) { }
+};
+
+/**
+* Shader owns a linked vertex + fragment program
+* Load() takes either the GLSL source itself or the path of a file that holds it, anything with a newline is treated as source
+* After linking every active attribute, uniform & uniform block is looked up once, so the Get fns never call into the driver
+* Compile & link errors are printed with the info log & leave the shader empty (GetHandle() returns 0)
+* Programs are built through gShaderCache when there is one, so the same sources are only compiled once (see ShaderCache.h)
+*/
+class Shader
+{
+private:
+	GLuint mHandle;
+	std::map<std::string, GLint> mAttributes;
+	std::map<std::string, GLint> mUniforms;
+	std::map<std::string, GLuint> mUniformBlocks;
+	// Bindings are program state, they're kept so a reloaded program can get them back
+	std::map<std::string, GLuint> mBlockBindings;
+	std::map<std::string, int> mSamplerUnits;
+private:
+	Shader(const Shader&);
+	Shader& operator=(const Shader&);
+	static GLuint Compile(GLenum inType, const std::string& inSource);
+	static void PrintLog(GLuint inShader, GLenum inType);
+	void PopulateLocations();
+	void ApplyBindings();
+	void DeleteProgram();
+public:
+	Shader();
+	~Shader();
+
+	// inDefines ("#define NAME VALUE\n" lines) is inserted into both stages right after their #version line
+	bool Load(const std::string& inVertex, const std::string& inFragment, const std::string& inDefines = std::string());
+	void Release();
+	/**
+	* Takes ownership of a linked program & replaces the current one, the uniform block & sampler bindings made so far are
+	* applied to the new program. Used by ShaderCache to swap in hot reloaded programs
+	*/
+	void Adopt(GLuint inProgram);
+
+	// Goes through gRenderState so binding the same program twice in a row is free
+	void Bind();
+	void UnBind();
+
+	// -1 when the name isn't an active attribute / uniform, uniform arrays are stored without the [0]
+	GLint GetAttribute(const std::string& inName) const;
+	GLint GetUniform(const std::string& inName) const;
+	// Assigns the named uniform block to a binding point, returns false if the program doesn't use the block
+	bool BindUniformBlock(const std::string& inName, GLuint inBindingPoint);
+	// Points the named sampler uniform at a texture unit, returns false if the program doesn't use it
+	bool SetSampler(const std::string& inName, int inUnit);
+	GLuint GetHandle() const;
+
+	// Returns the file's contents if inSourceOrPath has no newline in it, otherwise inSourceOrPath itself
+	static std::string ReadSource(const std::string& inSourceOrPath);
+	static std::string InsertDefines(const std::string& inSource, const std::string& inDefines);
+	/**
+	* Issues the compiles & the link without asking for their status, so a driver that compiles on threads of its own isn't waited for
+	* inRetrievable asks the driver to keep the binary around for glGetProgramBinary (GL_ARB_get_program_binary)
+	* FinishBuild() waits, prints the logs & returns the linked program or 0, either way the build is empty afterwards
+	*/
+	static void StartBuild(const std::string& inVertexSource, const std::string& inFragmentSource, bool inRetrievable, ShaderBuild& outBuild);
+	static GLuint FinishBuild(ShaderBuild& ioBuild);
+	static void DeleteBuild(ShaderBuild& ioBuild);
+};
+
+/**
+* Uniform setters for the program that is currently bound, a slot of -1 is silently ignored like it is by GL
+*/
+void SetUniform(GLint inSlot, int inValue);
+void SetUniform(GLint inSlot, float inValue);
+void SetUniform(GLint inSlot, const vec3& inValue);
+void SetUniform(GLint inSlot, const vec4& inValue);
+void SetUniform(GLint inSlot, const mat4& inValue);
+void SetUniformArray(GLint inSlot, const mat4* inValues, unsigned int inCount);
+
+#endif
@@ -0,0 +1,353 @@
+#define _CRT_SECURE_NO_WARNINGS
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#include "ShaderCache.h"
+#include "GLLoader.h"
+#include "FrameClock.h"
+#include <Windows.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// GL_ARB_get_program_binary & GL_KHR_parallel_shader_compile aren't part of the generated 3.3 core glad, the entry points come from GLLoader
+#ifndef GL_PROGRAM_BINARY_LENGTH
+	#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+	#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+	#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+
+ShaderCache* gShaderCache = 0;
+
+// Files hold a header followed by the binary, anything that doesn't match is treated as a miss & overwritten
+static const unsigned int kBinaryMagic = 0x42485353; // "SSHB"
+static const unsigned int kBinaryVersion = 1;
+struct ShaderBinaryHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned long long key;
+	unsigned int format;
+	unsigned int length;
+};
+
+// Seconds between two looks at the watched files
+static const double kPollInterval = 0.25;
+
+static const unsigned long long kHashBasis = 14695981039346656037ull;
+static unsigned long long Hash(unsigned long long inHash, const char* inData, size_t inLength)
+{
+	// FNV-1a
+	for (size_t i = 0; i < inLength; ++i)
+	{
+		inHash ^= (unsigned char)inData[i];
+		inHash *= 1099511628211ull;
+	}
+	return inHash;
+}
+
+static unsigned long long Hash(unsigned long long inHash, const std::string& inString)
+{
+	// The terminator is hashed too so "ab" + "c" & "a" + "bc" don't end up with the same key
+	return Hash(inHash, inString.c_str(), inString.size() + 1);
+}
+
+ShaderCache::ShaderCache()
+{
+	mDriverHash = kHashBasis;
+	mBinarySupported = false;
+	mParallelCompile = false;
+	mHotReload = false;
+	mLastPoll = 0;
+	mBinaryLoads = 0;
+	mCompiles = 0;
+	mRejectedBinaries = 0;
+	mBuildTime = 0.0;
+}
+
+ShaderCache::~ShaderCache()
+{
+	Shutdown();
+}
+
+void ShaderCache::Initialize(const std::string& inDirectory, bool inHotReload)
+{
+	Shutdown();
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDirectory = inDirectory;
+	mHotReload = inHotReload;
+	mLastPoll = FrameClock::Now();
+
+	GLint formats = 0;
+	bool hasFunctions = GetGLProcAddress("glGetProgramBinary") != 0 && GetGLProcAddress("glProgramBinary") != 0 && GetGLProcAddress("glProgramParameteri") != 0;
+	if (hasFunctions && IsGLExtensionSupported("GL_ARB_get_program_binary")) { glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats); }
+	// Some drivers expose the extension but don't offer a single format, which means they can't hand out binaries either
+	mBinarySupported = formats > 0;
+	mParallelCompile = IsGLExtensionSupported("GL_KHR_parallel_shader_compile") || IsGLExtensionSupported("GL_ARB_parallel_shader_compile");
+
+	const char* driver[] = { (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION) };
+	mDriverHash = kHashBasis;
+	for (unsigned int i = 0; i < 3; ++i) { mDriverHash = Hash(mDriverHash, std::string(driver[i] != 0 ? driver[i] : "")); }
+
+	// Fails if the directory is already there, which is fine
+	if (mBinarySupported && !mDirectory.empty()) { CreateDirectoryA(mDirectory.c_str(), NULL); }
+}
+
+void ShaderCache::Shutdown()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (unsigned int i = 0, size = (unsigned int)mWatched.size(); i < size; ++i)
+	{
+		if (mWatched[i].build.program != 0) { Shader::DeleteBuild(mWatched[i].build); }
+	}
+	mWatched.clear();
+	mBinaries.clear();
+	mBinarySupported = false;
+	mParallelCompile = false;
+	mHotReload = false;
+}
+
+unsigned long long ShaderCache::GetKey(const std::string& inVertexSource, const std::string& inFragmentSource) const
+{
+	return Hash(Hash(mDriverHash, inVertexSource), inFragmentSource);
+}
+
+std::string ShaderCache::GetBinaryPath(unsigned long long inKey) const
+{
+	char name[32];
+	sprintf(name, "%016llx.bin", inKey);
+	return mDirectory + "\\" + name;
+}
+
+GLuint ShaderCache::LoadBinary(unsigned long long inKey)
+{
+	if (!mBinarySupported) { return 0; }
+
+	std::unordered_map<unsigned long long, ProgramBinary>::iterator it = mBinaries.find(inKey);
+	if (it == mBinaries.end() && !mDirectory.empty())
+	{
+		std::ifstream file(GetBinaryPath(inKey).c_str(), std::ios::binary);
+		ShaderBinaryHeader header;
+		if (file.is_open() && file.read((char*)&header, sizeof(header)) && header.magic == kBinaryMagic &&
+			header.version == kBinaryVersion && header.key == inKey && header.length > 0)
+		{
+			ProgramBinary binary;
+			binary.format = (GLenum)header.format;
+			binary.data.resize(header.length);
+			if (file.read(&binary.data[0], header.length)) { it = mBinaries.insert(std::make_pair(inKey, binary)).first; }
+		}
+	}
+	if (it == mBinaries.end()) { return 0; }
+
+	ProgramBinaryProc programBinary = (ProgramBinaryProc)GetGLProcAddress("glProgramBinary");
+	GLuint program = glCreateProgram();
+	programBinary(program, it->second.format, &it->second.data[0], (GLsizei)it->second.data.size());
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (success) { return program; }
+
+	// Binaries are only valid for the driver that produced them, the hash covers the version string but not every update changes it
+	glDeleteProgram(program);
+	mBinaries.erase(it);
+	if (!mDirectory.empty()) { std::remove(GetBinaryPath(inKey).c_str()); }
+	++mRejectedBinaries;
+	return 0;
+}
+
+void ShaderCache::StoreBinary(unsigned long long inKey, GLuint inProgram)
+{
+	if (!mBinarySupported) { return; }
+
+	GLint length = 0;
+	glGetProgramiv(inProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) { return; }
+	ProgramBinary& binary = mBinaries[inKey];
+	binary.data.resize((size_t)length);
+	GLsizei written = 0;
+	GetProgramBinaryProc getProgramBinary = (GetProgramBinaryProc)GetGLProcAddress("glGetProgramBinary");
+	getProgramBinary(inProgram, length, &written, &binary.format, &binary.data[0]);
+	if (written <= 0)
+	{
+		mBinaries.erase(inKey);
+		return;
+	}
+	binary.data.resize((size_t)written);
+	if (mDirectory.empty()) { return; }
+
+	std::ofstream file(GetBinaryPath(inKey).c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "ShaderCache: can't write " << GetBinaryPath(inKey) << "\n";
+		return;
+	}
+	ShaderBinaryHeader header = { kBinaryMagic, kBinaryVersion, inKey, (unsigned int)binary.format, (unsigned int)written };
+	file.write((const char*)&header, sizeof(header));
+	file.write(&binary.data[0], written);
+}
+
+GLuint ShaderCache::GetProgram(const std::string& inVertexSource, const std::string& inFragmentSource)
+{
+	long long start = FrameClock::Now();
+	unsigned long long key = GetKey(inVertexSource, inFragmentSource);
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	GLuint program = LoadBinary(key);
+	if (program != 0) { ++mBinaryLoads; }
+	else
+	{
+		ShaderBuild build;
+		Shader::StartBuild(inVertexSource, inFragmentSource, mBinarySupported, build);
+		program = Shader::FinishBuild(build);
+		if (program != 0)
+		{
+			++mCompiles;
+			StoreBinary(key, program);
+		}
+	}
+	mBuildTime += FrameClock::ToSeconds(FrameClock::Now() - start);
+	return program;
+}
+
+long long ShaderCache::GetWriteTime(const std::string& inSourceOrPath)
+{
+	if (inSourceOrPath.find('\n') != std::string::npos) { return 0; }
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(inSourceOrPath.c_str(), GetFileExInfoStandard, &attributes)) { return 0; }
+	return ((long long)attributes.ftLastWriteTime.dwHighDateTime << 32) | (long long)attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+void ShaderCache::Watch(Shader* inShader, const std::string& inVertex, const std::string& inFragment, const std::string& inDefines)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	WatchedShader watched;
+	watched.shader = inShader;
+	watched.vertex = inVertex;
+	watched.fragment = inFragment;
+	watched.defines = inDefines;
+	watched.vertexTime = GetWriteTime(inVertex);
+	watched.fragmentTime = GetWriteTime(inFragment);
+	watched.buildKey = 0;
+	watched.buildFrames = 0;
+	mWatched.push_back(watched);
+}
+
+void ShaderCache::Unwatch(Shader* inShader)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (unsigned int i = 0; i < (unsigned int)mWatched.size(); ++i)
+	{
+		if (mWatched[i].shader != inShader) { continue; }
+		if (mWatched[i].build.program != 0) { Shader::DeleteBuild(mWatched[i].build); }
+		mWatched[i] = mWatched.back();
+		mWatched.pop_back();
+		--i;
+	}
+}
+
+void ShaderCache::PollFiles()
+{
+	for (unsigned int i = 0, size = (unsigned int)mWatched.size(); i < size; ++i)
+	{
+		WatchedShader& watched = mWatched[i];
+		// A save while the last one is still building is picked up once that build is done
+		if (watched.build.program != 0) { continue; }
+		long long vertexTime = GetWriteTime(watched.vertex);
+		long long fragmentTime = GetWriteTime(watched.fragment);
+		if (vertexTime == watched.vertexTime && fragmentTime == watched.fragmentTime) { continue; }
+		watched.vertexTime = vertexTime;
+		watched.fragmentTime = fragmentTime;
+
+		std::string vertexSource = Shader::ReadSource(watched.vertex);
+		std::string fragmentSource = Shader::ReadSource(watched.fragment);
+		if (vertexSource.empty() || fragmentSource.empty()) { continue; }
+		vertexSource = Shader::InsertDefines(vertexSource, watched.defines);
+		fragmentSource = Shader::InsertDefines(fragmentSource, watched.defines);
+
+		// Undoing an edit brings back a program that was already built
+		watched.buildKey = GetKey(vertexSource, fragmentSource);
+		GLuint program = LoadBinary(watched.buildKey);
+		if (program != 0)
+		{
+			watched.shader->Adopt(program);
+			std::cout << "ShaderCache: reloaded " << watched.vertex << " & " << watched.fragment << " from the cache\n";
+			continue;
+		}
+		Shader::StartBuild(vertexSource, fragmentSource, mBinarySupported, watched.build);
+		watched.buildFrames = 0;
+	}
+}
+
+bool ShaderCache::IsBuildComplete(WatchedShader& ioWatched) const
+{
+	if (mParallelCompile)
+	{
+		GLint complete = 0;
+		glGetProgramiv(ioWatched.build.program, GL_COMPLETION_STATUS_KHR, &complete);
+		return complete != 0;
+	}
+	// Without the extension there's no way to ask, give the driver a frame before waiting on it
+	return ioWatched.buildFrames++ > 0;
+}
+
+void ShaderCache::Update()
+{
+	if (!mHotReload) { return; }
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	long long now = FrameClock::Now();
+	if (FrameClock::ToSeconds(now - mLastPoll) >= kPollInterval)
+	{
+		mLastPoll = now;
+		PollFiles();
+	}
+
+	for (unsigned int i = 0, size = (unsigned int)mWatched.size(); i < size; ++i)
+	{
+		WatchedShader& watched = mWatched[i];
+		if (watched.build.program == 0 || !IsBuildComplete(watched)) { continue; }
+		GLuint program = Shader::FinishBuild(watched.build);
+		if (program == 0)
+		{
+			std::cout << "ShaderCache: " << watched.vertex << " & " << watched.fragment << " didn't build, keeping the old program\n";
+			continue;
+		}
+		StoreBinary(watched.buildKey, program);
+		watched.shader->Adopt(program);
+		std::cout << "ShaderCache: reloaded " << watched.vertex << " & " << watched.fragment << "\n";
+	}
+}
+
+bool ShaderCache::IsBinarySupported() const
+{
+	return mBinarySupported;
+}
+
+bool ShaderCache::IsHotReloadEnabled() const
+{
+	return mHotReload;
+}
+
+unsigned int ShaderCache::GetBinaryLoadCount() const
+{
+	return mBinaryLoads;
+}
+
+unsigned int ShaderCache::GetCompileCount() const
+{
+	return mCompiles;
+}
+
+unsigned int ShaderCache::GetRejectedBinaryCount() const
+{
+	return mRejectedBinaries;
+}
+
+double ShaderCache::GetBuildTime() const
+{
+	return mBuildTime;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#ifndef _H_SHADERCACHE_
+#define _H_SHADERCACHE_
+
+#include "include/glad/glad.h"
+#include "Shader.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+* ShaderCache keeps linked program binaries around so a GLSL program is only ever compiled once
+* Programs are keyed by a 64 bit FNV-1a hash of the vertex & fragment source (defines included, they're part of the source)
+* & the driver (vendor, renderer & version string), a driver update simply misses the cache instead of handing old binaries to it
+*
+* Every Shader::Load() goes through GetProgram(): a binary that's already in memory or in the cache directory is handed to
+* glProgramBinary, anything else is compiled, linked & its binary read back with glGetProgramBinary & written to the directory
+* GL_ARB_get_program_binary isn't part of GL 3.3, without it (or if the driver doesn't offer a single binary format) the cache
+* just compiles. A binary the driver refuses to load is deleted & the program is compiled again
+*
+* Hot reload: shaders loaded from files are watched, Update() polls their write times a few times a second & starts a new
+* build when one changes. The build doesn't block, the old program keeps drawing until the link finished, which with
+* GL_KHR_parallel_shader_compile is polled without stalling & without it is waited for on the frame after the link was issued
+* Update() has to be called on the thread that owns the context, Watch() & Unwatch() can be called from any thread
+*/
+class ShaderCache
+{
+private:
+	struct ProgramBinary
+	{
+		GLenum format;
+		std::vector<char> data;
+	};
+	struct WatchedShader
+	{
+		Shader* shader;
+		std::string vertex; // Either a path or the source itself, only paths are polled
+		std::string fragment;
+		std::string defines;
+		long long vertexTime;
+		long long fragmentTime;
+		ShaderBuild build; // program is 0 unless a reload is in flight
+		unsigned long long buildKey;
+		unsigned int buildFrames;
+	};
+	std::unordered_map<unsigned long long, ProgramBinary> mBinaries;
+	std::vector<WatchedShader> mWatched;
+	std::mutex mMutex;
+	std::string mDirectory;
+	unsigned long long mDriverHash;
+	bool mBinarySupported;
+	bool mParallelCompile;
+	bool mHotReload;
+	long long mLastPoll;
+	// Stats for the startup report
+	unsigned int mBinaryLoads;
+	unsigned int mCompiles;
+	unsigned int mRejectedBinaries;
+	double mBuildTime;
+private:
+	ShaderCache(const ShaderCache&);
+	ShaderCache& operator=(const ShaderCache&);
+	unsigned long long GetKey(const std::string& inVertexSource, const std::string& inFragmentSource) const;
+	std::string GetBinaryPath(unsigned long long inKey) const;
+	// Returns 0 if there's no binary or the driver didn't accept it
+	GLuint LoadBinary(unsigned long long inKey);
+	void StoreBinary(unsigned long long inKey, GLuint inProgram);
+	bool IsBuildComplete(WatchedShader& ioWatched) const;
+	void PollFiles();
+	static long long GetWriteTime(const std::string& inSourceOrPath);
+public:
+	ShaderCache();
+	~ShaderCache();
+
+	/**
+	* Needs a current context, inDirectory is created if it doesn't exist. An empty directory keeps the binaries in memory only,
+	* so programs are still only compiled once per run
+	*/
+	void Initialize(const std::string& inDirectory, bool inHotReload);
+	void Shutdown();
+
+	// Blocks until the program is ready, returns 0 (after printing the logs) if it didn't compile or link
+	GLuint GetProgram(const std::string& inVertexSource, const std::string& inFragmentSource);
+
+	// The arguments are the ones passed to Shader::Load(), inShader has to stay where it is until it's unwatched
+	void Watch(Shader* inShader, const std::string& inVertex, const std::string& inFragment, const std::string& inDefines);
+	void Unwatch(Shader* inShader);
+	// Once per frame on the thread that owns the context, swaps in reloaded programs once they're linked
+	void Update();
+
+	bool IsBinarySupported() const;
+	bool IsHotReloadEnabled() const;
+	unsigned int GetBinaryLoadCount() const;
+	unsigned int GetCompileCount() const;
+	unsigned int GetRejectedBinaryCount() const;
+	// Seconds spent in GetProgram(), binary loads & compiles alike
+	double GetBuildTime() const;
+};
+
+// Created by WinMain before Application::Initialize(), Shader::Load() compiles directly when it's 0
+extern ShaderCache* gShaderCache;
+
+#endif
@@ -0,0 +1,192 @@
+#include "Skinning.h"
+#include "SkinningPalette.h"
+#include "ViewUniforms.h"
+#include "MathSIMD.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "dualquat.h"
+
+SkinningMethod gDefaultSkinningMethod = SkinningMethod::LinearBlend;
+
+const char* GetSkinningModeName(SkinningMode inMode)
+{
+	return (inMode == SkinningMode::Cpu) ? "cpu" : "gpu";
+}
+
+#if MATH_SSE
+void SkinVertices(const vec3* inPositions, const vec3* inNormals, const vec4* inWeights, const ivec4* inInfluences,
+	const mat4* inPalette, unsigned int inCount, vec3* outPositions, vec3* outNormals)
+{
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		// Blend the 4 matrices column by column, then transform with the blended matrix
+		__m128 columns[4];
+		for (unsigned int c = 0; c < 4; ++c) { columns[c] = _mm_setzero_ps(); }
+		for (unsigned int k = 0; k < 4; ++k)
+		{
+			float weight = inWeights[i].v[k];
+			if (weight == 0.0f) { continue; }
+			__m128 w = _mm_set1_ps(weight);
+			const float* m = inPalette[inInfluences[i].v[k]].v;
+			for (unsigned int c = 0; c < 4; ++c) { columns[c] = _mm_add_ps(columns[c], _mm_mul_ps(_mm_load_ps(m + c * 4), w)); }
+		}
+
+		__m128 p = _mm_load_ps(inPositions[i].v);
+		__m128 position = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0], MATH_SWIZZLE(p, 0, 0, 0, 0)), _mm_mul_ps(columns[1], MATH_SWIZZLE(p, 1, 1, 1, 1))),
+			_mm_add_ps(_mm_mul_ps(columns[2], MATH_SWIZZLE(p, 2, 2, 2, 2)), columns[3]));
+		_mm_store_ps(outPositions[i].v, position);
+		outPositions[i].pad = 0.0f;
+
+		if (inNormals != 0 && outNormals != 0)
+		{
+			__m128 n = _mm_load_ps(inNormals[i].v);
+			__m128 normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0], MATH_SWIZZLE(n, 0, 0, 0, 0)), _mm_mul_ps(columns[1], MATH_SWIZZLE(n, 1, 1, 1, 1))),
+				_mm_mul_ps(columns[2], MATH_SWIZZLE(n, 2, 2, 2, 2)));
+			_mm_store_ps(outNormals[i].v, normal);
+			normalize(outNormals[i]);
+		}
+	}
+}
+#else
+void SkinVertices(const vec3* inPositions, const vec3* inNormals, const vec4* inWeights, const ivec4* inInfluences,
+	const mat4* inPalette, unsigned int inCount, vec3* outPositions, vec3* outNormals)
+{
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		mat4 skin = inPalette[inInfluences[i].x] * inWeights[i].x + inPalette[inInfluences[i].y] * inWeights[i].y +
+			inPalette[inInfluences[i].z] * inWeights[i].z + inPalette[inInfluences[i].w] * inWeights[i].w;
+		outPositions[i] = transformPoint(skin, inPositions[i]);
+		if (inNormals != 0 && outNormals != 0) { outNormals[i] = normalized(transformVector(skin, inNormals[i])); }
+	}
+}
+#endif
+
+const char* GetSkinningMethodName(SkinningMethod inMethod)
+{
+	return (inMethod == SkinningMethod::DualQuaternion) ? "dual quaternion" : "linear blend";
+}
+
+void SkinVertices(const vec3* inPositions, const vec3* inNormals, const vec4* inWeights, const ivec4* inInfluences,
+	const dualquat* inPalette, unsigned int inCount, vec3* outPositions, vec3* outNormals)
+{
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		// q & -q are the same transform, blending across hemispheres would take the long way around
+		const dualquat& first = inPalette[inInfluences[i].x];
+		dualquat blended = first * inWeights[i].x;
+		for (unsigned int k = 1; k < 4; ++k)
+		{
+			float weight = inWeights[i].v[k];
+			if (weight == 0.0f) { continue; }
+			const dualquat& joint = inPalette[inInfluences[i].v[k]];
+			blended = blended + joint * (dot(first, joint) < 0.0f ? -weight : weight);
+		}
+		blended = normalized(blended);
+		outPositions[i] = transformPoint(blended, inPositions[i]);
+		outPositions[i].pad = 0.0f;
+		if (inNormals != 0 && outNormals != 0) { outNormals[i] = transformVector(blended, inNormals[i]); }
+	}
+}
+
+static const char* kSkinnedVertexBody =
+	"in vec3 aPosition;\n"
+	"in vec3 aNormal;\n"
+	"in vec4 aWeights;\n"
+	"in ivec4 aJoints;\n"
+	"out vec3 vNormal;\n"
+	"uniform int uPaletteOffset;\n"
+	"#if defined(INSTANCED)\n"
+	"in vec3 aInstancePosition;\n"
+	"in int aPaletteOffset;\n"
+	"#define PALETTE_OFFSET (uPaletteOffset + aPaletteOffset)\n"
+	"#define INSTANCE_POSITION aInstancePosition\n"
+	"#else\n"
+	"#define PALETTE_OFFSET uPaletteOffset\n"
+	"#define INSTANCE_POSITION vec3(0.0)\n"
+	"#endif\n"
+	"#if defined(DUAL_QUATERNION)\n"
+	// Two vec4s per joint: the rotation (real part) & the dual part
+	"#if defined(PALETTE_UNIFORM_BUFFER)\n"
+	"layout(std140) uniform Palette { vec4 uPalette[MAX_JOINTS * 2]; };\n"
+	"void GetJoint(int inJoint, out vec4 outReal, out vec4 outDual) { outReal = uPalette[inJoint * 2]; outDual = uPalette[inJoint * 2 + 1]; }\n"
+	"#else\n"
+	"uniform samplerBuffer uPaletteTexture;\n"
+	"void GetJoint(int inJoint, out vec4 outReal, out vec4 outDual)\n"
+	"{\n"
+	"	int texel = (PALETTE_OFFSET + inJoint) * 2;\n"
+	"	outReal = texelFetch(uPaletteTexture, texel);\n"
+	"	outDual = texelFetch(uPaletteTexture, texel + 1);\n"
+	"}\n"
+	"#endif\n"
+	"vec3 Rotate(vec4 inQuat, vec3 inVector) { return inVector + 2.0 * cross(inQuat.xyz, cross(inQuat.xyz, inVector) + inQuat.w * inVector); }\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 real0, dual0, real1, dual1, real2, dual2, real3, dual3;\n"
+	"	GetJoint(aJoints.x, real0, dual0);\n"
+	"	GetJoint(aJoints.y, real1, dual1);\n"
+	"	GetJoint(aJoints.z, real2, dual2);\n"
+	"	GetJoint(aJoints.w, real3, dual3);\n"
+	// Flip the influences on the other hemisphere from the first one so the blend takes the short way
+	"	vec3 weights = aWeights.yzw * vec3(dot(real0, real1) < 0.0 ? -1.0 : 1.0, dot(real0, real2) < 0.0 ? -1.0 : 1.0, dot(real0, real3) < 0.0 ? -1.0 : 1.0);\n"
+	"	vec4 real = real0 * aWeights.x + real1 * weights.x + real2 * weights.y + real3 * weights.z;\n"
+	"	vec4 dual = dual0 * aWeights.x + dual1 * weights.x + dual2 * weights.y + dual3 * weights.z;\n"
+	"	float inverseLength = 1.0 / length(real);\n"
+	"	real *= inverseLength;\n"
+	"	dual *= inverseLength;\n"
+	"	vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));\n"
+	"	vNormal = Rotate(real, aNormal);\n"
+	"	gl_Position = uViewProjection * vec4(Rotate(real, aPosition) + translation + INSTANCE_POSITION, 1.0);\n"
+	"}\n"
+	"#else\n"
+	"#if defined(PALETTE_UNIFORM_BUFFER)\n"
+	"layout(std140) uniform Palette { mat4 uPalette[MAX_JOINTS]; };\n"
+	"mat4 GetJoint(int inJoint) { return uPalette[inJoint]; }\n"
+	"#else\n"
+	"uniform samplerBuffer uPaletteTexture;\n"
+	"mat4 GetJoint(int inJoint)\n"
+	"{\n"
+	"	int texel = (PALETTE_OFFSET + inJoint) * 4;\n"
+	"	return mat4(texelFetch(uPaletteTexture, texel), texelFetch(uPaletteTexture, texel + 1),\n"
+	"		texelFetch(uPaletteTexture, texel + 2), texelFetch(uPaletteTexture, texel + 3));\n"
+	"}\n"
+	"#endif\n"
+	"void main()\n"
+	"{\n"
+	"	mat4 skin = GetJoint(aJoints.x) * aWeights.x + GetJoint(aJoints.y) * aWeights.y +\n"
+	"		GetJoint(aJoints.z) * aWeights.z + GetJoint(aJoints.w) * aWeights.w;\n"
+	"	vNormal = mat3(skin) * aNormal;\n"
+	"	gl_Position = uViewProjection * (skin * vec4(aPosition, 1.0) + vec4(INSTANCE_POSITION, 0.0));\n"
+	"}\n"
+	"#endif\n";
+
+std::string GetSkinnedVertexShader(const SkinningPalette& inPalette, bool inInstanced)
+{
+	// #version has to be the first line, the defines go right after it
+	return std::string("#version 330 core\n") + inPalette.GetShaderDefines() + (inInstanced ? "#define INSTANCED\n" : "") + GetViewUniformBlock() + kSkinnedVertexBody;
+}
+
+std::string GetStaticVertexShader()
+{
+	return std::string("#version 330 core\n") + GetViewUniformBlock() +
+		"in vec3 aPosition;\n"
+		"in vec3 aNormal;\n"
+		"out vec3 vNormal;\n"
+		"void main()\n"
+		"{\n"
+		"	vNormal = aNormal;\n"
+		"	gl_Position = uViewProjection * vec4(aPosition, 1.0);\n"
+		"}\n";
+}
+
+std::string GetLitFragmentShader()
+{
+	return std::string("#version 330 core\n") + GetViewUniformBlock() +
+		"in vec3 vNormal;\n"
+		"out vec4 FragColor;\n"
+		"void main()\n"
+		"{\n"
+		"	float diffuse = max(dot(normalize(vNormal), -uLightDirection.xyz), 0.0);\n"
+		"	FragColor = vec4(uColor.rgb * (0.25 + 0.75 * diffuse), 1.0);\n"
+		"}\n";
+}
@@ -0,0 +1,65 @@
+#pragma once
+#ifndef _H_SKINNING_
+#define _H_SKINNING_
+
+#include <string>
+
+struct vec3;
+struct vec4;
+struct ivec4;
+struct mat4;
+struct dualquat;
+class SkinningPalette;
+
+/**
+* Linear blend skinning
+* Every vertex is moved by the weighted sum of up to 4 skin matrices, a skin matrix is the joint's world matrix * its inverse bind matrix
+* Gpu does this in the vertex shader with the palette from a SkinningPalette, so the CPU only uploads one matrix per joint per frame
+* Cpu deforms every vertex with SkinVertices() & re-uploads the mesh, it's the fallback & a reference for the GPU path
+*/
+enum class SkinningMode
+{
+	Cpu,
+	Gpu
+};
+
+const char* GetSkinningModeName(SkinningMode inMode);
+
+/**
+* How the joint influences are combined, for both modes
+* LinearBlend sums the skin matrices, DualQuaternion blends rigid transforms (see dualquat.h), which keeps the volume of
+* twisted joints & only needs 2 vec4s per joint in the palette instead of 4, but drops any scale in the skin matrices
+* Meshes start out with gDefaultSkinningMethod (-skinmethod=lbs|dqs) & can be switched one by one with Mesh::SetSkinningMethod()
+*/
+enum class SkinningMethod
+{
+	LinearBlend,
+	DualQuaternion
+};
+
+const char* GetSkinningMethodName(SkinningMethod inMethod);
+extern SkinningMethod gDefaultSkinningMethod;
+
+/**
+* outPositions / outNormals need inCount entries, inNormals & outNormals can both be 0
+* The normals are transformed by the blended matrix too, which is fine as long as the joints aren't scaled non-uniformly
+*/
+void SkinVertices(const vec3* inPositions, const vec3* inNormals, const vec4* inWeights, const ivec4* inInfluences,
+	const mat4* inPalette, unsigned int inCount, vec3* outPositions, vec3* outNormals);
+// Same with a dual quaternion palette, the blend flips influences that are on the other hemisphere from the first one
+void SkinVertices(const vec3* inPositions, const vec3* inNormals, const vec4* inWeights, const ivec4* inInfluences,
+	const dualquat* inPalette, unsigned int inCount, vec3* outPositions, vec3* outNormals);
+
+/**
+* Shader sources of the skinned lit material
+* The GPU variant reads & blends its palette the way inPalette stores it (matrices or dual quaternions), the CPU variant
+* takes already skinned vertices
+* Attributes: aPosition, aNormal, aWeights, aJoints - Uniforms: the View block of ViewUniforms (+ uPaletteOffset)
+* inInstanced adds the per instance attributes aPaletteOffset (added to uPaletteOffset) & aInstancePosition (see Crowd.h),
+* it needs a texture buffer palette since one uniform block can't hold a whole crowd
+*/
+std::string GetSkinnedVertexShader(const SkinningPalette& inPalette, bool inInstanced = false);
+std::string GetStaticVertexShader();
+std::string GetLitFragmentShader();
+
+#endif
@@ -0,0 +1,226 @@
+#include "SkinningPalette.h"
+#include "Shader.h"
+#include "RenderState.h"
+#include "FrameProfiler.h"
+#include "mat4.h"
+#include "dualquat.h"
+#include <cstring>
+#include <sstream>
+#include <iostream>
+
+SkinningPalette::SkinningPalette()
+{
+	mStorage = PaletteStorage::Auto;
+	mMethod = SkinningMethod::LinearBlend;
+	mJointSize = sizeof(mat4);
+	mTexture = 0;
+	mJointsPerSkeleton = 0;
+	mMaxSkeletons = 0;
+	mSkeletonStride = 0;
+	mMapAlignment = 16;
+	mUploadedSkeletons = 0;
+	mFrameOffset = 0;
+}
+
+SkinningPalette::~SkinningPalette()
+{
+	Shutdown();
+}
+
+bool SkinningPalette::Initialize(unsigned int inJointsPerSkeleton, unsigned int inMaxSkeletons, PaletteStorage inStorage, SkinningMethod inMethod)
+{
+	Shutdown();
+	if (inJointsPerSkeleton == 0 || inMaxSkeletons == 0) { return false; }
+
+	GLint maxBlockSize = 0;
+	GLint offsetAlignment = 0;
+	glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	if (offsetAlignment <= 0) { offsetAlignment = 256; }
+	mMethod = inMethod;
+	mJointSize = (mMethod == SkinningMethod::DualQuaternion) ? (GLsizeiptr)sizeof(dualquat) : (GLsizeiptr)sizeof(mat4);
+	GLsizeiptr paletteSize = (GLsizeiptr)inJointsPerSkeleton * mJointSize;
+	bool fitsUniformBlock = paletteSize <= (GLsizeiptr)maxBlockSize;
+
+	mStorage = inStorage;
+	if (mStorage == PaletteStorage::Auto) { mStorage = fitsUniformBlock ? PaletteStorage::UniformBuffer : PaletteStorage::TextureBuffer; }
+	else if (mStorage == PaletteStorage::UniformBuffer && !fitsUniformBlock)
+	{
+		std::cout << "SkinningPalette: " << inJointsPerSkeleton << " joints need " << paletteSize << " bytes, the uniform block limit is "
+			<< maxBlockSize << ", using a texture buffer instead\n";
+		mStorage = PaletteStorage::TextureBuffer;
+	}
+
+	mJointsPerSkeleton = inJointsPerSkeleton;
+	mMaxSkeletons = inMaxSkeletons;
+	// Ranges bound with glBindBufferRange have to start on the offset alignment, the texture buffer is packed
+	mSkeletonStride = (mStorage == PaletteStorage::UniformBuffer) ? (paletteSize + offsetAlignment - 1) / offsetAlignment * offsetAlignment : paletteSize;
+	// Uniform ranges start on the offset alignment, texel fetches need whole joints. Map() may pad up to one alignment per frame
+	mMapAlignment = (mStorage == PaletteStorage::UniformBuffer) ? (GLsizeiptr)offsetAlignment : mJointSize;
+	GLsizeiptr frameSize = mSkeletonStride * inMaxSkeletons + mMapAlignment;
+
+	GLenum target = (mStorage == PaletteStorage::UniformBuffer) ? GL_UNIFORM_BUFFER : GL_TEXTURE_BUFFER;
+	if (!mStream.Initialize(target, frameSize, StreamBufferMode::Auto)) { return false; }
+	if (mStorage == PaletteStorage::TextureBuffer)
+	{
+		GLint maxTexels = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+		GLsizeiptr texels = mStream.GetRegionSize() * ((mStream.GetMode() == StreamBufferMode::Orphan) ? 1 : StreamBuffer::kRegionCount) / 16;
+		if ((GLsizeiptr)maxTexels < texels)
+		{
+			std::cout << "SkinningPalette: " << texels << " texels is more than the texture buffer limit of " << maxTexels << "\n";
+			mStream.Shutdown();
+			return false;
+		}
+		glGenTextures(1, &mTexture);
+		gRenderState->BindTexture(kTextureUnit, GL_TEXTURE_BUFFER, mTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mStream.GetBuffer());
+	}
+
+	std::cout << "SkinningPalette: " << GetPaletteStorageName(mStorage) << ", " << GetSkinningMethodName(mMethod) << ", " << inMaxSkeletons << " x " << inJointsPerSkeleton
+		<< " joints, " << frameSize / 1024 << "KB per frame, " << GetStreamBufferModeName(mStream.GetMode()) << " streaming\n";
+	return true;
+}
+
+void SkinningPalette::Shutdown()
+{
+	if (mTexture != 0)
+	{
+		if (gRenderState != 0) { gRenderState->OnTextureDeleted(mTexture); }
+		glDeleteTextures(1, &mTexture);
+		mTexture = 0;
+	}
+	mStream.Shutdown();
+	mUploadedSkeletons = 0;
+	mFrameOffset = 0;
+}
+
+std::string SkinningPalette::GetShaderDefines() const
+{
+	std::stringstream defines;
+	if (mMethod == SkinningMethod::DualQuaternion) { defines << "#define DUAL_QUATERNION\n"; }
+	if (mStorage == PaletteStorage::UniformBuffer)
+	{
+		defines << "#define PALETTE_UNIFORM_BUFFER\n#define MAX_JOINTS " << mJointsPerSkeleton << "\n";
+	}
+	else
+	{
+		defines << "#define PALETTE_TEXTURE_BUFFER\n";
+	}
+	return defines.str();
+}
+
+void SkinningPalette::ConfigureShader(Shader& inShader) const
+{
+	if (mStorage == PaletteStorage::UniformBuffer)
+	{
+		if (!inShader.BindUniformBlock("Palette", kUniformBinding)) { std::cout << "SkinningPalette: the shader has no Palette block\n"; }
+	}
+	else
+	{
+		if (!inShader.SetSampler("uPaletteTexture", (int)kTextureUnit)) { std::cout << "SkinningPalette: the shader has no uPaletteTexture\n"; }
+	}
+}
+
+void SkinningPalette::Upload(const mat4* inPalettes, unsigned int inSkeletonCount)
+{
+	if (mMethod != SkinningMethod::LinearBlend)
+	{
+		std::cout << "SkinningPalette: matrices uploaded to a " << GetSkinningMethodName(mMethod) << " palette\n";
+		return;
+	}
+	Upload((const void*)inPalettes, inSkeletonCount);
+}
+
+void SkinningPalette::Upload(const dualquat* inPalettes, unsigned int inSkeletonCount)
+{
+	if (mMethod != SkinningMethod::DualQuaternion)
+	{
+		std::cout << "SkinningPalette: dual quaternions uploaded to a " << GetSkinningMethodName(mMethod) << " palette\n";
+		return;
+	}
+	Upload((const void*)inPalettes, inSkeletonCount);
+}
+
+void SkinningPalette::Upload(const void* inPalettes, unsigned int inSkeletonCount)
+{
+	if (mStream.GetBuffer() == 0) { return; }
+	if (inSkeletonCount > mMaxSkeletons) { inSkeletonCount = mMaxSkeletons; }
+	mUploadedSkeletons = inSkeletonCount;
+	if (inSkeletonCount == 0) { return; }
+
+	const unsigned char* source = (const unsigned char*)inPalettes;
+	GLsizeiptr paletteSize = (GLsizeiptr)mJointsPerSkeleton * mJointSize;
+	GLsizeiptr size = mSkeletonStride * inSkeletonCount;
+	mStream.BeginFrame();
+	unsigned char* mapped = (unsigned char*)mStream.Map(size, mMapAlignment, mFrameOffset);
+	if (mapped == 0)
+	{
+		std::cout << "SkinningPalette: couldn't map the palette stream\n";
+		mUploadedSkeletons = 0;
+		return;
+	}
+	if (mSkeletonStride == paletteSize) { memcpy(mapped, source, (size_t)size); }
+	else
+	{
+		for (unsigned int i = 0; i < inSkeletonCount; ++i)
+		{
+			memcpy(mapped + mSkeletonStride * i, source + paletteSize * i, (size_t)paletteSize);
+		}
+	}
+	mStream.Unmap();
+
+	if (gProfiler != 0) { gProfiler->AddCounter("Palette KB uploaded", (float)(paletteSize * inSkeletonCount) / 1024.0f); }
+}
+
+void SkinningPalette::Bind(unsigned int inSkeleton, GLint inOffsetUniform)
+{
+	if (mStream.GetBuffer() == 0 || inSkeleton >= mUploadedSkeletons) { return; }
+	if (mStorage == PaletteStorage::UniformBuffer)
+	{
+		// glBindBufferRange also changes the generic binding, binding it through the cache first keeps the cache correct
+		GLuint buffer = mStream.GetBuffer();
+		gRenderState->BindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBindBufferRange(GL_UNIFORM_BUFFER, kUniformBinding, buffer, mFrameOffset + mSkeletonStride * inSkeleton, (GLsizeiptr)mJointsPerSkeleton * mJointSize);
+	}
+	else
+	{
+		gRenderState->BindTexture(kTextureUnit, GL_TEXTURE_BUFFER, mTexture);
+		SetUniform(inOffsetUniform, (int)(mFrameOffset / (GLintptr)mJointSize + inSkeleton * mJointsPerSkeleton));
+	}
+}
+
+void SkinningPalette::EndFrame()
+{
+	mStream.EndFrame();
+}
+
+PaletteStorage SkinningPalette::GetStorage() const
+{
+	return mStorage;
+}
+
+SkinningMethod SkinningPalette::GetMethod() const
+{
+	return mMethod;
+}
+
+unsigned int SkinningPalette::GetJointsPerSkeleton() const
+{
+	return mJointsPerSkeleton;
+}
+
+unsigned int SkinningPalette::GetMaxSkeletons() const
+{
+	return mMaxSkeletons;
+}
+
+const char* GetPaletteStorageName(PaletteStorage inStorage)
+{
+	switch (inStorage)
+	{
+	case PaletteStorage::UniformBuffer: return "uniform buffer";
+	case PaletteStorage::TextureBuffer: return "texture buffer";
+	default: return "auto";
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef _H_SKINNINGPALETTE_
+#define _H_SKINNINGPALETTE_
+
+#include "include/glad/glad.h"
+#include "StreamBuffer.h"
+#include "Skinning.h"
+#include <string>
+
+struct mat4;
+struct dualquat;
+class Shader;
+
+/**
+* Where the skin matrices of every skeleton live on the GPU
+* UniformBuffer is the fastest to read in the vertex shader but a block is limited to GL_MAX_UNIFORM_BLOCK_SIZE (often 16KB - 64KB),
+* TextureBuffer has no practical limit & reads four RGBA32F texels per matrix with texelFetch
+* Auto picks the uniform buffer whenever one skeleton's palette fits in a block
+*/
+enum class PaletteStorage
+{
+	Auto,
+	UniformBuffer,
+	TextureBuffer
+};
+
+/**
+* SkinningPalette holds the matrix palettes of every skinned character for one frame
+* Upload() writes all of them into this frame's region of a StreamBuffer, Bind() then only selects which skeleton the next draw reads:
+* - UniformBuffer: each skeleton starts on a GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT boundary & is bound with glBindBufferRange
+* - TextureBuffer: the texture covers the whole ring, the palettes are packed back to back & the shader gets the first matrix
+*   of the skeleton (region start included) through uPaletteOffset
+* EndFrame() has to follow the last draw that reads the palettes, it fences the region so it isn't overwritten too early
+* With SkinningMethod::DualQuaternion every joint is a dualquat (2 texels) instead of a mat4 (4 texels), half the upload
+*/
+class SkinningPalette
+{
+public:
+	static const GLuint kUniformBinding = 0;
+	static const GLuint kTextureUnit = 8;
+private:
+	PaletteStorage mStorage;
+	SkinningMethod mMethod;
+	GLsizeiptr mJointSize; // sizeof(mat4) or sizeof(dualquat)
+	StreamBuffer mStream;
+	GLuint mTexture;
+	unsigned int mJointsPerSkeleton;
+	unsigned int mMaxSkeletons;
+	GLsizeiptr mSkeletonStride; // Bytes between the start of two palettes in the buffer
+	GLsizeiptr mMapAlignment;
+	unsigned int mUploadedSkeletons;
+	GLintptr mFrameOffset; // Where this frame's palettes start in the stream buffer
+private:
+	SkinningPalette(const SkinningPalette&);
+	SkinningPalette& operator=(const SkinningPalette&);
+	void Upload(const void* inPalettes, unsigned int inSkeletonCount);
+public:
+	SkinningPalette();
+	~SkinningPalette();
+
+	// Needs a current context, a uniform buffer request that doesn't fit falls back to a texture buffer with a message
+	bool Initialize(unsigned int inJointsPerSkeleton, unsigned int inMaxSkeletons, PaletteStorage inStorage, SkinningMethod inMethod = SkinningMethod::LinearBlend);
+	void Shutdown();
+
+	// Prepended to the skinned vertex shader (after #version), selects how GetJoint() reads the palette
+	std::string GetShaderDefines() const;
+	// Call once after the program is linked, wires up the uniform block binding or the palette sampler
+	void ConfigureShader(Shader& inShader) const;
+
+	// inPalettes holds inSkeletonCount * joints per skeleton entries, once per frame before the first skinned draw
+	// The type has to match the skinning method, the other one is rejected with a message
+	void Upload(const mat4* inPalettes, unsigned int inSkeletonCount);
+	void Upload(const dualquat* inPalettes, unsigned int inSkeletonCount);
+	// Makes skeleton inSkeleton the one the next draws read, inOffsetUniform is uPaletteOffset of the bound program
+	void Bind(unsigned int inSkeleton, GLint inOffsetUniform);
+	void EndFrame();
+
+	PaletteStorage GetStorage() const;
+	SkinningMethod GetMethod() const;
+	unsigned int GetJointsPerSkeleton() const;
+	unsigned int GetMaxSkeletons() const;
+};
+
+const char* GetPaletteStorageName(PaletteStorage inStorage);
+
+#endif
@@ -0,0 +1,411 @@
+#include "SkinningSample.h"
+#include "PackedMesh.h"
+#include "Pose.h"
+#include "Arena.h"
+#include "FrameProfiler.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static const float kSegmentLength = 0.25f;
+static const float kRadius = 0.3f;
+static const unsigned int kRingsPerJoint = 4;
+static const unsigned int kSides = 12;
+static const float kSpacing = 1.5f;
+static const float kFieldOfView = 60.0f;
+
+SkinningSample::SkinningSample(unsigned int inCharacterCount, SkinningMode inMode, PaletteStorage inStorage)
+{
+	mCharacterCount = inCharacterCount > 0 ? inCharacterCount : 1;
+	mJointCount = mCharacterCount * kJointsPerCharacter;
+	mMode = inMode;
+	mRequestedStorage = inStorage;
+	mPose = 0;
+	mInverseBindPose = 0;
+	mPalettes = 0;
+	mVisible = 0;
+	for (unsigned int i = 0; i < kMaxPackets; ++i)
+	{
+		mPackets[i].palettes = 0;
+		mPackets[i].dualQuats = 0;
+		mPackets[i].visible = 0;
+	}
+	mPacketCount = 1;
+	mAspectRatio = 1.0f;
+	mTime = 0.0f;
+	mReady = false;
+	mShowJoints = false;
+	mPackedMesh = false;
+	mMaterial = -1;
+	mRenderPacket = 0;
+	mInstanced = false;
+	mLivePalettes = true;
+	mPaletteSkeletons = mCharacterCount;
+}
+
+SkinningSample::~SkinningSample()
+{
+	Shutdown();
+}
+
+void SkinningSample::SetShowJoints(bool inShow)
+{
+	mShowJoints = inShow;
+}
+
+void SkinningSample::SetPackedMesh(bool inPacked)
+{
+	mPackedMesh = inPacked;
+}
+
+void SkinningSample::SetRenderPacketCount(unsigned int inCount)
+{
+	mPacketCount = (inCount < 1) ? 1 : (inCount > kMaxPackets ? kMaxPackets : inCount);
+}
+
+void SkinningSample::BuildMesh()
+{
+	// A capped cylinder along +y, the rings between two joints blend linearly from one to the other
+	std::vector<vec3>& positions = mMesh.GetPositions();
+	std::vector<vec3>& normals = mMesh.GetNormals();
+	std::vector<vec4>& weights = mMesh.GetWeights();
+	std::vector<ivec4>& influences = mMesh.GetInfluences();
+	std::vector<unsigned int>& indices = mMesh.GetIndices();
+
+	unsigned int rings = (kJointsPerCharacter - 1) * kRingsPerJoint + 1;
+	for (unsigned int r = 0; r < rings; ++r)
+	{
+		float height = (float)r / (float)kRingsPerJoint * kSegmentLength;
+		unsigned int joint = r / kRingsPerJoint;
+		float t = (float)(r % kRingsPerJoint) / (float)kRingsPerJoint;
+		unsigned int next = (joint + 1 < kJointsPerCharacter) ? joint + 1 : joint;
+		for (unsigned int s = 0; s < kSides; ++s)
+		{
+			float angle = (float)s / (float)kSides * 6.2831853f;
+			vec3 normal(cosf(angle), 0.0f, sinf(angle));
+			positions.push_back(vec3(normal.x * kRadius, height, normal.z * kRadius));
+			normals.push_back(normal);
+			weights.push_back(vec4(1.0f - t, t, 0.0f, 0.0f));
+			influences.push_back(ivec4((int)joint, (int)next, 0, 0));
+		}
+	}
+
+	for (unsigned int r = 0; r + 1 < rings; ++r)
+	{
+		for (unsigned int s = 0; s < kSides; ++s)
+		{
+			unsigned int a = r * kSides + s;
+			unsigned int b = r * kSides + (s + 1) % kSides;
+			unsigned int c = a + kSides;
+			unsigned int d = b + kSides;
+			// Counter clockwise when seen from outside
+			indices.push_back(a); indices.push_back(c); indices.push_back(b);
+			indices.push_back(b); indices.push_back(c); indices.push_back(d);
+		}
+	}
+
+	// The CPU arrays stay either way, CPU skinning reads them
+	OptimizeMesh(mMesh);
+	std::vector<unsigned char> image;
+	if (mPackedMesh && PackMesh(mMesh, image) && UploadPackedMesh(&image[0], image.size(), mMesh)) { return; }
+	mMesh.UpdateOpenGLBuffers();
+}
+
+void SkinningSample::Initialize()
+{
+	mPose = new Pose(mJointCount, *gPersistentArena);
+	mInverseBindPose = gPersistentArena->AllocateArray<mat4>(kJointsPerCharacter);
+	mPalettes = gPersistentArena->AllocateArray<mat4>(mJointCount);
+	mVisible = gPersistentArena->AllocateArray<unsigned char>(mCharacterCount);
+	bool allocated = mPose->IsValid() && mInverseBindPose != 0 && mHierarchy.Initialize(mJointCount, gPersistentArena) && mPalettes != 0 && mVisible != 0;
+	for (unsigned int i = 0; i < mPacketCount && allocated; ++i)
+	{
+		mPackets[i].visible = gPersistentArena->AllocateArray<unsigned char>(mCharacterCount);
+		allocated = mPackets[i].visible != 0;
+		if (allocated && mLivePalettes && UsesDualQuaternions())
+		{
+			mPackets[i].dualQuats = gPersistentArena->AllocateArray<dualquat>(mJointCount);
+			allocated = mPackets[i].dualQuats != 0;
+		}
+		else if (allocated && mLivePalettes)
+		{
+			mPackets[i].palettes = gPersistentArena->AllocateArray<mat4>(mJointCount);
+			allocated = mPackets[i].palettes != 0;
+		}
+	}
+	if (!allocated)
+	{
+		std::cout << "SkinningSample: the persistent arena is too small for " << mCharacterCount << " characters\n";
+		Shutdown();
+		return;
+	}
+
+	// The characters stand on a square grid, the bind pose is a straight chain so its inverse is just a translation down
+	for (unsigned int i = 0; i < mJointCount; ++i)
+	{
+		unsigned int k = i % kJointsPerCharacter;
+		unsigned int character = i / kJointsPerCharacter;
+		mPose->SetParent(i, (k == 0) ? -1 : (int)(i - 1));
+		vec3 offset = (k == 0) ? GetCharacterPosition(character) : vec3(0.0f, kSegmentLength, 0.0f);
+		mPose->SetLocal(i, offset, quat(), vec3(1, 1, 1));
+	}
+	for (unsigned int k = 0; k < kJointsPerCharacter; ++k)
+	{
+		mInverseBindPose[k] = mat4();
+		mInverseBindPose[k].ty = -(float)k * kSegmentLength;
+	}
+	memset(mVisible, 1, mCharacterCount);
+
+	BuildMesh();
+	if (mMode == SkinningMode::Gpu)
+	{
+		if (!mPalette.Initialize(kJointsPerCharacter, mPaletteSkeletons, mRequestedStorage, mMesh.GetSkinningMethod()))
+		{
+			std::cout << "SkinningSample: no GPU palette, falling back to CPU skinning\n";
+			mMode = SkinningMode::Cpu;
+		}
+	}
+	bool loaded = (mMode == SkinningMode::Gpu) ? mShader.Load(GetSkinnedVertexShader(mPalette, mInstanced), GetLitFragmentShader()) :
+		mShader.Load(GetStaticVertexShader(), GetLitFragmentShader());
+	if (!loaded || !mView.Initialize())
+	{
+		Shutdown();
+		return;
+	}
+	mView.ConfigureShader(mShader);
+	if (mMode == SkinningMode::Gpu) { mPalette.ConfigureShader(mShader); }
+
+	RenderMaterial material;
+	material.shader = &mShader;
+	material.mesh = &mMesh;
+	material.bind = &SkinningSample::BindMaterial;
+	material.drawSetup = &SkinningSample::SetupCharacter;
+	material.userData = this;
+	material.skinned = mMode == SkinningMode::Gpu;
+	material.cpuSkinned = mMode == SkinningMode::Cpu;
+	mQueue.Clear();
+	mMaterial = mQueue.AddMaterial(material);
+	if (mShowJoints && !mDebugDraw.Initialize(mJointCount * 2)) { mShowJoints = false; }
+
+	mReady = true;
+	std::cout << "SkinningSample: " << mCharacterCount << " characters, " << mMesh.GetVertexCount() << (mMesh.IsPacked() ? " packed" : "") << " vertices each, "
+		<< GetSkinningModeName(mMode) << " " << GetSkinningMethodName(mMesh.GetSkinningMethod()) << " skinning";
+	if (mMode == SkinningMode::Gpu) { std::cout << " (" << GetPaletteStorageName(mPalette.GetStorage()) << ")"; }
+	std::cout << "\n";
+}
+
+vec3 SkinningSample::GetCharacterPosition(unsigned int inCharacter) const
+{
+	unsigned int side = (unsigned int)ceilf(sqrtf((float)mCharacterCount));
+	return vec3((float)(inCharacter % side) * kSpacing, 0.0f, (float)(inCharacter / side) * kSpacing);
+}
+
+quat SkinningSample::GetSwayRotation(float inTime, unsigned int inCharacter, unsigned int inJoint)
+{
+	// Repeats every pi seconds, the root stays upright
+	if (inJoint == 0) { return quat(); }
+	float phase = (float)inCharacter * 0.7f + (float)inJoint * 0.4f;
+	return angleAxis(sinf(inTime * 2.0f + phase) * 0.15f, vec3(0, 0, 1));
+}
+
+void SkinningSample::Update(float inDeltaTime)
+{
+	if (!mReady || !mLivePalettes) { return; }
+	mTime += inDeltaTime;
+	{
+		PROFILE_SCOPE("Animate");
+		quat* rotations = mPose->GetRotations();
+		float time = mTime;
+		auto sway = [rotations, time](unsigned int inBegin, unsigned int inEnd)
+		{
+			for (unsigned int i = inBegin * kJointsPerCharacter; i < inEnd * kJointsPerCharacter; ++i)
+			{
+				rotations[i] = GetSwayRotation(time, i / kJointsPerCharacter, i % kJointsPerCharacter);
+			}
+		};
+		if (gJobSystem != 0) { gJobSystem->ParallelFor(mCharacterCount, kCharactersPerJob, sway); }
+		else { sway(0, mCharacterCount); }
+		// The roots never move, so they keep their world matrices from the first frame. The whole crowd is one hierarchy, so this stays serial
+		mHierarchy.Update(*mPose);
+	}
+	{
+		PROFILE_SCOPE("Palettes");
+		const mat4* world = mHierarchy.GetWorldMatrices();
+		const mat4* inverseBindPose = mInverseBindPose;
+		mat4* palettes = mPalettes;
+		auto skin = [world, inverseBindPose, palettes](unsigned int inBegin, unsigned int inEnd)
+		{
+			for (unsigned int c = inBegin; c < inEnd; ++c)
+			{
+				unsigned int first = c * kJointsPerCharacter;
+				MultiplyArray(world + first, inverseBindPose, palettes + first, kJointsPerCharacter);
+			}
+		};
+		if (gJobSystem != 0) { gJobSystem->ParallelFor(mCharacterCount, kCharactersPerJob, skin); }
+		else { skin(0, mCharacterCount); }
+	}
+}
+
+void SkinningSample::ExtractRenderData(unsigned int inPacket)
+{
+	if (!mReady || inPacket >= mPacketCount) { return; }
+	FramePacket& packet = mPackets[inPacket];
+	GetCamera(packet.eye, packet.target);
+	memcpy(packet.visible, mVisible, mCharacterCount);
+	if (!mLivePalettes) { return; }
+	// The conversion is done here so the render thread only copies
+	if (UsesDualQuaternions()) { Mat4ToDualQuatArray(mPalettes, packet.dualQuats, mJointCount); }
+	else { memcpy(packet.palettes, mPalettes, sizeof(mat4) * mJointCount); }
+}
+
+bool SkinningSample::UsesDualQuaternions() const
+{
+	return mMesh.GetSkinningMethod() == SkinningMethod::DualQuaternion;
+}
+
+void SkinningSample::UploadPalettes(const FramePacket& inPacket, unsigned int inSkeletonCount)
+{
+	if (UsesDualQuaternions()) { mPalette.Upload(inPacket.dualQuats, inSkeletonCount); }
+	else { mPalette.Upload(inPacket.palettes, inSkeletonCount); }
+}
+
+void SkinningSample::GetCamera(vec3& outEye, vec3& outTarget) const
+{
+	unsigned int side = (unsigned int)ceilf(sqrtf((float)mCharacterCount));
+	float extent = (float)(side > 0 ? side - 1 : 0) * kSpacing;
+	outTarget = vec3(extent * 0.5f, 2.0f, extent * 0.5f);
+	outEye = outTarget + vec3(0.0f, 4.0f + extent * 0.5f, 6.0f + extent);
+}
+
+float SkinningSample::GetFieldOfView()
+{
+	return kFieldOfView;
+}
+
+mat4 SkinningSample::GetViewProjection(const vec3& inEye, const vec3& inTarget, float inAspectRatio)
+{
+	return perspective(kFieldOfView, inAspectRatio, 0.1f, 1000.0f) * lookAt(inEye, inTarget, vec3(0, 1, 0));
+}
+
+void SkinningSample::Resize(int inWidth, int inHeight)
+{
+	if (inWidth > 0 && inHeight > 0) { mAspectRatio = (float)inWidth / (float)inHeight; }
+}
+
+void SkinningSample::RenderPacket(unsigned int inPacket, float inAspectRatio)
+{
+	if (!mReady || inPacket >= mPacketCount) { return; }
+	PROFILE_SCOPE("Skinning");
+	const FramePacket& packet = mPackets[inPacket];
+	// One upload for the whole crowd, each draw (& every viewport) only moves the palette binding
+	if (mMode == SkinningMode::Gpu) { UploadPalettes(packet, mCharacterCount); }
+	if (mShowJoints) { UploadJoints(packet); }
+	DrawPacket(packet, inAspectRatio);
+}
+
+void SkinningSample::RenderView(unsigned int inView, unsigned int inPacket, float inAspectRatio)
+{
+	if (!mReady || inPacket >= mPacketCount) { return; }
+	PROFILE_SCOPE("Skinning");
+	// The CPU path still skins every character again, its vertices are rewritten right before each draw
+	DrawPacket(mPackets[inPacket], inAspectRatio);
+}
+
+void SkinningSample::EndRenderPacket(unsigned int inPacket)
+{
+	// Streams that weren't written this frame ignore EndFrame()
+	mPalette.EndFrame();
+	mView.EndFrame();
+	mDebugDraw.EndFrame();
+}
+
+bool SkinningSample::HasDrawOnlyViews() const
+{
+	return true;
+}
+
+void SkinningSample::DrawPacket(const FramePacket& inPacket, float inAspectRatio)
+{
+	mat4 viewProjection = GetViewProjection(inPacket.eye, inPacket.target, inAspectRatio);
+	mRenderPacket = &inPacket;
+	mRenderViewProjection = viewProjection;
+	unsigned int drawn = 0;
+	if (mMaterial >= 0 && mQueue.Begin(mCharacterCount))
+	{
+		for (unsigned int c = 0; c < mCharacterCount; ++c)
+		{
+			if (!inPacket.visible[c]) { continue; }
+			mQueue.Submit((unsigned int)mMaterial, len(GetCharacterPosition(c) - inPacket.eye), c);
+			++drawn;
+		}
+		mQueue.Flush();
+	}
+	mRenderPacket = 0;
+	if (mShowJoints) { mDebugDraw.Draw(viewProjection); }
+	if (gProfiler != 0) { gProfiler->AddCounter("Skinned vertices", (float)(mMesh.GetVertexCount() * drawn)); }
+}
+
+void SkinningSample::BindMaterial(void* inUserData, Shader& inShader)
+{
+	SkinningSample* sample = (SkinningSample*)inUserData;
+	sample->mView.Upload(sample->mRenderViewProjection, normalized(vec3(-0.3f, -1.0f, -0.5f)), vec3(0.8f, 0.55f, 0.4f));
+}
+
+void SkinningSample::SetupCharacter(void* inUserData, Shader& inShader, unsigned int inCharacter)
+{
+	SkinningSample* sample = (SkinningSample*)inUserData;
+	if (sample->mMode == SkinningMode::Gpu)
+	{
+		sample->mPalette.Bind(inCharacter, inShader.GetUniform("uPaletteOffset"));
+		return;
+	}
+	// The skinned buffers are rewritten in place, the attributes the queue pointed at them stay valid
+	const FramePacket& packet = *sample->mRenderPacket;
+	if (sample->UsesDualQuaternions()) { sample->mMesh.CpuSkin(packet.dualQuats + inCharacter * kJointsPerCharacter); }
+	else { sample->mMesh.CpuSkin(packet.palettes + inCharacter * kJointsPerCharacter); }
+}
+
+void SkinningSample::UploadJoints(const FramePacket& inPacket)
+{
+	// A skin transform is world * inverse bind, so moving the bind position through it gives the joint's world position
+	for (unsigned int c = 0; c < mCharacterCount; ++c)
+	{
+		vec3 parent;
+		for (unsigned int k = 0; k < kJointsPerCharacter; ++k)
+		{
+			unsigned int index = c * kJointsPerCharacter + k;
+			vec3 bind(0.0f, (float)k * kSegmentLength, 0.0f);
+			vec3 joint = UsesDualQuaternions() ? transformPoint(inPacket.dualQuats[index], bind) : transformPoint(inPacket.palettes[index], bind);
+			if (k > 0) { mDebugDraw.AddLine(parent, joint, vec3(1.0f, 1.0f, 0.0f)); }
+			mDebugDraw.AddPoint(joint, vec3(1.0f, 0.2f, 0.2f));
+			parent = joint;
+		}
+	}
+	mDebugDraw.Upload();
+}
+
+void SkinningSample::Shutdown()
+{
+	mReady = false;
+	mPalette.Shutdown();
+	mView.Shutdown();
+	mDebugDraw.Shutdown();
+	mQueue.Clear();
+	mMaterial = -1;
+	mShader.Release();
+	mMesh.Release();
+	// The arrays belong to gPersistentArena, only the Pose object itself is on the heap
+	delete mPose;
+	mPose = 0;
+	mHierarchy.Release();
+	mInverseBindPose = 0;
+	mPalettes = 0;
+	mVisible = 0;
+	for (unsigned int i = 0; i < kMaxPackets; ++i)
+	{
+		mPackets[i].palettes = 0;
+		mPackets[i].dualQuats = 0;
+		mPackets[i].visible = 0;
+	}
+}
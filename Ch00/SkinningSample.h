@@ -0,0 +1,115 @@
+#pragma once
+#ifndef _H_SKINNINGSAMPLE_
+#define _H_SKINNINGSAMPLE_
+
+#include "Application.h"
+#include "Skinning.h"
+#include "SkinningPalette.h"
+#include "ViewUniforms.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "DebugDraw.h"
+#include "RenderQueue.h"
+#include "TransformHierarchy.h"
+#include "quat.h"
+#include "dualquat.h"
+#include <atomic>
+
+class Pose;
+
+/**
+* Skinned crowd (-sample=skinning)
+* Every character is a cylinder skinned to a chain of joints that sways a little differently from its neighbours
+* -characters=N sets the crowd size, -skinning=cpu|gpu picks the skinning path & -palette=auto|ubo|tbo where a GPU palette lives,
+* the mesh's SkinningMethod (-skinmethod=lbs|dqs) decides whether the packets carry matrices or dual quaternions
+* Update() writes the skin matrices of the whole crowd (the sway & the palettes are spread over gJobSystem), ExtractRenderData() copies them into the frame packet & RenderPacket()
+* uploads them once & submits one draw per character to a RenderQueue, which orders them front to back (see RenderQueue.h)
+* -showjoints draws every joint & bone on top with DebugDraw, -packedmesh uploads the mesh as 28 byte vertices (see PackedMesh.h)
+* Subclasses can move the camera (GetCamera()) & hide characters (mVisible), both are copied into the packet so
+* RenderPacket() skips the skinning & drawing of culled characters
+*/
+class SkinningSample : public Application
+{
+public:
+	static const unsigned int kJointsPerCharacter = 16;
+	static const unsigned int kMaxPackets = 3;
+	// Update() spreads the crowd over gJobSystem in batches of this many characters
+	static const unsigned int kCharactersPerJob = 16;
+protected:
+	struct FramePacket
+	{
+		// mCharacterCount * kJointsPerCharacter skin matrices or, for dual quaternion skinning, dual quaternions
+		mat4* palettes;
+		dualquat* dualQuats;
+		unsigned char* visible; // mCharacterCount flags
+		vec3 eye;
+		vec3 target;
+	};
+	unsigned int mCharacterCount;
+	unsigned int mJointCount;
+	SkinningMode mMode;
+	PaletteStorage mRequestedStorage;
+	Pose* mPose;
+	mat4* mInverseBindPose; // kJointsPerCharacter entries, shared by every character
+	TransformHierarchy mHierarchy; // World matrices of the whole crowd, only the swaying joints are recomputed
+	mat4* mPalettes;
+	FramePacket mPackets[kMaxPackets];
+	unsigned int mPacketCount;
+	Mesh mMesh;
+	Shader mShader;
+	SkinningPalette mPalette;
+	ViewUniforms mView;
+	DebugDraw mDebugDraw;
+	RenderQueue mQueue;
+	int mMaterial; // The skinned material in mQueue
+	// Only used by DrawPacket() & the material callbacks it runs
+	const FramePacket* mRenderPacket;
+	mat4 mRenderViewProjection;
+	bool mShowJoints;
+	bool mPackedMesh;
+	unsigned char* mVisible; // 1 for every character that should be drawn
+	// Written by Resize() on the render thread, read by Update() to build the culling frustum
+	std::atomic<float> mAspectRatio;
+	float mTime;
+	bool mReady;
+	// Set by subclasses before Initialize()
+	bool mInstanced; // Loads the instanced variant of the skinned shader
+	bool mLivePalettes; // Update() animates every joint & the packets carry a palette per character
+	unsigned int mPaletteSkeletons; // Palettes the GPU palette has room for, the character count by default
+protected:
+	void BuildMesh();
+	static float GetFieldOfView();
+	static mat4 GetViewProjection(const vec3& inEye, const vec3& inTarget, float inAspectRatio);
+	// Called on the update thread, the default camera frames the whole crowd
+	virtual void GetCamera(vec3& outEye, vec3& outTarget) const;
+	vec3 GetCharacterPosition(unsigned int inCharacter) const;
+	static quat GetSwayRotation(float inTime, unsigned int inCharacter, unsigned int inJoint);
+	// Joint positions are recovered from the skin transforms, so only the packet's palettes are needed
+	void UploadJoints(const FramePacket& inPacket);
+	// Draws a packet whose per frame data was already uploaded, once for the main view & once per viewport
+	void DrawPacket(const FramePacket& inPacket, float inAspectRatio);
+	// Uploads whichever palette the packet carries into mPalette
+	void UploadPalettes(const FramePacket& inPacket, unsigned int inSkeletonCount);
+	bool UsesDualQuaternions() const;
+	// RenderMaterial callbacks, inUserData is the sample
+	static void BindMaterial(void* inUserData, Shader& inShader);
+	static void SetupCharacter(void* inUserData, Shader& inShader, unsigned int inCharacter);
+public:
+	SkinningSample(unsigned int inCharacterCount, SkinningMode inMode, PaletteStorage inStorage);
+	~SkinningSample();
+	void SetShowJoints(bool inShow);
+	// Before Initialize()
+	void SetPackedMesh(bool inPacked);
+	void SetRenderPacketCount(unsigned int inCount);
+	void Initialize();
+	void Update(float inDeltaTime);
+	void ExtractRenderData(unsigned int inPacket);
+	void RenderPacket(unsigned int inPacket, float inAspectRatio);
+	void RenderView(unsigned int inView, unsigned int inPacket, float inAspectRatio);
+	void EndRenderPacket(unsigned int inPacket);
+	bool HasDrawOnlyViews() const;
+	void Resize(int inWidth, int inHeight);
+	void Shutdown();
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include "StreamBuffer.h"
+#include "GLLoader.h"
+#include "RenderState.h"
+#include "FrameProfiler.h"
+#include "FrameClock.h"
+#include <cstring>
+#include <iostream>
+
+// GL_ARB_buffer_storage isn't part of the generated 3.3 core glad, the entry point comes from GLLoader
+#ifndef GL_MAP_PERSISTENT_BIT
+	#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+	#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+StreamBufferMode gDefaultStreamBufferMode = StreamBufferMode::Auto;
+
+StreamBuffer::StreamBuffer()
+{
+	mTarget = GL_ARRAY_BUFFER;
+	mBuffer = 0;
+	mMode = StreamBufferMode::Auto;
+	mRegionSize = 0;
+	mRegion = 0;
+	mHead = 0;
+	for (unsigned int i = 0; i < kRegionCount; ++i) { mFences[i] = 0; }
+	mPersistent = 0;
+	mMapped = false;
+	mInFrame = false;
+	mOverflowReported = false;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	Shutdown();
+}
+
+bool StreamBuffer::Initialize(GLenum inTarget, GLsizeiptr inBytesPerFrame, StreamBufferMode inMode)
+{
+	Shutdown();
+	if (inBytesPerFrame <= 0) { return false; }
+
+	mMode = (inMode == StreamBufferMode::Auto) ? gDefaultStreamBufferMode : inMode;
+	BufferStorageProc bufferStorage = (BufferStorageProc)GetGLProcAddress("glBufferStorage");
+	bool hasBufferStorage = bufferStorage != 0 && IsGLExtensionSupported("GL_ARB_buffer_storage");
+	if (mMode == StreamBufferMode::Auto) { mMode = hasBufferStorage ? StreamBufferMode::Persistent : StreamBufferMode::Unsynchronized; }
+	else if (mMode == StreamBufferMode::Persistent && !hasBufferStorage) { mMode = StreamBufferMode::Unsynchronized; }
+
+	mTarget = inTarget;
+	// Keep every region 256 byte aligned so uniform ranges can start at the beginning of any of them
+	mRegionSize = (inBytesPerFrame + 255) & ~(GLsizeiptr)255;
+	GLsizeiptr size = (mMode == StreamBufferMode::Orphan) ? mRegionSize : mRegionSize * kRegionCount;
+
+	glGenBuffers(1, &mBuffer);
+	gRenderState->BindBuffer(mTarget, mBuffer);
+	if (mMode == StreamBufferMode::Persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		bufferStorage(mTarget, size, NULL, flags);
+		mPersistent = (unsigned char*)glMapBufferRange(mTarget, 0, size, flags);
+		if (mPersistent == 0)
+		{
+			std::cout << "StreamBuffer: persistent map failed, using unsynchronized maps\n";
+			if (gRenderState != 0) { gRenderState->OnBufferDeleted(mBuffer); }
+			glDeleteBuffers(1, &mBuffer);
+			mBuffer = 0;
+			return Initialize(inTarget, inBytesPerFrame, StreamBufferMode::Unsynchronized);
+		}
+	}
+	else
+	{
+		glBufferData(mTarget, size, NULL, GL_STREAM_DRAW);
+	}
+	mRegion = 0;
+	mHead = 0;
+	return true;
+}
+
+void StreamBuffer::Shutdown()
+{
+	for (unsigned int i = 0; i < kRegionCount; ++i)
+	{
+		if (mFences[i] != 0)
+		{
+			glDeleteSync(mFences[i]);
+			mFences[i] = 0;
+		}
+	}
+	if (mBuffer != 0)
+	{
+		if (mPersistent != 0 || mMapped)
+		{
+			gRenderState->BindBuffer(mTarget, mBuffer);
+			glUnmapBuffer(mTarget);
+		}
+		if (gRenderState != 0) { gRenderState->OnBufferDeleted(mBuffer); }
+		glDeleteBuffers(1, &mBuffer);
+		mBuffer = 0;
+	}
+	mPersistent = 0;
+	mMapped = false;
+	mInFrame = false;
+	mHead = 0;
+}
+
+bool StreamBuffer::WaitForFence(GLsync inFence)
+{
+	// Same as FramePacer, flush on the first wait & give up after a second so a lost device can't hang the loop
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	const GLuint64 timeout = 1000000;
+	GLenum result = GL_TIMEOUT_EXPIRED;
+	for (unsigned int attempt = 0; attempt < 1000 && result == GL_TIMEOUT_EXPIRED; ++attempt)
+	{
+		result = glClientWaitSync(inFence, flags, timeout);
+		flags = 0;
+	}
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void StreamBuffer::BeginFrame()
+{
+	if (mBuffer == 0) { return; }
+	if (mInFrame) { EndFrame(); }
+	mInFrame = true;
+	mHead = 0;
+
+	if (mMode == StreamBufferMode::Orphan)
+	{
+		gRenderState->BindBuffer(mTarget, mBuffer);
+		glBufferData(mTarget, mRegionSize, NULL, GL_STREAM_DRAW);
+		return;
+	}
+	if (mFences[mRegion] != 0)
+	{
+		// With 3 regions the GPU is almost always done with this one, any time spent here is a real stall
+		long long start = FrameClock::Now();
+		if (!WaitForFence(mFences[mRegion]))
+		{
+			// The region may still be read by the GPU, overwriting it is better than hanging
+			std::cout << "StreamBuffer: gave up waiting on the fence of region " << mRegion << "\n";
+			if (gProfiler != 0) { gProfiler->AddCounter("Stream buffer fence timeouts", 1.0f); }
+		}
+		glDeleteSync(mFences[mRegion]);
+		mFences[mRegion] = 0;
+		if (gProfiler != 0) { gProfiler->AddCounter("Stream buffer wait ms", (float)(FrameClock::ToSeconds(FrameClock::Now() - start) * 1000.0)); }
+	}
+}
+
+void* StreamBuffer::Map(GLsizeiptr inSize, GLsizeiptr inAlignment, GLintptr& outOffset)
+{
+	if (mBuffer == 0 || inSize <= 0) { return 0; }
+	if (!mInFrame) { BeginFrame(); }
+	if (mMapped) { Unmap(); }
+
+	GLsizeiptr start = (mHead + inAlignment - 1) & ~(inAlignment - 1);
+	if (start + inSize > mRegionSize)
+	{
+		if (!mOverflowReported)
+		{
+			std::cout << "StreamBuffer: " << start + inSize << " bytes in one frame, the region only holds " << mRegionSize << "\n";
+			mOverflowReported = true;
+		}
+		return 0;
+	}
+	mHead = start + inSize;
+	GLsizeiptr regionStart = (mMode == StreamBufferMode::Orphan) ? 0 : mRegionSize * mRegion;
+	outOffset = (GLintptr)(regionStart + start);
+
+	gRenderState->BindBuffer(mTarget, mBuffer);
+	if (mMode == StreamBufferMode::Persistent) { return mPersistent + outOffset; }
+
+	// The fence (or the orphaned storage) already guarantees nothing reads this range, so the driver doesn't need to check
+	void* result = glMapBufferRange(mTarget, outOffset, inSize, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	mMapped = result != 0;
+	return result;
+}
+
+void StreamBuffer::Unmap()
+{
+	if (!mMapped) { return; }
+	gRenderState->BindBuffer(mTarget, mBuffer);
+	glUnmapBuffer(mTarget);
+	mMapped = false;
+}
+
+void StreamBuffer::EndFrame()
+{
+	if (mBuffer == 0 || !mInFrame) { return; }
+	if (mMapped) { Unmap(); }
+	mInFrame = false;
+	if (mMode == StreamBufferMode::Orphan) { return; }
+	mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	mRegion = (mRegion + 1) % kRegionCount;
+}
+
+GLuint StreamBuffer::GetBuffer() const
+{
+	return mBuffer;
+}
+
+GLenum StreamBuffer::GetTarget() const
+{
+	return mTarget;
+}
+
+StreamBufferMode StreamBuffer::GetMode() const
+{
+	return mMode;
+}
+
+GLsizeiptr StreamBuffer::GetRegionSize() const
+{
+	return mRegionSize;
+}
+
+GLsizeiptr StreamBuffer::GetUsed() const
+{
+	return mHead;
+}
+
+StreamBufferMode ParseStreamBufferMode(const char* inName, StreamBufferMode inDefault)
+{
+	if (inName == 0) { return inDefault; }
+	if (strcmp(inName, "auto") == 0) { return StreamBufferMode::Auto; }
+	if (strcmp(inName, "orphan") == 0) { return StreamBufferMode::Orphan; }
+	if (strcmp(inName, "unsync") == 0) { return StreamBufferMode::Unsynchronized; }
+	if (strcmp(inName, "persistent") == 0) { return StreamBufferMode::Persistent; }
+	return inDefault;
+}
+
+const char* GetStreamBufferModeName(StreamBufferMode inMode)
+{
+	switch (inMode)
+	{
+	case StreamBufferMode::Orphan: return "orphan";
+	case StreamBufferMode::Unsynchronized: return "unsync";
+	case StreamBufferMode::Persistent: return "persistent";
+	default: return "auto";
+	}
+}
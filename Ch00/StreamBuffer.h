@@ -0,0 +1,88 @@
+#pragma once
+#ifndef _H_STREAMBUFFER_
+#define _H_STREAMBUFFER_
+
+#include "include/glad/glad.h"
+
+/**
+* How a StreamBuffer gets CPU written data to the GPU without the driver synchronizing behind our back
+* Orphan - glBufferData(NULL) at the start of every frame, the driver swaps in fresh storage while the old one drains
+* Unsynchronized - 3 regions used round robin, each mapped with GL_MAP_UNSYNCHRONIZED_BIT & protected by a fence from the frame
+*   that last wrote it, so the map never waits on the GPU unless it's a full ring behind
+* Persistent - same ring, but the whole buffer is allocated with glBufferStorage (GL_ARB_buffer_storage) & mapped once,
+*   coherent & persistent, so writing is a plain memcpy without any map calls
+* Auto picks Persistent when the extension is there & Unsynchronized otherwise
+*/
+enum class StreamBufferMode
+{
+	Auto,
+	Orphan,
+	Unsynchronized,
+	Persistent
+};
+
+/**
+* StreamBuffer is a ring for data that's rewritten every frame (skin palettes, instance arrays, debug geometry, per frame uniforms)
+* Usage, all on the thread that renders:
+*   BeginFrame() - waits for the fence of the region that is about to be reused
+*   Map() / Unmap() - any number of times, each Map() hands out the next aligned piece of this frame's region
+*   EndFrame() - after the draws that read this frame's data were issued, fences the region
+* The offsets Map() returns are from the start of the buffer, they're what glVertexAttribPointer / glBindBufferRange need
+*/
+class StreamBuffer
+{
+public:
+	static const unsigned int kRegionCount = 3;
+private:
+	GLenum mTarget;
+	GLuint mBuffer;
+	StreamBufferMode mMode;
+	GLsizeiptr mRegionSize;
+	unsigned int mRegion;
+	GLsizeiptr mHead; // Bytes used in the current region
+	GLsync mFences[kRegionCount];
+	unsigned char* mPersistent; // Start of the buffer in Persistent mode
+	bool mMapped;
+	bool mInFrame;
+	bool mOverflowReported;
+private:
+	StreamBuffer(const StreamBuffer&);
+	StreamBuffer& operator=(const StreamBuffer&);
+	// False when the fence wasn't signaled within a second or the wait failed
+	static bool WaitForFence(GLsync inFence);
+public:
+	StreamBuffer();
+	~StreamBuffer();
+
+	// inBytesPerFrame is the most one frame can Map() (including alignment padding), needs a current context
+	bool Initialize(GLenum inTarget, GLsizeiptr inBytesPerFrame, StreamBufferMode inMode);
+	void Shutdown();
+
+	void BeginFrame();
+	/**
+	* Returns a write only pointer to inSize bytes & their offset in the buffer, or 0 if this frame's region is full
+	* inAlignment has to be a power of 2 (16 for vertex data, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform ranges)
+	* The buffer is bound to its target through gRenderState when this returns
+	*/
+	void* Map(GLsizeiptr inSize, GLsizeiptr inAlignment, GLintptr& outOffset);
+	void Unmap();
+	void EndFrame();
+
+	GLuint GetBuffer() const;
+	GLenum GetTarget() const;
+	StreamBufferMode GetMode() const;
+	GLsizeiptr GetRegionSize() const;
+	GLsizeiptr GetUsed() const;
+};
+
+// Parses auto, orphan, unsync or persistent, returns inDefault for anything else
+StreamBufferMode ParseStreamBufferMode(const char* inName, StreamBufferMode inDefault);
+const char* GetStreamBufferModeName(StreamBufferMode inMode);
+
+/**
+* The mode every StreamBuffer created with Auto uses, WinMain sets it from -streaming=mode once the extensions are loaded
+* Persistent falls back to Unsynchronized when GL_ARB_buffer_storage isn't available
+*/
+extern StreamBufferMode gDefaultStreamBufferMode;
+
+#endif
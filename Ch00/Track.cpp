@@ -0,0 +1,291 @@
+#include "Track.h"
+#include <algorithm>
+#include <cmath>
+
+namespace TrackHelpers
+{
+	inline float Interpolate(float a, float b, float t) { return a + (b - a) * t; }
+	inline vec3 Interpolate(const vec3& a, const vec3& b, float t) { return lerp(a, b, t); }
+	inline quat Interpolate(const quat& a, const quat& b, float t) { return nlerp(a, b, t); }
+
+	// Hermite results of quaternions have to be normalized, the other types are used as is
+	inline float AdjustHermiteResult(float f) { return f; }
+	inline vec3 AdjustHermiteResult(const vec3& v) { return v; }
+	inline quat AdjustHermiteResult(const quat& q) { return normalized(q); }
+
+	// Quaternions take the shortest arc, so the second key is flipped into the first one's hemisphere
+	inline void Neighborhood(const float&, float&) {}
+	inline void Neighborhood(const vec3&, vec3&) {}
+	inline void Neighborhood(const quat& a, quat& b)
+	{
+		if (dot(a, b) < 0.0f) { b = -b; }
+	}
+
+	inline float Scale(float f, float s) { return f * s; }
+	inline vec3 Scale(const vec3& v, float s) { return v * s; }
+	inline quat Scale(const quat& q, float s) { return q * s; }
+}
+
+template<> float Track<float, 1>::Cast(const float* inValue) { return inValue[0]; }
+template<> vec3 Track<vec3, 3>::Cast(const float* inValue) { return vec3(inValue[0], inValue[1], inValue[2]); }
+template<> quat Track<quat, 4>::Cast(const float* inValue) { return normalized(quat(inValue[0], inValue[1], inValue[2], inValue[3])); }
+
+template<> void Track<float, 1>::Store(const float& inValue, float* outValue) { outValue[0] = inValue; }
+template<> void Track<vec3, 3>::Store(const vec3& inValue, float* outValue)
+{
+	outValue[0] = inValue.x;
+	outValue[1] = inValue.y;
+	outValue[2] = inValue.z;
+}
+template<> void Track<quat, 4>::Store(const quat& inValue, float* outValue)
+{
+	outValue[0] = inValue.x;
+	outValue[1] = inValue.y;
+	outValue[2] = inValue.z;
+	outValue[3] = inValue.w;
+}
+
+template<typename T, int N>
+Track<T, N>::Track()
+{
+	mInterpolation = Interpolation::Linear;
+	mUniformRate = 0.0f;
+}
+
+template<typename T, int N>
+void Track<T, N>::Resize(unsigned int inKeyCount)
+{
+	mTimes.resize(inKeyCount, 0.0f);
+	mValues.resize(inKeyCount * N, 0.0f);
+	mInTangents.resize(inKeyCount * N, 0.0f);
+	mOutTangents.resize(inKeyCount * N, 0.0f);
+	mUniformRate = 0.0f;
+}
+
+template<typename T, int N>
+unsigned int Track<T, N>::Size() const
+{
+	return (unsigned int)mTimes.size();
+}
+
+template<typename T, int N>
+void Track<T, N>::SetKey(unsigned int inIndex, float inTime, const T& inValue)
+{
+	mTimes[inIndex] = inTime;
+	Store(inValue, &mValues[inIndex * N]);
+	mUniformRate = 0.0f;
+}
+
+template<typename T, int N>
+void Track<T, N>::SetKey(unsigned int inIndex, float inTime, const T& inValue, const T& inInTangent, const T& inOutTangent)
+{
+	SetKey(inIndex, inTime, inValue);
+	// Tangents aren't unit quaternions, so they're stored without going through Cast()'s normalization
+	for (int i = 0; i < N; ++i)
+	{
+		mInTangents[inIndex * N + i] = ((const float*)&inInTangent)[i];
+		mOutTangents[inIndex * N + i] = ((const float*)&inOutTangent)[i];
+	}
+}
+
+template<typename T, int N>
+float Track<T, N>::GetTime(unsigned int inIndex) const
+{
+	return mTimes[inIndex];
+}
+
+template<typename T, int N>
+T Track<T, N>::GetValue(unsigned int inIndex) const
+{
+	return Cast(&mValues[inIndex * N]);
+}
+
+template<typename T, int N>
+const float* Track<T, N>::GetTimes() const
+{
+	return mTimes.empty() ? 0 : &mTimes[0];
+}
+
+template<typename T, int N>
+const float* Track<T, N>::GetValues() const
+{
+	return mValues.empty() ? 0 : &mValues[0];
+}
+
+template<typename T, int N>
+Interpolation Track<T, N>::GetInterpolation() const
+{
+	return mInterpolation;
+}
+
+template<typename T, int N>
+void Track<T, N>::SetInterpolation(Interpolation inInterpolation)
+{
+	mInterpolation = inInterpolation;
+}
+
+template<typename T, int N>
+float Track<T, N>::GetStartTime() const
+{
+	return mTimes.empty() ? 0.0f : mTimes.front();
+}
+
+template<typename T, int N>
+float Track<T, N>::GetEndTime() const
+{
+	return mTimes.empty() ? 0.0f : mTimes.back();
+}
+
+template<typename T, int N>
+float Track<T, N>::AdjustTime(float inTime, bool inLooping) const
+{
+	float start = mTimes.front();
+	float end = mTimes.back();
+	float duration = end - start;
+	if (duration <= 0.0f) { return start; }
+	if (inLooping)
+	{
+		float time = fmodf(inTime - start, duration);
+		if (time < 0.0f) { time += duration; }
+		return time + start;
+	}
+	if (inTime < start) { return start; }
+	if (inTime > end) { return end; }
+	return inTime;
+}
+
+template<typename T, int N>
+unsigned int Track<T, N>::FindKey(float inTime, TrackCursor* ioCursor) const
+{
+	// Returns the key the segment [key, key + 1] starts at, inTime is already inside the track
+	unsigned int last = (unsigned int)mTimes.size() - 2;
+	if (ioCursor != 0)
+	{
+		unsigned int key = ioCursor->key <= last ? ioCursor->key : last;
+		if (inTime >= mTimes[key])
+		{
+			if (key == last || inTime < mTimes[key + 1]) { return key; }
+			if (key + 1 == last || inTime < mTimes[key + 2])
+			{
+				ioCursor->key = key + 1;
+				return key + 1;
+			}
+		}
+	}
+
+	// Last key whose time is <= inTime
+	const float* begin = &mTimes[0];
+	const float* found = std::upper_bound(begin, begin + mTimes.size(), inTime);
+	unsigned int key = found == begin ? 0 : (unsigned int)(found - begin) - 1;
+	if (key > last) { key = last; }
+	if (ioCursor != 0) { ioCursor->key = key; }
+	return key;
+}
+
+template<typename T, int N>
+T Track<T, N>::SampleKeys(unsigned int inKey, float inTime) const
+{
+	float segment = mTimes[inKey + 1] - mTimes[inKey];
+	float t = segment > 0.0f ? (inTime - mTimes[inKey]) / segment : 0.0f;
+	if (t > 1.0f) { t = 1.0f; }
+
+	// Step keys hold until the next key's time, which also makes the end time of a clamped track land on the last key
+	if (mInterpolation == Interpolation::Constant) { return Cast(&mValues[(inTime >= mTimes[inKey + 1] ? inKey + 1 : inKey) * N]); }
+
+	T p1 = Cast(&mValues[inKey * N]);
+	T p2 = Cast(&mValues[(inKey + 1) * N]);
+	if (mInterpolation == Interpolation::Linear) { return TrackHelpers::Interpolate(p1, p2, t); }
+
+	// Tangents are per second, scaled by the segment length like the glTF cubic spline
+	T s1;
+	T s2;
+	for (int i = 0; i < N; ++i)
+	{
+		((float*)&s1)[i] = mOutTangents[inKey * N + i] * segment;
+		((float*)&s2)[i] = mInTangents[(inKey + 1) * N + i] * segment;
+	}
+	TrackHelpers::Neighborhood(p1, p2);
+
+	float tt = t * t;
+	float ttt = tt * t;
+	float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
+	float h2 = -2.0f * ttt + 3.0f * tt;
+	float h3 = ttt - 2.0f * tt + t;
+	float h4 = ttt - tt;
+	T result = TrackHelpers::Scale(p1, h1) + TrackHelpers::Scale(p2, h2) + TrackHelpers::Scale(s1, h3) + TrackHelpers::Scale(s2, h4);
+	return TrackHelpers::AdjustHermiteResult(result);
+}
+
+template<typename T, int N>
+T Track<T, N>::Sample(float inTime, bool inLooping, TrackCursor& ioCursor) const
+{
+	unsigned int size = (unsigned int)mTimes.size();
+	if (size == 0) { return T(); }
+	if (size == 1) { return Cast(&mValues[0]); }
+
+	float time = AdjustTime(inTime, inLooping);
+	if (mUniformRate > 0.0f)
+	{
+		// Evenly spaced keys, the segment is just the scaled time
+		float frame = (time - mTimes[0]) * mUniformRate;
+		unsigned int key = (unsigned int)frame;
+		if (key > size - 2) { key = size - 2; }
+		return SampleKeys(key, time);
+	}
+	return SampleKeys(FindKey(time, &ioCursor), time);
+}
+
+template<typename T, int N>
+T Track<T, N>::Sample(float inTime, bool inLooping) const
+{
+	unsigned int size = (unsigned int)mTimes.size();
+	if (size == 0) { return T(); }
+	if (size == 1) { return Cast(&mValues[0]); }
+	if (mUniformRate > 0.0f)
+	{
+		TrackCursor cursor;
+		return Sample(inTime, inLooping, cursor);
+	}
+
+	float time = AdjustTime(inTime, inLooping);
+	return SampleKeys(FindKey(time, 0), time);
+}
+
+template<typename T, int N>
+void Track<T, N>::ResampleUniform(float inSampleRate)
+{
+	if (mTimes.size() < 2 || inSampleRate <= 0.0f) { return; }
+
+	float start = mTimes.front();
+	float duration = mTimes.back() - start;
+	unsigned int count = (unsigned int)ceilf(duration * inSampleRate) + 1;
+	if (count < 2) { count = 2; }
+	float interval = duration / (float)(count - 1);
+
+	std::vector<float> times(count);
+	std::vector<float> values(count * N);
+	TrackCursor cursor;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		times[i] = (i == count - 1) ? mTimes.back() : start + interval * (float)i;
+		Store(Sample(times[i], false, cursor), &values[i * N]);
+	}
+
+	mTimes.swap(times);
+	mValues.swap(values);
+	mInTangents.assign(count * N, 0.0f);
+	mOutTangents.assign(count * N, 0.0f);
+	if (mInterpolation == Interpolation::Cubic) { mInterpolation = Interpolation::Linear; }
+	mUniformRate = interval > 0.0f ? 1.0f / interval : 0.0f;
+}
+
+template<typename T, int N>
+bool Track<T, N>::IsUniform() const
+{
+	return mUniformRate > 0.0f;
+}
+
+// Only these three are used, instantiating them here keeps the implementation out of the header
+template class Track<float, 1>;
+template class Track<vec3, 3>;
+template class Track<quat, 4>;
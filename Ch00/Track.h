@@ -0,0 +1,83 @@
+#pragma once
+#ifndef _H_TRACK_
+#define _H_TRACK_
+
+#include <vector>
+#include "vec3.h"
+#include "quat.h"
+
+enum class Interpolation
+{
+	Constant,
+	Linear,
+	Cubic // Hermite, uses the in & out tangents of every key
+};
+
+/**
+* Playback state of one track for one animation instance
+* Playback mostly moves forward a little every frame, so the key found last time (or the one after it) is almost always
+* the right one & the binary search only runs after a jump or a loop
+*/
+struct TrackCursor
+{
+	unsigned int key;
+	inline TrackCursor() : key(0) {}
+};
+
+/**
+* Keyframed curve with N floats per key (1 for scalars, 3 for vec3, 4 for quat)
+* Times, values & tangents are kept in separate arrays so the key search only touches the times
+* ResampleUniform() bakes the curve onto evenly spaced keys, after that sampling is an index computation & no search at all
+*/
+template<typename T, int N>
+class Track
+{
+protected:
+	std::vector<float> mTimes;
+	std::vector<float> mValues; // N floats per key
+	std::vector<float> mInTangents; // N floats per key, only used by cubic tracks
+	std::vector<float> mOutTangents;
+	Interpolation mInterpolation;
+	float mUniformRate; // Keys per second once resampled, 0 otherwise
+protected:
+	float AdjustTime(float inTime, bool inLooping) const;
+	unsigned int FindKey(float inTime, TrackCursor* ioCursor) const;
+	T SampleKeys(unsigned int inKey, float inTime) const;
+	static T Cast(const float* inValue);
+	static void Store(const T& inValue, float* outValue);
+public:
+	Track();
+
+	void Resize(unsigned int inKeyCount);
+	unsigned int Size() const;
+	// Keys have to be added in increasing time order
+	void SetKey(unsigned int inIndex, float inTime, const T& inValue);
+	void SetKey(unsigned int inIndex, float inTime, const T& inValue, const T& inInTangent, const T& inOutTangent);
+	float GetTime(unsigned int inIndex) const;
+	T GetValue(unsigned int inIndex) const;
+	const float* GetTimes() const;
+	const float* GetValues() const;
+
+	Interpolation GetInterpolation() const;
+	void SetInterpolation(Interpolation inInterpolation);
+	float GetStartTime() const;
+	float GetEndTime() const;
+
+	// inTime outside the track is looped or clamped, tracks without keys return a default T
+	T Sample(float inTime, bool inLooping, TrackCursor& ioCursor) const;
+	// Same result without a cursor, always binary searches
+	T Sample(float inTime, bool inLooping) const;
+
+	/**
+	* Replaces the keys with samples taken every 1 / inSampleRate seconds (the last one lands on the end time)
+	* Cubic tracks become linear, so the rate has to be high enough for the curve (30 to 60 is usually plenty)
+	*/
+	void ResampleUniform(float inSampleRate);
+	bool IsUniform() const;
+};
+
+typedef Track<float, 1> ScalarTrack;
+typedef Track<vec3, 3> VectorTrack;
+typedef Track<quat, 4> QuaternionTrack;
+
+#endif
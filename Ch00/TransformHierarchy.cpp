@@ -0,0 +1,178 @@
+#include "TransformHierarchy.h"
+#include "Pose.h"
+#include "Arena.h"
+#include "FrameProfiler.h"
+#include <cstring>
+#include <iostream>
+
+TransformHierarchy::TransformHierarchy()
+{
+	mMemory = 0;
+	mJointCount = 0;
+	mPositions = 0;
+	mRotations = 0;
+	mScales = 0;
+	mLocalMatrices = 0;
+	mWorldMatrices = 0;
+	mDirty = 0;
+	mRecomputed = 0;
+	mSkipped = 0;
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+	Release();
+}
+
+bool TransformHierarchy::Initialize(unsigned int inJointCount, LinearArena* inArena)
+{
+	Release();
+	if (inJointCount == 0) { return true; }
+	// Everything but the flags is 16 byte aligned & a multiple of 16 bytes per joint, so the arrays can follow each other
+	size_t size = (sizeof(vec3) * 2 + sizeof(quat) + sizeof(mat4) * 2 + 1) * (size_t)inJointCount;
+	unsigned char* block = 0;
+	if (inArena != 0) { block = (unsigned char*)inArena->Allocate(size, 16); }
+	else
+	{
+		mMemory = new unsigned char[size + 15];
+		block = (unsigned char*)(((size_t)mMemory + 15) & ~(size_t)15);
+	}
+	if (block == 0)
+	{
+		std::cout << "TransformHierarchy: no room for " << inJointCount << " joints\n";
+		return false;
+	}
+	mJointCount = inJointCount;
+	mWorldMatrices = (mat4*)block;
+	mLocalMatrices = mWorldMatrices + inJointCount;
+	mPositions = (vec3*)(mLocalMatrices + inJointCount);
+	mRotations = (quat*)(mPositions + inJointCount);
+	mScales = (vec3*)(mRotations + inJointCount);
+	mDirty = (unsigned char*)(mScales + inJointCount);
+	MarkAllDirty();
+	return true;
+}
+
+void TransformHierarchy::Release()
+{
+	delete[] mMemory;
+	mMemory = 0;
+	mJointCount = 0;
+	mPositions = 0;
+	mRotations = 0;
+	mScales = 0;
+	mLocalMatrices = 0;
+	mWorldMatrices = 0;
+	mDirty = 0;
+	mRecomputed = 0;
+	mSkipped = 0;
+}
+
+unsigned int TransformHierarchy::Size() const
+{
+	return mJointCount;
+}
+
+void TransformHierarchy::MarkDirty(unsigned int inJoint)
+{
+	if (inJoint < mJointCount) { mDirty[inJoint] = 1; }
+}
+
+void TransformHierarchy::MarkAllDirty()
+{
+	if (mDirty != 0) { memset(mDirty, 1, mJointCount); }
+}
+
+static inline bool SameVector(const vec3& a, const vec3& b)
+{
+#if MATH_SSE
+	// The padding lane isn't part of the value & may hold anything
+	return (_mm_movemask_ps(_mm_cmpneq_ps(_mm_load_ps(a.v), _mm_load_ps(b.v))) & 7) == 0;
+#else
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+#endif
+}
+
+static inline bool SameQuaternion(const quat& a, const quat& b)
+{
+#if MATH_SSE
+	return _mm_movemask_ps(_mm_cmpneq_ps(_mm_load_ps(a.v), _mm_load_ps(b.v))) == 0;
+#else
+	return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+#endif
+}
+
+unsigned int TransformHierarchy::Update(const Pose& inPose)
+{
+	if (inPose.Size() < mJointCount)
+	{
+		std::cout << "TransformHierarchy: the pose has " << inPose.Size() << " joints, " << mJointCount << " expected\n";
+		return 0;
+	}
+	{
+		PROFILE_SCOPE("Hierarchy dirty flags");
+		const vec3* positions = inPose.GetPositions();
+		const quat* rotations = inPose.GetRotations();
+		const vec3* scales = inPose.GetScales();
+		const int* parents = inPose.GetParents();
+		// Exact compares on purpose: anything that changed at all has to be recomputed, NaNs just stay dirty
+		for (unsigned int i = 0; i < mJointCount; ++i)
+		{
+			bool changed = !SameVector(positions[i], mPositions[i]) || !SameQuaternion(rotations[i], mRotations[i]) || !SameVector(scales[i], mScales[i]);
+			if (changed)
+			{
+				mPositions[i] = positions[i];
+				mRotations[i] = rotations[i];
+				mScales[i] = scales[i];
+			}
+			int parent = parents[i];
+			mDirty[i] = (mDirty[i] | (unsigned char)changed | (parent >= 0 ? mDirty[parent] : 0)) != 0 ? 1 : 0;
+		}
+	}
+
+	PROFILE_SCOPE("Hierarchy world matrices");
+	const int* parents = inPose.GetParents();
+	unsigned int recomputed = 0;
+	unsigned int i = 0;
+	while (i < mJointCount)
+	{
+		if (!mDirty[i]) { ++i; continue; }
+		// The run ends at the first clean joint or the first one with another parent. None of its joints can be the parent of another
+		int parent = parents[i];
+		unsigned int run = 1;
+		while (i + run < mJointCount && mDirty[i + run] && parents[i + run] == parent) { ++run; }
+		if (parent < 0) { inPose.GetLocalMatrices(i, run, mWorldMatrices + i); }
+		else
+		{
+			inPose.GetLocalMatrices(i, run, mLocalMatrices + i);
+			MultiplyArray(mWorldMatrices[parent], mLocalMatrices + i, mWorldMatrices + i, run);
+		}
+		memset(mDirty + i, 0, run);
+		recomputed += run;
+		i += run;
+	}
+
+	mRecomputed = recomputed;
+	mSkipped = mJointCount - recomputed;
+	if (gProfiler != 0)
+	{
+		gProfiler->AddCounter("World matrices recomputed", (float)mRecomputed);
+		gProfiler->AddCounter("World matrices skipped", (float)mSkipped);
+	}
+	return recomputed;
+}
+
+const mat4* TransformHierarchy::GetWorldMatrices() const
+{
+	return mWorldMatrices;
+}
+
+unsigned int TransformHierarchy::GetRecomputedCount() const
+{
+	return mRecomputed;
+}
+
+unsigned int TransformHierarchy::GetSkippedCount() const
+{
+	return mSkipped;
+}
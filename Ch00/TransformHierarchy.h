@@ -0,0 +1,61 @@
+#pragma once
+#ifndef _H_TRANSFORMHIERARCHY_
+#define _H_TRANSFORMHIERARCHY_
+
+#include "vec3.h"
+#include "quat.h"
+#include "mat4.h"
+
+class Pose;
+class LinearArena;
+
+/**
+* Keeps the world matrices of a pose between frames & only recomputes the ones that changed
+* Update() compares every joint's local transform with the one it saw last time, a joint is dirty if its own transform changed,
+* if it was marked with MarkDirty() or if its parent is dirty. Since parents come first (see Pose.h) all of that is one forward pass,
+* followed by a second one that recomputes only the dirty joints, so static props & rigs where only the hands or the face
+* animate skip most of the hierarchy
+* The recompute batches runs of dirty siblings (consecutive joints with the same parent): their local matrices are built in one go
+* & multiplied by the parent with MultiplyArray(), which keeps the parent's columns in registers for the whole run
+* Every Update() adds "World matrices recomputed" & "World matrices skipped" to gProfiler
+*/
+class TransformHierarchy
+{
+private:
+	unsigned char* mMemory; // Heap block, 0 when the arrays came from an arena
+	unsigned int mJointCount;
+	// What the world matrices were last computed from
+	vec3* mPositions;
+	quat* mRotations;
+	vec3* mScales;
+	mat4* mLocalMatrices; // Scratch for the sibling runs
+	mat4* mWorldMatrices;
+	unsigned char* mDirty;
+	unsigned int mRecomputed;
+	unsigned int mSkipped;
+private:
+	TransformHierarchy(const TransformHierarchy&);
+	TransformHierarchy& operator=(const TransformHierarchy&);
+public:
+	TransformHierarchy();
+	~TransformHierarchy();
+
+	// Sized for inJointCount joints, the arrays come from inArena if there is one. Every joint starts out dirty
+	bool Initialize(unsigned int inJointCount, LinearArena* inArena = 0);
+	void Release();
+	unsigned int Size() const;
+
+	// For changes Update() can't see, a joint whose parent was reparented for example. Its children follow automatically
+	void MarkDirty(unsigned int inJoint);
+	void MarkAllDirty();
+	// inPose needs Size() joints with the same hierarchy as the last call, returns how many world matrices were recomputed
+	unsigned int Update(const Pose& inPose);
+
+	// Model space matrices of every joint, valid after the first Update()
+	const mat4* GetWorldMatrices() const;
+	// Counts of the last Update()
+	unsigned int GetRecomputedCount() const;
+	unsigned int GetSkippedCount() const;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "ViewUniforms.h"
+#include "Shader.h"
+#include "RenderState.h"
+#include "mat4.h"
+#include "vec3.h"
+#include <cstring>
+#include <iostream>
+
+ViewUniforms::ViewUniforms()
+{
+	mAlignment = 256;
+}
+
+ViewUniforms::~ViewUniforms()
+{
+	Shutdown();
+}
+
+bool ViewUniforms::Initialize()
+{
+	Shutdown();
+	GLint offsetAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	if (offsetAlignment <= 0) { offsetAlignment = 256; }
+	mAlignment = (GLsizeiptr)offsetAlignment;
+	// Every block starts on the offset alignment, so a view costs a whole alignment even though the block is 96 bytes
+	GLsizeiptr stride = ((GLsizeiptr)sizeof(Block) + mAlignment - 1) / mAlignment * mAlignment;
+	return mStream.Initialize(GL_UNIFORM_BUFFER, stride * kMaxViewsPerFrame, StreamBufferMode::Auto);
+}
+
+void ViewUniforms::Shutdown()
+{
+	mStream.Shutdown();
+}
+
+void ViewUniforms::ConfigureShader(Shader& inShader) const
+{
+	if (!inShader.BindUniformBlock("View", kUniformBinding)) { std::cout << "ViewUniforms: the shader has no View block\n"; }
+}
+
+void ViewUniforms::Upload(const mat4& inViewProjection, const vec3& inLightDirection, const vec3& inColor)
+{
+	if (mStream.GetBuffer() == 0) { return; }
+	Block block;
+	memcpy(block.viewProjection, inViewProjection.v, sizeof(block.viewProjection));
+	block.lightDirection[0] = inLightDirection.x;
+	block.lightDirection[1] = inLightDirection.y;
+	block.lightDirection[2] = inLightDirection.z;
+	block.lightDirection[3] = 0.0f;
+	block.color[0] = inColor.x;
+	block.color[1] = inColor.y;
+	block.color[2] = inColor.z;
+	block.color[3] = 1.0f;
+
+	GLintptr offset = 0;
+	void* mapped = mStream.Map((GLsizeiptr)sizeof(Block), mAlignment, offset);
+	// The stream reports the overflow once, the draws keep reading the previous view's block
+	if (mapped == 0) { return; }
+	memcpy(mapped, &block, sizeof(Block));
+	mStream.Unmap();
+
+	// glBindBufferRange also changes the generic binding, binding it through the cache first keeps the cache correct
+	GLuint buffer = mStream.GetBuffer();
+	gRenderState->BindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBindBufferRange(GL_UNIFORM_BUFFER, kUniformBinding, buffer, offset, (GLsizeiptr)sizeof(Block));
+}
+
+void ViewUniforms::EndFrame()
+{
+	mStream.EndFrame();
+}
+
+const char* GetViewUniformBlock()
+{
+	return "layout(std140) uniform View { mat4 uViewProjection; vec4 uLightDirection; vec4 uColor; };\n";
+}
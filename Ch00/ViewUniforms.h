@@ -0,0 +1,55 @@
+#pragma once
+#ifndef _H_VIEWUNIFORMS_
+#define _H_VIEWUNIFORMS_
+
+#include "include/glad/glad.h"
+#include "StreamBuffer.h"
+
+struct mat4;
+struct vec3;
+class Shader;
+
+/**
+* ViewUniforms streams what every draw of a view shares (view projection, light direction & material color) through a
+* StreamBuffer instead of three glUniform* calls per material & view
+* Shaders declare the block with GetViewUniformBlock() & ConfigureShader() assigns it to kUniformBinding, Upload() then writes
+* one std140 block into this frame's region & binds it with glBindBufferRange. Every view (the window & the tool viewports of
+* WindowManager) uploads its own block, EndFrame() has to follow the last draw that reads them, same as SkinningPalette
+*/
+class ViewUniforms
+{
+public:
+	static const GLuint kUniformBinding = 1; // Palette is 0
+	static const unsigned int kMaxViewsPerFrame = 16; // The window & WindowManager::kMaxViewports with room to spare
+private:
+	// Matches the std140 layout of the View block, vec3s are padded to vec4
+	struct Block
+	{
+		float viewProjection[16];
+		float lightDirection[4];
+		float color[4];
+	};
+	StreamBuffer mStream;
+	GLsizeiptr mAlignment;
+private:
+	ViewUniforms(const ViewUniforms&);
+	ViewUniforms& operator=(const ViewUniforms&);
+public:
+	ViewUniforms();
+	~ViewUniforms();
+
+	// Needs a current context
+	bool Initialize();
+	void Shutdown();
+
+	// Call once after the program is linked
+	void ConfigureShader(Shader& inShader) const;
+	// Writes & binds the block the next draws read, once per view. More than kMaxViewsPerFrame views leaves the last block bound
+	void Upload(const mat4& inViewProjection, const vec3& inLightDirection, const vec3& inColor);
+	void EndFrame();
+};
+
+// GLSL 330 declaration of the View block: uViewProjection, uLightDirection & uColor (xyz / rgb of vec4s)
+const char* GetViewUniformBlock();
+
+#endif
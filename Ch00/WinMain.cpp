@@ -14,10 +14,37 @@
 #include <Windows.h>
 #include <iostream>
 #include "Application.h"
+#include "FrameClock.h"
+#include "CommandLine.h"
+#include "RenderState.h"
+#include "FramePacer.h"
+#include "FrameProfiler.h"
+#include "Benchmark.h"
+#include "GLLoader.h"
+#include "RenderThread.h"
+#include "JobSystem.h"
+#include "Arena.h"
+#include "AllocationTracker.h"
+#include "PoseSample.h"
+#include "SkinningSample.h"
+#include "CrowdSample.h"
+#include "GLTFSample.h"
+#include "BlendSample.h"
+#include "AssetLoader.h"
+#include "StreamBuffer.h"
+#include "ShaderCache.h"
+#include "WindowManager.h"
+#include <cwchar>
+#include <atomic>
 
 // We need to forward declare these 2 functions as they are used early on
 int WINAPI WinMain(HINSTANCE, HINSTANCE, PSTR, int);
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
+bool PumpMessages(MSG& outMsg);
+void RenderFrame(unsigned int inPacket);
+void RenderThreadStarted();
+void RenderThreadFrame(unsigned int inPacket);
+void RenderThreadStopping();
 
 #if _DEBUG
 	#pragma comment(linker,"/subsystem:console")
@@ -44,12 +71,6 @@ LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 // Define a function pointer for wglCreateContextAttribsARB
 typedef HGLRC(WINAPI* PFNWGLCREATECONTEXTATTRIBSARBPROC)(HDC, HGLRC, const int*);
 
-// Instead of including wgl.h we just define the function pointer signatures required from wgl.h
-// These fns are required to work with OpenGL
-typedef const char* (WINAPI* PFNWGLGETEXTENSIONSSTRINGEXTPROC)(void);
-typedef BOOL (WINAPI* PFNWGLSWAPINTERVALEXTPROC)(int);
-typedef int (WINAPI* PFNWGLGETSWAPINTERVALEXTPROC)(void);
-
 // 2 global variables for easy window cleanup
 Application* gApplication = 0; // Pointer to currently running Application 
 GLuint gVertexArrayObject = 0; // Handle to the global OpenGL Vertex Array Object (VAO)
@@ -57,10 +78,122 @@ GLuint gVertexArrayObject = 0; // Handle to the global OpenGL Vertex Array Objec
 * Note: Instead of each draw call having its own VAO, we'll use 1 to bound for the entire duration of the sample
 */
 
+/**
+* The client size is only updated by WndProc when a WM_SIZE msg arrives
+* gClientSizeDirty tells the renderer that the viewport & aspect ratio need to be recomputed
+* These are atomic because with -renderthread the renderer reads them on another thread
+*/
+std::atomic<int> gClientWidth(0);
+std::atomic<int> gClientHeight(0);
+std::atomic<bool> gClientSizeDirty(true);
+// Viewport & aspect ratio as last seen by the renderer, only touched by RenderFrame()
+int gViewportWidth = 0;
+int gViewportHeight = 0;
+float gAspectRatio = 1.0f;
+HDC gDeviceContext = 0;
+RenderState* gContextRenderState = 0; // The main context's cache, gRenderState is per thread so the render thread picks it up from here
+FramePacer gFramePacer; // Sets up vsync & keeps the CPU from running too far ahead of the GPU
+RenderThread* gRenderThread = 0; // Only created with -renderthread, owns the OpenGL context while it runs
+bool gGpuTimers = true;
+size_t gFrameArenaSize = 0;
+bool gPrintProfile = false;
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine, int iCmdShow)
 {
+	// The benchmark only records the WinMain thread's profiler, with a render thread the Render, Present & GPU markers would be missing
+	if (HasSwitch(szCmdLine, "benchmark") && HasSwitch(szCmdLine, "renderthread"))
+	{
+		std::cout << "-benchmark can't be combined with -renderthread, the render thread's timings wouldn't be in the report\n";
+		return 1;
+	}
+
 	// Create a new instance of application & store it in the global pointer
-	gApplication = new Application();
+	// -sample=name picks one of the built in samples instead of the empty Application
+	// -skinmethod=lbs|dqs is the default skinning method of every mesh, so it has to be set before the sample creates any
+	char skinMethodName[16];
+	skinMethodName[0] = 0;
+	if (GetSwitchString(szCmdLine, "skinmethod", skinMethodName, sizeof(skinMethodName)))
+	{
+		gDefaultSkinningMethod = (strcmp(skinMethodName, "dqs") == 0) ? SkinningMethod::DualQuaternion : SkinningMethod::LinearBlend;
+	}
+	char sampleName[64];
+	sampleName[0] = 0;
+	GetSwitchString(szCmdLine, "sample", sampleName, sizeof(sampleName));
+	if (strcmp(sampleName, "pose") == 0)
+	{
+		int joints = GetSwitchInt(szCmdLine, "joints", 4096);
+		gApplication = new PoseSample(joints > 0 ? (unsigned int)joints : 4096);
+	}
+	else if (strcmp(sampleName, "skinning") == 0)
+	{
+		int characters = GetSwitchInt(szCmdLine, "characters", 64);
+		char option[16];
+		option[0] = 0;
+		GetSwitchString(szCmdLine, "skinning", option, sizeof(option));
+		SkinningMode mode = (strcmp(option, "cpu") == 0) ? SkinningMode::Cpu : SkinningMode::Gpu;
+		option[0] = 0;
+		GetSwitchString(szCmdLine, "palette", option, sizeof(option));
+		PaletteStorage storage = (strcmp(option, "ubo") == 0) ? PaletteStorage::UniformBuffer :
+			(strcmp(option, "tbo") == 0) ? PaletteStorage::TextureBuffer : PaletteStorage::Auto;
+		SkinningSample* sample = new SkinningSample(characters > 0 ? (unsigned int)characters : 64, mode, storage);
+		sample->SetShowJoints(HasSwitch(szCmdLine, "showjoints"));
+		sample->SetPackedMesh(HasSwitch(szCmdLine, "packedmesh"));
+		gApplication = sample;
+	}
+	else if (strcmp(sampleName, "blend") == 0)
+	{
+		int characters = GetSwitchInt(szCmdLine, "characters", 256);
+		char option[16];
+		option[0] = 0;
+		GetSwitchString(szCmdLine, "skinning", option, sizeof(option));
+		SkinningMode mode = (strcmp(option, "cpu") == 0) ? SkinningMode::Cpu : SkinningMode::Gpu;
+		BlendSample* sample = new BlendSample(characters > 0 ? (unsigned int)characters : 256, mode, PaletteStorage::Auto);
+		sample->SetShowJoints(HasSwitch(szCmdLine, "showjoints"));
+		sample->SetPackedMesh(HasSwitch(szCmdLine, "packedmesh"));
+		sample->SetAnimationLOD(HasSwitch(szCmdLine, "animlod"));
+		option[0] = 0;
+		if (GetSwitchString(szCmdLine, "ik", option, sizeof(option)))
+		{
+			IKSolverType solver = (strcmp(option, "fabrik") == 0) ? IKSolverType::FABRIK :
+				(strcmp(option, "twobone") == 0) ? IKSolverType::TwoBone : IKSolverType::CCD;
+			int budget = GetSwitchInt(szCmdLine, "ikbudget", 0);
+			sample->SetIK(solver, budget > 0 ? (unsigned int)budget : 0, GetSwitchFloat(szCmdLine, "ikms", 0.0f));
+		}
+		gApplication = sample;
+	}
+	else if (strcmp(sampleName, "crowd") == 0)
+	{
+		int characters = GetSwitchInt(szCmdLine, "characters", 512);
+		char option[16];
+		option[0] = 0;
+		GetSwitchString(szCmdLine, "crowd", option, sizeof(option));
+		CrowdSample* sample = new CrowdSample(characters > 0 ? (unsigned int)characters : 512, strcmp(option, "live") != 0);
+		sample->SetShowJoints(HasSwitch(szCmdLine, "showjoints"));
+		sample->SetPackedMesh(HasSwitch(szCmdLine, "packedmesh"));
+		gApplication = sample;
+	}
+	else if (strcmp(sampleName, "gltf") == 0)
+	{
+		char path[260];
+		path[0] = 0;
+		GetSwitchString(szCmdLine, "gltf", path, sizeof(path));
+		int clip = GetSwitchInt(szCmdLine, "clip", 0);
+		GLTFSample* sample = new GLTFSample(path, clip > 0 ? (unsigned int)clip : 0);
+		sample->SetPackedMesh(HasSwitch(szCmdLine, "packedmesh"));
+		sample->SetClipCache(HasSwitch(szCmdLine, "clipcache"));
+		gApplication = sample;
+	}
+	else
+	{
+		if (sampleName[0] != 0) { std::cout << "Unknown sample " << sampleName << "\n"; }
+		gApplication = new Application();
+	}
+
+	/**
+	* -benchmark runs the application headless for a fixed number of frames with a fixed dt & writes a report of the frame times
+	* See Benchmark.h for the rest of the switches
+	*/
+	BenchmarkOptions benchmarkOptions = ParseBenchmarkOptions(szCmdLine);
 
 	// Window Creation
 	// Standard window definition - Just make sure WndProc fn is set correctly
@@ -109,6 +242,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 		windowRect.left, windowRect.top, screenWidth, screenHeight, NULL, NULL,
 		hInstance, szCmdLine);
 	HDC hdc = GetDC(hwnd);
+	gDeviceContext = hdc;
 
 	// Window Creation Completed
 	// OpenGL Context creation
@@ -156,116 +290,356 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 		WGL_CONTEXT_CORE_PROFILE_BIT_ARB, 0
 	};
 	HGLRC hglrc = wglCreateContextAttribsARB(hdc, 0, attribList);
+	/**
+	* The asset loader gets a second context that shares objects (buffers, textures, programs) with the main one
+	* -noasyncload skips it & assets are loaded on the WinMain thread instead
+	*/
+	HGLRC loaderRC = NULL;
+	if (!HasSwitch(szCmdLine, "noasyncload"))
+	{
+		loaderRC = wglCreateContextAttribsARB(hdc, hglrc, attribList);
+		if (loaderRC == NULL) { std::cout << "Couldn't create a shared context, assets will be loaded synchronously\n"; }
+	}
 	wglMakeCurrent(NULL, NULL);
 	wglDeleteContext(tempRC);
 	wglMakeCurrent(hdc, hglrc);
 
 	// OpenGL Context Creation Completed
-	// Use glad to load all OpenGL Core functions
-	if (!gladLoadGL()) { std::cout << "Couldn't initialize GLAD\n"; }
-	else { std::cout << "OpenGL Version:" + GLVersion.major << "." << GLVersion.minor << "\n"; }
+	/**
+	* Load the OpenGL 3.3 Core functions (through glad) & check the extensions we asked for
+	* -glload=lazy resolves extension functions the first time they're used instead of at startup
+	*/
+	char glLoadName[16];
+	GLLoadMode glLoadMode = GLLoadMode::Eager;
+	if (GetSwitchString(szCmdLine, "glload", glLoadName, sizeof(glLoadName)) && strcmp(glLoadName, "lazy") == 0) { glLoadMode = GLLoadMode::Lazy; }
+	// GL_ARB_buffer_storage lets StreamBuffer map its ring once & keep it mapped (see StreamBuffer.h)
+	static const char* const bufferStorageFunctions[] = { "glBufferStorage" };
+	// GL_ARB_get_program_binary lets ShaderCache skip compiling, GL_KHR_parallel_shader_compile lets hot reload poll a link (see ShaderCache.h)
+	static const char* const programBinaryFunctions[] = { "glGetProgramBinary", "glProgramBinary", "glProgramParameteri" };
+	static const GLExtensionRequest extensions[] = {
+		{ "GL_ARB_buffer_storage", bufferStorageFunctions, 1 },
+		{ "GL_ARB_get_program_binary", programBinaryFunctions, 3 },
+		{ "GL_KHR_parallel_shader_compile", 0, 0 },
+		{ "GL_ARB_parallel_shader_compile", 0, 0 }
+	};
+	if (!LoadOpenGL(glLoadMode, extensions, sizeof(extensions) / sizeof(extensions[0]))) { std::cout << "Couldn't initialize GLAD\n"; }
+	else
+	{
+		std::cout << "OpenGL Version:" << GLVersion.major << "." << GLVersion.minor << "\n";
+		std::cout << "Loaded " << GetGLResolvedFunctionCount() << " GL functions in " << GetGLLoadTime() * 1000.0 << "ms\n";
+	}
+
+	// Per frame data streams through StreamBuffers, -streaming=auto|orphan|unsync|persistent picks how they avoid driver stalls
+	char streamingName[16];
+	if (GetSwitchString(szCmdLine, "streaming", streamingName, sizeof(streamingName))) { gDefaultStreamBufferMode = ParseStreamBufferMode(streamingName, StreamBufferMode::Auto); }
+	std::cout << "Buffer streaming: " << GetStreamBufferModeName(gDefaultStreamBufferMode)
+		<< (IsGLExtensionSupported("GL_ARB_buffer_storage") ? " (persistent mapping available)\n" : " (no persistent mapping)\n");
 
-	// Enabling VSync
 	/**
-	* vsync is not a built-in function, it's an extension so it needs to be called using wglGetExtensionStringEXT
-	* The extension string for vsync is WGL_EXT_swap_control
-	* First we check if the extension string is present in the list of extension strings being used
+	* Enabling VSync & frame pacing
+	* Calling glFinish() after every swap stalls the CPU until the GPU is idle, so CPU & GPU work never overlap
+	* Instead the pacing mode is picked at startup: -pacing=none|finish|fence|adaptive, -framesinflight=N & -novsync
+	* The default keeps vsync on & lets 2 frames be in flight, so CPU & GPU work can overlap
 	*/
-	PFNWGLGETEXTENSIONSSTRINGEXTPROC _wglGetExtensionsStringEXT = (PFNWGLGETEXTENSIONSSTRINGEXTPROC)wglGetProcAddress("wglGetExtensionsStringEXT");
+	char pacingName[16];
+	FramePacing pacing = FramePacing::Fence;
+	if (GetSwitchString(szCmdLine, "pacing", pacingName, sizeof(pacingName))) { pacing = FramePacer::ParseMode(pacingName, pacing); }
+	int framesInFlight = GetSwitchInt(szCmdLine, "framesinflight", 2);
+	// Benchmarks shouldn't be capped by the refresh rate
+	bool vsync = !HasSwitch(szCmdLine, "novsync") && !benchmarkOptions.enabled;
+	gFramePacer.Initialize(pacing, framesInFlight > 0 ? (unsigned int)framesInFlight : 1, vsync);
+	// Completed vsynch
+	
 	/*
-	* strstr - finds the first occurence of a sub-string in a string
-	* It returns a ptr to the first character of the sub-string found in the string
-	* It returns a nullptr if the substring isn't present in the string
+	* OpenGL requires a VAO to be bound for all draw calls
+	* Instead of creating a VAO for each draw call, we create 1 global VAO that's bound to WinMain & is never unbound until the window is destroyed
+	*/
+	glGenVertexArrays(1, &gVertexArrayObject);
+
+	/**
+	* All state changes from here on go through the render state cache, so the per frame state below only reaches the driver when it changes
+	* The cache starts out invalid, the first request for every state is always issued
 	*/
-	bool swapControlSupported = strstr(_wglGetExtensionsStringEXT(), "WGL_EXT_swap_control") != 0;
+	gRenderState = new RenderState();
+	gRenderState->BindVertexArray(gVertexArrayObject);
+	gContextRenderState = gRenderState;
 
 	/**
-	* If WGL_EXT_swap_control extension is available it needs to be loaded
-	* The actual fn name is wglSwapIntervalEXT & is present in wgl.h passing an argument to this fn turns on vsynch
+	* The frame profiler times the message pump, Update, Render & Present phases of every frame
+	* GPU timer queries are on by default, -nogputimers turns them off. -profile prints a report every 300 frames (debug builds always do)
 	*/
-	int vsynch = 0;
-	if (swapControlSupported)
-	{
-		PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
-		PFNWGLGETSWAPINTERVALEXTPROC wglGetSwapIntervalEXT = (PFNWGLGETSWAPINTERVALEXTPROC)wglGetProcAddress("wglGetSwapIntervalEXT");
+	gGpuTimers = !HasSwitch(szCmdLine, "nogputimers");
+	gProfiler = new FrameProfiler();
+	gProfiler->Initialize(gGpuTimers);
+#if _DEBUG
+	gPrintProfile = true;
+#else
+	gPrintProfile = HasSwitch(szCmdLine, "profile");
+#endif
 
-		if (wglSwapIntervalEXT(1))
+	// Display the current window, in benchmark mode the window (& its GL context) stays hidden
+	if (!benchmarkOptions.enabled)
+	{
+		ShowWindow(hwnd, SW_SHOW);
+		UpdateWindow(hwnd);
+	}
+	/**
+	* -viewports=N opens N tool viewports next to the main window (see WindowManager.h), each with a context that shares this one's objects
+	* They're created while this context is still current on the WinMain thread, the render thread picks them up like the main window
+	*/
+	int viewportCount = GetSwitchInt(szCmdLine, "viewports", 0);
+	if (viewportCount > 0)
+	{
+		if (viewportCount > (int)WindowManager::kMaxViewports) { viewportCount = (int)WindowManager::kMaxViewports; }
+		gWindowManager = new WindowManager();
+		if (gWindowManager->Initialize(hInstance, hdc, hglrc, attribList))
 		{
-			std::cout << "Enabled vsynch\n";
-			vsynch = wglGetSwapIntervalEXT();
+			for (int i = 0; i < viewportCount; ++i)
+			{
+				wchar_t title[32];
+				swprintf(title, 32, L"Viewport %d", i + 1);
+				gWindowManager->CreateViewport(title, clientWidth / 2, clientHeight / 2, !benchmarkOptions.enabled);
+			}
 		}
-		else { std::cout << "Couldn't enable vsynch \n"; }
+		std::cout << gWindowManager->GetViewportCount() << " tool viewports sharing the main context\n";
+	}
+	/**
+	* -renderthread moves rendering onto its own thread, -renderthread=3 triple buffers the frame packets (the default is 2)
+	* The Application is told how many packets there will be before it's initialized
+	*/
+	bool useRenderThread = HasSwitch(szCmdLine, "renderthread");
+	unsigned int packetCount = 1;
+	if (useRenderThread)
+	{
+		packetCount = GetSwitchInt(szCmdLine, "renderthread", 2) >= 3 ? 3 : 2;
 	}
-	else { std::cout << "WGL_EXT_swap_control not enabled\n"; } // !swapControlSupported
+	gApplication->SetRenderPacketCount(packetCount);
 
-	//Completed vsynch 
-	
-	/*
-	* OpenGL requires a VAO to be bound for all draw calls
-	* Instead of creating a VAO for each draw call, we create 1 global VAO that's bound to WinMain & is never unbound until the window is destroyed
+	/**
+	* The job system is available to the Application from Initialize() on, through gJobSystem
+	* By default there's one worker per hardware thread (minus this one), -jobthreads=N overrides that
 	*/
-	glGenVertexArrays(1, &gVertexArrayObject);
-	glBindVertexArray(gVertexArrayObject);
+	int jobThreads = GetSwitchInt(szCmdLine, "jobthreads", 0);
+	gJobSystem = new JobSystem(jobThreads > 0 ? (unsigned int)jobThreads : 0);
+	std::cout << "Job system running on " << gJobSystem->GetThreadCount() << " threads\n";
+
+	// Started before Initialize() so it can queue its loads, see AssetLoader.h
+	gAssetLoader = new AssetLoader();
+	gAssetLoader->Start(hdc, loaderRC);
+	std::cout << (gAssetLoader->IsAsync() ? "Loading assets on a separate thread\n" : "Loading assets on the main thread\n");
+
+	/**
+	* Arenas: gPersistentArena is for Initialize() & lives until exit, gFrameArena is reset at the top of every frame
+	* Frame packets can point into the frame arena, so with a render thread there's one more arena than packets in rotation,
+	* an arena is only reset once the render thread is done with the packet that was filled from it
+	* -persistentarena=MB & -framearena=MB set their sizes, the high water marks are printed on exit to help pick them
+	*/
+	const size_t megabyte = 1024 * 1024;
+	int persistentArenaSize = GetSwitchInt(szCmdLine, "persistentarena", 64);
+	int frameArenaSize = GetSwitchInt(szCmdLine, "framearena", 16);
+	gFrameArenaSize = (frameArenaSize > 0 ? (size_t)frameArenaSize : 16) * megabyte;
+	gPersistentArena = new LinearArena("Persistent", (persistentArenaSize > 0 ? (size_t)persistentArenaSize : 64) * megabyte);
+	LinearArena* frameArenas[FramePacketQueue::kMaxPackets + 1];
+	unsigned int frameArenaCount = useRenderThread ? packetCount + 1 : 1;
+	for (unsigned int i = 0; i < frameArenaCount; ++i) { frameArenas[i] = new LinearArena("Frame", gFrameArenaSize); }
+	gFrameArena = frameArenas[0];
+
+	/**
+	* Every Shader::Load() goes through gShaderCache, linked programs are written to the ShaderCache directory & loaded from there
+	* on the next run. -shadercache=dir picks another directory, -noshadercache keeps the binaries in memory only
+	* -hotreload watches the shaders that were loaded from files & rebuilds them when they change
+	*/
+	char shaderCacheDirectory[260] = "ShaderCache";
+	GetSwitchString(szCmdLine, "shadercache", shaderCacheDirectory, sizeof(shaderCacheDirectory));
+	if (HasSwitch(szCmdLine, "noshadercache")) { shaderCacheDirectory[0] = '\0'; }
+	gShaderCache = new ShaderCache();
+	gShaderCache->Initialize(shaderCacheDirectory, HasSwitch(szCmdLine, "hotreload"));
+	if (!gShaderCache->IsBinarySupported()) { std::cout << "No program binaries, every shader is compiled\n"; }
 
-	// Display the current window
-	ShowWindow(hwnd, SW_SHOW);
-	UpdateWindow(hwnd);
 	/**
 	* Initialize the global application
-	* Note: Depending on the amount of work done when Initialize() is called the application might freeze for a few seconds
+	* Note: Depending on the amount of work done when Initialize() is called the application might freeze for a few seconds,
+	* anything slow (file decoding, uploads) should be queued on gAssetLoader instead
+	* or at least spread over gJobSystem, like ImportGLTF() (see GLTF.h) which decodes every mesh & clip in parallel
 	*/
 	gApplication->Initialize();
+	std::cout << "Shader cache: " << gShaderCache->GetBinaryLoadCount() << " programs loaded from binaries, " << gShaderCache->GetCompileCount() << " compiled";
+	if (gShaderCache->GetRejectedBinaryCount() > 0) { std::cout << " (" << gShaderCache->GetRejectedBinaryCount() << " binaries rejected by the driver)"; }
+	std::cout << " in " << gShaderCache->GetBuildTime() * 1000.0 << "ms\n";
+
+	// WM_SIZE was already sent while the window was being created, but just in case read the starting size directly
+	RECT clientRect;
+	GetClientRect(hwnd, &clientRect);
+	gClientWidth = clientRect.right - clientRect.left;
+	gClientHeight = clientRect.bottom - clientRect.top;
+	gClientSizeDirty = true;
+
+	/**
+	* From here on the render thread owns the OpenGL context, the WinMain thread only pumps messages,
+	* runs Update() & fills frame packets. The context comes back to this thread when WM_CLOSE stops the render thread
+	*/
+	if (useRenderThread)
+	{
+		gRenderThread = new RenderThread();
+		gRenderThread->Start(hdc, hglrc, packetCount, &RenderThreadFrame, &RenderThreadStarted, &RenderThreadStopping);
+		std::cout << "Rendering on a separate thread with " << packetCount << " frame packets\n";
+	}
+
+	/**
+	* Pick how the loop steps the Application, this is decided once at startup
+	* -fixedstep runs Update() at a fixed 60Hz, -fixedstep=N runs it at N Hz
+	* Without the switch Update() runs once per frame with the measured (variable) frame time
+	*/
+	StepMode stepMode = HasSwitch(szCmdLine, "fixedstep") ? StepMode::Fixed : StepMode::Variable;
+	// The benchmark passes its own fixed dt to every Update() so runs are reproducible
+	BenchmarkRunner* benchmark = 0;
+	bool benchmarkFailed = false;
+	if (benchmarkOptions.enabled)
+	{
+		stepMode = StepMode::Variable;
+		benchmark = new BenchmarkRunner(benchmarkOptions);
+		std::cout << "Benchmark: " << benchmarkOptions.frames << " frames (+" << benchmarkOptions.warmupFrames << " warm up) with dt " << benchmarkOptions.deltaTime << "\n";
+	}
+	FixedStepper fixedStepper;
+	if (stepMode == StepMode::Fixed)
+	{
+		int updateRate = GetSwitchInt(szCmdLine, "fixedstep", 60);
+		if (updateRate <= 0) { updateRate = 60; }
+		fixedStepper.SetStep(1.0f / (float)updateRate);
+		std::cout << "Fixed time step: " << updateRate << "Hz\n";
+	}
+	else { std::cout << "Variable time step\n"; }
+	// Same clamp as the fixed stepper, so hitting a breakpoint doesn't launch animations forward
+	const float maxFrameTime = 0.25f;
 
 	// Game loop implementation
-	DWORD lastTick = GetTickCount(); // Keep track of last frame to calculate delta time
+	FrameClock frameClock; // QPC based clock, keeps track of last frame to calculate delta time
 	MSG msg;
+	memset(&msg, 0, sizeof(MSG));
+	unsigned long long frameNumber = 0;
 	while (true)
 	{
+		// Everything allocated from the frame arena last time this arena was in use is released here
+		gFrameArena = frameArenas[frameNumber % frameArenaCount];
+		gFrameArena->Reset();
+		++frameNumber;
+
+		if (gProfiler != 0)
+		{
+			gProfiler->BeginFrame();
+			if (gPrintProfile && gProfiler->GetFrameIndex() > 0 && gProfiler->GetFrameIndex() % 300 == 0) { gProfiler->Report(std::cout); }
+		}
+
 		// Process window events
-		// Handle window events by peeking at the current message stack & dispatching msg accordingly
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		// All pending messages are handled before the frame is updated, returns false once WM_QUIT is received
 		{
-			if (msg.message == WM_QUIT) { break; }
+			PROFILE_SCOPE("MessagePump");
+			if (!PumpMessages(msg)) { break; }
+		}
+
+		// Finished loads are handed back to the Application before it updates
+		if (gAssetLoader != 0 && gAssetLoader->IsLoading())
+		{
+			PROFILE_SCOPE("AssetLoader");
+			if (gAssetLoader->Update() && gApplication != 0)
+			{
+				std::cout << "Assets ready, the loading thread was busy for " << gAssetLoader->GetBusyTime() * 1000.0 << "ms\n";
+				gApplication->OnAssetsReady();
+			}
 		}
-		TranslateMessage(&msg);
-		DispatchMessage(&msg);
 
 		// Update application based on the delta time
-		DWORD thisTick = GetTickCount();
-		float dt = (thisTick - lastTick) * 0.001f;
-		lastTick = thisTick;
-		if (gApplication != 0) { gApplication->Update(dt); }
+		float dt = frameClock.Tick();
+		if (benchmark != 0) { dt = benchmark->GetDeltaTime(); }
+		if (gApplication != 0)
+		{
+			PROFILE_SCOPE("Update");
+			if (stepMode == StepMode::Fixed)
+			{
+				unsigned int steps = fixedStepper.Advance(dt);
+				for (unsigned int i = 0; i < steps && gApplication != 0; ++i)
+				{
+					gApplication->Update(fixedStepper.GetStep());
+				}
+				if (gApplication != 0) { gApplication->Interpolate(fixedStepper.GetAlpha()); }
+			}
+			else
+			{
+				if (dt > maxFrameTime && benchmark == 0) { dt = maxFrameTime; }
+				gApplication->Update(dt);
+				gApplication->Interpolate(1.0f);
+			}
+		}
 
-		// Render Application
+		// Hand the frame over to the renderer
 		if (gApplication != 0)
 		{
-			RECT clientRect;
-			GetClientRect(hwnd, &clientRect);
-			clientWidth = clientRect.right - clientRect.left;
-			clientHeight = clientRect.bottom - clientRect.top;
-			glViewport(0, 0, clientWidth, clientHeight);
-			glEnable(GL_DEPTH_TEST);
-			glEnable(GL_CULL_FACE);
-			glPointSize(5.0f);
-			glBindVertexArray(gVertexArrayObject);
-
-			// Clear color, depth & stencil buffers
-			glClearColor(0.5f, 0.6f, 0.7f, 1.0f);
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+			if (gRenderThread != 0)
+			{
+				// Waiting here means the render thread is behind by every packet, so the update thread has to stall
+				unsigned int packet = 0;
+				bool acquired = false;
+				{
+					PROFILE_SCOPE("WaitForPacket");
+					acquired = gRenderThread->GetQueue().BeginWrite(packet);
+				}
+				if (acquired)
+				{
+					PROFILE_SCOPE("Extract");
+					gApplication->ExtractRenderData(packet);
+					gRenderThread->GetQueue().EndWrite(packet);
+				}
+			}
+			else
+			{
+				{
+					PROFILE_SCOPE("Extract");
+					gApplication->ExtractRenderData(0);
+				}
+				RenderFrame(0);
+			}
+		}
 
-			// Find aspect ratio
-			float aspect = (float)clientWidth / (float)clientHeight;
-			gApplication->Render(aspect);
+		if (gProfiler != 0)
+		{
+			gProfiler->AddCounter("Frame arena KB", (float)gFrameArena->GetUsed() / 1024.0f);
+			gProfiler->EndFrame();
 		}
 
-		// After application has been updated & rendered, the buffer needs to be presented
-		if (gApplication != 0)
+		// Once enough frames were measured the report is written & the window is closed like any other window
+		if (benchmark != 0 && gProfiler != 0 && !benchmark->IsFinished())
 		{
-			SwapBuffers(hdc);
-			if (vsynch != 0) { glFinish(); } // If vsynch is enabled, glFinish() needs to be called right after buffer swap
+			benchmark->RecordFrame(*gProfiler);
+			if (benchmark->IsFinished())
+			{
+				benchmarkFailed = !benchmark->WriteReport(*gProfiler);
+				gProfiler->Report(std::cout);
+				if (benchmark->CheckAssertions()) { benchmarkFailed = true; }
+				PostMessage(hwnd, WM_CLOSE, 0, 0);
+			}
 		}
 	} // End of game loop
 
+	if (benchmark != 0) { delete benchmark; }
+
+	// The high water marks show how much of each arena was actually needed
+	std::cout << "Persistent arena high water mark: " << gPersistentArena->GetHighWaterMark() / 1024 << "KB of " << gPersistentArena->GetCapacity() / 1024 << "KB\n";
+	for (unsigned int i = 0; i < frameArenaCount; ++i)
+	{
+		std::cout << "Frame arena " << i << " high water mark: " << frameArenas[i]->GetHighWaterMark() / 1024 << "KB of " << frameArenas[i]->GetCapacity() / 1024 << "KB\n";
+		delete frameArenas[i];
+	}
+	gFrameArena = 0;
+	delete gPersistentArena;
+	gPersistentArena = 0;
+
+	// Debug builds count every operator new, anything still outstanding here is either owned by a static or leaked
+	if (IsAllocationTrackingEnabled())
+	{
+		AllocationCounts heap = GetGlobalAllocationCounts();
+		std::cout << "Heap: " << heap.allocations << " allocations (" << heap.bytesAllocated / 1024 << "KB), " << (heap.allocations - heap.frees) << " still outstanding (" << (heap.bytesAllocated - heap.bytesFreed) / 1024 << "KB)\n";
+	}
+
 	// Once the game loop (window loop) finishes executing it's safe to return from the WinMain fn
 	if (gApplication != 0)
 	{
@@ -273,9 +647,135 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
 		delete gApplication;
 	}
 
+	// Scripts running the benchmark can check the exit code
+	if (benchmarkFailed) { return 1; }
 	return (int)msg.wParam;
 }
 
+/**
+* Renders & presents one frame packet
+* Without -renderthread this runs on the WinMain thread right after Update(), otherwise it's called by the render thread
+*/
+void RenderFrame(unsigned int inPacket)
+{
+	if (gApplication == 0) { return; }
+
+	// Render Application
+	{
+		PROFILE_GPU_SCOPE("Render");
+		// Only recompute the size dependent values when the window actually changed size
+		if (gClientSizeDirty.exchange(false))
+		{
+			gViewportWidth = gClientWidth;
+			gViewportHeight = gClientHeight;
+			// Find aspect ratio
+			gAspectRatio = (gViewportHeight > 0) ? (float)gViewportWidth / (float)gViewportHeight : 1.0f;
+			gApplication->Resize(gViewportWidth, gViewportHeight);
+		}
+
+		// Hot reloaded programs are swapped in on the thread that owns the context, before anything is drawn with them
+		if (gShaderCache != 0) { gShaderCache->Update(); }
+
+		/**
+		* The Application may have changed any of these during the last frame (rendering to a smaller framebuffer for example)
+		* Going through the cache means only the ones that are no longer set reach the driver
+		*/
+		gRenderState->ResetCounters();
+		gRenderState->Viewport(0, 0, gViewportWidth, gViewportHeight);
+		gRenderState->Enable(GL_DEPTH_TEST);
+		gRenderState->Enable(GL_CULL_FACE);
+		gRenderState->PointSize(5.0f);
+		gRenderState->BindVertexArray(gVertexArrayObject);
+
+		// Clear color, depth & stencil buffers
+		gRenderState->ClearColor(0.5f, 0.6f, 0.7f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		gApplication->RenderPacket(inPacket, gAspectRatio);
+
+		if (gProfiler != 0)
+		{
+			gProfiler->AddCounter("GL state calls issued", (float)gRenderState->GetIssuedCalls());
+			gProfiler->AddCounter("GL state calls skipped", (float)gRenderState->GetSkippedCalls());
+		}
+	}
+
+	// Tool viewports draw the same packet before the main window presents, the main window's swap ends the frame for all of them
+	if (gWindowManager != 0) { gWindowManager->RenderViewports(gApplication, inPacket); }
+	// The packet's streams are fenced once every view has read them
+	gApplication->EndRenderPacket(inPacket);
+
+	// After application has been updated & rendered, the buffer needs to be presented
+	{
+		PROFILE_SCOPE("Present");
+		SwapBuffers(gDeviceContext);
+		gFramePacer.FramePresented(); // Waits for the GPU according to the pacing mode picked at startup
+	}
+}
+
+/**
+* The render thread has a profiler & frame arena of its own (both are per thread), its profiler holds the Render & Present markers
+* while the WinMain thread's profiler holds MessagePump, Update, WaitForPacket & Extract. gRenderState is per thread as well,
+* the render thread takes over the main context's cache together with the context
+*/
+void RenderThreadStarted()
+{
+	gRenderState = gContextRenderState;
+	gProfiler = new FrameProfiler();
+	gProfiler->Initialize(gGpuTimers);
+	gFrameArena = new LinearArena("RenderFrame", gFrameArenaSize);
+}
+
+void RenderThreadFrame(unsigned int inPacket)
+{
+	gFrameArena->Reset();
+	gProfiler->BeginFrame();
+	if (gPrintProfile && gProfiler->GetFrameIndex() > 0 && gProfiler->GetFrameIndex() % 300 == 0)
+	{
+		std::cout << "Render thread:\n";
+		gProfiler->Report(std::cout);
+	}
+	RenderFrame(inPacket);
+	gProfiler->EndFrame();
+}
+
+void RenderThreadStopping()
+{
+	std::cout << "Render thread frame arena high water mark: " << gFrameArena->GetHighWaterMark() / 1024 << "KB\n";
+	delete gFrameArena;
+	gFrameArena = 0;
+
+	gProfiler->Shutdown();
+	delete gProfiler;
+	gProfiler = 0;
+	// The WinMain thread's gRenderState still points at the same cache once it gets the context back
+	gRenderState = 0;
+}
+
+/**
+* Message pump stage of the game loop
+* Peeking a single message per frame lets the queue back up during heavy input or resizing & adds whole frames of latency
+* Instead we keep peeking until the queue is empty, only dispatching messages that were actually removed from the queue
+* The time spent here shows up as the MessagePump marker of the frame profiler
+*/
+bool PumpMessages(MSG& outMsg)
+{
+	bool keepRunning = true;
+
+	while (PeekMessage(&outMsg, NULL, 0, 0, PM_REMOVE))
+	{
+		if (outMsg.message == WM_QUIT)
+		{
+			keepRunning = false;
+			break;
+		}
+		TranslateMessage(&outMsg);
+		DispatchMessage(&outMsg);
+	}
+
+	return keepRunning;
+}
+
 /**
 * In order to have a properly functioning window or to even compile the application,
 * an event processing function WndProc needs to be defined
@@ -292,9 +792,37 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
 	case WM_CLOSE:
 		if (gApplication != 0)
 		{
+			// The render thread has to let go of the OpenGL context before the Application can release its GL resources
+			if (gRenderThread != 0)
+			{
+				gRenderThread->Stop();
+				delete gRenderThread;
+				gRenderThread = 0;
+			}
+			// Loads still in flight finish (or are dropped) while the Application can still receive their results
+			if (gAssetLoader != 0) { gAssetLoader->Stop(); }
 			gApplication->Shutdown();
 			delete gApplication;
 			gApplication = 0;
+			// Shaders unwatch themselves when they're released, so the cache goes after the Application
+			if (gShaderCache != 0)
+			{
+				delete gShaderCache;
+				gShaderCache = 0;
+			}
+			if (gAssetLoader != 0)
+			{
+				delete gAssetLoader;
+				gAssetLoader = 0;
+			}
+
+			// The Application may still have jobs in flight until Shutdown() returns, so the workers are stopped after it
+			if (gJobSystem != 0)
+			{
+				gJobSystem->Shutdown();
+				delete gJobSystem;
+				gJobSystem = 0;
+			}
 			DestroyWindow(hwnd);
 		}
 		else { std::cout << "Already shut down gApplication!\n"; }
@@ -305,14 +833,50 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
 	* This means destroying gVertexArrayObject & deleting the OpenGL context
 	*/
 	case WM_DESTROY:
+		if (gRenderThread != 0)
+		{
+			gRenderThread->Stop();
+			delete gRenderThread;
+			gRenderThread = 0;
+		}
+		// Only still around if the window was destroyed without WM_CLOSE, its context shares objects with this one
+		if (gAssetLoader != 0)
+		{
+			gAssetLoader->Stop();
+			delete gAssetLoader;
+			gAssetLoader = 0;
+		}
 		if (gVertexArrayObject != 0)
 		{
 			HDC hdc = GetDC(hwnd);
 			HGLRC hglrc = wglGetCurrentContext();
 
+			// The viewports' contexts share objects with this one & have to go first
+			if (gWindowManager != 0)
+			{
+				gWindowManager->Shutdown();
+				delete gWindowManager;
+				gWindowManager = 0;
+			}
+
 			glBindVertexArray(0);
 			glDeleteVertexArrays(1, &gVertexArrayObject);
 			gVertexArrayObject = 0;
+			gFramePacer.Shutdown();
+
+			if (gProfiler != 0)
+			{
+				gProfiler->Shutdown();
+				delete gProfiler;
+				gProfiler = 0;
+			}
+
+			if (gRenderState != 0)
+			{
+				delete gRenderState;
+				gRenderState = 0;
+				gContextRenderState = 0;
+			}
 
 			wglMakeCurrent(NULL, NULL);
 			wglDeleteContext(hglrc);
@@ -323,6 +887,25 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
 		else { std::cout << "Display multiple error msgs\n"; }
 		break;
 
+	/**
+	* WM_SIZE is sent whenever the client area changes size
+	* We only record the new size here, the game loop picks it up at the start of the next render
+	* A minimized window reports a 0x0 client area, which we skip so the last valid aspect ratio is kept
+	*/
+	case WM_SIZE:
+		if (wParam != SIZE_MINIMIZED)
+		{
+			int width = LOWORD(lParam);
+			int height = HIWORD(lParam);
+			if (width > 0 && height > 0 && (width != gClientWidth || height != gClientHeight))
+			{
+				gClientWidth = width;
+				gClientHeight = height;
+				gClientSizeDirty = true;
+			}
+		}
+		break;
+
 	/**
 	* We can ignore the paint & erase background msgs as OpenGL is managing the rendering to the window
 	*/
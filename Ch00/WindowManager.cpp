@@ -0,0 +1,348 @@
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#include "include/glad/glad.h"
+#include <Windows.h>
+#include <iostream>
+#include "WindowManager.h"
+#include "Application.h"
+#include "RenderState.h"
+#include "FrameProfiler.h"
+#include "StreamBuffer.h"
+
+WindowManager* gWindowManager = 0;
+
+// Same signatures as in WinMain.cpp & FramePacer.cpp, the main context is current whenever they're fetched
+typedef HGLRC(WINAPI* PFNWGLCREATECONTEXTATTRIBSARBPROC)(HDC, HGLRC, const int*);
+typedef BOOL (WINAPI* PFNWGLSWAPINTERVALEXTPROC)(int);
+
+static const wchar_t* const kViewportClassName = L"Viewport Window";
+
+/**
+* Viewports get a window class of their own so the main WndProc doesn't have to tell them apart
+* The WindowManager is passed as the creation parameter & kept in the window's user data
+*/
+static LRESULT CALLBACK ViewportProc(HWND hwnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
+{
+	if (iMsg == WM_NCCREATE) { SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)((CREATESTRUCT*)lParam)->lpCreateParams); }
+	WindowManager* manager = (WindowManager*)GetWindowLongPtr(hwnd, GWLP_USERDATA);
+	// Messages sent from inside CreateWindowEx() arrive before the window was added, the starting size is set by CreateViewport()
+	int index = -1;
+	if (manager != 0)
+	{
+		for (unsigned int i = 0, size = manager->GetViewportCount(); i < size; ++i)
+		{
+			if (manager->GetWindow(i) == (void*)hwnd) { index = (int)i; break; }
+		}
+	}
+
+	switch (iMsg)
+	{
+	// Hidden instead of destroyed, the window & its context go away with the main window
+	case WM_CLOSE:
+		if (index >= 0) { manager->OnClose((unsigned int)index); }
+		ShowWindow(hwnd, SW_HIDE);
+		return 0;
+	// Same as the main window, a minimized viewport keeps its last valid size
+	case WM_SIZE:
+		if (index >= 0 && wParam != SIZE_MINIMIZED)
+		{
+			int width = LOWORD(lParam);
+			int height = HIWORD(lParam);
+			if (width > 0 && height > 0) { manager->OnResize((unsigned int)index, width, height); }
+		}
+		break;
+	case WM_PAINT:
+	case WM_ERASEBKGND:
+		return 0;
+	}
+
+	return DefWindowProc(hwnd, iMsg, wParam, lParam);
+}
+
+WindowManager::WindowManager()
+{
+	for (unsigned int i = 0; i < kMaxViewports; ++i)
+	{
+		Viewport& view = mViewports[i];
+		view.window = 0;
+		view.deviceContext = 0;
+		view.renderContext = 0;
+		view.vertexArray = 0;
+		view.renderState = 0;
+		view.clientWidth = 0;
+		view.clientHeight = 0;
+		view.closed = true;
+		view.viewportWidth = 0;
+		view.viewportHeight = 0;
+		view.aspectRatio = 1.0f;
+	}
+	mViewportCount = 0;
+	mInstance = 0;
+	mMainDeviceContext = 0;
+	mMainContext = 0;
+	mAttributes[0] = 0;
+	mRegistered = false;
+	mViewLimitReported = false;
+}
+
+WindowManager::~WindowManager()
+{
+	if (mViewportCount > 0) { std::cout << "WindowManager: Shutdown() wasn't called, " << mViewportCount << " viewports leaked\n"; }
+}
+
+bool WindowManager::Initialize(void* inHINSTANCE, void* inHDC, void* inHGLRC, const int* inAttribList)
+{
+	if (inHDC == 0 || inHGLRC == 0)
+	{
+		std::cout << "WindowManager: no main context to share with\n";
+		return false;
+	}
+	mInstance = inHINSTANCE;
+	mMainDeviceContext = inHDC;
+	mMainContext = inHGLRC;
+	// Attributes come in pairs, the terminating 0 is copied as well
+	unsigned int count = 0;
+	if (inAttribList != 0)
+	{
+		while (inAttribList[count] != 0 && count + 2 < kMaxAttributes)
+		{
+			mAttributes[count] = inAttribList[count];
+			mAttributes[count + 1] = inAttribList[count + 1];
+			count += 2;
+		}
+	}
+	mAttributes[count] = 0;
+	return true;
+}
+
+int WindowManager::CreateViewport(const wchar_t* inTitle, int inClientWidth, int inClientHeight, bool inShow)
+{
+	if (mMainContext == 0)
+	{
+		std::cout << "WindowManager: CreateViewport() called before Initialize()\n";
+		return -1;
+	}
+	if (mViewportCount == kMaxViewports)
+	{
+		std::cout << "WindowManager: only " << kMaxViewports << " viewports are supported\n";
+		return -1;
+	}
+	if (!mRegistered)
+	{
+		WNDCLASSEX wndclass;
+		wndclass.cbSize = sizeof(WNDCLASSEX);
+		// Every viewport keeps its DC for its whole lifetime & presents it from the render thread
+		wndclass.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC;
+		wndclass.lpfnWndProc = ViewportProc;
+		wndclass.cbClsExtra = 0;
+		wndclass.cbWndExtra = 0;
+		wndclass.hInstance = (HINSTANCE)mInstance;
+		wndclass.hIcon = LoadIcon(NULL, IDI_APPLICATION);
+		wndclass.hIconSm = LoadIcon(NULL, IDI_APPLICATION);
+		wndclass.hCursor = LoadCursor(NULL, IDC_ARROW);
+		wndclass.hbrBackground = (HBRUSH)(COLOR_BTNFACE + 1);
+		wndclass.lpszMenuName = 0;
+		wndclass.lpszClassName = kViewportClassName;
+		if (RegisterClassEx(&wndclass) == 0)
+		{
+			std::cout << "WindowManager: couldn't register the viewport window class\n";
+			return -1;
+		}
+		mRegistered = true;
+	}
+
+	// Unlike the main window tool viewports can be resized
+	DWORD style = (WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX | WS_MAXIMIZEBOX | WS_THICKFRAME);
+	RECT windowRect;
+	SetRect(&windowRect, 0, 0, inClientWidth, inClientHeight);
+	AdjustWindowRectEx(&windowRect, style, FALSE, 0);
+	HWND hwnd = CreateWindowEx(0, kViewportClassName, inTitle, style, CW_USEDEFAULT, CW_USEDEFAULT,
+		windowRect.right - windowRect.left, windowRect.bottom - windowRect.top, NULL, NULL, (HINSTANCE)mInstance, this);
+	if (hwnd == NULL)
+	{
+		std::cout << "WindowManager: couldn't create viewport " << mViewportCount << "\n";
+		return -1;
+	}
+	HDC hdc = GetDC(hwnd);
+
+	/**
+	* Objects can only be shared between contexts with a compatible pixel format, so the viewport copies the main window's
+	* The context is created with the main context's attributes & shares its objects
+	*/
+	HDC mainDC = (HDC)mMainDeviceContext;
+	HGLRC mainRC = (HGLRC)mMainContext;
+	PIXELFORMATDESCRIPTOR pfd;
+	memset(&pfd, 0, sizeof(PIXELFORMATDESCRIPTOR));
+	int pixelFormat = GetPixelFormat(mainDC);
+	DescribePixelFormat(mainDC, pixelFormat, sizeof(PIXELFORMATDESCRIPTOR), &pfd);
+	PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB = (PFNWGLCREATECONTEXTATTRIBSARBPROC)wglGetProcAddress("wglCreateContextAttribsARB");
+	HGLRC hglrc = NULL;
+	if (pixelFormat != 0 && SetPixelFormat(hdc, pixelFormat, &pfd) && wglCreateContextAttribsARB != NULL)
+	{
+		hglrc = wglCreateContextAttribsARB(hdc, mainRC, mAttributes);
+	}
+	if (hglrc == NULL || !wglMakeCurrent(hdc, hglrc))
+	{
+		std::cout << "WindowManager: couldn't create a shared context for viewport " << mViewportCount << "\n";
+		wglMakeCurrent(mainDC, mainRC);
+		if (hglrc != NULL) { wglDeleteContext(hglrc); }
+		ReleaseDC(hwnd, hdc);
+		DestroyWindow(hwnd);
+		return -1;
+	}
+
+	unsigned int index = mViewportCount;
+	Viewport& view = mViewports[index];
+	view.window = hwnd;
+	view.deviceContext = hdc;
+	view.renderContext = hglrc;
+	// VAOs aren't shared, every viewport keeps one bound for its whole lifetime just like the main window
+	glGenVertexArrays(1, &view.vertexArray);
+	view.renderState = new RenderState();
+	view.renderState->BindVertexArray(view.vertexArray);
+	// The main window's swap is the one that waits for vsync, a viewport waiting as well would halve the frame rate
+	PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
+	if (wglSwapIntervalEXT != NULL) { wglSwapIntervalEXT(0); }
+	wglMakeCurrent(mainDC, mainRC);
+
+	view.clientWidth = inClientWidth;
+	view.clientHeight = inClientHeight;
+	view.viewportWidth = 0; // Picked up by the first RenderViewports()
+	view.viewportHeight = 0;
+	view.aspectRatio = 1.0f;
+	view.closed = false;
+	mViewportCount = index + 1;
+
+	if (inShow)
+	{
+		ShowWindow(hwnd, SW_SHOW);
+		UpdateWindow(hwnd);
+	}
+	return (int)index;
+}
+
+unsigned int WindowManager::GetViewportCount() const
+{
+	return mViewportCount;
+}
+
+void* WindowManager::GetWindow(unsigned int inIndex) const
+{
+	return (inIndex < mViewportCount) ? mViewports[inIndex].window : 0;
+}
+
+bool WindowManager::IsViewportOpen(unsigned int inIndex) const
+{
+	return inIndex < mViewportCount && !mViewports[inIndex].closed;
+}
+
+void WindowManager::RenderViewports(Application* inApplication, unsigned int inPacket)
+{
+	if (mViewportCount == 0 || inApplication == 0) { return; }
+	PROFILE_SCOPE("Viewports");
+	// GPU scopes stay on the main context, its queries can't be used in the viewports' contexts
+	RenderState* mainState = gRenderState;
+	/**
+	* Fences the main context created this frame have to reach the GPU before another context waits on one of them,
+	* GL_SYNC_FLUSH_COMMANDS_BIT only flushes the context that waits & the main context doesn't swap until after the viewports
+	*/
+	glFlush();
+	// A RenderView() that runs all of RenderPacket() again takes a StreamBuffer region per view, more than this would wrap the ring
+	unsigned int maxViews = inApplication->HasDrawOnlyViews() ? mViewportCount : StreamBuffer::kRegionCount - 1;
+	unsigned int rendered = 0;
+	unsigned int issued = 0;
+	unsigned int skipped = 0;
+	for (unsigned int i = 0; i < mViewportCount; ++i)
+	{
+		Viewport& view = mViewports[i];
+		if (view.closed) { continue; }
+		if (rendered == maxViews)
+		{
+			if (!mViewLimitReported) { std::cout << "WindowManager: RenderView() isn't draw only, only " << maxViews << " viewports are drawn\n"; }
+			mViewLimitReported = true;
+			break;
+		}
+		if (!wglMakeCurrent((HDC)view.deviceContext, (HGLRC)view.renderContext)) { continue; }
+
+		int width = view.clientWidth;
+		int height = view.clientHeight;
+		if (width != view.viewportWidth || height != view.viewportHeight)
+		{
+			view.viewportWidth = width;
+			view.viewportHeight = height;
+			view.aspectRatio = (height > 0) ? (float)width / (float)height : 1.0f;
+		}
+
+		// Nothing but this viewport touches its context, so its cache never has to be invalidated
+		gRenderState = view.renderState;
+		gRenderState->ResetCounters();
+		gRenderState->Viewport(0, 0, view.viewportWidth, view.viewportHeight);
+		gRenderState->Enable(GL_DEPTH_TEST);
+		gRenderState->Enable(GL_CULL_FACE);
+		gRenderState->PointSize(5.0f);
+		gRenderState->BindVertexArray(view.vertexArray);
+		gRenderState->ClearColor(0.4f, 0.4f, 0.45f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		inApplication->RenderView(i, inPacket, view.aspectRatio);
+
+		issued += gRenderState->GetIssuedCalls();
+		skipped += gRenderState->GetSkippedCalls();
+		SwapBuffers((HDC)view.deviceContext);
+		++rendered;
+	}
+	gRenderState = mainState;
+	wglMakeCurrent((HDC)mMainDeviceContext, (HGLRC)mMainContext);
+
+	if (gProfiler != 0)
+	{
+		gProfiler->AddCounter("Viewports rendered", (float)rendered);
+		gProfiler->AddCounter("GL state calls issued", (float)issued);
+		gProfiler->AddCounter("GL state calls skipped", (float)skipped);
+	}
+}
+
+void WindowManager::Shutdown()
+{
+	HDC mainDC = (HDC)mMainDeviceContext;
+	HGLRC mainRC = (HGLRC)mMainContext;
+	for (unsigned int i = 0; i < mViewportCount; ++i)
+	{
+		Viewport& view = mViewports[i];
+		view.closed = true;
+		// The VAO has to be deleted in its own context, the context itself can't be current while it's deleted
+		if (wglMakeCurrent((HDC)view.deviceContext, (HGLRC)view.renderContext))
+		{
+			glBindVertexArray(0);
+			glDeleteVertexArrays(1, &view.vertexArray);
+		}
+		view.vertexArray = 0;
+		delete view.renderState;
+		view.renderState = 0;
+		wglMakeCurrent(mainDC, mainRC);
+		wglDeleteContext((HGLRC)view.renderContext);
+		view.renderContext = 0;
+		ReleaseDC((HWND)view.window, (HDC)view.deviceContext);
+		view.deviceContext = 0;
+		DestroyWindow((HWND)view.window);
+		view.window = 0;
+	}
+	mViewportCount = 0;
+	if (mRegistered)
+	{
+		UnregisterClass(kViewportClassName, (HINSTANCE)mInstance);
+		mRegistered = false;
+	}
+}
+
+void WindowManager::OnResize(unsigned int inIndex, int inWidth, int inHeight)
+{
+	if (inIndex >= mViewportCount) { return; }
+	mViewports[inIndex].clientWidth = inWidth;
+	mViewports[inIndex].clientHeight = inHeight;
+}
+
+void WindowManager::OnClose(unsigned int inIndex)
+{
+	if (inIndex < mViewportCount) { mViewports[inIndex].closed = true; }
+}
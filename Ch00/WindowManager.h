@@ -0,0 +1,82 @@
+#pragma once
+#ifndef _H_WINDOWMANAGER_
+#define _H_WINDOWMANAGER_
+
+#include "include/glad/glad.h"
+#include <atomic>
+
+class Application;
+class RenderState;
+
+/**
+* Extra tool viewports (preview, curve editor, retarget view...) that render in the same process as the main window
+* Every viewport has a window & an OpenGL context of its own that shares objects (buffers, textures, programs, syncs) with the
+* main context, so meshes, palettes & shaders are only uploaded once. What isn't shared gets created per viewport:
+* - a VAO, since VAOs are container objects & live in the context that created them (framebuffers & queries don't carry over either)
+* - a RenderState, since all the state it caches is per context
+* RenderViewports() is called by RenderFrame() on whichever thread owns the main context, after the main window was drawn & before
+* its SwapBuffers(). Viewports present without vsync, so all of them land in the one swap cycle the main window's vsync & the
+* FramePacer already pace. Closing a viewport only hides it, the main window still shuts everything down
+* Applications whose RenderView() isn't draw only (see Application::HasDrawOnlyViews()) get StreamBuffer::kRegionCount - 1 viewports
+*/
+class WindowManager
+{
+public:
+	static const unsigned int kMaxViewports = 8;
+	static const unsigned int kMaxAttributes = 16;
+protected:
+	struct Viewport
+	{
+		void* window; // HWND, HDC & HGLRC, kept as void* so this header doesn't need windows.h
+		void* deviceContext;
+		void* renderContext;
+		GLuint vertexArray;
+		RenderState* renderState;
+		// Written by the window procedure on the WinMain thread, read by the renderer
+		std::atomic<int> clientWidth;
+		std::atomic<int> clientHeight;
+		std::atomic<bool> closed;
+		// Viewport & aspect ratio as last seen by the renderer
+		int viewportWidth;
+		int viewportHeight;
+		float aspectRatio;
+	};
+	Viewport mViewports[kMaxViewports];
+	unsigned int mViewportCount;
+	void* mInstance;
+	void* mMainDeviceContext;
+	void* mMainContext;
+	int mAttributes[kMaxAttributes]; // wglCreateContextAttribsARB() list of the main context, 0 terminated
+	bool mRegistered;
+	bool mViewLimitReported;
+protected:
+	WindowManager(const WindowManager&);
+	WindowManager& operator=(const WindowManager&);
+public:
+	WindowManager();
+	~WindowManager();
+
+	// inAttribList is the list the main context was created with, the viewports are created with the same one
+	bool Initialize(void* inHINSTANCE, void* inHDC, void* inHGLRC, const int* inAttribList);
+	/**
+	* Call on the thread the main context is current on, before the render thread is started. The main context is current again on return
+	* Returns the index passed to Application::RenderView(), or -1 if the window or its context couldn't be created
+	*/
+	int CreateViewport(const wchar_t* inTitle, int inClientWidth, int inClientHeight, bool inShow);
+	unsigned int GetViewportCount() const;
+	void* GetWindow(unsigned int inIndex) const; // HWND
+	bool IsViewportOpen(unsigned int inIndex) const;
+
+	// Renders inPacket into every open viewport with inApplication->RenderView(), gRenderState points at the main cache again on return
+	void RenderViewports(Application* inApplication, unsigned int inPacket);
+	// Deletes the per viewport objects & contexts, call before the main context is deleted (the render thread has to be stopped)
+	void Shutdown();
+
+	// Called by the viewports' window procedure
+	void OnResize(unsigned int inIndex, int inWidth, int inHeight);
+	void OnClose(unsigned int inIndex);
+};
+
+extern WindowManager* gWindowManager;
+
+#endif
@@ -0,0 +1,79 @@
+#include "dualquat.h"
+#include "mat4.h"
+#include <cmath>
+
+dualquat operator+(const dualquat& l, const dualquat& r)
+{
+	return dualquat(l.real + r.real, l.dual + r.dual);
+}
+
+dualquat operator*(const dualquat& dq, float f)
+{
+	return dualquat(dq.real * f, dq.dual * f);
+}
+
+dualquat operator*(const dualquat& l, const dualquat& r)
+{
+	return dualquat(l.real * r.real, l.real * r.dual + l.dual * r.real);
+}
+
+float dot(const dualquat& l, const dualquat& r)
+{
+	return dot(l.real, r.real);
+}
+
+dualquat normalized(const dualquat& dq)
+{
+	float lengthSq = dot(dq.real, dq.real);
+	if (lengthSq < 0.000001f) { return dualquat(); }
+	float inverse = 1.0f / sqrtf(lengthSq);
+	return dq * inverse;
+}
+
+dualquat conjugate(const dualquat& dq)
+{
+	return dualquat(conjugate(dq.real), conjugate(dq.dual));
+}
+
+dualquat dualQuatFromTransform(const quat& inRotation, const vec3& inTranslation)
+{
+	quat translation(inTranslation.x, inTranslation.y, inTranslation.z, 0.0f);
+	return dualquat(inRotation, translation * inRotation * 0.5f);
+}
+
+vec3 getTranslation(const dualquat& dq)
+{
+	// 2 * dual * conjugate(real), only the vector part is needed
+	quat t = dq.dual * conjugate(dq.real);
+	return vec3(t.x * 2.0f, t.y * 2.0f, t.z * 2.0f);
+}
+
+vec3 transformPoint(const dualquat& dq, const vec3& v)
+{
+	return dq.real * v + getTranslation(dq);
+}
+
+vec3 transformVector(const dualquat& dq, const vec3& v)
+{
+	return dq.real * v;
+}
+
+dualquat mat4ToDualQuat(const mat4& m)
+{
+	return dualQuatFromTransform(normalized(mat4ToQuat(m)), vec3(m.tx, m.ty, m.tz));
+}
+
+mat4 dualQuatToMat4(const dualquat& dq)
+{
+	mat4 result = quatToMat4(dq.real);
+	vec3 t = getTranslation(dq);
+	result.tx = t.x;
+	result.ty = t.y;
+	result.tz = t.z;
+	return result;
+}
+
+void Mat4ToDualQuatArray(const mat4* inMatrices, dualquat* outResult, unsigned int inCount)
+{
+	for (unsigned int i = 0; i < inCount; ++i) { outResult[i] = mat4ToDualQuat(inMatrices[i]); }
+}
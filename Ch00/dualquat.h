@@ -0,0 +1,46 @@
+#pragma once
+#ifndef _H_DUALQUAT_
+#define _H_DUALQUAT_
+
+#include "vec3.h"
+#include "quat.h"
+
+struct mat4;
+
+/**
+* Unit dual quaternion, a rigid transform (rotation + translation) in 8 floats
+* real is the rotation & dual is 0.5 * translation * real, so blending a few of them & normalizing stays a rigid transform,
+* which is why dual quaternion skinning doesn't collapse twisted joints the way blended matrices do (candy wrapper)
+* Scale can't be represented, skin matrices with scale lose it on conversion
+* The memory layout is real (xyzw) then dual (xyzw), two vec4s per joint in a GPU palette
+*/
+struct alignas(16) dualquat
+{
+	quat real;
+	quat dual;
+
+	inline dualquat() : real(0, 0, 0, 1), dual(0, 0, 0, 0) {}
+	inline dualquat(const quat& inReal, const quat& inDual) : real(inReal), dual(inDual) {}
+};
+
+dualquat operator+(const dualquat& l, const dualquat& r);
+dualquat operator*(const dualquat& dq, float f);
+// Same order as quat & mat4: the result applies r first & then l
+dualquat operator*(const dualquat& l, const dualquat& r);
+float dot(const dualquat& l, const dualquat& r);
+dualquat normalized(const dualquat& dq);
+dualquat conjugate(const dualquat& dq);
+
+dualquat dualQuatFromTransform(const quat& inRotation, const vec3& inTranslation);
+vec3 getTranslation(const dualquat& dq);
+vec3 transformPoint(const dualquat& dq, const vec3& v);
+vec3 transformVector(const dualquat& dq, const vec3& v);
+
+// The upper 3x3 needs to be a pure rotation
+dualquat mat4ToDualQuat(const mat4& m);
+mat4 dualQuatToMat4(const dualquat& dq);
+
+// Batch conversion of skin matrices into a dual quaternion palette
+void Mat4ToDualQuatArray(const mat4* inMatrices, dualquat* outResult, unsigned int inCount);
+
+#endif
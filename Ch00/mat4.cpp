@@ -0,0 +1,388 @@
+#include "mat4.h"
+#include <cmath>
+#include <iostream>
+
+#if MATH_SSE
+// One column of a * b: the columns of a weighted by the four lanes of inColumn
+static inline __m128 MultiplyColumnSSE(const __m128* inA, __m128 inColumn)
+{
+	__m128 result = _mm_mul_ps(inA[0], MATH_SWIZZLE(inColumn, 0, 0, 0, 0));
+	result = _mm_add_ps(result, _mm_mul_ps(inA[1], MATH_SWIZZLE(inColumn, 1, 1, 1, 1)));
+	result = _mm_add_ps(result, _mm_mul_ps(inA[2], MATH_SWIZZLE(inColumn, 2, 2, 2, 2)));
+	result = _mm_add_ps(result, _mm_mul_ps(inA[3], MATH_SWIZZLE(inColumn, 3, 3, 3, 3)));
+	return result;
+}
+#endif
+
+#if MATH_AVX
+#define MATH_SWIZZLE_256(v, x, y, z, w) _mm256_shuffle_ps((v), (v), _MM_SHUFFLE(w, z, y, x))
+
+// Two columns of a * b at once, inA holds every column of a duplicated into both halves
+static inline __m256 MultiplyColumnsAVX(const __m256* inA, __m256 inColumns)
+{
+	__m256 result = _mm256_mul_ps(inA[0], MATH_SWIZZLE_256(inColumns, 0, 0, 0, 0));
+	result = _mm256_add_ps(result, _mm256_mul_ps(inA[1], MATH_SWIZZLE_256(inColumns, 1, 1, 1, 1)));
+	result = _mm256_add_ps(result, _mm256_mul_ps(inA[2], MATH_SWIZZLE_256(inColumns, 2, 2, 2, 2)));
+	result = _mm256_add_ps(result, _mm256_mul_ps(inA[3], MATH_SWIZZLE_256(inColumns, 3, 3, 3, 3)));
+	return result;
+}
+
+static inline void MultiplyAVX(const mat4& a, const mat4& b, mat4& out)
+{
+	__m256 columns[4];
+	columns[0] = _mm256_broadcast_ps((const __m128*)&a.v[0]);
+	columns[1] = _mm256_broadcast_ps((const __m128*)&a.v[4]);
+	columns[2] = _mm256_broadcast_ps((const __m128*)&a.v[8]);
+	columns[3] = _mm256_broadcast_ps((const __m128*)&a.v[12]);
+	// Computed before storing so out can be a or b
+	__m256 low = MultiplyColumnsAVX(columns, _mm256_loadu_ps(&b.v[0]));
+	__m256 high = MultiplyColumnsAVX(columns, _mm256_loadu_ps(&b.v[8]));
+	_mm256_storeu_ps(&out.v[0], low);
+	_mm256_storeu_ps(&out.v[8], high);
+}
+#endif
+
+bool operator==(const mat4& a, const mat4& b)
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		if (fabsf(a.v[i] - b.v[i]) > MATH_EPSILON) { return false; }
+	}
+	return true;
+}
+
+bool operator!=(const mat4& a, const mat4& b)
+{
+	return !(a == b);
+}
+
+mat4 operator+(const mat4& a, const mat4& b)
+{
+	mat4 result;
+	for (int i = 0; i < 16; ++i) { result.v[i] = a.v[i] + b.v[i]; }
+	return result;
+}
+
+mat4 operator*(const mat4& m, float f)
+{
+	mat4 result;
+	for (int i = 0; i < 16; ++i) { result.v[i] = m.v[i] * f; }
+	return result;
+}
+
+mat4 operator*(const mat4& a, const mat4& b)
+{
+	mat4 result;
+#if MATH_AVX
+	MultiplyAVX(a, b, result);
+#elif MATH_SSE
+	__m128 columns[4] = { _mm_load_ps(&a.v[0]), _mm_load_ps(&a.v[4]), _mm_load_ps(&a.v[8]), _mm_load_ps(&a.v[12]) };
+	for (int i = 0; i < 4; ++i)
+	{
+		_mm_store_ps(&result.v[i * 4], MultiplyColumnSSE(columns, _mm_load_ps(&b.v[i * 4])));
+	}
+#else
+	for (int column = 0; column < 4; ++column)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			result.v[column * 4 + row] =
+				a.v[0 * 4 + row] * b.v[column * 4 + 0] +
+				a.v[1 * 4 + row] * b.v[column * 4 + 1] +
+				a.v[2 * 4 + row] * b.v[column * 4 + 2] +
+				a.v[3 * 4 + row] * b.v[column * 4 + 3];
+		}
+	}
+#endif
+	return result;
+}
+
+vec4 operator*(const mat4& m, const vec4& v)
+{
+	vec4 result;
+#if MATH_SSE
+	__m128 columns[4] = { _mm_load_ps(&m.v[0]), _mm_load_ps(&m.v[4]), _mm_load_ps(&m.v[8]), _mm_load_ps(&m.v[12]) };
+	_mm_store_ps(result.v, MultiplyColumnSSE(columns, _mm_load_ps(v.v)));
+#else
+	for (int row = 0; row < 4; ++row)
+	{
+		result.v[row] = m.v[0 * 4 + row] * v.x + m.v[1 * 4 + row] * v.y + m.v[2 * 4 + row] * v.z + m.v[3 * 4 + row] * v.w;
+	}
+#endif
+	return result;
+}
+
+vec3 transformVector(const mat4& m, const vec3& v)
+{
+	vec4 result = m * vec4(v.x, v.y, v.z, 0.0f);
+	return vec3(result.x, result.y, result.z);
+}
+
+vec3 transformPoint(const mat4& m, const vec3& v)
+{
+	vec4 result = m * vec4(v.x, v.y, v.z, 1.0f);
+	return vec3(result.x, result.y, result.z);
+}
+
+vec3 transformPoint(const mat4& m, const vec3& v, float& w)
+{
+	vec4 result = m * vec4(v.x, v.y, v.z, w);
+	w = result.w;
+	return vec3(result.x, result.y, result.z);
+}
+
+void transpose(mat4& m)
+{
+	m = transposed(m);
+}
+
+mat4 transposed(const mat4& m)
+{
+#if MATH_SSE
+	__m128 c0 = _mm_load_ps(&m.v[0]);
+	__m128 c1 = _mm_load_ps(&m.v[4]);
+	__m128 c2 = _mm_load_ps(&m.v[8]);
+	__m128 c3 = _mm_load_ps(&m.v[12]);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	mat4 result;
+	_mm_store_ps(&result.v[0], c0);
+	_mm_store_ps(&result.v[4], c1);
+	_mm_store_ps(&result.v[8], c2);
+	_mm_store_ps(&result.v[12], c3);
+	return result;
+#else
+	return mat4(
+		m.xx, m.yx, m.zx, m.tx,
+		m.xy, m.yy, m.zy, m.ty,
+		m.xz, m.yz, m.zz, m.tz,
+		m.xw, m.yw, m.zw, m.tw);
+#endif
+}
+
+// 3x3 minor of m without column c & row r
+static float Minor(const mat4& m, int c, int r)
+{
+	float values[9];
+	int count = 0;
+	for (int column = 0; column < 4; ++column)
+	{
+		if (column == c) { continue; }
+		for (int row = 0; row < 4; ++row)
+		{
+			if (row == r) { continue; }
+			values[count++] = m.v[column * 4 + row];
+		}
+	}
+	return values[0] * (values[4] * values[8] - values[5] * values[7]) -
+		values[3] * (values[1] * values[8] - values[2] * values[7]) +
+		values[6] * (values[1] * values[5] - values[2] * values[4]);
+}
+
+float determinant(const mat4& m)
+{
+	float result = 0.0f;
+	for (int column = 0; column < 4; ++column)
+	{
+		float cofactor = Minor(m, column, 0) * ((column & 1) ? -1.0f : 1.0f);
+		result += m.v[column * 4] * cofactor;
+	}
+	return result;
+}
+
+mat4 adjugate(const mat4& m)
+{
+	// Transpose of the cofactor matrix
+	mat4 result;
+	for (int column = 0; column < 4; ++column)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			float cofactor = Minor(m, column, row) * (((column + row) & 1) ? -1.0f : 1.0f);
+			result.v[row * 4 + column] = cofactor;
+		}
+	}
+	return result;
+}
+
+mat4 inverse(const mat4& m)
+{
+	float det = determinant(m);
+	if (det == 0.0f)
+	{
+		std::cout << "WARNING: Trying to invert a matrix with a zero determinant\n";
+		return mat4();
+	}
+	return adjugate(m) * (1.0f / det);
+}
+
+void invert(mat4& m)
+{
+	m = inverse(m);
+}
+
+mat4 frustum(float l, float r, float b, float t, float n, float f)
+{
+	if (l == r || t == b || n == f)
+	{
+		std::cout << "WARNING: Trying to create invalid frustum\n";
+		return mat4();
+	}
+	return mat4(
+		(2.0f * n) / (r - l), 0, 0, 0,
+		0, (2.0f * n) / (t - b), 0, 0,
+		(r + l) / (r - l), (t + b) / (t - b), (-(f + n)) / (f - n), -1,
+		0, 0, (-2 * f * n) / (f - n), 0);
+}
+
+mat4 perspective(float fov, float aspect, float znear, float zfar)
+{
+	float ymax = znear * tanf(fov * 3.14159265359f / 360.0f);
+	float xmax = ymax * aspect;
+	return frustum(-xmax, xmax, -ymax, ymax, znear, zfar);
+}
+
+mat4 ortho(float l, float r, float b, float t, float n, float f)
+{
+	if (l == r || t == b || n == f)
+	{
+		std::cout << "WARNING: Trying to create invalid ortho matrix\n";
+		return mat4();
+	}
+	return mat4(
+		2.0f / (r - l), 0, 0, 0,
+		0, 2.0f / (t - b), 0, 0,
+		0, 0, -2.0f / (f - n), 0,
+		-((r + l) / (r - l)), -((t + b) / (t - b)), -((f + n) / (f - n)), 1);
+}
+
+mat4 lookAt(const vec3& position, const vec3& target, const vec3& up)
+{
+	// Camera looks down -z
+	vec3 f = normalized(target - position) * -1.0f;
+	vec3 r = cross(up, f);
+	if (r == vec3(0, 0, 0)) { return mat4(); }
+	normalize(r);
+	vec3 u = normalized(cross(f, r));
+	vec3 t = vec3(-dot(r, position), -dot(u, position), -dot(f, position));
+
+	return mat4(
+		r.x, u.x, f.x, 0,
+		r.y, u.y, f.y, 0,
+		r.z, u.z, f.z, 0,
+		t.x, t.y, t.z, 1);
+}
+
+void MultiplyArray(const mat4* inLeft, const mat4* inRight, mat4* outResult, unsigned int inCount)
+{
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+#if MATH_AVX
+		MultiplyAVX(inLeft[i], inRight[i], outResult[i]);
+#else
+		outResult[i] = inLeft[i] * inRight[i];
+#endif
+	}
+}
+
+void MultiplyArray(const mat4& inLeft, const mat4* inRight, mat4* outResult, unsigned int inCount)
+{
+	// The columns of inLeft stay in registers for the whole array
+#if MATH_AVX
+	__m256 columns[4];
+	columns[0] = _mm256_broadcast_ps((const __m128*)&inLeft.v[0]);
+	columns[1] = _mm256_broadcast_ps((const __m128*)&inLeft.v[4]);
+	columns[2] = _mm256_broadcast_ps((const __m128*)&inLeft.v[8]);
+	columns[3] = _mm256_broadcast_ps((const __m128*)&inLeft.v[12]);
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		__m256 low = MultiplyColumnsAVX(columns, _mm256_loadu_ps(&inRight[i].v[0]));
+		__m256 high = MultiplyColumnsAVX(columns, _mm256_loadu_ps(&inRight[i].v[8]));
+		_mm256_storeu_ps(&outResult[i].v[0], low);
+		_mm256_storeu_ps(&outResult[i].v[8], high);
+	}
+#elif MATH_SSE
+	__m128 columns[4] = { _mm_load_ps(&inLeft.v[0]), _mm_load_ps(&inLeft.v[4]), _mm_load_ps(&inLeft.v[8]), _mm_load_ps(&inLeft.v[12]) };
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		__m128 c0 = MultiplyColumnSSE(columns, _mm_load_ps(&inRight[i].v[0]));
+		__m128 c1 = MultiplyColumnSSE(columns, _mm_load_ps(&inRight[i].v[4]));
+		__m128 c2 = MultiplyColumnSSE(columns, _mm_load_ps(&inRight[i].v[8]));
+		__m128 c3 = MultiplyColumnSSE(columns, _mm_load_ps(&inRight[i].v[12]));
+		_mm_store_ps(&outResult[i].v[0], c0);
+		_mm_store_ps(&outResult[i].v[4], c1);
+		_mm_store_ps(&outResult[i].v[8], c2);
+		_mm_store_ps(&outResult[i].v[12], c3);
+	}
+#else
+	for (unsigned int i = 0; i < inCount; ++i) { outResult[i] = inLeft * inRight[i]; }
+#endif
+}
+
+void TransformPoints(const mat4& inMatrix, const vec3* inPoints, vec3* outResult, unsigned int inCount)
+{
+	unsigned int i = 0;
+#if MATH_AVX
+	// vec3 is 16 bytes, so two points fill one 256 bit register
+	__m256 c0 = _mm256_broadcast_ps((const __m128*)&inMatrix.v[0]);
+	__m256 c1 = _mm256_broadcast_ps((const __m128*)&inMatrix.v[4]);
+	__m256 c2 = _mm256_broadcast_ps((const __m128*)&inMatrix.v[8]);
+	__m256 c3 = _mm256_broadcast_ps((const __m128*)&inMatrix.v[12]);
+	for (; i + 2 <= inCount; i += 2)
+	{
+		__m256 p = _mm256_loadu_ps(inPoints[i].v);
+		__m256 result = _mm256_add_ps(c3, _mm256_mul_ps(c0, MATH_SWIZZLE_256(p, 0, 0, 0, 0)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(c1, MATH_SWIZZLE_256(p, 1, 1, 1, 1)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(c2, MATH_SWIZZLE_256(p, 2, 2, 2, 2)));
+		_mm256_storeu_ps(outResult[i].v, result);
+	}
+#endif
+#if MATH_SSE
+	__m128 m0 = _mm_load_ps(&inMatrix.v[0]);
+	__m128 m1 = _mm_load_ps(&inMatrix.v[4]);
+	__m128 m2 = _mm_load_ps(&inMatrix.v[8]);
+	__m128 m3 = _mm_load_ps(&inMatrix.v[12]);
+	for (; i < inCount; ++i)
+	{
+		__m128 p = _mm_load_ps(inPoints[i].v);
+		__m128 result = _mm_add_ps(m3, _mm_mul_ps(m0, MATH_SWIZZLE(p, 0, 0, 0, 0)));
+		result = _mm_add_ps(result, _mm_mul_ps(m1, MATH_SWIZZLE(p, 1, 1, 1, 1)));
+		result = _mm_add_ps(result, _mm_mul_ps(m2, MATH_SWIZZLE(p, 2, 2, 2, 2)));
+		_mm_store_ps(outResult[i].v, result);
+	}
+#else
+	for (; i < inCount; ++i) { outResult[i] = transformPoint(inMatrix, inPoints[i]); }
+#endif
+}
+
+void TransformVectors(const mat4& inMatrix, const vec3* inVectors, vec3* outResult, unsigned int inCount)
+{
+	unsigned int i = 0;
+#if MATH_AVX
+	__m256 c0 = _mm256_broadcast_ps((const __m128*)&inMatrix.v[0]);
+	__m256 c1 = _mm256_broadcast_ps((const __m128*)&inMatrix.v[4]);
+	__m256 c2 = _mm256_broadcast_ps((const __m128*)&inMatrix.v[8]);
+	for (; i + 2 <= inCount; i += 2)
+	{
+		__m256 p = _mm256_loadu_ps(inVectors[i].v);
+		__m256 result = _mm256_mul_ps(c0, MATH_SWIZZLE_256(p, 0, 0, 0, 0));
+		result = _mm256_add_ps(result, _mm256_mul_ps(c1, MATH_SWIZZLE_256(p, 1, 1, 1, 1)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(c2, MATH_SWIZZLE_256(p, 2, 2, 2, 2)));
+		_mm256_storeu_ps(outResult[i].v, result);
+	}
+#endif
+#if MATH_SSE
+	__m128 m0 = _mm_load_ps(&inMatrix.v[0]);
+	__m128 m1 = _mm_load_ps(&inMatrix.v[4]);
+	__m128 m2 = _mm_load_ps(&inMatrix.v[8]);
+	for (; i < inCount; ++i)
+	{
+		__m128 p = _mm_load_ps(inVectors[i].v);
+		__m128 result = _mm_mul_ps(m0, MATH_SWIZZLE(p, 0, 0, 0, 0));
+		result = _mm_add_ps(result, _mm_mul_ps(m1, MATH_SWIZZLE(p, 1, 1, 1, 1)));
+		result = _mm_add_ps(result, _mm_mul_ps(m2, MATH_SWIZZLE(p, 2, 2, 2, 2)));
+		_mm_store_ps(outResult[i].v, result);
+	}
+#else
+	for (; i < inCount; ++i) { outResult[i] = transformVector(inMatrix, inVectors[i]); }
+#endif
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef _H_MAT4_
+#define _H_MAT4_
+
+#include "vec3.h"
+#include "vec4.h"
+
+/**
+* Column major 4x4 matrix, the same memory layout OpenGL expects (upload with transpose = GL_FALSE)
+* The columns are the basis vectors (right, up, forward) & the translation (position)
+* Every column is a 16 byte aligned vec4, which is what the SSE & AVX kernels load
+*/
+struct alignas(16) mat4
+{
+	union
+	{
+		float v[16];
+		// right, up, forward & position
+		vec4 columns[4];
+		struct
+		{
+			// Column 0 (x basis vector)
+			float xx; float xy; float xz; float xw;
+			// Column 1 (y basis vector)
+			float yx; float yy; float yz; float yw;
+			// Column 2 (z basis vector)
+			float zx; float zy; float zz; float zw;
+			// Column 3 (translation)
+			float tx; float ty; float tz; float tw;
+		};
+	};
+	inline mat4()
+	{
+		xx = 1; xy = 0; xz = 0; xw = 0;
+		yx = 0; yy = 1; yz = 0; yw = 0;
+		zx = 0; zy = 0; zz = 1; zw = 0;
+		tx = 0; ty = 0; tz = 0; tw = 1;
+	}
+	inline mat4(const float* inFloats)
+	{
+		for (unsigned int i = 0; i < 16; ++i) { v[i] = inFloats[i]; }
+	}
+	// Values are given column by column
+	inline mat4(float _00, float _01, float _02, float _03,
+		float _10, float _11, float _12, float _13,
+		float _20, float _21, float _22, float _23,
+		float _30, float _31, float _32, float _33)
+	{
+		xx = _00; xy = _01; xz = _02; xw = _03;
+		yx = _10; yy = _11; yz = _12; yw = _13;
+		zx = _20; zy = _21; zz = _22; zw = _23;
+		tx = _30; ty = _31; tz = _32; tw = _33;
+	}
+};
+
+bool operator==(const mat4& a, const mat4& b);
+bool operator!=(const mat4& a, const mat4& b);
+mat4 operator+(const mat4& a, const mat4& b);
+mat4 operator*(const mat4& m, float f);
+mat4 operator*(const mat4& a, const mat4& b);
+vec4 operator*(const mat4& m, const vec4& v);
+// w = 0, translation is ignored
+vec3 transformVector(const mat4& m, const vec3& v);
+// w = 1
+vec3 transformPoint(const mat4& m, const vec3& v);
+// Homogeneous point, w is updated with the result
+vec3 transformPoint(const mat4& m, const vec3& v, float& w);
+
+void transpose(mat4& m);
+mat4 transposed(const mat4& m);
+float determinant(const mat4& m);
+mat4 adjugate(const mat4& m);
+mat4 inverse(const mat4& m);
+void invert(mat4& m);
+
+mat4 frustum(float l, float r, float b, float t, float n, float f);
+mat4 perspective(float fov, float aspect, float znear, float zfar);
+mat4 ortho(float l, float r, float b, float t, float n, float f);
+mat4 lookAt(const vec3& position, const vec3& target, const vec3& up);
+
+/**
+* Batch kernels, these are what the pose & skinning code should call for whole arrays
+* MultiplyArray computes outResult[i] = inLeft[i] * inRight[i], or inLeft * inRight[i] with a single left matrix (a parent & its children)
+* TransformPoints / TransformVectors apply the same matrix to inCount vec3s (w = 1 / w = 0), outResult can be inPoints
+*/
+void MultiplyArray(const mat4* inLeft, const mat4* inRight, mat4* outResult, unsigned int inCount);
+void MultiplyArray(const mat4& inLeft, const mat4* inRight, mat4* outResult, unsigned int inCount);
+void TransformPoints(const mat4& inMatrix, const vec3* inPoints, vec3* outResult, unsigned int inCount);
+void TransformVectors(const mat4& inMatrix, const vec3* inVectors, vec3* outResult, unsigned int inCount);
+
+#endif
@@ -0,0 +1,372 @@
+#include "quat.h"
+#include "mat4.h"
+#include <cmath>
+
+#if MATH_SSE
+static inline quat StoreQuat(__m128 inValue)
+{
+	quat result;
+	_mm_store_ps(result.v, inValue);
+	return result;
+}
+
+/**
+* Hamilton product with one broadcast per lane of a:
+* a * b = aw * b + ax * (bw, -bz, by, -bx) + ay * (bz, bw, -bx, -by) + az * (-by, bx, bw, -bz)
+*/
+static inline __m128 MultiplySSE(__m128 a, __m128 b)
+{
+	const __m128 signX = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+	const __m128 signY = _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f);
+	const __m128 signZ = _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+
+	__m128 result = _mm_mul_ps(MATH_SWIZZLE(a, 3, 3, 3, 3), b);
+	result = _mm_add_ps(result, _mm_mul_ps(MATH_SWIZZLE(a, 0, 0, 0, 0), _mm_xor_ps(MATH_SWIZZLE(b, 3, 2, 1, 0), signX)));
+	result = _mm_add_ps(result, _mm_mul_ps(MATH_SWIZZLE(a, 1, 1, 1, 1), _mm_xor_ps(MATH_SWIZZLE(b, 2, 3, 0, 1), signY)));
+	result = _mm_add_ps(result, _mm_mul_ps(MATH_SWIZZLE(a, 2, 2, 2, 2), _mm_xor_ps(MATH_SWIZZLE(b, 1, 0, 3, 2), signZ)));
+	return result;
+}
+
+static inline __m128 NlerpSSE(__m128 from, __m128 to, __m128 t)
+{
+	// Flip the sign of to if the dot product is negative, without a branch
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 flip = _mm_and_ps(MathDot4(from, to), signMask);
+	to = _mm_xor_ps(to, flip);
+
+	__m128 blended = _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), t));
+	__m128 lengthSq = MathDot4(blended, blended);
+	return _mm_div_ps(blended, _mm_sqrt_ps(lengthSq));
+}
+#endif
+
+#if MATH_AVX
+// Same as the SSE versions, _mm256_shuffle_ps works on each 128 bit half separately so two quaternions are handled at once
+#define MATH_SWIZZLE_256(v, x, y, z, w) _mm256_shuffle_ps((v), (v), _MM_SHUFFLE(w, z, y, x))
+
+static inline __m256 Dot4AVX(__m256 a, __m256 b)
+{
+	__m256 m = _mm256_mul_ps(a, b);
+	__m256 sum = _mm256_add_ps(m, MATH_SWIZZLE_256(m, 1, 0, 3, 2));
+	return _mm256_add_ps(sum, MATH_SWIZZLE_256(sum, 2, 3, 0, 1));
+}
+
+static inline __m256 MultiplyAVX(__m256 a, __m256 b)
+{
+	const __m256 signX = _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f);
+	const __m256 signY = _mm256_set_ps(-0.0f, -0.0f, 0.0f, 0.0f, -0.0f, -0.0f, 0.0f, 0.0f);
+	const __m256 signZ = _mm256_set_ps(-0.0f, 0.0f, 0.0f, -0.0f, -0.0f, 0.0f, 0.0f, -0.0f);
+
+	__m256 result = _mm256_mul_ps(MATH_SWIZZLE_256(a, 3, 3, 3, 3), b);
+	result = _mm256_add_ps(result, _mm256_mul_ps(MATH_SWIZZLE_256(a, 0, 0, 0, 0), _mm256_xor_ps(MATH_SWIZZLE_256(b, 3, 2, 1, 0), signX)));
+	result = _mm256_add_ps(result, _mm256_mul_ps(MATH_SWIZZLE_256(a, 1, 1, 1, 1), _mm256_xor_ps(MATH_SWIZZLE_256(b, 2, 3, 0, 1), signY)));
+	result = _mm256_add_ps(result, _mm256_mul_ps(MATH_SWIZZLE_256(a, 2, 2, 2, 2), _mm256_xor_ps(MATH_SWIZZLE_256(b, 1, 0, 3, 2), signZ)));
+	return result;
+}
+
+static inline __m256 NlerpAVX(__m256 from, __m256 to, __m256 t)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 flip = _mm256_and_ps(Dot4AVX(from, to), signMask);
+	to = _mm256_xor_ps(to, flip);
+
+	__m256 blended = _mm256_add_ps(from, _mm256_mul_ps(_mm256_sub_ps(to, from), t));
+	__m256 lengthSq = Dot4AVX(blended, blended);
+	return _mm256_div_ps(blended, _mm256_sqrt_ps(lengthSq));
+}
+#endif
+
+quat angleAxis(float angle, const vec3& axis)
+{
+	vec3 norm = normalized(axis);
+	float s = sinf(angle * 0.5f);
+	return quat(norm.x * s, norm.y * s, norm.z * s, cosf(angle * 0.5f));
+}
+
+quat fromTo(const vec3& from, const vec3& to)
+{
+	vec3 f = normalized(from);
+	vec3 t = normalized(to);
+	if (f == t) { return quat(); }
+
+	// Opposite vectors, any axis perpendicular to from works, use the most orthogonal basis vector
+	if (f == t * -1.0f)
+	{
+		vec3 ortho = vec3(1, 0, 0);
+		if (fabsf(f.y) < fabsf(f.x)) { ortho = vec3(0, 1, 0); }
+		if (fabsf(f.z) < fabsf(f.y) && fabsf(f.z) < fabsf(f.x)) { ortho = vec3(0, 0, 1); }
+		vec3 axis = normalized(cross(f, ortho));
+		return quat(axis.x, axis.y, axis.z, 0.0f);
+	}
+
+	// The half vector gives the half angle directly
+	vec3 half = normalized(f + t);
+	vec3 axis = cross(f, half);
+	return quat(axis.x, axis.y, axis.z, dot(f, half));
+}
+
+vec3 getAxis(const quat& q)
+{
+	return normalized(vec3(q.x, q.y, q.z));
+}
+
+float getAngle(const quat& q)
+{
+	float w = q.w;
+	if (w > 1.0f) { w = 1.0f; }
+	if (w < -1.0f) { w = -1.0f; }
+	return 2.0f * acosf(w);
+}
+
+quat operator+(const quat& a, const quat& b)
+{
+#if MATH_SSE
+	return StoreQuat(_mm_add_ps(_mm_load_ps(a.v), _mm_load_ps(b.v)));
+#else
+	return quat(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+#endif
+}
+
+quat operator-(const quat& a, const quat& b)
+{
+#if MATH_SSE
+	return StoreQuat(_mm_sub_ps(_mm_load_ps(a.v), _mm_load_ps(b.v)));
+#else
+	return quat(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+#endif
+}
+
+quat operator*(const quat& a, float b)
+{
+#if MATH_SSE
+	return StoreQuat(_mm_mul_ps(_mm_load_ps(a.v), _mm_set1_ps(b)));
+#else
+	return quat(a.x * b, a.y * b, a.z * b, a.w * b);
+#endif
+}
+
+quat operator-(const quat& q)
+{
+	return quat(-q.x, -q.y, -q.z, -q.w);
+}
+
+bool operator==(const quat& left, const quat& right)
+{
+	return fabsf(left.x - right.x) <= MATH_EPSILON && fabsf(left.y - right.y) <= MATH_EPSILON &&
+		fabsf(left.z - right.z) <= MATH_EPSILON && fabsf(left.w - right.w) <= MATH_EPSILON;
+}
+
+bool operator!=(const quat& a, const quat& b)
+{
+	return !(a == b);
+}
+
+bool sameOrientation(const quat& l, const quat& r)
+{
+	return fabsf(fabsf(dot(l, r)) - 1.0f) <= MATH_EPSILON;
+}
+
+float dot(const quat& a, const quat& b)
+{
+#if MATH_SSE
+	return _mm_cvtss_f32(MathDot4(_mm_load_ps(a.v), _mm_load_ps(b.v)));
+#else
+	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+#endif
+}
+
+float lenSq(const quat& q)
+{
+	return dot(q, q);
+}
+
+float len(const quat& q)
+{
+	float lengthSq = lenSq(q);
+	if (lengthSq < MATH_EPSILON) { return 0.0f; }
+	return sqrtf(lengthSq);
+}
+
+void normalize(quat& q)
+{
+	q = normalized(q);
+}
+
+quat normalized(const quat& q)
+{
+	float lengthSq = lenSq(q);
+	if (lengthSq < MATH_EPSILON) { return quat(); }
+	return q * (1.0f / sqrtf(lengthSq));
+}
+
+quat conjugate(const quat& q)
+{
+	return quat(-q.x, -q.y, -q.z, q.w);
+}
+
+quat inverse(const quat& q)
+{
+	float lengthSq = lenSq(q);
+	if (lengthSq < MATH_EPSILON) { return quat(); }
+	float recip = 1.0f / lengthSq;
+	return quat(-q.x * recip, -q.y * recip, -q.z * recip, q.w * recip);
+}
+
+quat operator*(const quat& q1, const quat& q2)
+{
+#if MATH_SSE
+	return StoreQuat(MultiplySSE(_mm_load_ps(q1.v), _mm_load_ps(q2.v)));
+#else
+	return quat(
+		q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y,
+		q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x,
+		q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w,
+		q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z);
+#endif
+}
+
+vec3 operator*(const quat& q, const vec3& v)
+{
+	// v + 2w(u x v) + 2u x (u x v), written with a single temporary
+	vec3 u(q.x, q.y, q.z);
+	vec3 t = cross(u, v) * 2.0f;
+	return v + t * q.w + cross(u, t);
+}
+
+quat mix(const quat& from, const quat& to, float t)
+{
+	return from * (1.0f - t) + to * t;
+}
+
+quat nlerp(const quat& from, const quat& to, float t)
+{
+#if MATH_SSE
+	return StoreQuat(NlerpSSE(_mm_load_ps(from.v), _mm_load_ps(to.v), _mm_set1_ps(t)));
+#else
+	quat target = dot(from, to) < 0.0f ? -to : to;
+	return normalized(from + (target - from) * t);
+#endif
+}
+
+quat slerp(const quat& start, const quat& end, float t)
+{
+	quat target = end;
+	float cosine = dot(start, end);
+	if (cosine < 0.0f)
+	{
+		target = -end;
+		cosine = -cosine;
+	}
+	// Nearly parallel, sin(theta) would be too small to divide by
+	if (cosine > 1.0f - 0.001f) { return nlerp(start, target, t); }
+
+	float theta = acosf(cosine);
+	float sinTheta = sinf(theta);
+	float a = sinf((1.0f - t) * theta) / sinTheta;
+	float b = sinf(t * theta) / sinTheta;
+	return start * a + target * b;
+}
+
+// Rotation whose local x, y & z axes are the given orthonormal vectors
+static quat FromBasis(const vec3& inRight, const vec3& inUp, const vec3& inForward)
+{
+	quat result;
+	float trace = inRight.x + inUp.y + inForward.z;
+	if (trace > 0.0f)
+	{
+		float s = sqrtf(trace + 1.0f) * 2.0f;
+		result = quat((inUp.z - inForward.y) / s, (inForward.x - inRight.z) / s, (inRight.y - inUp.x) / s, 0.25f * s);
+	}
+	else if (inRight.x > inUp.y && inRight.x > inForward.z)
+	{
+		float s = sqrtf(1.0f + inRight.x - inUp.y - inForward.z) * 2.0f;
+		result = quat(0.25f * s, (inUp.x + inRight.y) / s, (inForward.x + inRight.z) / s, (inUp.z - inForward.y) / s);
+	}
+	else if (inUp.y > inForward.z)
+	{
+		float s = sqrtf(1.0f + inUp.y - inRight.x - inForward.z) * 2.0f;
+		result = quat((inUp.x + inRight.y) / s, 0.25f * s, (inForward.y + inUp.z) / s, (inForward.x - inRight.z) / s);
+	}
+	else
+	{
+		float s = sqrtf(1.0f + inForward.z - inRight.x - inUp.y) * 2.0f;
+		result = quat((inForward.x + inRight.z) / s, (inForward.y + inUp.z) / s, 0.25f * s, (inRight.y - inUp.x) / s);
+	}
+	return normalized(result);
+}
+
+quat lookRotation(const vec3& direction, const vec3& up)
+{
+	vec3 f = normalized(direction);
+	vec3 u = normalized(up);
+	vec3 r = normalized(cross(u, f));
+	u = cross(f, r);
+	return FromBasis(r, u, f);
+}
+
+mat4 quatToMat4(const quat& q)
+{
+	vec3 r = q * vec3(1, 0, 0);
+	vec3 u = q * vec3(0, 1, 0);
+	vec3 f = q * vec3(0, 0, 1);
+	return mat4(r.x, r.y, r.z, 0,
+		u.x, u.y, u.z, 0,
+		f.x, f.y, f.z, 0,
+		0, 0, 0, 1);
+}
+
+quat mat4ToQuat(const mat4& m)
+{
+	// Scale is removed by re-orthonormalizing the basis
+	vec3 forward = normalized(vec3(m.zx, m.zy, m.zz));
+	vec3 up = normalized(vec3(m.yx, m.yy, m.yz));
+	vec3 right = normalized(cross(up, forward));
+	up = cross(forward, right);
+	return FromBasis(right, up, forward);
+}
+
+void NlerpArray(const quat* inFrom, const quat* inTo, float inT, quat* outResult, unsigned int inCount)
+{
+	unsigned int i = 0;
+#if MATH_AVX
+	__m256 t8 = _mm256_set1_ps(inT);
+	for (; i + 2 <= inCount; i += 2)
+	{
+		__m256 result = NlerpAVX(_mm256_loadu_ps(inFrom[i].v), _mm256_loadu_ps(inTo[i].v), t8);
+		_mm256_storeu_ps(outResult[i].v, result);
+	}
+#endif
+#if MATH_SSE
+	__m128 t4 = _mm_set1_ps(inT);
+	for (; i < inCount; ++i)
+	{
+		_mm_store_ps(outResult[i].v, NlerpSSE(_mm_load_ps(inFrom[i].v), _mm_load_ps(inTo[i].v), t4));
+	}
+#else
+	for (; i < inCount; ++i) { outResult[i] = nlerp(inFrom[i], inTo[i], inT); }
+#endif
+}
+
+void NlerpArray(const quat* inFrom, const quat* inTo, const float* inT, quat* outResult, unsigned int inCount)
+{
+#if MATH_SSE
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		_mm_store_ps(outResult[i].v, NlerpSSE(_mm_load_ps(inFrom[i].v), _mm_load_ps(inTo[i].v), _mm_set1_ps(inT[i])));
+	}
+#else
+	for (unsigned int i = 0; i < inCount; ++i) { outResult[i] = nlerp(inFrom[i], inTo[i], inT[i]); }
+#endif
+}
+
+void MultiplyArray(const quat* inLeft, const quat* inRight, quat* outResult, unsigned int inCount)
+{
+	unsigned int i = 0;
+#if MATH_AVX
+	for (; i + 2 <= inCount; i += 2)
+	{
+		_mm256_storeu_ps(outResult[i].v, MultiplyAVX(_mm256_loadu_ps(inLeft[i].v), _mm256_loadu_ps(inRight[i].v)));
+	}
+#endif
+	for (; i < inCount; ++i) { outResult[i] = inLeft[i] * inRight[i]; }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef _H_QUAT_
+#define _H_QUAT_
+
+#include "vec3.h"
+
+struct mat4;
+
+/**
+* Rotation quaternion, stored as (x, y, z) vector part & w scalar part
+* q1 * q2 is the Hamilton product: the result rotates by q2 first & then by q1, the same order as mat4 multiplication,
+* so a world rotation is always parent * local
+*/
+struct alignas(16) quat
+{
+	union
+	{
+		struct
+		{
+			float x;
+			float y;
+			float z;
+			float w;
+		};
+		float v[4];
+	};
+	inline quat() { x = y = z = 0.0f; w = 1.0f; }
+	inline quat(float inX, float inY, float inZ, float inW) { x = inX; y = inY; z = inZ; w = inW; }
+};
+
+quat angleAxis(float angle, const vec3& axis);
+quat fromTo(const vec3& from, const vec3& to);
+vec3 getAxis(const quat& q);
+float getAngle(const quat& q);
+
+quat operator+(const quat& a, const quat& b);
+quat operator-(const quat& a, const quat& b);
+quat operator*(const quat& a, float b);
+quat operator-(const quat& q);
+// True if both quaternions rotate the same way (q & -q are the same rotation)
+bool sameOrientation(const quat& left, const quat& right);
+bool operator==(const quat& left, const quat& right);
+bool operator!=(const quat& a, const quat& b);
+
+float dot(const quat& a, const quat& b);
+float lenSq(const quat& q);
+float len(const quat& q);
+void normalize(quat& q);
+quat normalized(const quat& q);
+quat conjugate(const quat& q);
+quat inverse(const quat& q);
+
+quat operator*(const quat& q1, const quat& q2);
+vec3 operator*(const quat& q, const vec3& v);
+
+// Plain linear blend, not normalized
+quat mix(const quat& from, const quat& to, float t);
+// Normalized lerp along the shortest arc (to is negated when the two are in different hemispheres)
+quat nlerp(const quat& from, const quat& to, float t);
+quat slerp(const quat& start, const quat& end, float t);
+quat lookRotation(const vec3& direction, const vec3& up);
+
+mat4 quatToMat4(const quat& q);
+quat mat4ToQuat(const mat4& m);
+
+/**
+* Batch kernels, the arrays can alias (outResult == inFrom for example)
+* NlerpArray blends inCount pairs with the same weight (or a weight per element), the shortest arc rule of nlerp() applies to every pair
+* MultiplyArray computes outResult[i] = inLeft[i] * inRight[i]
+*/
+void NlerpArray(const quat* inFrom, const quat* inTo, float inT, quat* outResult, unsigned int inCount);
+void NlerpArray(const quat* inFrom, const quat* inTo, const float* inT, quat* outResult, unsigned int inCount);
+void MultiplyArray(const quat* inLeft, const quat* inRight, quat* outResult, unsigned int inCount);
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#ifndef _H_VEC2_
+#define _H_VEC2_
+
+// 2 component vector, only used for vertex data like texture coordinates so it doesn't need any math
+struct vec2
+{
+	union
+	{
+		struct
+		{
+			float x;
+			float y;
+		};
+		float v[2];
+	};
+	inline vec2() { x = y = 0.0f; }
+	inline vec2(float inX, float inY) { x = inX; y = inY; }
+	inline vec2(const float* inFloats) { x = inFloats[0]; y = inFloats[1]; }
+};
+
+#endif
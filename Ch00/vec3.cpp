@@ -0,0 +1,213 @@
+#include "vec3.h"
+#include <cmath>
+
+#if MATH_SSE
+static inline vec3 StoreVec3(__m128 inValue)
+{
+	vec3 result;
+	_mm_store_ps(result.v, inValue);
+	return result;
+}
+#endif
+
+vec3 operator+(const vec3& l, const vec3& r)
+{
+#if MATH_SSE
+	return StoreVec3(_mm_add_ps(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return vec3(l.x + r.x, l.y + r.y, l.z + r.z);
+#endif
+}
+
+vec3 operator-(const vec3& l, const vec3& r)
+{
+#if MATH_SSE
+	return StoreVec3(_mm_sub_ps(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return vec3(l.x - r.x, l.y - r.y, l.z - r.z);
+#endif
+}
+
+vec3 operator*(const vec3& v, float f)
+{
+#if MATH_SSE
+	return StoreVec3(_mm_mul_ps(_mm_load_ps(v.v), _mm_set1_ps(f)));
+#else
+	return vec3(v.x * f, v.y * f, v.z * f);
+#endif
+}
+
+vec3 operator*(const vec3& l, const vec3& r)
+{
+#if MATH_SSE
+	return StoreVec3(_mm_mul_ps(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return vec3(l.x * r.x, l.y * r.y, l.z * r.z);
+#endif
+}
+
+vec3 operator-(const vec3& v)
+{
+	return vec3(-v.x, -v.y, -v.z);
+}
+
+bool operator==(const vec3& l, const vec3& r)
+{
+	vec3 diff(l - r);
+	return lenSq(diff) < MATH_EPSILON;
+}
+
+bool operator!=(const vec3& l, const vec3& r)
+{
+	return !(l == r);
+}
+
+float dot(const vec3& l, const vec3& r)
+{
+#if MATH_SSE
+	return _mm_cvtss_f32(MathDot3(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return l.x * r.x + l.y * r.y + l.z * r.z;
+#endif
+}
+
+float lenSq(const vec3& v)
+{
+	return dot(v, v);
+}
+
+float len(const vec3& v)
+{
+	float lengthSq = lenSq(v);
+	if (lengthSq < MATH_EPSILON) { return 0.0f; }
+	return sqrtf(lengthSq);
+}
+
+void normalize(vec3& v)
+{
+	v = normalized(v);
+}
+
+vec3 normalized(const vec3& v)
+{
+#if MATH_SSE
+	__m128 value = _mm_load_ps(v.v);
+	__m128 lengthSq = MathDot3(value, value);
+	if (_mm_cvtss_f32(lengthSq) < MATH_EPSILON) { return v; }
+	return StoreVec3(_mm_div_ps(value, _mm_sqrt_ps(lengthSq)));
+#else
+	float lengthSq = lenSq(v);
+	if (lengthSq < MATH_EPSILON) { return v; }
+	float invLength = 1.0f / sqrtf(lengthSq);
+	return vec3(v.x * invLength, v.y * invLength, v.z * invLength);
+#endif
+}
+
+float angle(const vec3& l, const vec3& r)
+{
+	float sqMagL = lenSq(l);
+	float sqMagR = lenSq(r);
+	if (sqMagL < MATH_EPSILON || sqMagR < MATH_EPSILON) { return 0.0f; }
+
+	float cosine = dot(l, r) / sqrtf(sqMagL * sqMagR);
+	if (cosine > 1.0f) { cosine = 1.0f; }
+	if (cosine < -1.0f) { cosine = -1.0f; }
+	return acosf(cosine);
+}
+
+vec3 project(const vec3& a, const vec3& b)
+{
+	float magBSq = lenSq(b);
+	if (magBSq < MATH_EPSILON) { return vec3(); }
+	return b * (dot(a, b) / magBSq);
+}
+
+vec3 reject(const vec3& a, const vec3& b)
+{
+	return a - project(a, b);
+}
+
+vec3 reflect(const vec3& a, const vec3& b)
+{
+	float magBSq = lenSq(b);
+	if (magBSq < MATH_EPSILON) { return vec3(); }
+	return a - b * (2.0f * dot(a, b) / magBSq);
+}
+
+vec3 cross(const vec3& l, const vec3& r)
+{
+#if MATH_SSE
+	__m128 a = _mm_load_ps(l.v);
+	__m128 b = _mm_load_ps(r.v);
+	__m128 result = _mm_sub_ps(_mm_mul_ps(MATH_SWIZZLE(a, 1, 2, 0, 3), MATH_SWIZZLE(b, 2, 0, 1, 3)),
+		_mm_mul_ps(MATH_SWIZZLE(a, 2, 0, 1, 3), MATH_SWIZZLE(b, 1, 2, 0, 3)));
+	return StoreVec3(result);
+#else
+	return vec3(l.y * r.z - l.z * r.y, l.z * r.x - l.x * r.z, l.x * r.y - l.y * r.x);
+#endif
+}
+
+vec3 lerp(const vec3& s, const vec3& e, float t)
+{
+	return s + (e - s) * t;
+}
+
+vec3 slerp(const vec3& s, const vec3& e, float t)
+{
+	if (t < 0.01f) { return lerp(s, e, t); }
+
+	vec3 from = normalized(s);
+	vec3 to = normalized(e);
+	float theta = angle(from, to);
+	float sinTheta = sinf(theta);
+	if (sinTheta < MATH_EPSILON) { return lerp(s, e, t); }
+
+	float a = sinf((1.0f - t) * theta) / sinTheta;
+	float b = sinf(t * theta) / sinTheta;
+	return from * a + to * b;
+}
+
+vec3 nlerp(const vec3& s, const vec3& e, float t)
+{
+	return normalized(lerp(s, e, t));
+}
+
+void LerpArray(const vec3* inFrom, const vec3* inTo, float inT, vec3* outResult, unsigned int inCount)
+{
+#if MATH_SSE
+	__m128 t = _mm_set1_ps(inT);
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		__m128 from = _mm_load_ps(inFrom[i].v);
+		_mm_store_ps(outResult[i].v, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(inTo[i].v), from), t)));
+	}
+#else
+	for (unsigned int i = 0; i < inCount; ++i) { outResult[i] = lerp(inFrom[i], inTo[i], inT); }
+#endif
+}
+
+void LerpArray(const vec3* inFrom, const vec3* inTo, const float* inT, vec3* outResult, unsigned int inCount)
+{
+#if MATH_SSE
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		__m128 from = _mm_load_ps(inFrom[i].v);
+		_mm_store_ps(outResult[i].v, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(inTo[i].v), from), _mm_set1_ps(inT[i]))));
+	}
+#else
+	for (unsigned int i = 0; i < inCount; ++i) { outResult[i] = lerp(inFrom[i], inTo[i], inT[i]); }
+#endif
+}
+
+void MultiplyAddArray(const vec3* inA, const vec3* inB, float inT, vec3* outResult, unsigned int inCount)
+{
+#if MATH_SSE
+	__m128 t = _mm_set1_ps(inT);
+	for (unsigned int i = 0; i < inCount; ++i)
+	{
+		_mm_store_ps(outResult[i].v, _mm_add_ps(_mm_load_ps(inA[i].v), _mm_mul_ps(_mm_load_ps(inB[i].v), t)));
+	}
+#else
+	for (unsigned int i = 0; i < inCount; ++i) { outResult[i] = inA[i] + inB[i] * inT; }
+#endif
+}
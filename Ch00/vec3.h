@@ -0,0 +1,61 @@
+#pragma once
+#ifndef _H_VEC3_
+#define _H_VEC3_
+
+#include "MathSIMD.h"
+
+/**
+* 3 component vector, padded to 16 bytes so it can be loaded straight into an SSE register
+* The 4th lane (pad) is never read by the math functions, arrays of vec3 are arrays of 16 byte elements
+* Vertex data that has to be tightly packed should use plain float arrays instead
+*/
+struct alignas(16) vec3
+{
+	union
+	{
+		struct
+		{
+			float x;
+			float y;
+			float z;
+			float pad;
+		};
+		float v[4];
+	};
+	inline vec3() { x = y = z = pad = 0.0f; }
+	inline vec3(float inX, float inY, float inZ) { x = inX; y = inY; z = inZ; pad = 0.0f; }
+	inline vec3(const float* inFloats) { x = inFloats[0]; y = inFloats[1]; z = inFloats[2]; pad = 0.0f; }
+};
+
+vec3 operator+(const vec3& l, const vec3& r);
+vec3 operator-(const vec3& l, const vec3& r);
+vec3 operator*(const vec3& v, float f);
+vec3 operator*(const vec3& l, const vec3& r);
+vec3 operator-(const vec3& v);
+bool operator==(const vec3& l, const vec3& r);
+bool operator!=(const vec3& l, const vec3& r);
+
+float dot(const vec3& l, const vec3& r);
+float lenSq(const vec3& v);
+float len(const vec3& v);
+void normalize(vec3& v);
+vec3 normalized(const vec3& v);
+// Angle between the two vectors in radians
+float angle(const vec3& l, const vec3& r);
+vec3 project(const vec3& a, const vec3& b);
+vec3 reject(const vec3& a, const vec3& b);
+vec3 reflect(const vec3& a, const vec3& b);
+vec3 cross(const vec3& l, const vec3& r);
+vec3 lerp(const vec3& s, const vec3& e, float t);
+vec3 slerp(const vec3& s, const vec3& e, float t);
+vec3 nlerp(const vec3& s, const vec3& e, float t);
+
+/**
+* Batch kernels for poses, the arrays can alias
+* LerpArray blends inCount pairs with one weight or with a weight per element (inT[i]), MultiplyAddArray computes inA[i] + inB[i] * inT
+*/
+void LerpArray(const vec3* inFrom, const vec3* inTo, float inT, vec3* outResult, unsigned int inCount);
+void LerpArray(const vec3* inFrom, const vec3* inTo, const float* inT, vec3* outResult, unsigned int inCount);
+void MultiplyAddArray(const vec3* inA, const vec3* inB, float inT, vec3* outResult, unsigned int inCount);
+
+#endif
@@ -0,0 +1,103 @@
+#include "vec4.h"
+#include <cmath>
+
+#if MATH_SSE
+static inline vec4 StoreVec4(__m128 inValue)
+{
+	vec4 result;
+	_mm_store_ps(result.v, inValue);
+	return result;
+}
+#endif
+
+vec4 operator+(const vec4& l, const vec4& r)
+{
+#if MATH_SSE
+	return StoreVec4(_mm_add_ps(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return vec4(l.x + r.x, l.y + r.y, l.z + r.z, l.w + r.w);
+#endif
+}
+
+vec4 operator-(const vec4& l, const vec4& r)
+{
+#if MATH_SSE
+	return StoreVec4(_mm_sub_ps(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return vec4(l.x - r.x, l.y - r.y, l.z - r.z, l.w - r.w);
+#endif
+}
+
+vec4 operator*(const vec4& v, float f)
+{
+#if MATH_SSE
+	return StoreVec4(_mm_mul_ps(_mm_load_ps(v.v), _mm_set1_ps(f)));
+#else
+	return vec4(v.x * f, v.y * f, v.z * f, v.w * f);
+#endif
+}
+
+vec4 operator*(const vec4& l, const vec4& r)
+{
+#if MATH_SSE
+	return StoreVec4(_mm_mul_ps(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return vec4(l.x * r.x, l.y * r.y, l.z * r.z, l.w * r.w);
+#endif
+}
+
+bool operator==(const vec4& l, const vec4& r)
+{
+	return lenSq(l - r) < MATH_EPSILON;
+}
+
+bool operator!=(const vec4& l, const vec4& r)
+{
+	return !(l == r);
+}
+
+float dot(const vec4& l, const vec4& r)
+{
+#if MATH_SSE
+	return _mm_cvtss_f32(MathDot4(_mm_load_ps(l.v), _mm_load_ps(r.v)));
+#else
+	return l.x * r.x + l.y * r.y + l.z * r.z + l.w * r.w;
+#endif
+}
+
+float lenSq(const vec4& v)
+{
+	return dot(v, v);
+}
+
+float len(const vec4& v)
+{
+	float lengthSq = lenSq(v);
+	if (lengthSq < MATH_EPSILON) { return 0.0f; }
+	return sqrtf(lengthSq);
+}
+
+void normalize(vec4& v)
+{
+	v = normalized(v);
+}
+
+vec4 normalized(const vec4& v)
+{
+#if MATH_SSE
+	__m128 value = _mm_load_ps(v.v);
+	__m128 lengthSq = MathDot4(value, value);
+	if (_mm_cvtss_f32(lengthSq) < MATH_EPSILON) { return v; }
+	return StoreVec4(_mm_div_ps(value, _mm_sqrt_ps(lengthSq)));
+#else
+	float lengthSq = lenSq(v);
+	if (lengthSq < MATH_EPSILON) { return v; }
+	float invLength = 1.0f / sqrtf(lengthSq);
+	return vec4(v.x * invLength, v.y * invLength, v.z * invLength, v.w * invLength);
+#endif
+}
+
+vec4 lerp(const vec4& s, const vec4& e, float t)
+{
+	return s + (e - s) * t;
+}
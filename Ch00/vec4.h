@@ -0,0 +1,58 @@
+#pragma once
+#ifndef _H_VEC4_
+#define _H_VEC4_
+
+#include "MathSIMD.h"
+
+// 4 component vector, the columns of mat4 & homogeneous points / directions
+struct alignas(16) vec4
+{
+	union
+	{
+		struct
+		{
+			float x;
+			float y;
+			float z;
+			float w;
+		};
+		float v[4];
+	};
+	inline vec4() { x = y = z = w = 0.0f; }
+	inline vec4(float inX, float inY, float inZ, float inW) { x = inX; y = inY; z = inZ; w = inW; }
+	inline vec4(const float* inFloats) { x = inFloats[0]; y = inFloats[1]; z = inFloats[2]; w = inFloats[3]; }
+};
+
+// Integer vector, holds the 4 joint indices that influence a skinned vertex
+struct ivec4
+{
+	union
+	{
+		struct
+		{
+			int x;
+			int y;
+			int z;
+			int w;
+		};
+		int v[4];
+	};
+	inline ivec4() { x = y = z = w = 0; }
+	inline ivec4(int inX, int inY, int inZ, int inW) { x = inX; y = inY; z = inZ; w = inW; }
+};
+
+vec4 operator+(const vec4& l, const vec4& r);
+vec4 operator-(const vec4& l, const vec4& r);
+vec4 operator*(const vec4& v, float f);
+vec4 operator*(const vec4& l, const vec4& r);
+bool operator==(const vec4& l, const vec4& r);
+bool operator!=(const vec4& l, const vec4& r);
+
+float dot(const vec4& l, const vec4& r);
+float lenSq(const vec4& v);
+float len(const vec4& v);
+void normalize(vec4& v);
+vec4 normalized(const vec4& v);
+vec4 lerp(const vec4& s, const vec4& e, float t);
+
+#endif